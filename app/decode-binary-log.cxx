@@ -0,0 +1,69 @@
+/// Write the messages in a TBinaryLog dump file as text.
+
+#include <TBinaryLog.hxx>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+void usage(int argc, char **argv) {
+    std::cout << std::endl
+              << argv[0] << " [-o <output-file-name>] <dump-file-name> ..."
+              << std::endl
+              << std::endl
+              << "   Decode the messages in binary log dump files written"
+              << std::endl
+              << "   by CP::TBinaryLog."
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string outputName;
+
+    for (;;) {
+        int c = getopt(argc, argv, "ho:");
+        switch (c) {
+        case 'h':
+            usage(argc,argv);
+            return 0;
+        case 'o':
+            outputName = optarg;
+            continue;
+        }
+        if (c<0) break;
+    }
+
+    if (argc<optind+1) { 
+        std::cerr << "ERROR: Missing input file" << std::endl;
+        usage(argc,argv);
+        return 1;
+    }
+
+    std::ofstream outputFile;
+    if (!outputName.empty()) {
+        outputFile.open(outputName.c_str());
+        if (!outputFile.is_open()) {
+            std::cerr << "ERROR: Cannot open " << outputName << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = outputName.empty() ? std::cout : outputFile;
+
+    int status = 0;
+    for (; optind<argc; ++optind) {
+        std::ifstream input(argv[optind], std::ios::in|std::ios::binary);
+        if (!input.is_open()) {
+            std::cerr << "ERROR: Cannot open " << argv[optind] << std::endl;
+            status = 1;
+            continue;
+        }
+        if (!CP::TBinaryLog::Decode(input,output)) {
+            std::cerr << "ERROR: " << argv[optind]
+                      << " is not a binary log dump" << std::endl;
+            status = 1;
+        }
+    }
+
+    return status;
+}
@@ -2,6 +2,7 @@
 #include <cstdlib>
 
 #include "ECore.hxx"
+#include "TBinaryLog.hxx"
 
 #ifdef _GNU_SOURCE
 #include <execinfo.h>
@@ -54,6 +55,7 @@ CP::ECore::ECore() {
     }
 #endif
     std::strcat(fWhat,"Exception:  ECore");
+    CP::TBinaryLog::DumpForException();
 }
 
 void CP::ECore::AppendWhat(const char* child) {
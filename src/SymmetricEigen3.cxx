@@ -0,0 +1,79 @@
+#include <cmath>
+#include <algorithm>
+
+#include "SymmetricEigen3.hxx"
+
+// Use the cyclic Jacobi method.  The analytic (trigonometric) solution is a
+// little faster, but the eigenvectors lose precision when two eigenvalues
+// are nearly equal, or when the eigenvalues are very different (e.g. the
+// 1E+9 moment given to an axis without any measurements).  For a 3x3 matrix,
+// Jacobi usually converges in four or five sweeps.
+void CP::Tools::SymmetricEigen3(const double* matrix,
+                                double* values, double* vectors) {
+    double a[3][3] = {{matrix[0], matrix[3], matrix[4]},
+                      {matrix[3], matrix[1], matrix[5]},
+                      {matrix[4], matrix[5], matrix[2]}};
+    double v[3][3] = {{1.0, 0.0, 0.0},
+                      {0.0, 1.0, 0.0},
+                      {0.0, 0.0, 1.0}};
+
+    const double scale = a[0][0]*a[0][0] + a[1][1]*a[1][1] + a[2][2]*a[2][2]
+        + 2.0*(a[0][1]*a[0][1] + a[0][2]*a[0][2] + a[1][2]*a[1][2]);
+    const int maxSweeps = 50;
+    for (int sweep = 0; sweep < maxSweeps; ++sweep) {
+        double off = a[0][1]*a[0][1] + a[0][2]*a[0][2] + a[1][2]*a[1][2];
+        if (off <= 1E-32*scale) break;
+        for (int p = 0; p < 2; ++p) {
+            for (int q = p+1; q < 3; ++q) {
+                if (a[p][q] == 0.0) continue;
+                // Find the rotation that zeros a[p][q].
+                double theta = 0.5*(a[q][q]-a[p][p])/a[p][q];
+                double t;
+                if (std::abs(theta) > 1E+150) t = 0.5/theta;
+                else {
+                    t = 1.0/(std::abs(theta) + std::sqrt(theta*theta+1.0));
+                    if (theta < 0.0) t = -t;
+                }
+                double c = 1.0/std::sqrt(t*t+1.0);
+                double s = t*c;
+                a[p][p] -= t*a[p][q];
+                a[q][q] += t*a[p][q];
+                a[p][q] = a[q][p] = 0.0;
+                int r = 3-p-q;
+                double arp = a[r][p];
+                double arq = a[r][q];
+                a[r][p] = a[p][r] = c*arp - s*arq;
+                a[r][q] = a[q][r] = s*arp + c*arq;
+                for (int k = 0; k < 3; ++k) {
+                    double vkp = v[k][p];
+                    double vkq = v[k][q];
+                    v[k][p] = c*vkp - s*vkq;
+                    v[k][q] = s*vkp + c*vkq;
+                }
+            }
+        }
+    }
+
+    // Sort into decreasing order.
+    int order[3] = {0, 1, 2};
+    if (a[order[0]][order[0]] < a[order[1]][order[1]]) {
+        std::swap(order[0],order[1]);
+    }
+    if (a[order[1]][order[1]] < a[order[2]][order[2]]) {
+        std::swap(order[1],order[2]);
+    }
+    if (a[order[0]][order[0]] < a[order[1]][order[1]]) {
+        std::swap(order[0],order[1]);
+    }
+    for (int j = 0; j < 3; ++j) {
+        values[j] = a[order[j]][order[j]];
+        for (int i = 0; i < 3; ++i) vectors[3*i+j] = v[i][order[j]];
+    }
+}
+
+void CP::Tools::SymmetricEigen3(std::size_t count, const double* matrices,
+                                double* values, double* vectors) {
+    for (std::size_t i = 0; i < count; ++i) {
+        SymmetricEigen3(matrices+6*i, values+3*i, vectors+9*i);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef SymmetricEigen3_hxx_seen
+#define SymmetricEigen3_hxx_seen
+
+#include <cstddef>
+
+namespace CP {
+
+    namespace Tools {
+
+        /// Find the eigenvalues and eigenvectors of a symmetric 3x3 matrix
+        /// without allocating memory.  The matrix is given by the six
+        /// independent elements in the order (xx, yy, zz, xy, xz, yz).  The
+        /// eigenvalues are returned in decreasing order, and the
+        /// eigenvectors are the columns of "vectors" stored by row
+        /// (i.e. vectors[3*i+j] is the i'th component of the j'th
+        /// eigenvector), which is the same order as TMatrixDSymEigen.  The
+        /// eigenvectors have unit length, but the sign is arbitrary.
+        void SymmetricEigen3(const double* matrix,
+                             double* values, double* vectors);
+
+        /// Find the eigenvalues and eigenvectors for "count" symmetric 3x3
+        /// matrices.  The matrices, values, and vectors are packed one after
+        /// the other (6, 3, and 9 elements for each matrix) in the order
+        /// used by SymmetricEigen3 for a single matrix.
+        void SymmetricEigen3(std::size_t count, const double* matrices,
+                             double* values, double* vectors);
+
+    }
+}
+#endif
@@ -41,6 +41,9 @@ namespace CP {
 /// TAlgorithmResult objects are often created by one TAlgorithm, and then
 /// used as input to the next TAlgorithm.  In that case, the TAlgorithm will
 /// use the last container of objects, and hit selection for it's input.
+/// A graph of algorithms connected this way can be run with
+/// TAlgorithmScheduler, which runs the independent algorithms at the same
+/// time.
 ///
 class CP::TAlgorithm : public TNamed {
 public:
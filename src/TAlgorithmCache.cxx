@@ -0,0 +1,315 @@
+#include <typeinfo>
+#include <map>
+
+#include <TROOT.h>
+#include <TClass.h>
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TBufferFile.h>
+
+#include "TAlgorithmCache.hxx"
+#include "TAlgorithm.hxx"
+#include "TReconBase.hxx"
+#include "THitSelection.hxx"
+#include "THit.hxx"
+#include "TRuntimeParameters.hxx"
+#include "TSHA1.hxx"
+#include "TCaptLog.hxx"
+
+namespace {
+    /// Add a string (with the terminating null so that strings can't run
+    /// together) to a hash.
+    void HashString(const std::string& value, CP::TSHA1& sha) {
+        sha.Input(value.c_str(), value.size()+1);
+    }
+
+    /// Add a hash code to a hash.
+    void HashValue(const CP::TSHAHashValue& value, CP::TSHA1& sha) {
+        for (int i = 0; i<5; ++i) sha.Input(value(i));
+    }
+
+    /// Check that an object has a dictionary so that its streamer writes
+    /// all of its fields.
+    bool HasDictionary(const TObject& object) {
+        TClass* type = TClass::GetClass(typeid(object));
+        if (type && type->HasDictionary()) return true;
+        CaptNamedInfo("Algorithm", "Can't hash " << object.GetName()
+                      << " since " << object.ClassName()
+                      << " doesn't have a dictionary");
+        return false;
+    }
+
+    /// Check that a datum, and the objects that it holds, can be
+    /// serialized.
+    bool CanSerialize(const CP::TDatum& datum) {
+        if (!HasDictionary(datum)) return false;
+        const CP::TReconObjectContainer* objects
+            = dynamic_cast<const CP::TReconObjectContainer*>(&datum);
+        if (objects) {
+            for (CP::TReconObjectContainer::const_iterator o
+                     = objects->begin();
+                 o != objects->end(); ++o) {
+                if (!CanSerialize(**o)) return false;
+            }
+        }
+        const CP::TDataVector* vector
+            = dynamic_cast<const CP::TDataVector*>(&datum);
+        if (vector) {
+            for (CP::TDataVector::const_iterator d = vector->begin();
+                 d != vector->end(); ++d) {
+                if (!CanSerialize(**d)) return false;
+            }
+        }
+        return true;
+    }
+
+    /// Find the hit selections held by a datum, and the objects that it
+    /// holds.  This follows the same objects as CanSerialize().
+    void FindHitSelections(const CP::TDatum& datum,
+                           std::vector<const CP::THitSelection*>& found) {
+        const CP::THitSelection* hits
+            = dynamic_cast<const CP::THitSelection*>(&datum);
+        if (hits) found.push_back(hits);
+        const CP::TReconObjectContainer* objects
+            = dynamic_cast<const CP::TReconObjectContainer*>(&datum);
+        if (objects) {
+            for (CP::TReconObjectContainer::const_iterator o
+                     = objects->begin();
+                 o != objects->end(); ++o) {
+                FindHitSelections(**o, found);
+            }
+        }
+        const CP::TDataVector* vector
+            = dynamic_cast<const CP::TDataVector*>(&datum);
+        if (vector) {
+            for (CP::TDataVector::const_iterator d = vector->begin();
+                 d != vector->end(); ++d) {
+                FindHitSelections(**d, found);
+            }
+        }
+    }
+
+    /// Hash the saved fields of a hit.  A hit read from the cache has the
+    /// same hash as the hit that was saved.
+    CP::TSHAHashValue HashHit(const CP::THit& hit) {
+        TBufferFile buffer(TBuffer::kWrite);
+        buffer.WriteObject(&hit);
+        CP::TSHA1 sha;
+        sha.Input(buffer.Buffer(), buffer.Length());
+        unsigned int hash[5];
+        sha.Result(hash);
+        return CP::TSHAHashValue(hash);
+    }
+
+    /// The input hits indexed by the hash of their contents.
+    typedef std::map<CP::TSHAHashValue, CP::THandle<CP::THit> > HitMap;
+
+    /// Add the hits held by an input to the map.  Hits with the same
+    /// contents can't be told apart, so the first one is used.
+    void FillHitMap(const CP::TAlgorithmResult& input, HitMap& hitMap) {
+        std::vector<const CP::THitSelection*> selections;
+        FindHitSelections(input, selections);
+        for (std::vector<const CP::THitSelection*>::iterator s
+                 = selections.begin();
+             s != selections.end(); ++s) {
+            for (CP::THitSelection::const_iterator h = (*s)->begin();
+                 h != (*s)->end(); ++h) {
+                hitMap.insert(std::make_pair(HashHit(**h), *h));
+            }
+        }
+    }
+}
+
+CP::TAlgorithmCache::TAlgorithmCache(const std::string& fileName)
+    : fFile(NULL), fHits(0), fMisses(0) {
+    // The file is read and written by the threads running the algorithms.
+    ROOT::EnableThreadSafety();
+    {
+        // Opening the file makes it the current directory, so restore the
+        // caller's directory.
+        TDirectory::TContext context;
+        fFile = new TFile(fileName.c_str(), "UPDATE");
+    }
+    if (!fFile->IsOpen()) {
+        CaptError("Unable to open the algorithm cache " << fileName);
+        delete fFile;
+        fFile = NULL;
+        return;
+    }
+    CaptNamedInfo("Algorithm", "Using the algorithm cache " << fileName);
+}
+
+CP::TAlgorithmCache::~TAlgorithmCache() {
+    if (!fFile) return;
+    CaptNamedInfo("Algorithm", "Algorithm cache hits: " << fHits
+                  << " misses: " << fMisses);
+    fFile->Close();
+    delete fFile;
+}
+
+bool CP::TAlgorithmCache::IsOpen() const {
+    return fFile != NULL;
+}
+
+void CP::TAlgorithmCache::AddParameters(const CP::TAlgorithm& algorithm,
+                                        const std::string& prefix) {
+    // Read the parameters file for the prefix now so that it isn't read by
+    // the threads running the algorithms.
+    CP::TRuntimeParameters::Get().GetParameterHash(prefix);
+    std::lock_guard<std::mutex> lock(fMutex);
+    fParameters[algorithm.GetName()].push_back(prefix);
+}
+
+CP::THandle<CP::TAlgorithmResult>
+CP::TAlgorithmCache::Process(CP::TAlgorithm& algorithm,
+                             const CP::TAlgorithmResult& input,
+                             const CP::TAlgorithmResult& input1,
+                             const CP::TAlgorithmResult& input2) {
+    CP::TSHAHashValue key = GetKey(algorithm, input, input1, input2);
+    if (!key.Valid()) {
+        // The inputs can't be hashed, so the result can't be cached.
+        {
+            std::lock_guard<std::mutex> lock(fMutex);
+            ++fMisses;
+        }
+        return algorithm.Process(input, input1, input2);
+    }
+
+    CP::THandle<CP::TAlgorithmResult> result
+        = Find(key, input, input1, input2);
+    if (result) {
+        std::lock_guard<std::mutex> lock(fMutex);
+        ++fHits;
+        return result;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        ++fMisses;
+    }
+    result = algorithm.Process(input, input1, input2);
+    if (result) Save(key, *result);
+    return result;
+}
+
+CP::TSHAHashValue
+CP::TAlgorithmCache::GetKey(const CP::TAlgorithm& algorithm,
+                            const CP::TAlgorithmResult& input,
+                            const CP::TAlgorithmResult& input1,
+                            const CP::TAlgorithmResult& input2) const {
+    std::vector<std::string> prefixes;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        std::map< std::string, std::vector<std::string> >::const_iterator
+            p = fParameters.find(algorithm.GetName());
+        if (p != fParameters.end()) prefixes = p->second;
+    }
+
+    CP::TSHA1 sha;
+    HashString(algorithm.GetName(), sha);
+    HashString(algorithm.GetVersion(), sha);
+    for (std::vector<std::string>::iterator p = prefixes.begin();
+         p != prefixes.end(); ++p) {
+        HashString(*p, sha);
+        HashValue(CP::TRuntimeParameters::Get().GetParameterHash(*p), sha);
+    }
+    if (!HashResult(input, sha)) return CP::TSHAHashValue();
+    if (!HashResult(input1, sha)) return CP::TSHAHashValue();
+    if (!HashResult(input2, sha)) return CP::TSHAHashValue();
+
+    unsigned int hash[5];
+    sha.Result(hash);
+    return CP::TSHAHashValue(hash);
+}
+
+CP::THandle<CP::TAlgorithmResult>
+CP::TAlgorithmCache::Find(const CP::TSHAHashValue& key,
+                          const CP::TAlgorithmResult& input,
+                          const CP::TAlgorithmResult& input1,
+                          const CP::TAlgorithmResult& input2) {
+    CP::TAlgorithmResult* result = NULL;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        if (!fFile) return CP::THandle<CP::TAlgorithmResult>();
+        TObject* object = fFile->Get(KeyName(key).c_str());
+        if (!object) return CP::THandle<CP::TAlgorithmResult>();
+        result = dynamic_cast<CP::TAlgorithmResult*>(object);
+        if (!result) {
+            CaptError("Algorithm cache key " << KeyName(key)
+                      << " is not a TAlgorithmResult");
+            delete object;
+            return CP::THandle<CP::TAlgorithmResult>();
+        }
+    }
+    CaptNamedDebug("Algorithm", "Found " << result->GetName()
+                   << " in the algorithm cache");
+    CP::THandle<CP::TAlgorithmResult> found(result);
+    ResolveHits(*result, input, input1, input2);
+    return found;
+}
+
+void CP::TAlgorithmCache::Save(const CP::TSHAHashValue& key,
+                               const CP::TAlgorithmResult& result) {
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (!fFile) return;
+    fFile->WriteTObject(&result, KeyName(key).c_str());
+}
+
+int CP::TAlgorithmCache::GetHitCount() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fHits;
+}
+
+int CP::TAlgorithmCache::GetMissCount() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fMisses;
+}
+
+std::string CP::TAlgorithmCache::KeyName(const CP::TSHAHashValue& key) {
+    return "result_" + key.AsString();
+}
+
+int CP::TAlgorithmCache::ResolveHits(CP::TAlgorithmResult& result,
+                                     const CP::TAlgorithmResult& input,
+                                     const CP::TAlgorithmResult& input1,
+                                     const CP::TAlgorithmResult& input2) {
+    std::vector<const CP::THitSelection*> selections;
+    FindHitSelections(result, selections);
+    if (selections.empty()) return 0;
+
+    HitMap hitMap;
+    FillHitMap(input, hitMap);
+    FillHitMap(input1, hitMap);
+    FillHitMap(input2, hitMap);
+    if (hitMap.empty()) return 0;
+
+    int resolved = 0;
+    for (std::vector<const CP::THitSelection*>::iterator s
+             = selections.begin();
+         s != selections.end(); ++s) {
+        // The selections belong to the result that was just read, so they
+        // can be changed.
+        CP::THitSelection& hits = const_cast<CP::THitSelection&>(**s);
+        for (CP::THitSelection::iterator h = hits.begin();
+             h != hits.end(); ++h) {
+            HitMap::iterator match = hitMap.find(HashHit(**h));
+            if (match == hitMap.end()) continue;
+            *h = match->second;
+            ++resolved;
+        }
+    }
+    CaptNamedDebug("Algorithm", "Resolved " << resolved
+                   << " cached hits for " << result.GetName());
+    return resolved;
+}
+
+bool CP::TAlgorithmCache::HashResult(const CP::TAlgorithmResult& result,
+                                     CP::TSHA1& sha) {
+    if (!CanSerialize(result)) return false;
+    // The result is written the same way it would be written to a file, so
+    // the hash uses every saved field of the result and its contents.
+    TBufferFile buffer(TBuffer::kWrite);
+    buffer.WriteObject(&result);
+    sha.Input(buffer.Buffer(), buffer.Length());
+    return true;
+}
@@ -0,0 +1,164 @@
+#ifndef TAlgorithmCache_hxx_seen
+#define TAlgorithmCache_hxx_seen
+
+#include <string>
+#include <vector>
+#include <map>
+
+#ifndef __CINT__
+#include <mutex>
+#endif
+
+#include "THandle.hxx"
+#include "TAlgorithmResult.hxx"
+#include "TSHAHashValue.hxx"
+
+class TFile;
+
+namespace CP {
+    class TAlgorithm;
+    class TAlgorithmCache;
+    class TSHA1;
+}
+
+/// Save the results of TAlgorithm objects in a sidecar file so that running
+/// a chain of algorithms again can skip the algorithms whose inputs and
+/// configuration haven't changed.  Each result is saved with a key that is
+/// a SHA1 hash of
+///
+/// - The algorithm name and version (see TAlgorithm::GetVersion()).
+///
+/// - The runtime parameters used by the algorithm.  These are the
+///   parameters with names starting with the prefixes given to
+///   AddParameters().  If an algorithm doesn't have any prefixes, only the
+///   version is used, so the version must be changed when the configuration
+///   changes.
+///
+/// - The serialized contents of the inputs (see HashResult()).  If an
+///   input holds an object that can't be serialized, the algorithm is
+///   always run.
+///
+/// \code
+/// CP::TAlgorithmCache cache("reco.cache.root");
+/// cache.AddParameters(tpcClusters, "captRecon.tpcClusters");
+///
+/// // Run the algorithm unless the result is already in the cache.
+/// CP::THandle<CP::TAlgorithmResult> clusters
+///     = cache.Process(tpcClusters, *hits);
+///
+/// // Or, let a scheduler use the cache for every algorithm.
+/// scheduler.SetCache(&cache);
+/// \endcode
+///
+/// The results are read from the file when they are found, so each call
+/// returns a new object owned by the caller.  The hits in a result are
+/// replaced by the matching input hits after it's read, so a cached result
+/// refers to the same hits as the result made by the algorithm.  The cache
+/// can be used by several threads at the same time, but the file is only
+/// read or written by one thread at a time.
+class CP::TAlgorithmCache {
+public:
+    /// Open the sidecar file, or create it if it doesn't exist.  If the file
+    /// can't be opened, an error is printed, and the algorithms are always
+    /// run.
+    explicit TAlgorithmCache(const std::string& fileName);
+
+    /// Close the sidecar file.
+    ~TAlgorithmCache();
+
+    /// Check if the sidecar file is open.
+    bool IsOpen() const;
+
+    /// Add a prefix for the runtime parameters that configure the
+    /// algorithm.  This can be called more than once for an algorithm.
+    void AddParameters(const CP::TAlgorithm& algorithm,
+                       const std::string& prefix);
+
+    /// Run the algorithm unless a result for the same inputs and
+    /// configuration is in the cache.  A new result is saved in the cache,
+    /// unless the inputs can't be hashed.
+    /// This returns an empty handle if the algorithm doesn't make a result,
+    /// and exceptions thrown by the algorithm are passed to the caller.
+    CP::THandle<CP::TAlgorithmResult>
+    Process(CP::TAlgorithm& algorithm,
+            const CP::TAlgorithmResult& input,
+            const CP::TAlgorithmResult& input1 = CP::TAlgorithmResult::Empty,
+            const CP::TAlgorithmResult& input2 = CP::TAlgorithmResult::Empty);
+
+    /// Get the key for the result of running the algorithm on the inputs.
+    /// The key isn't valid if the inputs can't be hashed (see
+    /// HashResult()).
+    CP::TSHAHashValue
+    GetKey(const CP::TAlgorithm& algorithm,
+           const CP::TAlgorithmResult& input,
+           const CP::TAlgorithmResult& input1 = CP::TAlgorithmResult::Empty,
+           const CP::TAlgorithmResult& input2 = CP::TAlgorithmResult::Empty)
+        const;
+
+    /// Read the result saved with the key.  This returns an empty handle if
+    /// the key isn't in the cache.  The hits in the result that match hits
+    /// in the inputs are replaced by the input hits (see ResolveHits()).
+    CP::THandle<CP::TAlgorithmResult>
+    Find(const CP::TSHAHashValue& key,
+         const CP::TAlgorithmResult& input = CP::TAlgorithmResult::Empty,
+         const CP::TAlgorithmResult& input1 = CP::TAlgorithmResult::Empty,
+         const CP::TAlgorithmResult& input2 = CP::TAlgorithmResult::Empty);
+
+    /// Save a result with the key.
+    void Save(const CP::TSHAHashValue& key,
+              const CP::TAlgorithmResult& result);
+
+    /// Get the number of results found in the cache by Process().
+    int GetHitCount() const;
+
+    /// Get the number of times Process() ran the algorithm.
+    int GetMissCount() const;
+
+    /// Add the contents of a result to a hash.  The result is serialized
+    /// the same way it is written to a file, so every saved field of the
+    /// result and the objects it holds is used.  This returns false (and
+    /// the hash shouldn't be used) if the result holds an object without a
+    /// dictionary since it can't be serialized.  Since the hits of a cached
+    /// result are resolved against the inputs, a result read from the cache
+    /// has the same hash as the result made by the algorithm, so the later
+    /// algorithms in a chain are also found in the cache.
+    static bool HashResult(const CP::TAlgorithmResult& result,
+                           CP::TSHA1& sha);
+
+    /// Replace the hits in a result read from the cache by the matching
+    /// hits in the inputs.  The hits are saved as part of the result, so
+    /// the hits that are read are copies of the hits that the algorithm
+    /// used.  A hit matches when all of its saved fields are the same as an
+    /// input hit.  Hits that don't match (e.g. hits made by the algorithm)
+    /// are kept.  This returns the number of hits that were replaced.
+    static int ResolveHits(
+        CP::TAlgorithmResult& result,
+        const CP::TAlgorithmResult& input,
+        const CP::TAlgorithmResult& input1 = CP::TAlgorithmResult::Empty,
+        const CP::TAlgorithmResult& input2 = CP::TAlgorithmResult::Empty);
+
+private:
+    TAlgorithmCache(const TAlgorithmCache&);
+    TAlgorithmCache& operator = (const TAlgorithmCache&);
+
+    /// Make the name used for a key in the sidecar file.
+    static std::string KeyName(const CP::TSHAHashValue& key);
+
+    /// The sidecar file.
+    TFile* fFile;
+
+    /// The runtime parameter prefixes for each algorithm, indexed by the
+    /// algorithm name.
+    std::map< std::string, std::vector<std::string> > fParameters;
+
+    /// The number of results found, and the number of times an algorithm
+    /// was run.
+    int fHits;
+    int fMisses;
+
+#ifndef __CINT__
+    /// Protect the file and the counts.
+    mutable std::mutex fMutex;
+#endif
+};
+#endif
@@ -0,0 +1,352 @@
+#include <exception>
+
+#include "TAlgorithmScheduler.hxx"
+#include "TAlgorithm.hxx"
+#include "TAlgorithmCache.hxx"
+#include "TEvent.hxx"
+#include "TEventFolder.hxx"
+#include "THitSelection.hxx"
+#include "TCaptLog.hxx"
+
+CP::TAlgorithmScheduler::TAlgorithmScheduler(int threads, int depth)
+    : fCache(NULL), fConnected(false), fDepth(depth), fThreadCount(threads),
+      fStopping(false) {
+    if (fDepth < 1) fDepth = 1;
+    if (fThreadCount < 1) fThreadCount = std::thread::hardware_concurrency();
+    if (fThreadCount < 1) fThreadCount = 1;
+    for (int i = 0; i<fThreadCount; ++i) {
+        fThreads.push_back(std::thread(&CP::TAlgorithmScheduler::Run, this));
+    }
+}
+
+CP::TAlgorithmScheduler::~TAlgorithmScheduler() {
+    while (Next()) continue;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fStopping = true;
+    }
+    fWork.notify_all();
+    for (std::vector<std::thread>::iterator t = fThreads.begin();
+         t != fThreads.end(); ++t) {
+        t->join();
+    }
+}
+
+std::string CP::TAlgorithmScheduler::FitPath(const std::string& name) {
+    return "~/fits/" + name;
+}
+
+void CP::TAlgorithmScheduler::AddAlgorithm(CP::TAlgorithm* algorithm,
+                                           const std::string& output,
+                                           const std::string& input,
+                                           const std::string& input1,
+                                           const std::string& input2) {
+    if (!algorithm) {
+        CaptError("A NULL algorithm can't be scheduled");
+        throw EAlgorithmScheduler();
+    }
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    if (fConnected) {
+        CaptError("Algorithm " << algorithm->GetName()
+                  << " added after the first event was submitted");
+        throw EAlgorithmScheduler();
+    }
+
+    std::string name = output;
+    if (name.find(FitPath("")) == 0) name = name.substr(FitPath("").size());
+    if (name.empty()) name = algorithm->GetName();
+    if (name.find('/') != std::string::npos) {
+        CaptError("Algorithm output " << output << " is not in ~/fits");
+        throw EAlgorithmScheduler();
+    }
+    if (fOutputs.find(FitPath(name)) != fOutputs.end()) {
+        CaptError("Algorithm output " << output << " is already used");
+        throw EAlgorithmScheduler();
+    }
+    for (std::vector<TStage>::iterator s = fStages.begin();
+         s != fStages.end(); ++s) {
+        if (s->fAlgorithm != algorithm) continue;
+        CaptError("Algorithm " << algorithm->GetName()
+                  << " is already scheduled");
+        throw EAlgorithmScheduler();
+    }
+
+    TStage stage;
+    stage.fAlgorithm = algorithm;
+    stage.fOutput = name;
+    const std::string* inputs[3] = {&input, &input1, &input2};
+    for (int i = 0; i<3; ++i) {
+        if (inputs[i]->empty()) continue;
+        // A bare name is the output of another algorithm.
+        if (inputs[i]->find('/') == std::string::npos) {
+            stage.fInputs.push_back(FitPath(*inputs[i]));
+        }
+        else stage.fInputs.push_back(*inputs[i]);
+    }
+
+    fOutputs[FitPath(name)] = fStages.size();
+    fStages.push_back(stage);
+}
+
+void CP::TAlgorithmScheduler::Connect() {
+    int stages = fStages.size();
+    for (int s = 0; s<stages; ++s) {
+        fStages[s].fSources.clear();
+        fStages[s].fUsers.clear();
+    }
+    for (int s = 0; s<stages; ++s) {
+        TStage& stage = fStages[s];
+        for (std::size_t i = 0; i<stage.fInputs.size(); ++i) {
+            std::map<std::string,int>::iterator source
+                = fOutputs.find(stage.fInputs[i]);
+            if (source == fOutputs.end()) {
+                stage.fSources.push_back(-1);
+                continue;
+            }
+            stage.fSources.push_back(source->second);
+            fStages[source->second].fUsers.push_back(s);
+        }
+    }
+
+    // Check for cycles by removing the stages that only depend on stages
+    // that have already been removed.
+    std::vector<int> missing(stages,0);
+    std::vector<int> ready;
+    for (int s = 0; s<stages; ++s) {
+        for (std::size_t i = 0; i<fStages[s].fSources.size(); ++i) {
+            if (fStages[s].fSources[i] >= 0) ++missing[s];
+        }
+        if (missing[s] == 0) ready.push_back(s);
+    }
+    int removed = 0;
+    while (!ready.empty()) {
+        int s = ready.back();
+        ready.pop_back();
+        ++removed;
+        for (std::size_t u = 0; u<fStages[s].fUsers.size(); ++u) {
+            int user = fStages[s].fUsers[u];
+            if (--missing[user] == 0) ready.push_back(user);
+        }
+    }
+    if (removed < stages) {
+        for (int s = 0; s<stages; ++s) {
+            if (missing[s] == 0) continue;
+            CaptError("Algorithm " << fStages[s].fAlgorithm->GetName()
+                      << " is part of a cycle of inputs");
+        }
+        throw EAlgorithmCycle();
+    }
+
+    fConnected = true;
+}
+
+void CP::TAlgorithmScheduler::SetCache(CP::TAlgorithmCache* cache) {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fCache = cache;
+}
+
+void CP::TAlgorithmScheduler::Process(CP::TEvent& event) {
+    Submit(&event);
+    while (Next() != &event) continue;
+}
+
+void CP::TAlgorithmScheduler::Submit(CP::TEvent* event) {
+    if (!event) return;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        if (!fConnected) Connect();
+    }
+
+    int stages = fStages.size();
+    TEventSlot* slot = new TEventSlot;
+    slot->fEvent = event;
+    slot->fStates.resize(stages,kWaiting);
+    slot->fMissing.resize(stages,0);
+    slot->fResults.resize(stages);
+    slot->fRemaining = stages;
+
+    // Read the inputs from the event before any of the algorithms can run.
+    for (int s = 0; s<stages; ++s) {
+        const TStage& stage = fStages[s];
+        for (std::size_t i = 0; i<stage.fInputs.size(); ++i) {
+            if (stage.fSources[i] >= 0) {
+                ++slot->fMissing[s];
+                continue;
+            }
+            const std::string& path = stage.fInputs[i];
+            if (slot->fEventInputs.find(path) != slot->fEventInputs.end()) {
+                continue;
+            }
+            CP::THandle<CP::TAlgorithmResult> result;
+            if (event->Has<CP::TAlgorithmResult>(path)) {
+                result = event->Get<CP::TAlgorithmResult>(path);
+            }
+            else if (event->Has<CP::THitSelection>(path)) {
+                CP::THandle<CP::THitSelection> hits
+                    = event->Get<CP::THitSelection>(path);
+                result = CP::THandle<CP::TAlgorithmResult>(
+                    new CP::TAlgorithmResult(*hits));
+            }
+            slot->fEventInputs[path] = result;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    // Skip the algorithms that are missing an input from the event.
+    for (int s = 0; s<stages; ++s) {
+        if (slot->fStates[s] != kWaiting) continue;
+        const TStage& stage = fStages[s];
+        for (std::size_t i = 0; i<stage.fInputs.size(); ++i) {
+            if (stage.fSources[i] >= 0) continue;
+            if (slot->fEventInputs[stage.fInputs[i]]) continue;
+            CaptNamedDebug("Algorithm","Input " << stage.fInputs[i]
+                           << " for " << stage.fAlgorithm->GetName()
+                           << " is not in the event");
+            Finish(*slot, s, CP::THandle<CP::TAlgorithmResult>());
+            break;
+        }
+    }
+    fSlots.push_back(slot);
+    fWork.notify_all();
+}
+
+CP::TEvent* CP::TAlgorithmScheduler::Next() {
+    TEventSlot* slot = NULL;
+    {
+        std::unique_lock<std::mutex> lock(fMutex);
+        if (fSlots.empty()) return NULL;
+        slot = fSlots.front();
+        while (slot->fRemaining > 0) fFinished.wait(lock);
+        fSlots.pop_front();
+    }
+
+    // Add the results to the event in the order the algorithms were added.
+    CP::TEvent* event = slot->fEvent;
+    for (std::size_t s = 0; s<fStages.size(); ++s) {
+        if (!slot->fResults[s]) continue;
+        event->AddFit(slot->fResults[s]);
+    }
+    delete slot;
+    return event;
+}
+
+bool CP::TAlgorithmScheduler::IsFull() const {
+    return GetPendingCount() >= fDepth;
+}
+
+int CP::TAlgorithmScheduler::GetPendingCount() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fSlots.size();
+}
+
+int CP::TAlgorithmScheduler::GetThreadCount() const {
+    return fThreadCount;
+}
+
+const CP::TAlgorithmResult*
+CP::TAlgorithmScheduler::GetInput(const TEventSlot& slot,
+                                  const TStage& stage, int i) const {
+    int source = stage.fSources[i];
+    if (source >= 0) return GetPointer(slot.fResults[source]);
+    std::map< std::string, CP::THandle<CP::TAlgorithmResult> >::const_iterator
+        input = slot.fEventInputs.find(stage.fInputs[i]);
+    if (input == slot.fEventInputs.end()) return NULL;
+    return GetPointer(input->second);
+}
+
+void CP::TAlgorithmScheduler::Finish(
+    TEventSlot& slot, int stage, CP::THandle<CP::TAlgorithmResult> result) {
+    slot.fResults[stage] = result;
+    slot.fStates[stage] = result ? kDone: kSkipped;
+    --slot.fRemaining;
+    const std::vector<int>& users = fStages[stage].fUsers;
+    for (std::size_t u = 0; u<users.size(); ++u) {
+        int user = users[u];
+        if (slot.fStates[user] != kWaiting) continue;
+        if (result) --slot.fMissing[user];
+        else Finish(slot, user, CP::THandle<CP::TAlgorithmResult>());
+    }
+}
+
+bool CP::TAlgorithmScheduler::FindReady(TEventSlot*& slot, int& stage) {
+    for (std::size_t e = 0; e<fSlots.size(); ++e) {
+        TEventSlot* current = fSlots[e];
+        for (std::size_t s = 0; s<fStages.size(); ++s) {
+            if (current->fStates[s] != kWaiting) continue;
+            if (current->fMissing[s] > 0) continue;
+            // The algorithm must be finished with the earlier events.
+            bool busy = false;
+            for (std::size_t p = 0; p<e; ++p) {
+                EStageState state = fSlots[p]->fStates[s];
+                if (state == kWaiting || state == kRunning) busy = true;
+            }
+            if (busy) continue;
+            slot = current;
+            stage = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CP::TAlgorithmScheduler::Run() {
+    std::unique_lock<std::mutex> lock(fMutex);
+    for (;;) {
+        TEventSlot* slot = NULL;
+        int stage = -1;
+        if (!FindReady(slot,stage)) {
+            if (fStopping) return;
+            fWork.wait(lock);
+            continue;
+        }
+        slot->fStates[stage] = kRunning;
+
+        // The inputs are finished, so they won't change while the
+        // algorithm runs.  Other algorithms may be reading the same inputs,
+        // so the state built by the const methods is locked (see the class
+        // documentation).
+        const TStage& current = fStages[stage];
+        const CP::TAlgorithmResult* inputs[3] = {
+            &CP::TAlgorithmResult::Empty,
+            &CP::TAlgorithmResult::Empty,
+            &CP::TAlgorithmResult::Empty};
+        for (std::size_t i = 0; i<current.fInputs.size() && i<3; ++i) {
+            inputs[i] = GetInput(*slot,current,i);
+        }
+        CP::TEvent* event = slot->fEvent;
+        CP::TAlgorithmCache* cache = fCache;
+        lock.unlock();
+
+        CP::THandle<CP::TAlgorithmResult> result;
+        try {
+            CP::TEventFolder::TScope scope(event);
+            if (cache) {
+                result = cache->Process(*current.fAlgorithm, *inputs[0],
+                                        *inputs[1], *inputs[2]);
+            }
+            else {
+                result = current.fAlgorithm->Process(*inputs[0], *inputs[1],
+                                                     *inputs[2]);
+            }
+            if (result && current.fOutput != result->GetName()) {
+                result->SetName(current.fOutput.c_str());
+            }
+        }
+        catch (std::exception& ex) {
+            CaptError("Algorithm " << current.fAlgorithm->GetName()
+                      << " failed: " << ex.what());
+            result = CP::THandle<CP::TAlgorithmResult>();
+        }
+        catch (...) {
+            CaptError("Algorithm " << current.fAlgorithm->GetName()
+                      << " failed");
+            result = CP::THandle<CP::TAlgorithmResult>();
+        }
+
+        lock.lock();
+        Finish(*slot, stage, result);
+        fWork.notify_all();
+        fFinished.notify_all();
+    }
+}
@@ -0,0 +1,253 @@
+#ifndef TAlgorithmScheduler_hxx_seen
+#define TAlgorithmScheduler_hxx_seen
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+#ifndef __CINT__
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#include "THandle.hxx"
+#include "TAlgorithmResult.hxx"
+#include "ECore.hxx"
+
+namespace CP {
+    class TAlgorithm;
+    class TAlgorithmCache;
+    class TAlgorithmScheduler;
+    class TEvent;
+
+    /// A base exception for errors in the algorithms given to a
+    /// TAlgorithmScheduler.
+    EXCEPTION(EAlgorithmScheduler,ECore);
+
+    /// An exception thrown when the inputs of the scheduled algorithms form a
+    /// cycle.
+    EXCEPTION(EAlgorithmCycle,EAlgorithmScheduler);
+}
+
+/// Run a graph of TAlgorithm objects on events using a pool of threads.
+/// Each algorithm is added with the path of the TAlgorithmResult that it
+/// produces, and the paths of (up to three) inputs that are passed to
+/// TAlgorithm::Process.  An input is either the output of another algorithm,
+/// or an object that is already in the event (a TAlgorithmResult, or a
+/// THitSelection which is converted into a TAlgorithmResult).  Algorithms
+/// that don't depend on each other are run at the same time, and several
+/// events can be in flight so that the first algorithms work on the next
+/// event while the last algorithms finish the current one.  Each algorithm
+/// sees the events in the order they were submitted, and is only run on one
+/// event at a time, so the algorithms don't need to be reentrant.
+///
+/// \code
+/// CP::TAlgorithmScheduler scheduler;
+/// scheduler.AddAlgorithm(&tpcHits, "~/fits/tpcHits", "~/hits/drift");
+/// scheduler.AddAlgorithm(&tpcClusters, "~/fits/tpcClusters",
+///                        "~/fits/tpcHits");
+/// scheduler.AddAlgorithm(&pdsHits, "~/fits/pdsHits", "~/hits/pmt");
+/// scheduler.AddAlgorithm(&match, "~/fits/match",
+///                        "~/fits/tpcClusters", "~/fits/pdsHits");
+///
+/// // Process a single event.
+/// scheduler.Process(*event);
+///
+/// // Or, keep several events in flight.
+/// for (;;) {
+///     CP::TEvent* event = input.NextEvent();
+///     if (event) scheduler.Submit(event);
+///     if (event && !scheduler.IsFull()) continue;
+///     CP::TEvent* done = scheduler.Next();
+///     if (!done) break;
+///     output.WriteEvent(*done);
+///     delete done;
+/// }
+/// \endcode
+///
+/// The results are added to the event (with TEvent::AddFit) when the event
+/// is returned by Next(), and are added in the order the algorithms were
+/// added to the scheduler, so the output doesn't depend on the thread
+/// timing.  If an algorithm throws an exception, doesn't return a result,
+/// or is missing an input, the algorithms that need its output are not run
+/// for that event.
+///
+/// While an algorithm is running, TAlgorithm::GetEvent() returns the event
+/// being processed (see TEventFolder::TScope).  Since other algorithms are
+/// running on the same event, an algorithm must take its input from the
+/// arguments to Process and must not change the event.  The events are
+/// owned by the caller.
+///
+/// Algorithms that use the same input are run at the same time, so the
+/// inputs must only be read.  The state that is built when the inputs are
+/// read (the THitSelection and TDataVector indexes, the geometry
+/// identifier map, and the hit geometry in TSingleHit) is built under a
+/// lock so that it can be shared by the algorithms.
+///
+/// If a TAlgorithmCache is given to SetCache(), the algorithms are run with
+/// TAlgorithmCache::Process so an algorithm is skipped when its result for
+/// the same inputs and configuration is already in the cache.
+class CP::TAlgorithmScheduler {
+public:
+    /// Create a scheduler that runs the algorithms on "threads" threads (the
+    /// number of cores if threads is less than one).  The scheduler is full
+    /// (see IsFull()) when "depth" events are in flight.
+    explicit TAlgorithmScheduler(int threads = 0, int depth = 2);
+
+    /// Finish the events that are in flight and stop the threads.
+    ~TAlgorithmScheduler();
+
+    /// Add an algorithm that makes the result at the output path, using the
+    /// results at the input paths.  The output path is "~/fits/<name>" (or
+    /// just "<name>"), and the result returned by the algorithm is renamed
+    /// to match.  The inputs are given to TAlgorithm::Process in order, and
+    /// empty inputs are ignored.  The algorithm is not owned by the
+    /// scheduler, and may only be added once.  The algorithms must all be
+    /// added before the first event is submitted.
+    void AddAlgorithm(CP::TAlgorithm* algorithm,
+                      const std::string& output,
+                      const std::string& input = "",
+                      const std::string& input1 = "",
+                      const std::string& input2 = "");
+
+    /// Use a cache for the algorithm results.  The cache is not owned by the
+    /// scheduler, and may be NULL to always run the algorithms.
+    void SetCache(CP::TAlgorithmCache* cache);
+
+    /// Run the algorithms on an event, and wait until they are finished.
+    /// Any events that were submitted earlier are finished first.
+    void Process(CP::TEvent& event);
+
+    /// Start running the algorithms on an event.  This doesn't wait, and
+    /// the event must not be used by the caller until it's returned by
+    /// Next().  The graph of algorithms is checked when the first event is
+    /// submitted, and an EAlgorithmCycle exception is thrown if it has a
+    /// cycle.
+    void Submit(CP::TEvent* event);
+
+    /// Wait for the oldest event that was submitted to be finished, add the
+    /// results to it, and return it.  This returns NULL if there aren't any
+    /// events in flight.
+    CP::TEvent* Next();
+
+    /// Check if the number of events in flight has reached the depth.
+    bool IsFull() const;
+
+    /// Get the number of events that have been submitted, but not returned
+    /// by Next().
+    int GetPendingCount() const;
+
+    /// Get the number of threads running the algorithms.
+    int GetThreadCount() const;
+
+private:
+    TAlgorithmScheduler(const TAlgorithmScheduler&);
+    TAlgorithmScheduler& operator = (const TAlgorithmScheduler&);
+
+    /// The states of an algorithm for an event.
+    enum EStageState {kWaiting, kRunning, kDone, kSkipped};
+
+    /// An algorithm with its inputs and output.
+    struct TStage {
+        /// The algorithm (not owned).
+        CP::TAlgorithm* fAlgorithm;
+
+        /// The name of the result.
+        std::string fOutput;
+
+        /// The paths of the inputs.
+        std::vector<std::string> fInputs;
+
+        /// The stage that makes each input, or -1 if the input is read
+        /// from the event.
+        std::vector<int> fSources;
+
+        /// The stages that use the output of this stage.
+        std::vector<int> fUsers;
+    };
+
+    /// The state of an event that is in flight.
+    struct TEventSlot {
+        /// The event (not owned).
+        CP::TEvent* fEvent;
+
+        /// The state of each stage.
+        std::vector<EStageState> fStates;
+
+        /// The number of stage inputs that aren't finished yet.
+        std::vector<int> fMissing;
+
+        /// The result of each stage.
+        std::vector< CP::THandle<CP::TAlgorithmResult> > fResults;
+
+        /// The inputs that are read from the event, indexed by path.
+        std::map< std::string, CP::THandle<CP::TAlgorithmResult> >
+        fEventInputs;
+
+        /// The number of stages that haven't finished.
+        int fRemaining;
+    };
+
+    /// Make the canonical path for a result made by one of the stages.
+    static std::string FitPath(const std::string& name);
+
+    /// Connect the stage inputs to the stage outputs, and check for cycles.
+    void Connect();
+
+    /// Find the input for a stage.  If the input isn't available, this
+    /// returns NULL.
+    const CP::TAlgorithmResult* GetInput(const TEventSlot& slot,
+                                         const TStage& stage, int i) const;
+
+    /// Finish a stage for an event.  If the stage didn't make a result, the
+    /// stages that use it are skipped.  The mutex must be held.
+    void Finish(TEventSlot& slot, int stage,
+                CP::THandle<CP::TAlgorithmResult> result);
+
+#ifndef __CINT__
+    /// Find a stage that can be run.  The mutex must be held.
+    bool FindReady(TEventSlot*& slot, int& stage);
+
+    /// The body of each thread.
+    void Run();
+
+    /// The algorithms in the order they were added.
+    std::vector<TStage> fStages;
+
+    /// The stage indexed by the output path.
+    std::map<std::string,int> fOutputs;
+
+    /// The cache for the algorithm results (not owned), or NULL.
+    CP::TAlgorithmCache* fCache;
+
+    /// True after the stage inputs have been connected.
+    bool fConnected;
+
+    /// The events in flight in the order they were submitted.
+    std::deque<TEventSlot*> fSlots;
+
+    /// The number of events in flight when the scheduler is full.
+    int fDepth;
+
+    /// The number of threads.
+    int fThreadCount;
+
+    /// Protect the stages and events.
+    mutable std::mutex fMutex;
+
+    /// Wake the threads when a stage might be ready to run.
+    std::condition_variable fWork;
+
+    /// Wake Next() when a stage has finished.
+    std::condition_variable fFinished;
+
+    /// Set to stop the threads.
+    bool fStopping;
+
+    /// The threads running the algorithms.
+    std::vector<std::thread> fThreads;
+#endif
+};
+#endif
@@ -0,0 +1,438 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "TBinaryLog.hxx"
+
+std::atomic<int> CP::TBinaryLog::fLevel(CP::TCaptLog::SilentLevel);
+
+namespace {
+    /// One message in the ring buffer.  The sequence number is zero while
+    /// the slot is being written, and is set last so a slot that is dumped
+    /// while it's being written can be skipped.
+    struct Slot {
+        std::atomic<unsigned long long> fSequence;
+        unsigned long long fTime;
+        unsigned short fSite;
+        unsigned short fThread;
+        unsigned char fCount;
+        unsigned char fLength;
+        unsigned char fPadding[2];
+        unsigned char fPayload[CP::TBinaryLog::kPayloadSize];
+    };
+    static_assert(sizeof(Slot) == CP::TBinaryLog::kSlotSize,
+                  "Binary log slot has the wrong size");
+
+    /// The magic string at the start of a dump file, and the format
+    /// version.
+    const char kMagic[8] = {'C','A','P','T','B','L','O','G'};
+    const unsigned int kVersion = 1;
+
+    /// The ring buffer, and the mask to turn a sequence number into a slot
+    /// index.  The ring is never deleted since messages can be written by
+    /// other threads at any time.
+    std::atomic<Slot*> gRing(NULL);
+    unsigned long long gMask = 0;
+
+    /// The sequence number of the next message.
+    std::atomic<unsigned long long> gNext(0);
+
+    /// The registered call sites.
+    typedef std::atomic<const CP::TBinaryLog::TSite*> SitePointer;
+    SitePointer gSites[CP::TBinaryLog::kMaxSites];
+    std::atomic<int> gSiteCount(0);
+
+    /// The file that the ring is dumped into.  This is a fixed buffer so it
+    /// can be used from a signal handler.
+    char gDumpFile[4096] = {0};
+
+    /// Dump the ring when an ECore exception is created.
+    std::atomic<bool> gDumpOnException(false);
+
+    /// The sequence number of the slot being written by this thread.
+    thread_local unsigned long long tSequence = 0;
+
+    /// A small number for each thread that writes a message.
+    std::atomic<unsigned short> gThreadCount(0);
+    thread_local unsigned short tThread = 0;
+
+    /// The signals that cause the ring to be dumped, and the handlers that
+    /// were installed before.
+    const int kSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+    const int kSignalCount = sizeof(kSignals)/sizeof(kSignals[0]);
+    struct sigaction gPreviousActions[kSignalCount];
+    bool gHandlersInstalled = false;
+    volatile sig_atomic_t gCrashDumped = 0;
+
+    void CrashHandler(int signal) {
+        if (!gCrashDumped) {
+            gCrashDumped = 1;
+            CP::TBinaryLog::Dump();
+        }
+        // Pass the signal to the previous handler (usually the default
+        // action).
+        for (int i = 0; i<kSignalCount; ++i) {
+            if (kSignals[i] != signal) continue;
+            sigaction(signal, &gPreviousActions[i], NULL);
+        }
+        raise(signal);
+    }
+
+    void InstallHandlers() {
+        if (gHandlersInstalled) return;
+        gHandlersInstalled = true;
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = CrashHandler;
+        sigemptyset(&action.sa_mask);
+        for (int i = 0; i<kSignalCount; ++i) {
+            sigaction(kSignals[i], &action, &gPreviousActions[i]);
+        }
+    }
+
+    /// Write a buffer to a file descriptor using only signal safe calls.
+    bool WriteAll(int fd, const void* data, std::size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t written = write(fd, bytes, size);
+            if (written < 0) return false;
+            bytes += written;
+            size -= written;
+        }
+        return true;
+    }
+
+    bool WriteWord(int fd, unsigned int word) {
+        return WriteAll(fd, &word, sizeof(word));
+    }
+
+    bool ReadWord(std::istream& input, unsigned int& word) {
+        input.read(reinterpret_cast<char*>(&word), sizeof(word));
+        return input.good();
+    }
+
+    bool ReadString(std::istream& input, unsigned int length,
+                    std::string& value) {
+        value.assign(length, ' ');
+        if (length > 0) input.read(&value[0], length);
+        return input.good();
+    }
+
+    /// A call site read from a dump file.
+    struct DecodedSite {
+        DecodedSite() : fLevel(0), fLine(0) {}
+        unsigned int fLevel;
+        unsigned int fLine;
+        std::string fFile;
+        std::string fFormat;
+    };
+
+    const char* LevelName(unsigned int level) {
+        switch (level) {
+        case CP::TCaptLog::ErrorLevel: return "ERROR";
+        case CP::TCaptLog::SevereLevel: return "SEVERE";
+        case CP::TCaptLog::WarnLevel: return "WARNING";
+        case CP::TCaptLog::DebugLevel: return "DEBUG";
+        case CP::TCaptLog::TraceLevel: return "TRACE";
+        }
+        return "UNKNOWN";
+    }
+
+    /// Decode the arguments in a payload as text.  This returns false if
+    /// the payload is corrupted.
+    bool DecodeArguments(const unsigned char* payload, unsigned int length,
+                         unsigned int count,
+                         std::vector<std::string>& arguments) {
+        unsigned int position = 0;
+        for (unsigned int i = 0; i<count; ++i) {
+            if (position >= length) return false;
+            unsigned char type = payload[position++];
+            std::ostringstream text;
+            std::size_t size = 0;
+            switch (type) {
+            case 'i': {
+                long long value;
+                size = sizeof(value);
+                if (position + size > length) return false;
+                std::memcpy(&value, payload+position, size);
+                text << value;
+                break;
+            }
+            case 'u': {
+                unsigned long long value;
+                size = sizeof(value);
+                if (position + size > length) return false;
+                std::memcpy(&value, payload+position, size);
+                text << value;
+                break;
+            }
+            case 'd': {
+                double value;
+                size = sizeof(value);
+                if (position + size > length) return false;
+                std::memcpy(&value, payload+position, size);
+                text << value;
+                break;
+            }
+            case 'p': {
+                unsigned long long value;
+                size = sizeof(value);
+                if (position + size > length) return false;
+                std::memcpy(&value, payload+position, size);
+                text << "0x" << std::hex << value;
+                break;
+            }
+            case 't':
+                // The arguments after this didn't fit in the payload.
+                text << "...";
+                break;
+            case 'b':
+                size = 1;
+                if (position + size > length) return false;
+                text << (payload[position] ? "true" : "false");
+                break;
+            case 'c':
+                size = 1;
+                if (position + size > length) return false;
+                text << static_cast<char>(payload[position]);
+                break;
+            case 's':
+                if (position >= length) return false;
+                size = payload[position++];
+                if (position + size > length) return false;
+                text << std::string(
+                    reinterpret_cast<const char*>(payload+position), size);
+                break;
+            default:
+                return false;
+            }
+            position += size;
+            arguments.push_back(text.str());
+        }
+        return true;
+    }
+
+    /// Replace each "{}" in the format with the next argument.  Arguments
+    /// without a "{}" are added to the end.
+    std::string FormatMessage(const std::string& format,
+                              const std::vector<std::string>& arguments) {
+        std::string result;
+        std::size_t next = 0;
+        std::size_t position = 0;
+        for (;;) {
+            std::size_t mark = format.find("{}", position);
+            if (mark == std::string::npos || next >= arguments.size()) {
+                result += format.substr(position);
+                break;
+            }
+            result += format.substr(position, mark-position);
+            result += arguments[next++];
+            position = mark + 2;
+        }
+        for (; next < arguments.size(); ++next) {
+            result += " ";
+            result += arguments[next];
+        }
+        return result;
+    }
+}
+
+CP::TBinaryLog::TSite::TSite(CP::TCaptLog::ErrorPriority level,
+                             const char* file, int line, const char* format)
+    : fLevel(level), fFile(file), fLine(line), fFormat(format), fId(-1) {
+    int id = gSiteCount.fetch_add(1);
+    if (id >= kMaxSites) return;
+    fId = id;
+    gSites[id].store(this, std::memory_order_release);
+}
+
+void CP::TBinaryLog::Open(const char* dumpFile, int slotCount,
+                          CP::TCaptLog::ErrorPriority level) {
+    if (!gRing.load()) {
+        unsigned long long size = 1;
+        while (size < static_cast<unsigned long long>(slotCount)) size *= 2;
+        Slot* ring = new Slot[size];
+        for (unsigned long long i = 0; i<size; ++i) {
+            ring[i].fSequence.store(0, std::memory_order_relaxed);
+        }
+        gMask = size - 1;
+        gRing.store(ring, std::memory_order_release);
+    }
+    gDumpFile[0] = 0;
+    if (dumpFile) {
+        std::strncpy(gDumpFile, dumpFile, sizeof(gDumpFile)-1);
+        gDumpFile[sizeof(gDumpFile)-1] = 0;
+    }
+    InstallHandlers();
+    SetLevel(level);
+}
+
+void CP::TBinaryLog::Close() {
+    fLevel.store(CP::TCaptLog::SilentLevel);
+}
+
+void CP::TBinaryLog::SetLevel(CP::TCaptLog::ErrorPriority level) {
+    if (!gRing.load()) return;
+    fLevel.store(level);
+}
+
+CP::TCaptLog::ErrorPriority CP::TBinaryLog::GetLevel() {
+    return CP::TCaptLog::ErrorPriority(fLevel.load());
+}
+
+void CP::TBinaryLog::SetDumpOnException(bool dump) {
+    gDumpOnException = dump;
+}
+
+void CP::TBinaryLog::DumpForException() {
+    if (!gDumpOnException.load(std::memory_order_relaxed)) return;
+    Dump();
+}
+
+unsigned char* CP::TBinaryLog::BeginRecord() {
+    Slot* ring = gRing.load(std::memory_order_acquire);
+    if (!ring) return NULL;
+    tSequence = gNext.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring[tSequence & gMask];
+    slot.fSequence.store(0, std::memory_order_release);
+    return slot.fPayload;
+}
+
+void CP::TBinaryLog::EndRecord(const TSite& site, const TEncoder& encoder) {
+    Slot& slot = gRing.load(std::memory_order_relaxed)[tSequence & gMask];
+    if (!tThread) tThread = ++gThreadCount;
+    slot.fTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    slot.fSite = site.GetId();
+    slot.fThread = tThread;
+    slot.fCount = encoder.GetCount();
+    slot.fLength = encoder.GetLength();
+    slot.fSequence.store(tSequence+1, std::memory_order_release);
+}
+
+bool CP::TBinaryLog::Dump() {
+    if (!gDumpFile[0]) return false;
+    return Dump(gDumpFile);
+}
+
+bool CP::TBinaryLog::Dump(const char* fileName) {
+    Slot* ring = gRing.load(std::memory_order_acquire);
+    if (!ring || !fileName) return false;
+    int fd = open(fileName, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    unsigned int slotCount = gMask + 1;
+    unsigned int siteCount = std::min(gSiteCount.load(), (int) kMaxSites);
+    bool ok = WriteAll(fd, kMagic, sizeof(kMagic))
+        && WriteWord(fd, kVersion)
+        && WriteWord(fd, kSlotSize)
+        && WriteWord(fd, slotCount)
+        && WriteWord(fd, siteCount);
+    for (unsigned int i = 0; ok && i<siteCount; ++i) {
+        const TSite* site = gSites[i].load(std::memory_order_acquire);
+        const char* file = site ? site->GetFile() : "";
+        const char* format = site ? site->GetFormat() : "";
+        unsigned int fileLength = std::strlen(file);
+        unsigned int formatLength = std::strlen(format);
+        ok = WriteWord(fd, site ? site->GetLevel() : 0)
+            && WriteWord(fd, site ? site->GetLine() : 0)
+            && WriteWord(fd, fileLength)
+            && WriteWord(fd, formatLength)
+            && WriteAll(fd, file, fileLength)
+            && WriteAll(fd, format, formatLength);
+    }
+    if (ok) ok = WriteAll(fd, ring, slotCount*sizeof(Slot));
+    if (close(fd) != 0) ok = false;
+    return ok;
+}
+
+bool CP::TBinaryLog::Decode(std::istream& input, std::ostream& output) {
+    char magic[sizeof(kMagic)];
+    input.read(magic, sizeof(magic));
+    if (!input.good() || std::memcmp(magic, kMagic, sizeof(magic)) != 0) {
+        return false;
+    }
+    unsigned int version = 0;
+    unsigned int slotSize = 0;
+    unsigned int slotCount = 0;
+    unsigned int siteCount = 0;
+    if (!ReadWord(input, version) || version != kVersion) return false;
+    if (!ReadWord(input, slotSize) || slotSize != kSlotSize) return false;
+    if (!ReadWord(input, slotCount)) return false;
+    if (!ReadWord(input, siteCount)) return false;
+
+    std::vector<DecodedSite> sites(siteCount);
+    for (unsigned int i = 0; i<siteCount; ++i) {
+        unsigned int fileLength = 0;
+        unsigned int formatLength = 0;
+        if (!ReadWord(input, sites[i].fLevel)
+            || !ReadWord(input, sites[i].fLine)
+            || !ReadWord(input, fileLength)
+            || !ReadWord(input, formatLength)
+            || !ReadString(input, fileLength, sites[i].fFile)
+            || !ReadString(input, formatLength, sites[i].fFormat)) {
+            return false;
+        }
+    }
+
+    // Read the slots and sort the ones holding messages by sequence.
+    std::vector<unsigned char> raw(static_cast<std::size_t>(slotCount)
+                                   * kSlotSize);
+    if (!raw.empty()) {
+        input.read(reinterpret_cast<char*>(&raw[0]), raw.size());
+        if (input.gcount() != static_cast<std::streamsize>(raw.size())) {
+            return false;
+        }
+    }
+    std::vector< std::pair<unsigned long long, std::size_t> > messages;
+    for (std::size_t i = 0; i<slotCount; ++i) {
+        unsigned long long sequence;
+        std::memcpy(&sequence, &raw[i*kSlotSize] + offsetof(Slot,fSequence),
+                    sizeof(sequence));
+        if (sequence == 0) continue;
+        messages.push_back(std::make_pair(sequence, i*kSlotSize));
+    }
+    std::sort(messages.begin(), messages.end());
+
+    if (!messages.empty() && messages.front().first > 1) {
+        output << "# " << messages.front().first - 1
+               << " earlier messages were overwritten" << std::endl;
+    }
+    for (std::size_t i = 0; i<messages.size(); ++i) {
+        const unsigned char* slot = &raw[messages[i].second];
+        unsigned long long time;
+        unsigned short site;
+        unsigned short thread;
+        std::memcpy(&time, slot + offsetof(Slot,fTime), sizeof(time));
+        std::memcpy(&site, slot + offsetof(Slot,fSite), sizeof(site));
+        std::memcpy(&thread, slot + offsetof(Slot,fThread), sizeof(thread));
+        unsigned int count = slot[offsetof(Slot,fCount)];
+        unsigned int length = slot[offsetof(Slot,fLength)];
+        std::vector<std::string> arguments;
+        if (site >= sites.size()
+            || length > kPayloadSize
+            || !DecodeArguments(slot + offsetof(Slot,fPayload), length,
+                                count, arguments)) {
+            output << "# Corrupted message " << messages[i].first
+                   << std::endl;
+            continue;
+        }
+        output << "[" << time/1000000000ULL << "."
+               << std::setw(6) << std::setfill('0')
+               << (time%1000000000ULL)/1000
+               << std::setfill(' ')
+               << " " << thread << "] "
+               << LevelName(sites[site].fLevel) << ": "
+               << sites[site].fFile << ":" << sites[site].fLine << ": "
+               << FormatMessage(sites[site].fFormat, arguments)
+               << std::endl;
+    }
+    return true;
+}
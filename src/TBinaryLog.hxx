@@ -0,0 +1,281 @@
+#ifndef TBinaryLog_hxx_seen
+#define TBinaryLog_hxx_seen
+
+#include <iostream>
+#include <string>
+
+#include "TCaptLog.hxx"
+
+#ifndef __CINT__
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#endif
+
+namespace CP {
+    class TBinaryLog;
+}
+
+/// A binary record of diagnostic messages that is kept in memory, and only
+/// turned into text after the fact.  The CaptBinaryDebug() macros (and the
+/// Severe, Warn and Trace variants) don't format any text.  The message
+/// format string, the file and the line are registered once for each call
+/// site, and each execution of the macro copies the site number, a time
+/// stamp and the raw bytes of the arguments into a fixed size slot of a
+/// ring buffer.  The ring holds the most recent messages, and is written to
+/// a dump file when the program crashes (on SIGSEGV, SIGBUS, SIGFPE, SIGILL
+/// or SIGABRT), when an ECore exception is created (if enabled with
+/// SetDumpOnException()), or when Dump() is called.  The dump file is
+/// turned into text with the decode-binary-log application (or Decode()).
+///
+/// \code
+/// CP::TBinaryLog::Open("binary-log.dump");
+/// ...
+/// CaptBinaryDebug("volume {} at {} cm", volume->GetName(), x/unit::cm);
+/// \endcode
+///
+/// Each "{}" in the format is replaced by the next argument when the
+/// message is decoded.  The arguments can be integers, floating point
+/// numbers, booleans, strings (const char* or std::string), and pointers
+/// (saved as the address).  The arguments are limited to the payload size
+/// of a slot (kPayloadSize bytes), so long strings are truncated, and when
+/// an argument doesn't fit, it and the following arguments are dropped and
+/// decoded as "...".  The
+/// messages are recorded when the error level passed to Open() (or
+/// SetLevel()) is at least the level of the macro, independent of the
+/// TCaptLog levels, so the binary log can record debugging messages in a
+/// production job that only writes log level text.
+class CP::TBinaryLog {
+public:
+    /// The size of a slot in the ring buffer.
+    enum {kSlotSize = 64};
+
+    /// The number of bytes in a slot used for the arguments.
+    enum {kPayloadSize = 40};
+
+    /// The maximum number of call sites that can be registered.
+    enum {kMaxSites = 4096};
+
+    /// Start recording messages into a ring buffer with space for (at
+    /// least) slotCount messages, and set the file that the ring is dumped
+    /// into.  This installs the handlers that dump the ring when the program
+    /// crashes.  The ring buffer is only allocated the first time that
+    /// Open() is called, so later calls only change the file and level.
+    static void Open(const char* dumpFile,
+                     int slotCount = 65536,
+                     CP::TCaptLog::ErrorPriority level
+                     = CP::TCaptLog::DebugLevel);
+
+    /// Stop recording messages.  The messages in the ring can still be
+    /// dumped.
+    static void Close();
+
+    /// Set the most verbose level of message that is recorded.
+    static void SetLevel(CP::TCaptLog::ErrorPriority level);
+
+    /// Get the level of messages being recorded.  This is SilentLevel
+    /// when the log isn't open.
+    static CP::TCaptLog::ErrorPriority GetLevel();
+
+    /// Dump the ring each time an ECore exception is created.
+    static void SetDumpOnException(bool dump);
+
+    /// Write the ring to the dump file given to Open().  This only uses
+    /// functions that can be called from a signal handler, and returns false
+    /// if the file couldn't be written.
+    static bool Dump();
+
+    /// Write the ring to a file.
+    static bool Dump(const char* fileName);
+
+    /// Read a dump file and write the messages as text, from the oldest to
+    /// the most recent.  This returns false if the input isn't a dump file.
+    static bool Decode(std::istream& input, std::ostream& output);
+
+    /// [Internal method] Called by the ECore constructor to dump the ring
+    /// if SetDumpOnException() has been set.
+    static void DumpForException();
+
+#ifndef __CINT__
+    /// [Internal method] Check if a message at a level is being recorded.
+    static bool IsRecording(CP::TCaptLog::ErrorPriority level) {
+        return level <= fLevel.load(std::memory_order_relaxed);
+    }
+
+    /// [Internal class] A call site of a binary log macro.  The site is
+    /// registered the first time the macro is executed, and the site number
+    /// is saved in each message.
+    class TSite {
+    public:
+        TSite(CP::TCaptLog::ErrorPriority level, const char* file, int line,
+              const char* format);
+
+        /// The site number (negative if too many sites are registered).
+        int GetId() const {return fId;}
+
+        CP::TCaptLog::ErrorPriority GetLevel() const {return fLevel;}
+        const char* GetFile() const {return fFile;}
+        int GetLine() const {return fLine;}
+        const char* GetFormat() const {return fFormat;}
+
+    private:
+        CP::TCaptLog::ErrorPriority fLevel;
+        const char* fFile;
+        int fLine;
+        const char* fFormat;
+        int fId;
+    };
+
+    /// [Internal class] Copy the arguments of a message into the payload of
+    /// a slot.  Each argument is saved as a type code followed by the value.
+    /// The last byte of the payload is kept for a marker that is saved when
+    /// an argument doesn't fit, and the arguments after that are dropped so
+    /// that a later argument can't take the place of a dropped one.
+    class TEncoder {
+    public:
+        TEncoder(unsigned char* payload)
+            : fPayload(payload), fLength(0), fCount(0), fFull(false) {}
+
+        void Add(const char* value) {
+            if (!value) value = "(null)";
+            if (fFull) return;
+            if (fLength + 3 > kPayloadSize) {
+                Truncate();
+                return;
+            }
+            std::size_t length = std::strlen(value);
+            std::size_t room = kPayloadSize - fLength - 3;
+            if (length > room) length = room;
+            fPayload[fLength++] = 's';
+            fPayload[fLength++] = length;
+            std::memcpy(fPayload + fLength, value, length);
+            fLength += length;
+            ++fCount;
+        }
+        void Add(char* value) {Add(static_cast<const char*>(value));}
+        void Add(const std::string& value) {Add(value.c_str());}
+        void Add(char value) {AddBytes('c', &value, 1);}
+        void Add(double value) {AddBytes('d', &value, sizeof(value));}
+        void Add(float value) {Add(static_cast<double>(value));}
+        void Add(long double value) {Add(static_cast<double>(value));}
+
+        /// Only a bool is saved as a bool.  Other types that convert to a
+        /// bool (e.g. pointers) don't silently match this.
+        template <typename T>
+        typename std::enable_if<std::is_same<T,bool>::value>::type
+        Add(T value) {AddBytes('b', &value, 1);}
+
+        /// Integers (and enums) are saved as 64 bit values.
+        template <typename T>
+        typename std::enable_if<(std::is_integral<T>::value
+                                 && !std::is_same<T,bool>::value)
+                                || std::is_enum<T>::value>::type
+        Add(T value) {
+            if (std::is_signed<T>::value) {
+                long long v = value;
+                AddBytes('i', &v, sizeof(v));
+            }
+            else {
+                unsigned long long v = value;
+                AddBytes('u', &v, sizeof(v));
+            }
+        }
+
+        /// Pointers (other than strings) are saved as the address.
+        template <typename T>
+        void Add(const T* value) {
+            unsigned long long v = reinterpret_cast<std::uintptr_t>(value);
+            AddBytes('p', &v, sizeof(v));
+        }
+
+        /// The number of bytes used.
+        unsigned int GetLength() const {return fLength;}
+
+        /// The number of arguments saved (including the marker for dropped
+        /// arguments).
+        unsigned int GetCount() const {return fCount;}
+
+    private:
+        void AddBytes(unsigned char type, const void* bytes,
+                      std::size_t size) {
+            if (fFull) return;
+            if (fLength + 2 + size > kPayloadSize) {
+                Truncate();
+                return;
+            }
+            fPayload[fLength++] = type;
+            std::memcpy(fPayload + fLength, bytes, size);
+            fLength += size;
+            ++fCount;
+        }
+
+        /// Save the marker for the dropped arguments, and ignore the rest.
+        void Truncate() {
+            fPayload[fLength++] = 't';
+            ++fCount;
+            fFull = true;
+        }
+
+        unsigned char* fPayload;
+        unsigned int fLength;
+        unsigned int fCount;
+        bool fFull;
+    };
+
+    /// [Internal method] Record a message from a call site.
+    template <typename... Args>
+    static void Write(const TSite& site, const Args&... args) {
+        if (site.GetId() < 0) return;
+        unsigned char* payload = BeginRecord();
+        if (!payload) return;
+        TEncoder encoder(payload);
+        int expand[] = {0, (encoder.Add(args), 0)...};
+        (void) expand;
+        EndRecord(site, encoder);
+    }
+
+private:
+    /// Claim the next slot in the ring and return the payload, or NULL if
+    /// the log isn't open.
+    static unsigned char* BeginRecord();
+
+    /// Finish the slot claimed by BeginRecord().
+    static void EndRecord(const TSite& site, const TEncoder& encoder);
+
+    /// The level of the messages being recorded.
+    static std::atomic<int> fLevel;
+#endif
+};
+
+#ifndef __CINT__
+/// INTERNAL: A macro to record a message in the binary log.  This is used
+/// by the user visible macros.
+#define _CAPT_BINARY(level,format,...)                                  \
+    do {                                                                \
+        if (CP::TBinaryLog::IsRecording(level)) {                       \
+            static const CP::TBinaryLog::TSite _captSite(               \
+                level, __FILE__, __LINE__, format);                     \
+            CP::TBinaryLog::Write(_captSite, ##__VA_ARGS__);            \
+        }                                                               \
+    } while (0)
+
+/// Record a message at the CP::TCaptLog::SevereLevel in the binary log.
+/// This takes a format string with a "{}" for each of the following
+/// arguments.
+#define CaptBinarySevere(format,...)                                    \
+    _CAPT_BINARY(CP::TCaptLog::SevereLevel, format, ##__VA_ARGS__)
+
+/// Record a message at the CP::TCaptLog::WarnLevel in the binary log.
+#define CaptBinaryWarn(format,...)                                      \
+    _CAPT_BINARY(CP::TCaptLog::WarnLevel, format, ##__VA_ARGS__)
+
+/// Record a message at the CP::TCaptLog::DebugLevel in the binary log.
+#define CaptBinaryDebug(format,...)                                     \
+    _CAPT_BINARY(CP::TCaptLog::DebugLevel, format, ##__VA_ARGS__)
+
+/// Record a message at the CP::TCaptLog::TraceLevel in the binary log.
+#define CaptBinaryTrace(format,...)                                     \
+    _CAPT_BINARY(CP::TCaptLog::TraceLevel, format, ##__VA_ARGS__)
+#endif
+#endif
@@ -1,6 +1,13 @@
 #include <vector>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cstdlib>
 #include <time.h>
 
 #include "TCaptLog.hxx"
@@ -11,17 +18,52 @@ std::ostream* CP::TCaptLog::fDebugStream = NULL;
 std::ostream* CP::TCaptLog::fLogStream = NULL;
 std::map<std::string,CP::TCaptLog::ErrorPriority> CP::TCaptLog::fErrorTraces;
 std::map<std::string,CP::TCaptLog::LogPriority> CP::TCaptLog::fLogTraces;
-int CP::TCaptLog::fIndentation = 0;
+std::atomic<unsigned int> CP::TCaptLog::fGeneration(1);
 
 CP::TCaptLog::TCaptLog() { }
 CP::TCaptLog::~TCaptLog() { }
 
+namespace {
+    /// Protect the maps of trace levels.  This is never deleted so that the
+    /// levels can be used during the program exit.
+    std::mutex& TraceMutex() {
+        static std::mutex* mutex = new std::mutex;
+        return *mutex;
+    }
+}
+
+void CP::TCaptLog::InvalidateTraces() {
+    unsigned int generation = (fGeneration.load() + 1) & 0xFFFFFF;
+    if (generation == 0) generation = 1;
+    fGeneration.store(generation, std::memory_order_release);
+}
+
+unsigned int CP::TCaptLog::TTraceSite::Refresh() const {
+    // The generation is read before the levels, so a level that is changed
+    // during the look up will cause another look up.
+    unsigned int generation = fGeneration.load(std::memory_order_acquire);
+    unsigned int levels = (generation << 8)
+        | (CP::TCaptLog::GetLogLevel(fTrace) << 4)
+        | CP::TCaptLog::GetDebugLevel(fTrace);
+    fLevels.store(levels, std::memory_order_release);
+    return levels;
+}
+
+void CP::TCaptLog::SetDebugLevel(CP::TCaptLog::ErrorPriority level) {
+    std::lock_guard<std::mutex> lock(TraceMutex());
+    fErrorPriority = level;
+    InvalidateTraces();
+}
+
 void CP::TCaptLog::SetDebugLevel(const char* trace, 
                               CP::TCaptLog::ErrorPriority level) {
+    std::lock_guard<std::mutex> lock(TraceMutex());
     fErrorTraces[trace] = level;
+    InvalidateTraces();
 }
 
 CP::TCaptLog::ErrorPriority CP::TCaptLog::GetDebugLevel(const char* trace) {
+    std::lock_guard<std::mutex> lock(TraceMutex());
     std::map<std::string,ErrorPriority>::iterator elem = fErrorTraces.find(trace);
     if (elem == fErrorTraces.end()) return fErrorPriority;
     return elem->second;
@@ -48,7 +90,323 @@ namespace {
     }
 }
 
+namespace {
+    /// The indentation of the log messages written by this thread.
+    thread_local int tIndentation = 0;
+
+    /// The buffers used to format the messages written by this thread.  A
+    /// message can be written while another message is being formatted, so
+    /// the buffers are used as a stack.
+    struct RecordBuffers {
+        RecordBuffers() : fDepth(0) {}
+        ~RecordBuffers() {
+            for (std::size_t i = 0; i<fStreams.size(); ++i) {
+                delete fStreams[i];
+            }
+        }
+
+        /// The streams that have been allocated.
+        std::vector<std::ostringstream*> fStreams;
+
+        /// The number of streams in use.
+        std::size_t fDepth;
+
+        /// A stream with the default formatting.  This is copied into a
+        /// buffer before it is reused.
+        std::ostringstream fDefault;
+    };
+
+    /// The buffers for this thread.  These are deleted by RecordBufferOwner
+    /// when the thread exits.  A message written after that (e.g. from a
+    /// static destructor) allocates new buffers that are never deleted.
+    thread_local RecordBuffers* tRecordBuffers = NULL;
+
+    struct RecordBufferOwner {
+        ~RecordBufferOwner() {
+            delete tRecordBuffers;
+            tRecordBuffers = NULL;
+        }
+    };
+    thread_local RecordBufferOwner tRecordBufferOwner;
+
+    RecordBuffers& GetRecordBuffers() {
+        if (!tRecordBuffers) {
+            tRecordBuffers = new RecordBuffers;
+            (void) &tRecordBufferOwner;
+        }
+        return *tRecordBuffers;
+    }
+
+    /// Serialize the records written to the log and error streams.  This is
+    /// never deleted so that messages can be written during the program
+    /// exit.
+    std::mutex& OutputMutex() {
+        static std::mutex* mutex = new std::mutex;
+        return *mutex;
+    }
+
+    /// A record waiting to be written by the writer thread.  A record
+    /// without a stream is a marker added by AsyncWriter::Flush() and
+    /// belongs to the thread waiting for it.
+    struct QueuedRecord {
+        QueuedRecord() : fNext(NULL), fStream(NULL), fDone(false) {}
+        std::atomic<QueuedRecord*> fNext;
+        std::ostream* fStream;
+        std::string fText;
+        bool fDone;
+    };
+
+    /// An intrusive queue with multiple producers and a single consumer.
+    /// Push() can be called from any thread, and only needs one atomic
+    /// exchange, so a thread writing a message never waits for a lock.
+    /// Pop() is only called by the writer thread.  A Pop() that happens
+    /// while a Push() is half done returns NULL, and the record is found on
+    /// the next call.
+    class RecordQueue {
+    public:
+        RecordQueue() : fHead(&fStub), fTail(&fStub) {}
+
+        void Push(QueuedRecord* record) {
+            record->fNext.store(NULL, std::memory_order_relaxed);
+            QueuedRecord* previous
+                = fHead.exchange(record, std::memory_order_acq_rel);
+            previous->fNext.store(record, std::memory_order_release);
+        }
+
+        QueuedRecord* Pop() {
+            QueuedRecord* tail = fTail;
+            QueuedRecord* next = tail->fNext.load(std::memory_order_acquire);
+            if (tail == &fStub) {
+                if (!next) return NULL;
+                fTail = next;
+                tail = next;
+                next = next->fNext.load(std::memory_order_acquire);
+            }
+            if (next) {
+                fTail = next;
+                return tail;
+            }
+            if (tail != fHead.load(std::memory_order_acquire)) return NULL;
+            Push(&fStub);
+            next = tail->fNext.load(std::memory_order_acquire);
+            if (!next) return NULL;
+            fTail = next;
+            return tail;
+        }
+
+    private:
+        std::atomic<QueuedRecord*> fHead;
+        QueuedRecord* fTail;
+        QueuedRecord fStub;
+    };
+
+    /// The writer thread for the asynchronous output.  The writer wakes up
+    /// periodically (or when a flush is requested), writes all of the queued
+    /// records, and then flushes the streams that were written.
+    class AsyncWriter {
+    public:
+        AsyncWriter() : fRunning(false), fProducers(0), fStopping(false) {}
+
+        bool IsRunning() const {return fRunning;}
+
+        void Start() {
+            std::lock_guard<std::mutex> control(fControl);
+            if (fRunning) return;
+            fStopping = false;
+            fThread = std::thread(&AsyncWriter::Run, this);
+            fRunning = true;
+        }
+
+        /// Stop the writer thread after all of the queued records have been
+        /// written.
+        void Stop() {
+            std::lock_guard<std::mutex> control(fControl);
+            if (!fRunning) return;
+            fRunning = false;
+            // Wait for threads that saw the writer running to finish adding
+            // their records.
+            while (fProducers > 0) std::this_thread::yield();
+            {
+                std::lock_guard<std::mutex> lock(fMutex);
+                fStopping = true;
+            }
+            fWake.notify_one();
+            fThread.join();
+        }
+
+        /// Add a record to the queue.  This returns false if the writer
+        /// isn't running, and the caller must write the record.
+        bool Push(std::ostream& stream, std::string& text) {
+            ++fProducers;
+            if (!fRunning) {
+                --fProducers;
+                return false;
+            }
+            QueuedRecord* record = new QueuedRecord;
+            record->fStream = &stream;
+            record->fText.swap(text);
+            fQueue.Push(record);
+            --fProducers;
+            return true;
+        }
+
+        /// Wait until the records that were added by this thread have been
+        /// written and flushed.  This returns false if the writer isn't
+        /// running.
+        bool Flush() {
+            QueuedRecord marker;
+            ++fProducers;
+            if (!fRunning) {
+                --fProducers;
+                return false;
+            }
+            fQueue.Push(&marker);
+            --fProducers;
+            std::unique_lock<std::mutex> lock(fMutex);
+            fWake.notify_one();
+            while (!marker.fDone) fDone.wait(lock);
+            return true;
+        }
+
+    private:
+        void Run() {
+            std::vector<std::ostream*> streams;
+            std::vector<QueuedRecord*> markers;
+            std::unique_lock<std::mutex> lock(fMutex);
+            for (;;) {
+                bool stopping = fStopping;
+                lock.unlock();
+                {
+                    std::lock_guard<std::mutex> output(OutputMutex());
+                    while (QueuedRecord* record = fQueue.Pop()) {
+                        if (!record->fStream) {
+                            markers.push_back(record);
+                            continue;
+                        }
+                        *record->fStream << record->fText;
+                        if (std::find(streams.begin(), streams.end(),
+                                      record->fStream) == streams.end()) {
+                            streams.push_back(record->fStream);
+                        }
+                        delete record;
+                    }
+                    for (std::size_t i = 0; i<streams.size(); ++i) {
+                        streams[i]->flush();
+                    }
+                    streams.clear();
+                    if (!markers.empty()) {
+                        std::cout.flush();
+                        std::cerr.flush();
+                    }
+                }
+                lock.lock();
+                if (!markers.empty()) {
+                    for (std::size_t i = 0; i<markers.size(); ++i) {
+                        markers[i]->fDone = true;
+                    }
+                    markers.clear();
+                    fDone.notify_all();
+                }
+                if (stopping) break;
+                fWake.wait_for(lock, std::chrono::milliseconds(20));
+            }
+        }
+
+        /// The records waiting to be written.
+        RecordQueue fQueue;
+
+        /// True while records should be added to the queue.
+        std::atomic<bool> fRunning;
+
+        /// The number of threads that are adding records to the queue.
+        std::atomic<int> fProducers;
+
+        /// Serialize Start() and Stop().
+        std::mutex fControl;
+
+        /// Protect fStopping and the markers, and used with the conditions.
+        std::mutex fMutex;
+
+        /// Wake the writer thread.
+        std::condition_variable fWake;
+
+        /// Signal that markers have been reached.
+        std::condition_variable fDone;
+
+        /// Set when the writer thread should exit.
+        bool fStopping;
+
+        std::thread fThread;
+    };
+
+    /// The writer.  This is never deleted, and the thread is stopped by
+    /// StopAsyncWriter() when the program exits.
+    AsyncWriter& GetAsyncWriter() {
+        static AsyncWriter* writer = new AsyncWriter;
+        return *writer;
+    }
+
+    void StopAsyncWriter() {
+        GetAsyncWriter().Stop();
+    }
+}
+
+CP::TCaptLog::TRecord::TRecord(RecordDestination destination)
+    : fDestination(destination) {
+    RecordBuffers& buffers = GetRecordBuffers();
+    if (buffers.fDepth == buffers.fStreams.size()) {
+        buffers.fStreams.push_back(new std::ostringstream);
+    }
+    std::ostringstream* stream = buffers.fStreams[buffers.fDepth++];
+    stream->str(std::string());
+    stream->clear();
+    stream->copyfmt(buffers.fDefault);
+    fStream = stream;
+}
+
+CP::TCaptLog::TRecord::~TRecord() {
+    --GetRecordBuffers().fDepth;
+}
+
+void CP::TCaptLog::TRecord::Write() {
+    std::string text = static_cast<std::ostringstream*>(fStream)->str();
+    text += '\n';
+    std::ostream& stream = (fDestination == kLogRecord)
+        ? CP::TCaptLog::GetLogStream(): CP::TCaptLog::GetDebugStream();
+    AsyncWriter& writer = GetAsyncWriter();
+    if (writer.Push(stream,text)) {
+        if (fDestination == kErrorRecord) writer.Flush();
+        return;
+    }
+    std::lock_guard<std::mutex> output(OutputMutex());
+    stream << text;
+    stream.flush();
+}
+
+void CP::TCaptLog::SetAsynchronous(bool async) {
+    if (!async) {
+        GetAsyncWriter().Stop();
+        return;
+    }
+    // Make sure the queue is written when the program exits.
+    static int registered = std::atexit(StopAsyncWriter);
+    (void) registered;
+    GetAsyncWriter().Start();
+}
+
+bool CP::TCaptLog::IsAsynchronous() {
+    return GetAsyncWriter().IsRunning();
+}
+
+void CP::TCaptLog::Flush() {
+    if (GetAsyncWriter().Flush()) return;
+    std::lock_guard<std::mutex> output(OutputMutex());
+    GetLogStream().flush();
+    GetDebugStream().flush();
+}
+
 void CP::TCaptLog::SetDebugStream(std::ostream* err) {
+    Flush();
     CP::TCaptLog::fDebugStream = err;
     if (!fDebugStream) return;
     std::ofstream* ofile = dynamic_cast<std::ofstream*>(err);
@@ -71,18 +429,28 @@ std::ostream& CP::TCaptLog::GetDebugStream() {
     return *CP::TCaptLog::fDebugStream;
 }
     
+void CP::TCaptLog::SetLogLevel(CP::TCaptLog::LogPriority level) {
+    std::lock_guard<std::mutex> lock(TraceMutex());
+    fLogPriority = level;
+    InvalidateTraces();
+}
+
 void CP::TCaptLog::SetLogLevel(const char* trace, 
                             CP::TCaptLog::LogPriority level) {
+    std::lock_guard<std::mutex> lock(TraceMutex());
     fLogTraces[trace] = level;
+    InvalidateTraces();
 }
 
 CP::TCaptLog::LogPriority CP::TCaptLog::GetLogLevel(const char* trace) {
+    std::lock_guard<std::mutex> lock(TraceMutex());
     std::map<std::string,LogPriority>::iterator elem = fLogTraces.find(trace);
     if (elem == fLogTraces.end()) return fLogPriority;
     return elem->second;
 }
 
 void CP::TCaptLog::SetLogStream(std::ostream* log) {
+    Flush();
     CP::TCaptLog::fLogStream = log;
     if (!fLogStream) return;
     std::ofstream* ofile = dynamic_cast<std::ofstream*>(log);
@@ -106,26 +474,26 @@ std::ostream& CP::TCaptLog::GetLogStream() {
 }
 
 void CP::TCaptLog::SetIndentation(int i) {
-    CP::TCaptLog::fIndentation = std::max(i,0);
+    tIndentation = std::max(i,0);
 }
 
 void CP::TCaptLog::IncreaseIndentation() {
-    ++CP::TCaptLog::fIndentation;
+    ++tIndentation;
 }
 
 void CP::TCaptLog::DecreaseIndentation() {
-    if (CP::TCaptLog::fIndentation>0) --CP::TCaptLog::fIndentation;
+    if (tIndentation>0) --tIndentation;
 }
     
 void CP::TCaptLog::ResetIndentation() {
-    CP::TCaptLog::fIndentation = 0;
+    tIndentation = 0;
 }
 
 
 std::string CP::TCaptLog::MakeIndent() {
-    if (fIndentation<1) return "";
+    if (tIndentation<1) return "";
     std::string indent = "";
-    for (int i=0; i<fIndentation; ++i) {
+    for (int i=0; i<tIndentation; ++i) {
         indent += "..";
     }
     indent += " ";
@@ -297,6 +665,23 @@ namespace {
                 }
                 CP::TCaptLog::SetDebugStream(str);
             }
+            else if (fields.size() == 2
+                     && fields[0] == "log"
+                     && fields[1] == "asynchronous") {
+                // Set the output to be written from a separate thread.
+                if (value != "true" && value != "false") {
+                    std::cerr << "WARNING: " << config << ":" 
+                              << inputLine << ": "
+                              << "Asynchronous must be true or false."
+                              << std::endl;
+                    std::cerr << "  Line: <" << cache << ">"
+                              << std::endl;
+                    std::cerr << "  Configuration line has been skip" 
+                              << std::endl;
+                    continue;
+                }
+                CP::TCaptLog::SetAsynchronous(value == "true");
+            }
             else if (fields.size() == 3
                      && fields[0] == "log"
                      && fields[1] == "default"
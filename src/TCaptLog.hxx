@@ -5,6 +5,9 @@
 #include <iomanip>
 #include <string>
 #include <map>
+#ifndef __CINT__
+#include <atomic>
+#endif
 
 namespace CP {
     class TCaptLog;
@@ -178,6 +181,9 @@ namespace CP {
 /// - error.[trace].level -- Set the error level for the named trace.  The
 ///  level names are the same as error.default.level.
 ///
+/// - log.asynchronous -- Write the messages from a separate thread (see
+///  \ref logAsynchronous).  This accepts true or false.
+///
 /// An example of the captainlog.config file shows how it might be used.  This
 /// file causes the log messages to be printed in "output.log", and the error
 /// messages to be printed in "output.err".  The default log level is set to
@@ -229,6 +235,29 @@ namespace CP {
 /// # End of captainlog.config
 /// \endcode
 ///
+/// \section logAsynchronous Asynchronous Output
+///
+/// Each message is formatted into a buffer that belongs to the thread
+/// writing the message, and the completed message is then written as a
+/// single record, so messages from different threads are never mixed
+/// together.  By default, the record is written to the stream (and the
+/// stream is flushed) before the macro returns.  When the asynchronous
+/// output is enabled with TCaptLog::SetAsynchronous(), the records are
+/// passed through a lock-free queue to a separate writer thread that writes
+/// them in batches, and the streams are flushed once per batch, so the
+/// thread producing the message doesn't wait for the output.  The
+/// asynchronous output can also be enabled in the configuration file with
+///
+/// \code
+/// log.asynchronous = true
+/// \endcode
+///
+/// Messages from CaptError() and CaptNamedError() are always written before
+/// the macro returns since they usually come right before a crash.  Output
+/// that is written directly to GetLogStream() or GetDebugStream() doesn't go
+/// through the queue, so call TCaptLog::Flush() first if it needs to be
+/// ordered with the messages.
+///
 /// \section logLevel Log Levels
 ///
 /// The available log output levels are:
@@ -402,7 +431,7 @@ public:
 
     /// Set the default debugging level.  The level parameter takes a value
     /// with type TCaptLog::ErrorPriority.
-    static void SetDebugLevel(ErrorPriority level) {fErrorPriority = level;}
+    static void SetDebugLevel(ErrorPriority level);
 
     /// Set the debugging level for a particular trace.
     static void SetDebugLevel(const char* trace, ErrorPriority level);
@@ -417,7 +446,7 @@ public:
     static void SetLogStream(std::ostream* log);
 
     /// Set the default logging level.
-    static void SetLogLevel(LogPriority level) {fLogPriority = level;}
+    static void SetLogLevel(LogPriority level);
 
     /// Set the logging level for a named trace.
     static void SetLogLevel(const char* trace, LogPriority level);
@@ -434,7 +463,20 @@ public:
     /// Return the stream associated with the log file.
     static std::ostream& GetLogStream();
 
-    /// Set the indentation level for a log message.
+    /// Write the messages from a separate thread (see \ref
+    /// logAsynchronous).  When the asynchronous output is turned off, the
+    /// messages that are still queued are written before this returns.
+    static void SetAsynchronous(bool async);
+
+    /// Check if the messages are being written from a separate thread.
+    static bool IsAsynchronous();
+
+    /// Wait until all of the queued messages have been written, and then
+    /// flush the log and error streams.
+    static void Flush();
+
+    /// Set the indentation level for a log message.  The indentation is
+    /// kept separately for each thread.
     static void SetIndentation(int i);
 
     /// Increase the indentation level.
@@ -449,33 +491,126 @@ public:
     /// [Internal method] Make an indentation for a log message.
     static std::string MakeIndent();
 
+    /// [Internal] The destinations for a TRecord.
+    typedef enum {kLogRecord,
+                  kDebugRecord,
+                  kErrorRecord} RecordDestination;
+
+    /// [Internal class] Format a message into a buffer that belongs to the
+    /// current thread, and then write it as a single record.  This is used
+    /// by the logging macros.  A message that is being formatted can write
+    /// other messages (e.g. from a function called in the streamish
+    /// argument), so the buffers are used as a stack.
+    class TRecord {
+    public:
+        explicit TRecord(RecordDestination destination);
+        ~TRecord();
+
+        /// The stream that the message is formatted into.
+        std::ostream& Stream() {return *fStream;}
+
+        /// Write the formatted message.
+        void Write();
+
+    private:
+        TRecord(const TRecord&);
+        TRecord& operator = (const TRecord&);
+
+        RecordDestination fDestination;
+        std::ostream* fStream;
+    };
+
+#ifndef __CINT__
+    /// [Internal class] The error and log levels of a named trace cached for
+    /// one use of a named macro (e.g. CaptNamedDebug()).  The macro creates
+    /// a static TTraceSite, so the trace is looked up the first time the
+    /// macro is executed, and later executions only read an atomic word
+    /// holding the levels.  The cached levels are marked with a generation
+    /// number that is changed whenever a level is set, and are looked up
+    /// again when the generation doesn't match.
+    class TTraceSite {
+    public:
+        explicit TTraceSite(const char* trace) : fTrace(trace), fLevels(0) {}
+
+        /// Get the debugging level for the trace.
+        ErrorPriority GetDebugLevel() const {
+            return ErrorPriority(Levels() & 0xF);
+        }
+
+        /// Get the logging level for the trace.
+        LogPriority GetLogLevel() const {
+            return LogPriority((Levels() >> 4) & 0xF);
+        }
+
+    private:
+        /// Get the cached levels.  The error level is in the lowest four
+        /// bits, the log level is in the next four bits, and the generation
+        /// is in the remaining bits.
+        unsigned int Levels() const {
+            unsigned int levels = fLevels.load(std::memory_order_acquire);
+            if ((levels >> 8)
+                == fGeneration.load(std::memory_order_acquire)) {
+                return levels;
+            }
+            return Refresh();
+        }
+
+        /// Look up the levels and save them.
+        unsigned int Refresh() const;
+
+        /// The name of the trace.  This is a string literal.
+        const char* fTrace;
+
+        /// The cached levels.  The generation is zero until the first look
+        /// up.
+        mutable std::atomic<unsigned int> fLevels;
+    };
+#endif
+
 private: 
+    /// Change the generation so the cached levels are looked up again.
+    static void InvalidateTraces();
+
     static ErrorPriority fErrorPriority;
     static LogPriority fLogPriority;
     static std::ostream* fDebugStream;
     static std::ostream* fLogStream;
     static std::map<std::string,ErrorPriority> fErrorTraces;
     static std::map<std::string,LogPriority> fLogTraces;
-    static int fIndentation;
+#ifndef __CINT__
+    /// The generation of the trace levels (never zero).
+    static std::atomic<unsigned int> fGeneration;
+#endif
 
     TCaptLog();
 };
 
+/// INTERNAL: A macro to format a message and write it as a single record.
+/// This is used by the _CAPT_OUTPUT_ERROR and _CAPT_OUTPUT_LOG macros.
+#define _CAPT_OUTPUT_RECORD(destination,outStream)                      \
+    do {                                                                \
+        CP::TCaptLog::TRecord _captRecord(destination);                 \
+        _captRecord.Stream() << outStream;                              \
+        _captRecord.Write();                                            \
+    } while (0)
+
 /// INTERNAL: A macro to handle the output of an error message.  This is used
 /// by the user visible macros.
 #ifndef _CAPT_OUTPUT_ERROR
 # define _CAPT_OUTPUT_ERROR(trace,outStream)                           \
-    do {                                                                \
-        std::ios::fmtflags save = CP::TCaptLog::GetDebugStream().flags(); \
-        CP::TCaptLog::GetDebugStream() << trace << __FILE__            \
-                                        << ":" << __LINE__ << ": "      \
-                                        << outStream                    \
-                                        << std::setprecision(6)         \
-                                        << std::setw(0)                 \
-                                        << std::setfill(' ')            \
-                                        << std::endl;                   \
-        CP::TCaptLog::GetDebugStream().flags(save);                    \
-    } while (0)
+    _CAPT_OUTPUT_RECORD(CP::TCaptLog::kDebugRecord,                    \
+                        trace << __FILE__ << ":" << __LINE__ << ": "   \
+                        << outStream)
+#endif
+
+/// INTERNAL: A macro to handle the output of a message from CaptError().
+/// The message is written before the macro returns, even when the output
+/// is asynchronous.
+#ifndef _CAPT_OUTPUT_FATAL
+# define _CAPT_OUTPUT_FATAL(trace,outStream)                           \
+    _CAPT_OUTPUT_RECORD(CP::TCaptLog::kErrorRecord,                    \
+                        trace << __FILE__ << ":" << __LINE__ << ": "   \
+                        << outStream)
 #endif
 
 /// Set this to false if the error output code should not be included in
@@ -496,7 +631,7 @@ private:
 # define CaptError(outStream)                                        \
     do {                                                              \
         if (CAPT_ERROR_OUTPUT) {                                     \
-            _CAPT_OUTPUT_ERROR("ERROR: ",outStream);                 \
+            _CAPT_OUTPUT_FATAL("ERROR: ",outStream);                 \
         }                                                             \
     } while (0)
 #else
@@ -513,8 +648,9 @@ private:
 # define CaptNamedError(trace,outStream)                              \
     do {                                                                \
         if (CAPT_ERROR_OUTPUT) {                                       \
-            if (CP::TCaptLog::ErrorLevel <= CP::TCaptLog::GetDebugLevel(trace)) \
-                _CAPT_OUTPUT_ERROR("ERROR[" trace "]: ", outStream);  \
+            static CP::TCaptLog::TTraceSite _captTrace(trace);          \
+            if (CP::TCaptLog::ErrorLevel <= _captTrace.GetDebugLevel()) \
+                _CAPT_OUTPUT_FATAL("ERROR[" trace "]: ", outStream);  \
         }                                                               \
     } while (0)
 #else
@@ -548,7 +684,8 @@ private:
 # define CaptNamedSevere(trace,outStream)                              \
     do {                                                                \
         if (CAPT_ERROR_OUTPUT) {                                       \
-            if (CP::TCaptLog::SevereLevel <= CP::TCaptLog::GetDebugLevel(trace)) \
+            static CP::TCaptLog::TTraceSite _captTrace(trace);          \
+            if (CP::TCaptLog::SevereLevel <= _captTrace.GetDebugLevel()) \
                 _CAPT_OUTPUT_ERROR("SEVERE[" trace "]: ", outStream);  \
         }                                                               \
     } while (0)
@@ -581,7 +718,8 @@ private:
 # define CaptNamedWarn(trace,outStream)                                \
     do {                                                                \
         if (CAPT_ERROR_OUTPUT) {                                       \
-            if (CP::TCaptLog::WarnLevel <= CP::TCaptLog::GetDebugLevel(trace)) \
+            static CP::TCaptLog::TTraceSite _captTrace(trace);          \
+            if (CP::TCaptLog::WarnLevel <= _captTrace.GetDebugLevel())  \
                 _CAPT_OUTPUT_ERROR("WARNING[" trace "]: ", outStream); \
         }                                                               \
     } while (0)
@@ -616,7 +754,8 @@ private:
 #define CaptNamedDebug(trace,outStream)                                \
     do {                                                                \
         if (CAPT_ERROR_OUTPUT) {                                       \
-            if (CP::TCaptLog::DebugLevel <= CP::TCaptLog::GetDebugLevel(trace)) \
+            static CP::TCaptLog::TTraceSite _captTrace(trace);          \
+            if (CP::TCaptLog::DebugLevel <= _captTrace.GetDebugLevel()) \
                 _CAPT_OUTPUT_ERROR("DEBUG[" trace "]: ", outStream);   \
         }                                                               \
     } while (0)
@@ -649,7 +788,8 @@ private:
 #define CaptNamedTrace(trace,outStream)                                \
     do {                                                                \
         if (CAPT_ERROR_OUTPUT) {                                       \
-            if (CP::TCaptLog::TraceLevel <= CP::TCaptLog::GetDebugLevel(trace)) \
+            static CP::TCaptLog::TTraceSite _captTrace(trace);          \
+            if (CP::TCaptLog::TraceLevel <= _captTrace.GetDebugLevel()) \
                 _CAPT_OUTPUT_ERROR("TRACE[" trace "]: ", outStream);   \
         }                                                               \
     } while (0)
@@ -661,17 +801,9 @@ private:
 /// by the user visible macros.
 #ifndef _CAPT_OUTPUT_LOG
 #define _CAPT_OUTPUT_LOG(trace,outStream)                              \
-    do {                                                                \
-        std::ios::fmtflags save = CP::TCaptLog::GetLogStream().flags(); \
-        CP::TCaptLog::GetLogStream() << trace                          \
-                                      << CP::TCaptLog::MakeIndent()    \
-                                      << outStream                      \
-                                      << std::setprecision(6)           \
-                                      << std::setw(0)                   \
-                                      << std::setfill(' ')              \
-                                      << std::endl;                     \
-        CP::TCaptLog::GetLogStream().flags(save);                      \
-    } while (0)
+    _CAPT_OUTPUT_RECORD(CP::TCaptLog::kLogRecord,                      \
+                        trace << CP::TCaptLog::MakeIndent()            \
+                        << outStream)
 #endif
 
 /// Set this to false if the logging output code should not be included in
@@ -707,7 +839,8 @@ behaviour may result.
 #define CaptNamedLog(trace,outStream)                                  \
     do {                                                                \
         if (CAPT_LOG_OUTPUT) {                                         \
-            if (CP::TCaptLog::LogLevel <= CP::TCaptLog::GetLogLevel(trace)) \
+            static CP::TCaptLog::TTraceSite _captTrace(trace);          \
+            if (CP::TCaptLog::LogLevel <= _captTrace.GetLogLevel())     \
                 _CAPT_OUTPUT_LOG("% [" trace "] ",outStream);          \
         }                                                               \
     } while (0)
@@ -739,7 +872,8 @@ behaviour may result.
 #define CaptNamedInfo(trace,outStream)                                 \
     do {                                                                \
         if (CAPT_LOG_OUTPUT) {                                         \
-            if (CP::TCaptLog::InfoLevel <= CP::TCaptLog::GetLogLevel(trace)) \
+            static CP::TCaptLog::TTraceSite _captTrace(trace);          \
+            if (CP::TCaptLog::InfoLevel <= _captTrace.GetLogLevel())    \
                 _CAPT_OUTPUT_LOG("%% [" trace "] ",outStream);         \
         }                                                               \
     } while (0)
@@ -771,7 +905,8 @@ behaviour may result.
 #define CaptNamedVerbose(trace,outStream)                              \
     do {                                                                \
         if (CAPT_LOG_OUTPUT) {                                         \
-            if (CP::TCaptLog::VerboseLevel <= CP::TCaptLog::GetLogLevel(trace)) \
+            static CP::TCaptLog::TTraceSite _captTrace(trace);          \
+            if (CP::TCaptLog::VerboseLevel <= _captTrace.GetLogLevel()) \
                 _CAPT_OUTPUT_LOG("%%% [" trace "] ",outStream);          \
         }                                                               \
     } while (0)
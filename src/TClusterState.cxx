@@ -6,7 +6,7 @@ ClassImp(CP::TClusterState);
 CP::TClusterState::TClusterState(): TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
-    Init();
+    Init(fStorage);
 }
 
 CP::TClusterState::~TClusterState() {}
@@ -15,36 +15,23 @@ CP::TClusterState::TClusterState(const CP::TClusterState& init)
   : TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
-    Init();
+    Init(fStorage);
 
-    for (int i=0; i<GetSize(); ++i) {
-        SetValue(i,init.GetValue(i));
-    }
-
-    for (int i=0; i<GetSize(); ++i) {
-        for (int j=0; j<GetSize(); ++j) {
-            SetCovarianceValue(i,j,init.GetCovarianceValue(i,j));
-        }
-    }
-    
+    CopyValues(init);
 }
 
 CP::TClusterState& CP::TClusterState::operator=(const CP::TClusterState& rhs) {
     if (this == &rhs) return *this;
 
-    for (int i=0; i<GetSize(); ++i) {
-        SetValue(i,rhs.GetValue(i));
-    }
+    CopyValues(rhs);
 
-    for (int i=0; i<GetSize(); ++i) {
-        for (int j=0; j<GetSize(); ++j) {
-            SetCovarianceValue(i,j,rhs.GetCovarianceValue(i,j));
-        }
-    }
-    
     return *this;
 }
 
+CP::TReconState* CP::TClusterState::CopyState() const {
+    return new CP::TClusterState(*this);
+}
+
 CP::TCorrValues CP::TClusterState::ProjectState(const CP::THandle<CP::TReconState>& proj) {
     TCorrValues values(TClusterState::GetSize());
     values.SetType("EDeposit X Y Z T ");
@@ -56,12 +43,12 @@ CP::TCorrValues CP::TClusterState::ProjectState(const CP::THandle<CP::TReconStat
         for (int i = 0; i < TMEDepositState::GetSize(); ++i) {
             values.SetValue(i+base,
                             eDepositState->
-                            GetThis().fValues.GetValue(i+offset));
+                            GetThis().GetValue(i+offset));
             for (int j = 0; j < TMEDepositState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
                     eDepositState->
-                    GetThis().fValues.GetCovarianceValue(i+offset,
+                    GetThis().GetCovarianceValue(i+offset,
                                                          j+offset));
             }
         }
@@ -73,11 +60,11 @@ CP::TCorrValues CP::TClusterState::ProjectState(const CP::THandle<CP::TReconStat
         const int offset = posState->GetPositionIndex();
         for (int i = 0; i < TMPositionState::GetSize(); ++i) {
             values.SetValue(i+base, 
-                            posState->GetThis().fValues.GetValue(i+offset));
+                            posState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMPositionState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    posState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    posState->GetThis().GetCovarianceValue(i+offset,
                                                                    j+offset));
             }
         }
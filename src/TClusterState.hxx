@@ -2,6 +2,7 @@
 #define TClusterState_hxx_seen
 
 #include "TReconState.hxx"
+#include "TReconStateView.hxx"
 #include "TReconNode.hxx"
 
 namespace CP {
@@ -25,6 +26,9 @@ public:
     TClusterState(const TClusterState& init);
     virtual TClusterState& operator=(const TClusterState& rhs);
 
+    /// Make a new copy of the state.
+    virtual CP::TReconState* CopyState() const;
+
     /// Return the number of entries for the Direction in the TCorrValues
     /// vector.
     static int GetSize() {
@@ -34,6 +38,23 @@ public:
     /// The projection operator to get the full state.
     static CP::TCorrValues ProjectState(const CP::THandle<CP::TReconState>& state);
 
+private:
+    /// The fixed size storage for the state values.
+    TReconStateStorage<5> fStorage; //! Don't Save
+
     ClassDef(TClusterState,2);
 };
+
+#ifndef __CINT__
+namespace CP {
+    /// The compile time layout of the TClusterState fields.
+    template <> struct TReconStateLayout<CP::TClusterState> {
+        enum {
+            kEDeposit = 0,
+            kPosition = 1,
+            kSize = 5
+        };
+    };
+}
+#endif
 #endif
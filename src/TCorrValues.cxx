@@ -7,6 +7,58 @@
 
 ClassImp(CP::TCorrValues);
 
+namespace {
+    /// The largest number of parameters (that are neither fixed nor free)
+    /// for which the Hessian is found with InvertSmallSymmetric.  This is
+    /// large enough for all of the reconstruction states (TTrackState has
+    /// ten).
+    const int kMaxFastDimension = 10;
+
+    /// Invert a small symmetric positive definite matrix in place using a
+    /// Cholesky decomposition.  The rows have a fixed stride so the inner
+    /// loops run over contiguous memory and nothing is allocated.  Only the
+    /// lower triangle (j<=i) is used for the input and filled for the
+    /// output.  This returns false, leaving the matrix undefined, if the
+    /// matrix isn't positive definite.
+    bool InvertSmallSymmetric(double a[][kMaxFastDimension], int n) {
+        // Decompose into L*L^T keeping L in the lower triangle.
+        for (int j = 0; j<n; ++j) {
+            double diag = a[j][j];
+            for (int k = 0; k<j; ++k) diag -= a[j][k]*a[j][k];
+            if (!(diag > 0.0)) return false;
+            diag = std::sqrt(diag);
+            a[j][j] = diag;
+            for (int i = j+1; i<n; ++i) {
+                double sum = a[i][j];
+                for (int k = 0; k<j; ++k) sum -= a[i][k]*a[j][k];
+                a[i][j] = sum/diag;
+            }
+        }
+
+        // Invert L in place one column at a time.  The columns to the right
+        // of the current column still hold L.
+        for (int j = 0; j<n; ++j) {
+            a[j][j] = 1.0/a[j][j];
+            for (int i = j+1; i<n; ++i) {
+                double sum = 0.0;
+                for (int k = j; k<i; ++k) sum += a[i][k]*a[k][j];
+                a[i][j] = -sum/a[i][i];
+            }
+        }
+
+        // Form inv(L)^T*inv(L) in place one row at a time.  The rows below
+        // the current row still hold inv(L).
+        for (int i = 0; i<n; ++i) {
+            for (int j = 0; j<=i; ++j) {
+                double sum = 0.0;
+                for (int k = i; k<n; ++k) sum += a[k][i]*a[k][j];
+                a[i][j] = sum;
+            }
+        }
+        return true;
+    }
+}
+
 /// Set the variance value for a free parameter.  The value is about 1E+154
 /// (1E+19) for a double (float).
 const CP::TCorrValues::Element CP::TCorrValues::kFreeValue = 
@@ -19,7 +71,8 @@ const CP::TCorrValues::Element
     CP::TCorrValues::kFixedThreshold = 1.0/CP::TCorrValues::kFreeThreshold;
 
 CP::TCorrValues::TCorrValues(int n) 
-    : fVector(n), fMatrix(n), fNDOF(0), fTypeHash(0), fHessian(NULL) {
+    : fVector(n), fMatrix(n), fNDOF(0), fTypeHash(0), fHessian(NULL),
+      fHessianValid(false) {
     // All parameters are initially free.
     for (int i=0; i<GetDimensions(); ++i) {
         fMatrix(i,i) = kFreeValue;
@@ -27,18 +80,21 @@ CP::TCorrValues::TCorrValues(int n)
 }
 
 CP::TCorrValues::TCorrValues(double value, double uncertainty)
-    : fVector(1), fMatrix(1), fNDOF(1), fTypeHash(0), fHessian(NULL) {
+    : fVector(1), fMatrix(1), fNDOF(1), fTypeHash(0), fHessian(NULL),
+      fHessianValid(false) {
     SetValue(0,value);
     SetCovarianceValue(0,0,uncertainty*uncertainty);
 }
 
 CP::TCorrValues::TCorrValues(const TCorrValues& hv) 
     : TObject(hv), fVector(hv.fVector), fMatrix(hv.fMatrix), 
-      fNDOF(hv.fNDOF), fTypeHash(hv.fTypeHash), fHessian(NULL) {}
+      fNDOF(hv.fNDOF), fTypeHash(hv.fTypeHash), fHessian(NULL),
+      fHessianValid(false) {}
 
 CP::TCorrValues::TCorrValues(const TVectorT<float>& v) 
     : fVector(v), fMatrix(v.GetNoElements()),
-      fNDOF(0), fTypeHash(0), fHessian(NULL) {
+      fNDOF(0), fTypeHash(0), fHessian(NULL),
+      fHessianValid(false) {
     // All parameters are initially free.
     for (int i=0; i<GetDimensions(); ++i) {
         fMatrix(i,i) = kFreeValue;
@@ -48,7 +104,8 @@ CP::TCorrValues::TCorrValues(const TVectorT<float>& v)
 CP::TCorrValues::TCorrValues(const TVectorT<float>& v,
                                const TVectorT<float>& err) 
     : fVector(v), fMatrix(v.GetNoElements()),
-      fNDOF(0), fTypeHash(0), fHessian(NULL) {
+      fNDOF(0), fTypeHash(0), fHessian(NULL),
+      fHessianValid(false) {
     if (err.GetNoElements() != v.GetNoElements()) {
         CaptError("Mismatched number of elements");
         throw ECorrValuesConstructor();
@@ -61,7 +118,8 @@ CP::TCorrValues::TCorrValues(const TVectorT<float>& v,
 CP::TCorrValues::TCorrValues(const TVectorT<float>& v,
                                const TMatrixTSym<float>& cov) 
     : fVector(v), fMatrix(cov),
-      fNDOF(0), fTypeHash(0), fHessian(NULL) {
+      fNDOF(0), fTypeHash(0), fHessian(NULL),
+      fHessianValid(false) {
     if (cov.GetNcols() != fVector.GetNoElements()) {
         CaptError("Mismatch between element count and covariance columns.");
         throw ECorrValuesConstructor();
@@ -72,6 +130,14 @@ CP::TCorrValues::TCorrValues(const TVectorT<float>& v,
     }
 }
 
+CP::TCorrValues::~TCorrValues() {
+    if (fHessian) delete fHessian;
+}
+
+void CP::TCorrValues::ClearHessian() {
+    fHessianValid = false;
+}
+
 void CP::TCorrValues::SetValues(const TVectorT<float>& v) {
     fVector = v;
 }
@@ -79,8 +145,7 @@ void CP::TCorrValues::SetValues(const TVectorT<float>& v) {
 void CP::TCorrValues::SetCovariance(const TMatrixTSym<float>& m) {
     fMatrix = m;
     fNDOF = 0;
-    if (fHessian) delete fHessian;
-    fHessian = NULL;
+    ClearHessian();
 }
 
 void CP::TCorrValues::SetValue(int i, double v) {
@@ -121,8 +186,7 @@ void CP::TCorrValues::SetCovarianceValue(int i, int j, double v) {
     fMatrix(i,j) = v;
     fMatrix(j,i) = v;
     fNDOF = 0;
-    if (fHessian) delete fHessian;
-    fHessian = NULL;
+    ClearHessian();
 }
 
 double CP::TCorrValues::GetCovarianceValue(int i, int j) const {
@@ -183,8 +247,7 @@ void CP::TCorrValues::ResizeTo(int n) {
     for (int i=0; i<GetDimensions(); ++i) {
         fMatrix(i,i) = kFreeValue;
     }
-    if (fHessian) delete fHessian;
-    fHessian = NULL;
+    ClearHessian();
 }
 
 int CP::TCorrValues::GetDimensions(void) const {
@@ -238,6 +301,8 @@ void CP::TCorrValues::SetFixed(int i) {
         fMatrix(j,i) = fMatrix(i,j) = 0.0;
     }
     fMatrix(i,i) = kFixedValue;
+    fNDOF = 0;
+    ClearHessian();
 }
 
 bool CP::TCorrValues::IsFixed(int i) const {
@@ -268,6 +333,8 @@ void CP::TCorrValues::SetFree(int i) {
         fMatrix(j,i) = fMatrix(i,j) = 0.0;
     }
     fMatrix(i,i) = kFreeValue;
+    fNDOF = 0;
+    ClearHessian();
 }
 
 bool CP::TCorrValues::IsFree(int i) const {
@@ -331,57 +398,89 @@ bool CP::TCorrValues::Validate(bool fix) {
     }
     if (!ok && fix) {
         fNDOF = 0;
-        if (fHessian) delete fHessian;
-        fHessian = 0;
+        ClearHessian();
     }
     return ok;
 }
 
 const TMatrixTSym<float>& CP::TCorrValues::GetHessian() const {
-    if (fHessian) return (*fHessian);
-    fHessian = new TMatrixTSym<float>(GetDimensions());
-
-    // Collect the non-zero elements of the covariance.
-    std::vector<int> goodList;
-    for (int i = 0; i<GetDimensions(); ++i) {
-        if (IsFixed(i)) continue;
-        if (IsFree(i)) continue;
-        goodList.push_back(i);
-    }
-
-    if (goodList.size()>0) {
-        // Make a symetric matrix of just the good elements and invert.
-        TMatrixT<Element> h(goodList.size(),goodList.size());
-        for (unsigned int i = 0; i<goodList.size(); ++i) {
-            for (unsigned int j = i; j<goodList.size(); ++j) {
-                h(j,i) = h(i,j) = fMatrix(goodList[i],goodList[j]);
-            }
+    if (fHessian && fHessianValid) return (*fHessian);
+    int dim = GetDimensions();
+    if (!fHessian) fHessian = new TMatrixTSym<float>(dim);
+    else if (fHessian->GetNrows() != dim) fHessian->ResizeTo(dim,dim);
+    fHessian->Zero();
+    fHessianValid = true;
+
+    // Collect the elements that are neither fixed nor free.  The indices are
+    // only saved when there are few enough for the fast inversion.
+    int good[kMaxFastDimension];
+    int goodCount = 0;
+    for (int i = 0; i<dim; ++i) {
+        double variance = fMatrix(i,i);
+        if (IsFixed(variance)) continue;
+        if (IsFree(variance)) continue;
+        if (goodCount < kMaxFastDimension) good[goodCount] = i;
+        ++goodCount;
+    }
+
+    bool inverted = (goodCount < 1);
+    if (!inverted && goodCount <= kMaxFastDimension) {
+        double h[kMaxFastDimension][kMaxFastDimension];
+        for (int i = 0; i<goodCount; ++i) {
+            for (int j = 0; j<=i; ++j) h[i][j] = fMatrix(good[i],good[j]);
         }
-        h.Invert();
-        // Copy the values of the inverted covariance matrix into the Hessian.
-        for (unsigned int i = 0; i<goodList.size(); ++i) {
-            for (unsigned int j = 0; j<goodList.size(); ++j) {
-                (*fHessian)(goodList[i],goodList[j]) = h(i,j);
+        inverted = InvertSmallSymmetric(h,goodCount);
+        for (int i = 0; inverted && i<goodCount; ++i) {
+            for (int j = 0; j<=i; ++j) {
+                (*fHessian)(good[i],good[j]) = h[i][j];
+                (*fHessian)(good[j],good[i]) = h[i][j];
             }
         }
     }
 
+    if (!inverted) {
+        // Either there are too many parameters, or the covariance isn't
+        // positive definite, so use the general inversion.
+        std::vector<int> goodList;
+        for (int i = 0; i<dim; ++i) {
+            if (IsFixed(i)) continue;
+            if (IsFree(i)) continue;
+            goodList.push_back(i);
+        }
+        FillHessianGeneral(goodList);
+    }
+
     // Set the Hessian values for the free and fixed variances.
-    for (int i = 0; i<GetDimensions(); ++i) {
+    for (int i = 0; i<dim; ++i) {
         if (IsFree(i)) (*fHessian)(i,i) = 1.0/kFreeValue;
         if (IsFixed(i)) (*fHessian)(i,i) = 1.0/kFixedValue;
     }
     return (*fHessian);
 }
 
+void CP::TCorrValues::FillHessianGeneral(const std::vector<int>& goodList)
+    const {
+    // Make a symetric matrix of just the good elements and invert.
+    TMatrixT<Element> h(goodList.size(),goodList.size());
+    for (unsigned int i = 0; i<goodList.size(); ++i) {
+        for (unsigned int j = i; j<goodList.size(); ++j) {
+            h(j,i) = h(i,j) = fMatrix(goodList[i],goodList[j]);
+        }
+    }
+    h.Invert();
+    // Copy the values of the inverted covariance matrix into the Hessian.
+    for (unsigned int i = 0; i<goodList.size(); ++i) {
+        for (unsigned int j = 0; j<goodList.size(); ++j) {
+            (*fHessian)(goodList[i],goodList[j]) = h(i,j);
+        }
+    }
+}
+
 const CP::TCorrValues& CP::TCorrValues::operator =(const CP::TCorrValues&
                                                      rhs) {
     int dim = rhs.GetDimensions();
     
-    if (dim != GetDimensions()) {
-        ResizeTo(dim);
-        if (fHessian) delete fHessian;
-    }
+    if (dim != GetDimensions()) ResizeTo(dim);
 
     for (int i=0; i<dim; ++i) {
         fVector[i] = rhs.fVector[i];
@@ -392,7 +491,12 @@ const CP::TCorrValues& CP::TCorrValues::operator =(const CP::TCorrValues&
 
     fNDOF = rhs.fNDOF;
     fTypeHash = rhs.fTypeHash;
-    if (rhs.fHessian) fHessian = new TMatrixTSym<float>(*rhs.fHessian);
+    ClearHessian();
+    if (rhs.fHessian && rhs.fHessianValid) {
+        if (fHessian) *fHessian = *rhs.fHessian;
+        else fHessian = new TMatrixTSym<float>(*rhs.fHessian);
+        fHessianValid = true;
+    }
 
     return rhs;
 }
@@ -13,6 +13,7 @@
 #include <TMatrixD.h>
 
 #include "ECore.hxx"
+#include "TEventArena.hxx"
 
 namespace CP {
     class TCorrValues;
@@ -101,7 +102,10 @@ public:
     /// parameter vector and matrix must have the same number of dimensions.
     TCorrValues(const TVectorT<float> &v,const TMatrixTSym<float> &C);
   
-    virtual ~TCorrValues(){};
+    virtual ~TCorrValues();
+
+    /// Allocate from the current event arena (see TEventArena).
+    EVENT_ARENA_ALLOCATED;
   
     /// The assignment operator
     const TCorrValues& operator =(const TCorrValues& rhs);
@@ -144,7 +148,12 @@ public:
 
     /// Get the Hessian matrix (the inverse of the covariance), also known as
     /// the curvature matrix.  If the covariance as free or fixed parameters,
-    /// the corresponding rows and columns in the hessian will be zero.
+    /// the corresponding rows and columns in the hessian will be zero.  The
+    /// Hessian is cached until the covariance changes, and the storage is
+    /// reused when it's recalculated.  When there are no more than ten
+    /// parameters that are neither fixed nor free (which covers all of the
+    /// reconstruction states), the inverse is found with a Cholesky
+    /// decomposition in fixed size arrays instead of with TMatrixT.
     const TMatrixTSym<float>& GetHessian() const;
 
     /// Set the dimensionality of the object.  This has the side effect
@@ -234,9 +243,20 @@ private:
     /// A semi-unique hash of the object element definitions.
     unsigned int fTypeHash;
 
+    /// Mark the Hessian as needing to be recalculated.  The storage is kept
+    /// so that it can be reused.
+    void ClearHessian();
+
+    /// Calculate the Hessian for the parameters listed in "good" using
+    /// TMatrixT.  This is used when the fast calculation can't be.
+    void FillHessianGeneral(const std::vector<int>& good) const;
+
     /// The value of the Hessian (if it's already calculated).
     mutable TMatrixTSym<float>* fHessian; //! Don't Save
 
+    /// True if fHessian holds the inverse of the current covariance.
+    mutable bool fHessianValid; //! Don't Save
+
     ClassDef(TCorrValues,3);
 };
 
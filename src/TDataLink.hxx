@@ -90,11 +90,15 @@ public:
     virtual ~TDataLink();
 
     /// Set the TDatum that is being linked.
-    virtual void SetLink(CP::TDatum *link) {fLink = link;}
+    virtual void SetLink(CP::TDatum *link) {
+        fLink = link;
+        IncrementGeneration();
+    }
 
     /// Set the TDatum that is being linked.
     virtual void SetLink(CP::THandle<CP::TDatum> link) {
         fLink = GetPointer(link);
+        IncrementGeneration();
     }
 
     /// Print the datum information.
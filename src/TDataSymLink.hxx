@@ -77,6 +77,7 @@ public:
     virtual void SetLink(const char* link) {
         if (link) fLink = link;
         else fLink = "";
+        IncrementGeneration();
     };
 
     /// Print the datum information.
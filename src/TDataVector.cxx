@@ -5,6 +5,11 @@
 // macro must be in a separate file and the virtual distructor is also
 // implemented here.
 #include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
 
 #include <TBrowser.h>
 
@@ -12,11 +17,171 @@
 
 ClassImp(CP::TDataVector);
 
+namespace {
+    /// The smallest data vector that will be indexed.  Smaller data vectors
+    /// use a linear search since it's faster than building the hash.
+    const unsigned int kMinimumIndexSize = 16;
+
+    /// The number of mutexes protecting the name indexes.
+    const std::size_t kIndexMutexes = 64;
+
+    /// Get the mutex protecting the name index of a data vector.  The index
+    /// is built by const methods, so several threads reading the same data
+    /// vector can try to build it at once.  The mutexes are shared by
+    /// address so that a data vector doesn't need to carry one.  These are
+    /// never deleted so data vectors can be used during the program exit.
+    std::mutex& IndexMutex(const CP::TDataVector* vector) {
+        static std::mutex* mutexes = new std::mutex[kIndexMutexes];
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(vector);
+        return mutexes[(address/sizeof(void*)) % kIndexMutexes];
+    }
+
+    /// The key used in the index for the name of a datum.  This follows
+    /// CP::TDatumCompareName which matches "unnamed" to a datum without a
+    /// name.
+    std::string NameKey(const char* name) {
+        if (!name || !(*name)) return "unnamed";
+        return name;
+    }
+
+    /// The key used to look up a name in the index.  This follows
+    /// CP::TDatumCompareName which treats ":" as "unnamed".
+    std::string QueryKey(const char* name) {
+        if (std::strcmp(name,":") == 0) return "unnamed";
+        return name;
+    }
+}
+
+/// The name index.  For each name, this remembers the last object with that
+/// name in the temporary and the main storage, and how many objects have the
+/// name so that it can tell when a removed object was hiding another one.
+/// The number of objects from each store that have been indexed is saved so
+/// that objects appended to the end of the stores can be indexed
+/// just-in-time (this also catches objects added by the streamer).
+class CP::TDataVector::TNameIndex {
+public:
+    struct Entry {
+        Entry() : fVector(NULL), fVectorCount(0),
+                  fTemporary(NULL), fTemporaryCount(0) {}
+        CP::TDatum* fVector;
+        int fVectorCount;
+        CP::TDatum* fTemporary;
+        int fTemporaryCount;
+    };
+    typedef std::unordered_map<std::string, Entry> Entries;
+
+    TNameIndex() : fIndexedVector(0), fIndexedTemporary(0) {}
+
+    /// Add an object that was appended to the main storage.
+    void AddVector(CP::TDatum* element) {
+        Entry& entry = fEntries[NameKey(element->GetName())];
+        entry.fVector = element;
+        ++entry.fVectorCount;
+        ++fIndexedVector;
+    }
+
+    /// Add an object that was appended to the temporary storage.
+    void AddTemporary(CP::TDatum* element) {
+        Entry& entry = fEntries[NameKey(element->GetName())];
+        entry.fTemporary = element;
+        ++entry.fTemporaryCount;
+        ++fIndexedTemporary;
+    }
+
+    /// Remove an object.  This returns false if the index can't be updated
+    /// (i.e. the object was hiding another with the same name) and needs to
+    /// be rebuilt.
+    bool Remove(CP::TDatum* element, bool temporary) {
+        Entries::iterator e = fEntries.find(NameKey(element->GetName()));
+        if (e == fEntries.end()) return false;
+        Entry& entry = e->second;
+        if (temporary) {
+            if (entry.fTemporaryCount < 1) return false;
+            if (entry.fTemporary == element && entry.fTemporaryCount > 1) {
+                return false;
+            }
+            if (--entry.fTemporaryCount < 1) entry.fTemporary = NULL;
+            --fIndexedTemporary;
+        }
+        else {
+            if (entry.fVectorCount < 1) return false;
+            if (entry.fVector == element && entry.fVectorCount > 1) {
+                return false;
+            }
+            if (--entry.fVectorCount < 1) entry.fVector = NULL;
+            --fIndexedVector;
+        }
+        if (entry.fVectorCount < 1 && entry.fTemporaryCount < 1) {
+            fEntries.erase(e);
+        }
+        return true;
+    }
+
+    /// Find the object with a name.  The temporary storage is searched
+    /// first.
+    CP::TDatum* Find(const char* name) const {
+        Entries::const_iterator e = fEntries.find(QueryKey(name));
+        if (e == fEntries.end()) return NULL;
+        if (e->second.fTemporaryCount > 0) return e->second.fTemporary;
+        return e->second.fVector;
+    }
+
+    /// Check if there is an object with the name in the main storage.
+    bool HasVector(const char* name) const {
+        Entries::const_iterator e = fEntries.find(NameKey(name));
+        if (e == fEntries.end()) return false;
+        return e->second.fVectorCount > 0;
+    }
+
+    /// The last object with each name.
+    Entries fEntries;
+
+    /// The number of objects in the main storage that have been indexed.
+    std::size_t fIndexedVector;
+
+    /// The number of objects in the temporary storage that have been
+    /// indexed.
+    std::size_t fIndexedTemporary;
+};
+
 // The default destructor.
 CP::TDataVector::~TDataVector() {
     Clear();
 }
 
+CP::TDataVector::TNameIndex* CP::TDataVector::GetNameIndex() const {
+    std::lock_guard<std::mutex> lock(IndexMutex(this));
+    if (!fNameIndex) {
+        if (size() < kMinimumIndexSize) return NULL;
+        fNameIndex = new TNameIndex;
+    }
+    // Objects have been removed without updating the index, so start over.
+    if (fNameIndex->fIndexedVector > fVector.size()
+        || fNameIndex->fIndexedTemporary > fTemporary.size()) {
+        fNameIndex->fEntries.clear();
+        fNameIndex->fIndexedVector = 0;
+        fNameIndex->fIndexedTemporary = 0;
+    }
+    // Index any objects that have been appended since the index was last
+    // used.
+    while (fNameIndex->fIndexedVector < fVector.size()) {
+        fNameIndex->AddVector(fVector[fNameIndex->fIndexedVector]);
+    }
+    while (fNameIndex->fIndexedTemporary < fTemporary.size()) {
+        fNameIndex->AddTemporary(fTemporary[fNameIndex->fIndexedTemporary]);
+    }
+    return fNameIndex;
+}
+
+void CP::TDataVector::InvalidateNameIndex() const {
+    delete fNameIndex;
+    fNameIndex = NULL;
+}
+
+void CP::TDataVector::ChildRenamed(CP::TDatum*) {
+    InvalidateNameIndex();
+}
+
 CP::TDataVector::iterator CP::TDataVector::begin(void) {
     return iterator(this,fVector.begin());
 }
@@ -59,9 +224,19 @@ CP::TDataVector::iterator CP::TDataVector::erase(TDatum* element) {
  
     // Now make sure that the element is removed from this objects storage.
     TDatumVector::iterator i = std::find(fVector.begin(),fVector.end(),element);
-    if (i != fVector.end()) return iterator(this,fVector.erase(i));
+    if (i != fVector.end()) {
+        if (fNameIndex && element) {
+            TNameIndex* index = GetNameIndex();
+            if (!index->Remove(element,false)) InvalidateNameIndex();
+        }
+        return iterator(this,fVector.erase(i));
+    }
 
     i = std::find(fTemporary.begin(),fTemporary.end(),element);
+    if (fNameIndex && element && i != fTemporary.end()) {
+        TNameIndex* index = GetNameIndex();
+        if (!index->Remove(element,true)) InvalidateNameIndex();
+    }
     return iterator(this,fTemporary.erase(i));
 }    
 
@@ -85,6 +260,15 @@ CP::TDataVector::iterator CP::TDataVector::insert(iterator position,
     // end of the permenant objects if it's not.
     CP::TDatumVector::iterator i
         = std::find(fVector.begin(),fVector.end(),*position);
+    IncrementGeneration();
+    // An element at the end of the main storage is indexed when the index is
+    // next used.  Otherwise, it can be added if it doesn't hide an object
+    // with the same name.
+    if (fNameIndex && i != fVector.end()) {
+        TNameIndex* index = GetNameIndex();
+        if (index->HasVector(element->GetName())) InvalidateNameIndex();
+        else index->AddVector(element);
+    }
     return iterator(this,fVector.insert(i,element));
 }
 
@@ -94,6 +278,13 @@ void CP::TDataVector::push_back(TDatum* element) {
 
 // Find a TDatum in the data vector. 
 CP::TDatum* CP::TDataVector::FindDatum(const char* name) {
+    // Use the index if the data vector is large enough.  An empty name is
+    // handled by the linear search since it only matches unnamed objects.
+    if (name && *name) {
+        TNameIndex* index = GetNameIndex();
+        if (index) return index->Find(name);
+    }
+
     TDatumVector::reverse_iterator i;
     
     // Check to see if the object is in the temporary storage.
@@ -122,6 +313,7 @@ void CP::TDataVector::InsertDatum(CP::TDatum* val) {
     if (!val) return;
     val->ReassignParentDatum(this);
     fVector.push_back(val);
+    IncrementGeneration();
 }
 
 // Insert the element into the temporary storage. 
@@ -129,6 +321,7 @@ void CP::TDataVector::InsertTemporary(CP::TDatum* val) {
     if (!val) return;
     val->ReassignParentDatum(this);
     fTemporary.push_back(val);
+    IncrementGeneration();
 }
 
 // Add a temporary datum to the TDataVector object.  The temporary object will
@@ -173,6 +366,7 @@ bool CP::TDataVector::IsTemporary(CP::THandle<CP::TDatum> val) {
 
 // Delete the contents of the CP::TDataVector.
 void CP::TDataVector::Clear(Option_t*) {
+    InvalidateNameIndex();
     for (iterator i = begin(); i != end(); ++i) {
         (*i)->AssignParentDatum(NULL);
         delete (*i);
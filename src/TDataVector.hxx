@@ -103,7 +103,7 @@ public:
     typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
     /// @}
 
-    TDataVector() : TData("",T_DATA_VECTOR_TITLE) { };
+    TDataVector() : TData("",T_DATA_VECTOR_TITLE), fNameIndex(NULL) { };
 
     /// Create a new TDataVector.  A TDataVector inherits two fields from
     /// TNamed, "Name" and "Title".  The name is the handle that is
@@ -117,7 +117,7 @@ public:
     /// Interaction Data".  The default title is "Event Data Vector".
     explicit TDataVector(const char* name,
                          const char* title = T_DATA_VECTOR_TITLE)  
-        : TData(name,title) { };
+        : TData(name,title), fNameIndex(NULL) { };
 
     /// This will recursively delete the data vector *AND* all of the
     /// children.
@@ -125,7 +125,11 @@ public:
 
     /// A virtual method that is used to find data in this.  The Get member
     /// template will use FindDatum to implement the error checked access.
-    /// This is a pure virtual function since it must be implemented.
+    /// This is a pure virtual function since it must be implemented.  If
+    /// several objects have the same name, the last temporary object is
+    /// found, and then the last object in the main storage.  Large data
+    /// vectors keep a hash index of the names so the search doesn't need to
+    /// compare every name.
     virtual TDatum* FindDatum(const char* name);
 
     /// Add a temporary TDatum that will not be saved to the output file.
@@ -246,13 +250,32 @@ protected:
     /// Insert the object into the temporary storage.
     virtual void InsertTemporary(TDatum* val);
 
+    /// Drop the name index when a child is renamed.
+    virtual void ChildRenamed(TDatum* element);
+
 private: 
+    /// The type of the hash index of the child names.  This is defined in
+    /// the implementation file.
+    class TNameIndex;
+
+    /// Get the name index, building or updating it as needed.  This returns
+    /// NULL if the data vector is too small to need an index.  The index is
+    /// built under a lock, so several threads can read the same data
+    /// vector.
+    TNameIndex* GetNameIndex() const;
+
+    /// Delete the name index so it will be rebuilt when it's next needed.
+    void InvalidateNameIndex() const;
+
     TDatumVector fVector;
     
     /// Hold all of the temporary objects.  These objects are not saved in the
     /// output file.
     TDatumVector fTemporary; //! Do Not Save
 
+    /// The lazily built index of the child names.
+    mutable TNameIndex* fNameIndex; //! Do Not Save
+
     ClassDef(TDataVector,4);
 };
 
@@ -6,6 +6,8 @@
 // implemented here.
 #include <string.h>
 
+#include <atomic>
+
 #include <TClass.h>
 #include <TDataMember.h>
 #include <TDataType.h>
@@ -16,13 +18,36 @@
 
 ClassImp(CP::TDatum);
 
+namespace {
+    /// The number of generation values reserved by a thread at a time.
+    const unsigned long kGenerationBlock = 1UL << 16;
+
+    /// The first generation value that hasn't been reserved by a thread.
+    std::atomic<unsigned long> gGenerationBlocks(1);
+
+    /// Get a generation value that has never been used before.  The values
+    /// are handed out from a block reserved by each thread so that the
+    /// threads don't contend for a shared counter.
+    unsigned long NextGeneration() {
+        thread_local unsigned long next = 0;
+        thread_local unsigned long last = 0;
+        if (next == last) {
+            next = gGenerationBlocks.fetch_add(kGenerationBlock);
+            last = next + kGenerationBlock;
+        }
+        return next++;
+    }
+}
+
 CP::TDatum::TDatum() 
-    : TNamed("unnamed",TDATUM_TITLE), fParent(NULL) { 
+    : TNamed("unnamed",TDATUM_TITLE), fParent(NULL),
+      fGeneration(NextGeneration()) { 
     SetBit(kCanDelete,true);
 }
 
 CP::TDatum::TDatum(const char* name, const char* title) 
-    : TNamed(name,title), fParent(NULL) { 
+    : TNamed(name,title), fParent(NULL),
+      fGeneration(NextGeneration()) { 
     SetBit(kCanDelete,true);
 }
 
@@ -31,6 +56,33 @@ CP::TDatum::~TDatum() {
     fParent = NULL;
 }
 
+unsigned long CP::TDatum::GetGeneration() const {
+    return GetRootDatum()->fGeneration;
+}
+
+void CP::TDatum::IncrementGeneration() {
+    GetRootDatum()->fGeneration = NextGeneration();
+}
+
+void CP::TDatum::AssignParentDatum(CP::TDatum *parent) {
+    // Change the generation of the old tree, and the new tree.
+    IncrementGeneration();
+    fParent = parent;
+    IncrementGeneration();
+}
+
+void CP::TDatum::SetName(const char* name) {
+    TNamed::SetName(name);
+    if (fParent) fParent->ChildRenamed(this);
+    IncrementGeneration();
+}
+
+void CP::TDatum::SetNameTitle(const char* name, const char* title) {
+    TNamed::SetNameTitle(name,title);
+    if (fParent) fParent->ChildRenamed(this);
+    IncrementGeneration();
+}
+
 void CP::TDatum::ReassignParentDatum(CP::TDatum *parent) {
     CP::TDatum *old = GetParentDatum();
     
@@ -39,7 +91,9 @@ void CP::TDatum::ReassignParentDatum(CP::TDatum *parent) {
 
     if (old) old->RemoveDatum(this);
 
+    // RemoveDatum changed the generation of the old tree.
     fParent = parent;
+    IncrementGeneration();
 }
 
 TString CP::TDatum::GetFullName(void) const {
@@ -253,7 +307,9 @@ CP::TDatum* CP::TDatum::RemoveDatum(CP::TDatum* element) {
     // pointer to the element.  If this object is not the parent, then just
     // return NULL.
     if (element->fParent != this) return NULL;
+    IncrementGeneration();
     element->fParent = NULL;
+    element->IncrementGeneration();
     return element;
 }
 
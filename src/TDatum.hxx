@@ -16,6 +16,7 @@
 #include "THandle.hxx"
 #include "ECore.hxx"
 #include "TCaptLog.hxx"
+#include "TDatumPath.hxx"
 
 namespace CP {
     EXCEPTION(EDatum,ECore);
@@ -70,6 +71,7 @@ class CP::TDatum : public TNamed {
     friend class TDataVector;
     friend class TDataSymLink;
     friend class TDataLink;
+    friend class TDatumPath;
 
 public:
     TDatum();
@@ -142,27 +144,20 @@ public:
     /// referenced object is a link reference class. WARNING: This cannot be
     /// used interactively inside of early root versions.
     template <class T> CP::THandle<T> Get(const char* name=".") const {
-        TDatum *d = RecursiveFind(name);
-        if (!d) return THandle<T>(NULL);
-        T* t = dynamic_cast<T*>(d->GetThis());
-        if (!t) {
-            TObject* tmp = d->GetThis();
-            if (!tmp) tmp = d;
-            CaptWarn(ClassName() << "::Get<" << T::Class_Name() 
-                      << ">(" << name << "): Cannot convert from"
-                      << " \"" << tmp->ClassName() << "\""
-                      << " to \"" << T::Class_Name() << "\""
-                      << std::endl
-                      << "    Object name:"
-                      << " \"" << d->GetFullName() << "\"");
-            throw EBadConversion();
-        }
-        return THandle<T>(t,false);
+        return ConvertDatum<T>(RecursiveFind(name),name);
     }
 
     template <class T> CP::THandle<T> Get(const std::string& name) const {
         return Get<T>(name.c_str());
     }
+
+    /// Get a datum using a pre-parsed path.  The path remembers the result
+    /// of the last search, so this is much faster than using a string when
+    /// the same path is used repeatedly (e.g. for every event).  See
+    /// TDatumPath for details.
+    template <class T> CP::THandle<T> Get(const CP::TDatumPath& path) const {
+        return ConvertDatum<T>(path.Find(*this),path.GetName());
+    }
     //@}
 
     /// Check that a reference to an element the name space (see the Get()
@@ -193,6 +188,13 @@ public:
         return *object;
     }
 
+    /// Use a datum with a pre-parsed path (see TDatumPath).
+    template <class T> T& Use(const CP::TDatumPath& path) const {
+        THandle<T> object(Get<T>(path));
+        if (!object) throw ENoSuchElement();
+        return *object;
+    }
+
     /// Check that a particular element exists in the name space (see the
     /// Get() method for naming syntax details).
     template <class T> bool Has(const std::string& name) const {
@@ -203,6 +205,31 @@ public:
         return true;
     }
 
+    /// Check that an element exists using a pre-parsed path (see
+    /// TDatumPath).
+    template <class T> bool Has(const CP::TDatumPath& path) const {
+        TDatum *d = path.Find(*this);
+        if (!d) return false;
+        T* t = dynamic_cast<T*>(d->GetThis());
+        if (!t) return false;
+        return true;
+    }
+
+    /// Return the generation of the tree holding this datum.  The generation
+    /// is kept by the root datum, and is changed whenever a datum in the
+    /// tree is renamed, or moved into or out of a container, so that a
+    /// cached lookup (see TDatumPath) can tell if it's still valid.  Every
+    /// tree gets a generation that has never been used before, so a tree
+    /// allocated at the address of a deleted tree won't match a stale
+    /// lookup.  A change to a different tree doesn't change the generation.
+    unsigned long GetGeneration() const;
+
+    /// @{Override the TNamed methods so that the generation is changed when
+    /// a datum is renamed.
+    virtual void SetName(const char* name);
+    virtual void SetNameTitle(const char* name, const char* title);
+    /// @}
+
     /// A virtual method that is used to find data in "this".  The
     /// derived class will provide a FindDatum that understands the
     /// specific container used and the Get member template will use
@@ -246,7 +273,16 @@ protected:
     /// different in that ReassignParentDatum because this will not try to
     /// remove the datum from the parent before setting the parent
     /// field.
-    virtual void AssignParentDatum(TDatum *parent) {fParent = parent;};
+    virtual void AssignParentDatum(TDatum *parent);
+
+    /// Called when a child of this datum is renamed so that a container can
+    /// update any lookup tables.  The default does nothing.
+    virtual void ChildRenamed(TDatum*) {}
+
+    /// Change the generation of the tree holding this datum.  This must be
+    /// called by any derived class that changes the result of a name lookup
+    /// without changing a parent (e.g. by changing a link).
+    void IncrementGeneration();
 
     /// Used by the Get<> method template to find the actual object to
     /// return.  For instance, the name might be "dir/subdir/object",
@@ -297,9 +333,34 @@ protected:
     virtual TDatum* RemoveDatum(TDatum* element);
 
 private:
+    /// Do the dynamic_cast for the Get<>() methods and report errors.  The
+    /// name is only used in the error message.
+    template <class T> CP::THandle<T> ConvertDatum(TDatum* d,
+                                                  const char* name) const {
+        if (!d) return THandle<T>(NULL);
+        T* t = dynamic_cast<T*>(d->GetThis());
+        if (!t) {
+            TObject* tmp = d->GetThis();
+            if (!tmp) tmp = d;
+            CaptWarn(ClassName() << "::Get<" << T::Class_Name() 
+                      << ">(" << name << "): Cannot convert from"
+                      << " \"" << tmp->ClassName() << "\""
+                      << " to \"" << T::Class_Name() << "\""
+                      << std::endl
+                      << "    Object name:"
+                      << " \"" << d->GetFullName() << "\"");
+            throw EBadConversion();
+        }
+        return THandle<T>(t,false);
+    }
+
     /// The parent which owns this.
     TDatum *fParent;
 
+    /// The generation of the tree when this is the root datum (see
+    /// GetGeneration()).
+    unsigned long fGeneration; //! Don't Save
+
     ClassDef(TDatum,2);
 };
 
@@ -0,0 +1,139 @@
+#include <cstring>
+
+#include "TDatumPath.hxx"
+#include "TDatum.hxx"
+
+CP::TDatumPath::TDatumPath(const char* name)
+    : fName(name ? name : ""), fCachedStart(NULL), fCachedGeneration(0),
+      fCachedResult(NULL) {
+    Compile();
+}
+
+CP::TDatumPath::TDatumPath(const std::string& name)
+    : fName(name), fCachedStart(NULL), fCachedGeneration(0),
+      fCachedResult(NULL) {
+    Compile();
+}
+
+CP::TDatumPath::~TDatumPath() {}
+
+void CP::TDatumPath::Reset() const {
+    fCachedStart = NULL;
+    fCachedResult = NULL;
+}
+
+// Parse the name into steps following the same rules as
+// TDatum::RecursiveFind().
+void CP::TDatumPath::Compile() {
+    std::string name(fName);
+    if (name.empty()) return;
+
+    // A "//" after the beginning of the name refers to an unnamed datum, so
+    // replace it with "/:/" (":" is the name used for unnamed datum by
+    // TDatumCompareName).
+    for (std::size_t dslash = name.find("//",1);
+         dslash != std::string::npos;
+         dslash = name.find("//",dslash+1)) {
+        name.insert(dslash+1,":");
+    }
+
+    std::size_t pos = 0;
+    if (name.compare(0,2,"//") == 0) {
+        // The name syntax is //xxxx/yyyy so go to the root of the tree and
+        // check the name.  A bare "//" is just the root of the tree.
+        fSteps.push_back(Step(kRoot));
+        pos = 2;
+        if (pos < name.size()) {
+            std::size_t slash = name.find('/',pos);
+            fSteps.push_back(Step(kCheckName,name.substr(pos,slash-pos)));
+            pos = (slash == std::string::npos) ? name.size() : slash+1;
+        }
+    }
+
+    while (pos < name.size()) {
+        if (name[pos] == '/') {
+            // The name syntax is /xxxx/yyyy so look up the tree for xxxx.
+            ++pos;
+            std::size_t slash = name.find('/',pos);
+            fSteps.push_back(Step(kSearchUp,name.substr(pos,slash-pos)));
+            pos = (slash == std::string::npos) ? name.size() : slash+1;
+        }
+        else if (name[pos] == '.') {
+            // The name syntax is "./" or "../".
+            ++pos;
+            if (pos < name.size() && name[pos] == '.') {
+                fSteps.push_back(Step(kParent));
+                ++pos;
+            }
+            if (pos >= name.size()) break;
+            if (name[pos] == '/') {
+                ++pos;
+                continue;
+            }
+            fSteps.push_back(Step(kNoMatch));
+            break;
+        }
+        else if (name[pos] == '~') {
+            // The name syntax must be "~/".
+            ++pos;
+            if (pos >= name.size() || name[pos] != '/') {
+                fSteps.push_back(Step(kBadName));
+                break;
+            }
+            ++pos;
+            fSteps.push_back(Step(kRoot));
+        }
+        else {
+            // The name syntax is xxxx/yyyy.
+            std::size_t slash = name.find('/',pos);
+            fSteps.push_back(Step(kChild,name.substr(pos,slash-pos)));
+            pos = (slash == std::string::npos) ? name.size() : slash+1;
+        }
+    }
+}
+
+CP::TDatum* CP::TDatumPath::Find(const CP::TDatum& start) const {
+    unsigned long generation = start.GetGeneration();
+    if (fCachedStart == &start && fCachedGeneration == generation) {
+        return fCachedResult;
+    }
+    CP::TDatum* result = Resolve(start);
+    fCachedStart = &start;
+    fCachedGeneration = generation;
+    fCachedResult = result;
+    return result;
+}
+
+CP::TDatum* CP::TDatumPath::Resolve(const CP::TDatum& start) const {
+    CP::TDatum* result = const_cast<CP::TDatum*>(&start);
+    for (std::vector<Step>::const_iterator step = fSteps.begin();
+         step != fSteps.end(); ++step) {
+        switch (step->fType) {
+        case kRoot:
+            result = result->GetRootDatum();
+            break;
+        case kCheckName:
+            if (step->fName != result->GetName()) return NULL;
+            continue;
+        case kSearchUp:
+            while (result && step->fName != result->GetName()) {
+                result = result->GetParentDatum();
+            }
+            break;
+        case kParent:
+            result = result->GetParentDatum();
+            break;
+        case kChild:
+            result = result->FindDatum(step->fName.c_str());
+            break;
+        case kNoMatch:
+            return NULL;
+        case kBadName:
+            throw CP::EBadName();
+        }
+        if (!result) return NULL;
+        result = result->GetThis();
+        if (!result) return NULL;
+    }
+    return result;
+}
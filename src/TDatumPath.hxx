@@ -0,0 +1,103 @@
+#ifndef TDatumPath_hxx_seen
+#define TDatumPath_hxx_seen
+
+#include <string>
+#include <vector>
+
+namespace CP {
+    class TDatum;
+    class TDatumPath;
+}
+
+/// A TDatum path name (see TDatum::Get() for the syntax) that is parsed once
+/// and remembers the last datum it was resolved to.  Looking up a datum with
+/// a string name needs to copy and parse the name, and then compare the
+/// name of every child at each level of the path.  A TDatumPath does the
+/// parsing when it's constructed, and when it's used again with the same
+/// starting datum, and the data tree hasn't changed, it returns the
+/// previous result without doing the search.  A typical use is to make the
+/// path a static (or a class member) so that it is reused for every event.
+///
+/// \code
+/// static CP::TDatumPath driftPath("~/hits/drift");
+/// CP::THandle<CP::THitSelection> drift
+///     = event.Get<CP::THitSelection>(driftPath);
+/// \endcode
+///
+/// The cached result is checked against the generation of the tree holding
+/// the starting datum, which is changed whenever a datum in the tree is
+/// renamed, or moved into or out of a container (see
+/// TDatum::GetGeneration()), so a stale result is never returned.  A link to
+/// a datum in a different tree is followed when the path is resolved, but a
+/// change to the other tree isn't noticed.  The cache is not protected
+/// against concurrent use, so a path shouldn't be shared by threads that
+/// are processing different events (make it thread_local instead of
+/// static).
+class CP::TDatumPath {
+public:
+    /// Parse a path name.  The name syntax is described in TDatum::Get().
+    explicit TDatumPath(const char* name);
+    explicit TDatumPath(const std::string& name);
+    ~TDatumPath();
+
+    /// Find the datum referenced by the path starting from a datum.  This
+    /// returns NULL if the datum doesn't exist, and throws EBadName if the
+    /// path is not valid (e.g. "~xxx").  The result has already been passed
+    /// through TDatum::GetThis() so links are followed.
+    CP::TDatum* Find(const CP::TDatum& start) const;
+
+    /// Get the path name.
+    const char* GetName() const {return fName.c_str();}
+
+    /// Forget the cached result.  This is never required for correctness.
+    void Reset() const;
+
+private:
+    /// The operations that make up a compiled path.
+    enum EStepType {
+        /// Go to the root of the tree (e.g. "~/" or "//").
+        kRoot,
+        /// Check that the current datum has a name (e.g. "//xxx/").
+        kCheckName,
+        /// Go up the tree to the first datum with a name (e.g. "/xxx/").
+        kSearchUp,
+        /// Go to the parent (e.g. "../").
+        kParent,
+        /// Find a child datum with a name (e.g. "xxx/").
+        kChild,
+        /// The path can never match anything (e.g. ".xxx").
+        kNoMatch,
+        /// The path is illegal and EBadName is thrown (e.g. "~xxx").
+        kBadName
+    };
+
+    /// One step of the compiled path.
+    struct Step {
+        Step(EStepType type, const std::string& name = "")
+            : fType(type), fName(name) {}
+        EStepType fType;
+        std::string fName;
+    };
+
+    /// Parse the name into steps.
+    void Compile();
+
+    /// Search for the datum without using the cache.
+    CP::TDatum* Resolve(const CP::TDatum& start) const;
+
+    /// The path name.
+    std::string fName;
+
+    /// The compiled steps.
+    std::vector<Step> fSteps;
+
+    /// The datum where the last search started.
+    mutable const CP::TDatum* fCachedStart;
+
+    /// The generation of the data tree when the last search was done.
+    mutable unsigned long fCachedGeneration;
+
+    /// The result of the last search.
+    mutable CP::TDatum* fCachedResult;
+};
+#endif
@@ -0,0 +1,160 @@
+#include <atomic>
+#include <vector>
+
+#include <TStorage.h>
+
+#include "TEventArena.hxx"
+
+namespace {
+    /// The header in front of every allocation.  This points to the block
+    /// set that holds the allocation, or is NULL for heap allocations.  The
+    /// header size keeps the objects aligned for any type.
+    struct alignas(16) AllocationHeader {
+        void* fBlocks;
+    };
+
+    /// The arena that is current for this thread.
+    thread_local CP::TEventArena* tCurrentArena = NULL;
+
+    /// Round a size up to keep the allocations aligned.
+    std::size_t AlignedSize(std::size_t size) {
+        const std::size_t align = alignof(AllocationHeader);
+        return (size + align - 1) & ~(align - 1);
+    }
+}
+
+/// A set of blocks that are used (and freed) together.  The reference count
+/// is the number of live objects in the blocks plus one for the arena that
+/// is allocating from them.  The last reference to be released deletes the
+/// block set, so blocks that were abandoned by TEventArena::Reset() are
+/// freed when the last object in them is deleted.
+class CP::TEventArena::TBlockSet {
+public:
+    TBlockSet() : fReferences(1), fNextBlock(0),
+                  fCurrent(NULL), fEnd(NULL) {}
+
+    ~TBlockSet() {
+        for (std::vector<char*>::iterator b = fBlocks.begin();
+             b != fBlocks.end(); ++b) {
+            ::operator delete(*b);
+        }
+    }
+
+    /// Drop a reference and delete the block set if it was the last one.
+    void Release() {
+        if (fReferences.fetch_sub(1,std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    /// Start allocating from the first block again.
+    void Rewind() {
+        fNextBlock = 0;
+        fCurrent = fEnd = NULL;
+    }
+
+    /// Get space for an allocation, moving to the next block (allocating
+    /// it if needed) when the current block is full.
+    char* Take(std::size_t size, std::size_t blockSize) {
+        if (static_cast<std::size_t>(fEnd - fCurrent) < size) {
+            if (fNextBlock >= fBlocks.size()) {
+                fBlocks.push_back(
+                    static_cast<char*>(::operator new(blockSize)));
+            }
+            fCurrent = fBlocks[fNextBlock++];
+            fEnd = fCurrent + blockSize;
+        }
+        char* space = fCurrent;
+        fCurrent += size;
+        fReferences.fetch_add(1,std::memory_order_relaxed);
+        return space;
+    }
+
+    /// The live object count plus one for the owning arena.
+    std::atomic<long> fReferences;
+
+    /// The blocks of memory.
+    std::vector<char*> fBlocks;
+
+    /// The index of the next block in fBlocks to allocate from.
+    std::size_t fNextBlock;
+
+    /// The next free byte in the current block.
+    char* fCurrent;
+
+    /// The end of the current block.
+    char* fEnd;
+};
+
+CP::TEventArena::TEventArena(std::size_t blockSize)
+    : fBlockSize(AlignedSize(blockSize)), fBlocks(new TBlockSet),
+      fAllocatedBytes(0), fAbandonedCount(0) { }
+
+CP::TEventArena::~TEventArena() {
+    if (tCurrentArena == this) tCurrentArena = NULL;
+    fBlocks->Release();
+}
+
+CP::TEventArena::TScope::TScope(CP::TEventArena* arena)
+    : fPrevious(tCurrentArena) {
+    tCurrentArena = arena;
+}
+
+CP::TEventArena::TScope::~TScope() {
+    tCurrentArena = fPrevious;
+}
+
+CP::TEventArena* CP::TEventArena::GetCurrent() {
+    return tCurrentArena;
+}
+
+void* CP::TEventArena::AllocateLocal(std::size_t size) {
+    std::size_t total = sizeof(AllocationHeader) + AlignedSize(size);
+    if (total > fBlockSize/4) return NULL;
+    AllocationHeader* header
+        = reinterpret_cast<AllocationHeader*>(fBlocks->Take(total,fBlockSize));
+    header->fBlocks = fBlocks;
+    fAllocatedBytes += total;
+    return header + 1;
+}
+
+void* CP::TEventArena::Allocate(std::size_t size) {
+    if (tCurrentArena) {
+        void* object = tCurrentArena->AllocateLocal(size);
+        if (object) return object;
+    }
+    // Use the ROOT allocator so that TObject::IsOnHeap() works.
+    AllocationHeader* header = static_cast<AllocationHeader*>(
+        TStorage::ObjectAlloc(sizeof(AllocationHeader) + size));
+    header->fBlocks = NULL;
+    return header + 1;
+}
+
+void CP::TEventArena::Deallocate(void* object) {
+    if (!object) return;
+    AllocationHeader* header = static_cast<AllocationHeader*>(object) - 1;
+    if (!header->fBlocks) {
+        TStorage::ObjectDealloc(header);
+        return;
+    }
+    static_cast<TBlockSet*>(header->fBlocks)->Release();
+}
+
+void CP::TEventArena::Reset() {
+    fAllocatedBytes = 0;
+    if (fBlocks->fReferences.load(std::memory_order_acquire) == 1) {
+        // Everything has been deleted so the blocks can be reused.
+        fBlocks->Rewind();
+        return;
+    }
+    // Objects are still alive, so give up the blocks.  They are freed when
+    // the last object is deleted.
+    ++fAbandonedCount;
+    TBlockSet* old = fBlocks;
+    fBlocks = new TBlockSet;
+    old->Release();
+}
+
+long CP::TEventArena::GetLiveCount() const {
+    return fBlocks->fReferences.load(std::memory_order_relaxed) - 1;
+}
@@ -0,0 +1,126 @@
+#ifndef TEventArena_hxx_seen
+#define TEventArena_hxx_seen
+
+#include <cstddef>
+
+namespace CP {
+    class TEventArena;
+}
+
+/// Declare the allocation operators for a class that can be allocated from
+/// the current TEventArena.  This must be placed in the public section of
+/// the class declaration, and is inherited by derived classes.  Objects of
+/// the class are still deleted normally (e.g. by the THandle or the
+/// container that owns them), and the memory is returned to the arena.
+#define EVENT_ARENA_ALLOCATED                                           \
+    static void* operator new(std::size_t size) {                       \
+        return CP::TEventArena::Allocate(size);                         \
+    }                                                                   \
+    static void* operator new(std::size_t, void* place) {return place;} \
+    static void operator delete(void* object) {                         \
+        CP::TEventArena::Deallocate(object);                            \
+    }                                                                   \
+    static void operator delete(void*, void*) {}
+
+/// A monotonic memory arena for the objects created while an event is being
+/// processed.  The event model classes (the THandle internals, TReconBase,
+/// TReconNode, TReconState, TCorrValues, and THitSelection) are allocated
+/// from the arena that is current for the thread, and from the heap when
+/// there isn't a current arena.  The arena hands out memory by advancing a
+/// pointer through large blocks, and the memory is reclaimed in bulk by
+/// Reset() after the event has been deleted, so the per-object cost of
+/// malloc and free is avoided.  The objects are constructed and destroyed
+/// normally, so they can be owned by handles (THandleBaseDeletable deletes
+/// them as usual), and the destructors free any memory the objects own.
+///
+/// \code
+/// CP::TEventArena arena;
+/// for (each event) {
+///     {
+///         CP::TEventArena::TScope scope(&arena);
+///         userCode.Process(*event);
+///     }
+///     delete event;
+///     arena.Reset();
+/// }
+/// \endcode
+///
+/// An object that is still alive when Reset() is called (e.g. a handle
+/// saved by the user code between events) stays valid.  The blocks
+/// holding the surviving objects are given up by the arena, and they are
+/// freed when the last object in them is deleted (which may be on a
+/// different thread).  Objects allocated from an arena aren't marked as
+/// on the heap by ROOT (TObject::IsOnHeap()), so they shouldn't be owned
+/// by a ROOT collection.
+class CP::TEventArena {
+public:
+    /// Create an arena that allocates memory in blocks of blockSize bytes.
+    /// Allocations larger than a quarter of a block come from the heap.
+    explicit TEventArena(std::size_t blockSize = 1024*1024);
+    ~TEventArena();
+
+    /// Make an arena current for this thread while the scope exists.  If the
+    /// arena is NULL, objects are allocated from the heap.
+    class TScope {
+    public:
+        explicit TScope(TEventArena* arena);
+        ~TScope();
+    private:
+        TScope(const TScope&);
+        TScope& operator = (const TScope&);
+        TEventArena* fPrevious;
+    };
+
+    /// Allocate memory from the current arena for this thread, or from the
+    /// heap if there isn't a current arena.  This is used by the
+    /// EVENT_ARENA_ALLOCATED operators.
+    static void* Allocate(std::size_t size);
+
+    /// Return memory allocated by Allocate().  This can be called from any
+    /// thread.
+    static void Deallocate(void* object);
+
+    /// Get the arena that is current for this thread (may be NULL).
+    static TEventArena* GetCurrent();
+
+    /// Reclaim the memory in the arena.  If all of the objects have been
+    /// deleted, the blocks are reused.  Otherwise, the blocks are given up
+    /// (and freed when the remaining objects are deleted), and new blocks
+    /// are used for the next event.
+    void Reset();
+
+    /// The number of objects allocated from the arena since the last Reset()
+    /// that haven't been deleted.
+    long GetLiveCount() const;
+
+    /// The number of bytes allocated from the arena since the last Reset().
+    std::size_t GetAllocatedBytes() const {return fAllocatedBytes;}
+
+    /// The number of times that Reset() had to give up the blocks because
+    /// objects were still alive.
+    long GetAbandonedCount() const {return fAbandonedCount;}
+
+private:
+    TEventArena(const TEventArena&);
+    TEventArena& operator = (const TEventArena&);
+
+    /// The blocks of memory that are used together.  This is defined in the
+    /// implementation file.
+    class TBlockSet;
+
+    /// Allocate memory from this arena.
+    void* AllocateLocal(std::size_t size);
+
+    /// The size of the blocks being allocated.
+    std::size_t fBlockSize;
+
+    /// The blocks for the current event.
+    TBlockSet* fBlocks;
+
+    /// The number of bytes allocated since the last Reset().
+    std::size_t fAllocatedBytes;
+
+    /// The number of times the blocks were abandoned.
+    long fAbandonedCount;
+};
+#endif
@@ -17,6 +17,20 @@
 CP::TEventFolder* CP::TEventFolder::fEventFolder = NULL;
 CP::TEvent* CP::TEventFolder::fCurrentEvent = NULL;
 
+namespace {
+    /// The event made current for this thread by TEventFolder::TScope.
+    thread_local CP::TEvent* tScopeEvent = NULL;
+}
+
+CP::TEventFolder::TScope::TScope(CP::TEvent* event)
+    : fPrevious(tScopeEvent) {
+    tScopeEvent = event;
+}
+
+CP::TEventFolder::TScope::~TScope() {
+    tScopeEvent = fPrevious;
+}
+
 CP::TEventFolder::TEventFolder() {
     fFolderOfEvents = NULL;
 }
@@ -94,6 +108,7 @@ CP::TEvent* CP::TEventFolder::FindEvent(int, int) const {
 }
 
 CP::TEvent* CP::TEventFolder::GetCurrentEvent(void) {
+    if (tScopeEvent) return tScopeEvent;
     return fCurrentEvent;
 }
 
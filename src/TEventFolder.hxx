@@ -66,6 +66,21 @@ public:
     /// code slow downs.
     static TEvent* GetCurrentEvent(void);
 
+    /// Make an event the current event for this thread while the scope
+    /// exists.  This lets events be processed on several threads at once
+    /// (e.g. by TAlgorithmScheduler), since GetCurrentEvent() returns the
+    /// event for the scope on the calling thread before the most recent
+    /// event.  The scope doesn't change the event folder.
+    class TScope {
+    public:
+        explicit TScope(TEvent* event);
+        ~TScope();
+    private:
+        TScope(const TScope&);
+        TScope& operator = (const TScope&);
+        TEvent* fPrevious;
+    };
+
     /// Set the pointer to the current event.  The event will become the
     /// current event if it is saved in the event folder.  If it is not in the
     /// event folder, then this does nothing.
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <time.h>
+
+#include <TTree.h>
+
+#include "TEventProfiler.hxx"
+#include "TRootOutput.hxx"
+#include "TCaptLog.hxx"
+
+namespace {
+    /// The number of profilers that are enabled.  The timers and the
+    /// allocation counters are only active when this isn't zero.
+    std::atomic<int> gProfilers(0);
+
+    /// The allocation hook has been installed (see
+    /// CP::TEventProfiler::InstallAllocationHook()).
+    std::atomic<bool> gAllocationHook(false);
+
+    /// The number of calls to operator new, and the bytes requested.
+    std::atomic<long long> gAllocations(0);
+    std::atomic<long long> gAllocatedBytes(0);
+
+    /// The maximum number of stages.
+    const int kMaxStages = 256;
+
+    /// The accumulated time in each stage in nanoseconds.
+    std::atomic<long long> gStageTimes[kMaxStages];
+
+    /// The number of stages and the stage names.  The names are protected
+    /// by StageMutex().
+    std::atomic<int> gStageCount(0);
+    std::string gStageNames[kMaxStages];
+
+    /// Protect the stage names.  This is never deleted so that timers can
+    /// be used during the program exit.
+    std::mutex& StageMutex() {
+        static std::mutex* mutex = new std::mutex;
+        return *mutex;
+    }
+
+    /// The stage numbers indexed by name.
+    std::map<std::string,int>& StageIndex() {
+        static std::map<std::string,int>* index
+            = new std::map<std::string,int>;
+        return *index;
+    }
+
+    long long WallTime() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    long long CpuTime() {
+        struct timespec now;
+        if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now) != 0) return 0;
+        return 1000000000LL*now.tv_sec + now.tv_nsec;
+    }
+
+    /// Make a legal branch name from a stage name.
+    std::string BranchName(const std::string& stage) {
+        std::string name = "stage_" + stage;
+        for (std::size_t i = 0; i<name.size(); ++i) {
+            char c = name[i];
+            if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z')
+                || ('0' <= c && c <= '9')) continue;
+            name[i] = '_';
+        }
+        return name;
+    }
+}
+
+CP::TEventProfiler::TEventProfiler()
+    : fEnabled(false), fStartWall(0), fStartCpu(0), fStartAllocations(0),
+      fStartAllocatedBytes(0) {}
+
+CP::TEventProfiler::~TEventProfiler() {
+    Enable(false);
+}
+
+bool CP::TEventProfiler::IsCountingAllocations() {
+    return gAllocationHook.load(std::memory_order_relaxed);
+}
+
+void CP::TEventProfiler::InstallAllocationHook() {
+    gAllocationHook.store(true);
+}
+
+void CP::TEventProfiler::CountAllocation(std::size_t size) {
+    if (gProfilers.load(std::memory_order_relaxed) < 1) return;
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void CP::TEventProfiler::Enable(bool enable) {
+    if (enable == fEnabled) return;
+    if (enable) {
+        CaptNamedInfo("MEM","Enabling the event profile");
+        if (!IsCountingAllocations()) {
+            CaptNamedInfo("MEM","Memory allocations are not counted"
+                          " (link with -lcaptEventAllocHook)");
+        }
+        ++gProfilers;
+    }
+    else {
+        CaptNamedInfo("MEM","Disabling the event profile");
+        --gProfilers;
+    }
+    fEnabled = enable;
+    Snapshot();
+}
+
+int CP::TEventProfiler::GetStage(const char* name) {
+    std::lock_guard<std::mutex> lock(StageMutex());
+    std::map<std::string,int>::iterator stage = StageIndex().find(name);
+    if (stage != StageIndex().end()) return stage->second;
+    int count = gStageCount.load();
+    if (count >= kMaxStages) {
+        CaptError("Too many profile stages (" << name << " is ignored)");
+        return -1;
+    }
+    gStageNames[count] = name;
+    StageIndex()[name] = count;
+    gStageCount.store(count+1);
+    return count;
+}
+
+int CP::TEventProfiler::GetStageCount() {
+    return gStageCount.load();
+}
+
+std::string CP::TEventProfiler::GetStageName(int stage) {
+    std::lock_guard<std::mutex> lock(StageMutex());
+    if (stage < 0 || stage >= gStageCount.load()) return "";
+    return gStageNames[stage];
+}
+
+CP::TEventProfiler::TTimer::TTimer(const char* stage)
+    : fStage(-1), fStart(0) {
+    if (gProfilers.load(std::memory_order_relaxed) < 1) return;
+    fStage = GetStage(stage);
+    fStart = WallTime();
+}
+
+CP::TEventProfiler::TTimer::~TTimer() {
+    if (fStage < 0) return;
+    gStageTimes[fStage].fetch_add(WallTime() - fStart,
+                                  std::memory_order_relaxed);
+}
+
+void CP::TEventProfiler::Snapshot() {
+    fStartWall = WallTime();
+    fStartCpu = CpuTime();
+    fStartAllocations = gAllocations.load();
+    fStartAllocatedBytes = gAllocatedBytes.load();
+    int stages = gStageCount.load();
+    fStartStages.resize(stages);
+    for (int i = 0; i<stages; ++i) fStartStages[i] = gStageTimes[i].load();
+}
+
+void CP::TEventProfiler::Mark() {
+    if (!fEnabled) return;
+    Snapshot();
+}
+
+void CP::TEventProfiler::LogEvent(int run, int event) {
+    if (!fEnabled) return;
+    TEventRecord record;
+    record.fRun = run;
+    record.fEvent = event;
+    record.fWallTime = 1E-9*(WallTime() - fStartWall);
+    record.fCpuTime = 1E-9*(CpuTime() - fStartCpu);
+    record.fAllocations = -1;
+    record.fAllocatedBytes = -1;
+    if (IsCountingAllocations()) {
+        record.fAllocations = gAllocations.load() - fStartAllocations;
+        record.fAllocatedBytes
+            = gAllocatedBytes.load() - fStartAllocatedBytes;
+    }
+    int stages = gStageCount.load();
+    record.fStageTimes.resize(stages);
+    for (int i = 0; i<stages; ++i) {
+        long long start = (i < (int) fStartStages.size()) ?
+            fStartStages[i]: 0;
+        record.fStageTimes[i] = 1E-9*(gStageTimes[i].load() - start);
+    }
+    fEvents.push_back(record);
+    Snapshot();
+}
+
+void CP::TEventProfiler::Write(CP::TRootOutput* output) {
+    if (!fEnabled) return;
+    if (fEvents.empty()) return;
+
+    int stages = GetStageCount();
+    if (output && output->IsOpen()) {
+        CaptNamedInfo("MEM","Writing the event profile to file");
+        output->cd();
+
+        // Copy each record into the branch variables and fill the tree.
+        // The stages are only known now, so the tree is built here.
+        TEventRecord entry;
+        entry.fStageTimes.resize(stages);
+        TTree tree("eventProfile", "Resources used by each event");
+        tree.Branch("run", &entry.fRun, "run/I");
+        tree.Branch("event", &entry.fEvent, "event/I");
+        tree.Branch("wall", &entry.fWallTime, "wall/D");
+        tree.Branch("cpu", &entry.fCpuTime, "cpu/D");
+        tree.Branch("allocations", &entry.fAllocations, "allocations/L");
+        tree.Branch("allocatedBytes", &entry.fAllocatedBytes,
+                    "allocatedBytes/L");
+        for (int i = 0; i<stages; ++i) {
+            std::string name = BranchName(GetStageName(i));
+            tree.Branch(name.c_str(), &entry.fStageTimes[i],
+                        (name + "/D").c_str());
+        }
+        for (std::vector<TEventRecord>::iterator e = fEvents.begin();
+             e != fEvents.end(); ++e) {
+            entry.fRun = e->fRun;
+            entry.fEvent = e->fEvent;
+            entry.fWallTime = e->fWallTime;
+            entry.fCpuTime = e->fCpuTime;
+            entry.fAllocations = e->fAllocations;
+            entry.fAllocatedBytes = e->fAllocatedBytes;
+            for (int i = 0; i<stages; ++i) {
+                entry.fStageTimes[i] = (i < (int) e->fStageTimes.size()) ?
+                    e->fStageTimes[i]: 0.0;
+            }
+            tree.Fill();
+        }
+        tree.Write();
+    }
+
+    // Summarize the profile in the log.
+    double wallTime = 0.0;
+    double cpuTime = 0.0;
+    long long allocations = 0;
+    std::vector<double> stageTimes(stages,0.0);
+    std::size_t slowest = 0;
+    for (std::size_t e = 0; e<fEvents.size(); ++e) {
+        wallTime += fEvents[e].fWallTime;
+        cpuTime += fEvents[e].fCpuTime;
+        allocations += fEvents[e].fAllocations;
+        for (std::size_t i = 0; i<fEvents[e].fStageTimes.size(); ++i) {
+            stageTimes[i] += fEvents[e].fStageTimes[i];
+        }
+        if (fEvents[slowest].fWallTime < fEvents[e].fWallTime) slowest = e;
+    }
+    double events = fEvents.size();
+    std::ostringstream meanAllocations;
+    if (IsCountingAllocations()) meanAllocations << allocations/events;
+    else meanAllocations << "not available";
+    CaptNamedLog("MEM","Mean event wall time: " << wallTime/events << " s"
+                 << "  CPU time: " << cpuTime/events << " s"
+                 << "  Allocations: " << meanAllocations.str());
+    for (int i = 0; i<stages; ++i) {
+        CaptNamedLog("MEM","Stage " << GetStageName(i)
+                     << " mean time: " << stageTimes[i]/events << " s");
+    }
+    const TEventRecord& slow = fEvents[slowest];
+    CaptNamedLog("MEM","Slowest event (run,event): (" << slow.fRun
+                 << "," << slow.fEvent << ")  wall time: " << slow.fWallTime
+                 << " s  CPU time: " << slow.fCpuTime << " s");
+    for (std::size_t i = 0; i<slow.fStageTimes.size(); ++i) {
+        CaptNamedLog("MEM","    Stage " << GetStageName(i)
+                     << " time: " << slow.fStageTimes[i] << " s");
+    }
+}
@@ -0,0 +1,170 @@
+#ifndef TEventProfiler_hxx_seen
+#define TEventProfiler_hxx_seen
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace CP {
+    class TEventProfiler;
+    class TRootOutput;
+}
+
+/// Record a profile of the resources used by each event.  For each event,
+/// the profiler records the wall time, the CPU time of the process, the
+/// number of memory allocations and the number of bytes allocated (counted
+/// by the global operator new, see IsCountingAllocations()), and the time
+/// spent in each named stage.
+/// This is used inside the default eventLoop when the "-u" option is given,
+/// and the profile is written to the output file as a TTree named
+/// "eventProfile" with one entry per event.  The eventLoop times the user
+/// code in the "Process" stage, and TRootInput and TRootOutput time the
+/// event reading and writing in the "TRootInput" and "TRootOutput" stages.
+/// User code can time its own stages with a TTimer.
+///
+/// \code
+/// int operator () (CP::TEvent& event) {
+///     {
+///         CP::TEventProfiler::TTimer timer("fitTracks");
+///         FitTracks(event);
+///     }
+///     ...
+/// }
+/// \endcode
+///
+/// A timer does nothing unless a profiler is enabled.  The stage times are
+/// inclusive, so a stage timed inside of another stage is also counted in
+/// the outer stage.  Memory allocated from a TEventArena doesn't go through
+/// operator new, and isn't counted.
+///
+/// The allocations are counted by replacing the global operator new and
+/// delete, which is only done by the optional captEventAllocHook library.
+/// A program that should count allocations must be linked with
+/// "-lcaptEventAllocHook", or the library can be loaded with
+/// "LD_PRELOAD=libcaptEventAllocHook.so".  Without it, the allocation
+/// counts are recorded as -1 and reported as not available.
+class CP::TEventProfiler {
+public:
+    /// The resources used by one event.
+    struct TEventRecord {
+        /// The run and event number.
+        int fRun;
+        int fEvent;
+
+        /// The wall time in seconds.
+        double fWallTime;
+
+        /// The CPU time used by the process in seconds.
+        double fCpuTime;
+
+        /// The number of calls to operator new (-1 if the allocations are
+        /// not counted).
+        long long fAllocations;
+
+        /// The number of bytes requested from operator new (-1 if the
+        /// allocations are not counted).
+        long long fAllocatedBytes;
+
+        /// The time in seconds spent in each stage (indexed by the stage
+        /// number).  Stages that were created after the event have no
+        /// entry.
+        std::vector<double> fStageTimes;
+    };
+
+    /// Construct the profiler with profiling disabled.
+    TEventProfiler();
+    ~TEventProfiler();
+
+    /// Enable the event profile.  If this is not called, Mark(), LogEvent()
+    /// and Write() have no effect.  The profile is disabled when the
+    /// argument is false.
+    void Enable(bool enable = true);
+
+    /// Check if this profiler is enabled.
+    bool IsEnabled() const {return fEnabled;}
+
+    /// Start the next event record now.  The resources used since the last
+    /// call to Mark() or LogEvent() are not recorded.
+    void Mark();
+
+    /// Record the resources used since the last call to Mark() or
+    /// LogEvent() as one event, and start the next event record.  In the
+    /// eventLoop, this is called after an event has been written, so the
+    /// time reading an event is included with the event.
+    void LogEvent(int run, int event);
+
+    /// Get the events that have been recorded.
+    const std::vector<TEventRecord>& GetEvents() const {return fEvents;}
+
+    /// Write the profile tree to the top-level directory of the output file
+    /// and print a summary to the log.  The output may be NULL, and then
+    /// only the summary is printed.
+    void Write(CP::TRootOutput* output);
+
+    /// Get the number of the stage with a name, creating the stage if it
+    /// doesn't exist.
+    static int GetStage(const char* name);
+
+    /// Get the number of stages.
+    static int GetStageCount();
+
+    /// Get the name of a stage.
+    static std::string GetStageName(int stage);
+
+    /// Check if the memory allocations are counted.  This is true when the
+    /// captEventAllocHook library is linked into the program.
+    static bool IsCountingAllocations();
+
+    /// [Internal method] Tell the profiler that the allocations are being
+    /// counted.  This is called by the captEventAllocHook library when it
+    /// is loaded.
+    static void InstallAllocationHook();
+
+    /// [Internal method] Count an allocation of size bytes.  This is called
+    /// by the operator new in the captEventAllocHook library, and only
+    /// counts the allocation while a profiler is enabled.
+    static void CountAllocation(std::size_t size);
+
+    /// Time a stage while the timer exists.  The timer is ignored when no
+    /// profiler is enabled.
+    class TTimer {
+    public:
+        explicit TTimer(const char* stage);
+        ~TTimer();
+
+    private:
+        TTimer(const TTimer&);
+        TTimer& operator = (const TTimer&);
+
+        /// The stage being timed (negative if it isn't being timed).
+        int fStage;
+
+        /// The time that the timer started in nanoseconds.
+        long long fStart;
+    };
+
+private:
+    /// The resource counters at the start of the current event.
+    void Snapshot();
+
+    /// Whether to record the profile.  Set using Enable().
+    bool fEnabled;
+
+    /// The wall time at the start of the event in nanoseconds.
+    long long fStartWall;
+
+    /// The CPU time at the start of the event in nanoseconds.
+    long long fStartCpu;
+
+    /// The allocation counters at the start of the event.
+    long long fStartAllocations;
+    long long fStartAllocatedBytes;
+
+    /// The accumulated stage times at the start of the event in
+    /// nanoseconds.
+    std::vector<long long> fStartStages;
+
+    /// The recorded events.
+    std::vector<TEventRecord> fEvents;
+};
+#endif
@@ -1,4 +1,5 @@
 #include <memory>
+#include <mutex>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -26,13 +27,24 @@
 #include "TGeomIdFinder.hxx"
 #include "TCaptIdFinder.hxx"
 
-CP::TGeomIdManager::TGeomIdManager() {
+namespace {
+    /// Protect the lazy build of the geometry id map.  This is never
+    /// deleted so the map can be used during the program exit.
+    std::mutex& GeomIdMapMutex() {
+        static std::mutex* mutex = new std::mutex;
+        return *mutex;
+    }
+}
+
+CP::TGeomIdManager::TGeomIdManager()
+    : fGeoManager(NULL), fGeomIdMapBuilt(true) {
     ResetGeometry();
 }
 
 CP::TGeomIdManager::~TGeomIdManager() {}
 
 bool CP::TGeomIdManager::CdId(TGeometryId id) const {
+    CheckGeomIdMap();
     GeomIdKey gid = MakeGeomIdKey(id);
     GeomIdMap::const_iterator pair = fGeomIdMap.find(gid);
     if (pair != fGeomIdMap.end()) return CdKey(pair->second);
@@ -42,6 +54,7 @@ bool CP::TGeomIdManager::CdId(TGeometryId id) const {
 bool CP::TGeomIdManager::FindGeometryId(TGeometryId& id) const {
     // Save the current node.
     CP::TManager::Get().Geometry();
+    CheckGeomIdMap();
     gGeoManager->PushPath();
 
     bool success = true;
@@ -99,6 +112,7 @@ bool CP::TGeomIdManager::GetGeometryId(double x, double y, double z,
 void CP::TGeomIdManager::ResetGeometry() {
     fGeomIdMap.clear();
     fRootIdMap.clear();
+    fGeomIdMapBuilt = true;
     fGeomIdHashCode = TSHAHashValue();
     fGeomIdChangedHash = TSHAHashValue();
     fGeomIdAlignmentId = TAlignmentId();
@@ -118,7 +132,8 @@ void CP::TGeomIdManager::ResetGeometry() {
     // See if the geometry already has an alignment applied.
     GetAlignmentCode(fGeomIdAlignmentId);
 
-    BuildGeomIdMap();
+    // The geometry id map is built when it's first used.
+    fGeomIdMapBuilt = false;
 
     // Lock the geometry into memory.
     gGeoManager->LockGeometry();
@@ -488,6 +503,18 @@ CP::TGeometryId CP::TGeomIdManager::MakeGeometryId(GeomIdKey key) const {
     return TGeometryId(key);
 }
 
+void CP::TGeomIdManager::CheckGeomIdMap() const {
+    if (fGeomIdMapBuilt.load(std::memory_order_acquire)) return;
+    // Another thread might be building the map, so wait for it, and then
+    // check again.  The flag is set after the map is built so that a
+    // thread that sees it doesn't read a partial map.
+    std::lock_guard<std::mutex> lock(GeomIdMapMutex());
+    if (fGeomIdMapBuilt.load(std::memory_order_relaxed)) return;
+    CP::TGeomIdManager* self = const_cast<CP::TGeomIdManager*>(this);
+    if (gGeoManager) self->BuildGeomIdMap();
+    self->fGeomIdMapBuilt.store(true, std::memory_order_release);
+}
+
 void CP::TGeomIdManager::BuildGeomIdMap() {
     // DO NOT CALL TManager::Get().Geometry() HERE
 
@@ -710,6 +737,7 @@ void CP::TGeomIdManager::RecurseHashCode(std::vector<std::string>& names) {
 
 std::string CP::TGeomIdManager::GetPath(TGeometryId id) const {
     if (!gGeoManager) return "not-available";
+    CheckGeomIdMap();
     if (fGeomIdMap.empty()) return "not-available";
     if (id == TGeometryId()) return "empty";
 
@@ -734,13 +762,7 @@ TGeoManager* CP::TGeomIdManager::GetGeoManager() {
     return gGeoManager;
 }
 
-bool CP::TGeomIdManager::FindAndLoadGeometry(CP::TEvent* event) {
-    // Check to see if the geometry has already been overloaded
-    if (GetGeometryHashOverride().Equivalent(GetHash())) {
-        CaptNamedDebug("Geometry","Correct geometry override already loaded");
-        return false;
-    }
-
+bool CP::TGeomIdManager::LoadOverrideGeometry() {
     // Check to see if we have a hash code to override the default geometry.
     if (GetGeometryHashOverride().Valid()) {
         CaptNamedDebug("Geometry","Override standard geometry");
@@ -774,6 +796,33 @@ bool CP::TGeomIdManager::FindAndLoadGeometry(CP::TEvent* event) {
         }
     }
 
+    return false;
+}
+
+bool CP::TGeomIdManager::PrefetchGeometry() {
+    if (!GetGeometryHashOverride().Valid()
+        && GetGeometryFileOverride().empty()) return false;
+
+    // Load the override geometry unless it's already loaded.
+    if (!GetGeometryHashOverride().Equivalent(GetHash())
+        && !LoadOverrideGeometry()) {
+        return false;
+    }
+
+    CheckGeomIdMap();
+    return true;
+}
+
+bool CP::TGeomIdManager::FindAndLoadGeometry(CP::TEvent* event) {
+    // Check to see if the geometry has already been overloaded
+    if (GetGeometryHashOverride().Equivalent(GetHash())) {
+        CaptNamedDebug("Geometry","Correct geometry override already loaded");
+        return false;
+    }
+
+    // Check to see if the geometry has been overridden.
+    if (LoadOverrideGeometry()) return true;
+
     // Check to see if there is a geometry in the current file.  This
     // overrides the default geometry.
     TSHAHashValue hc;
@@ -1013,6 +1062,8 @@ void CP::TGeomIdManager::ApplyAlignment(const CP::TEvent* const event) {
         if (!id.Valid()) CaptNamedInfo("Geometry",
                                         "No alignment should be apply");
 
+        // The geometry id map must match the unaligned geometry.
+        CheckGeomIdMap();
         gGeoManager->UnlockGeometry();
         int alignmentCount = 0;
         // Apply alignment to each geometry element.
@@ -5,6 +5,10 @@
 #include <vector>
 #include <map>
 
+#ifndef __CINT__
+#include <atomic>
+#endif
+
 #include <TVector3.h>
 #include <TFile.h>
 
@@ -129,7 +133,8 @@ public:
     /// detector simulation). After this has been successfully called
     /// (returned true), gGeoManager will point to a geometry named
     /// CAPTAINGeometry-xxxxxxxx-xxxxxxxx-xxxxxxxx-xxxxxxxx-xxxxxxxx" where
-    /// "x" stands for a lower case hexidecimal digit.
+    /// "x" stands for a lower case hexidecimal digit.  The geometry id map
+    /// is not built until it is first used (e.g. by CdId()).
     void ResetGeometry();
 
     /// A map of geometry id represented as integers to the associated ROOT
@@ -146,7 +151,7 @@ public:
     ///     TGeometryId gid(g->first);
     /// }
     /// \endcode
-    const GeomIdMap& GetGeomIdMap() {return fGeomIdMap;}
+    const GeomIdMap& GetGeomIdMap() {CheckGeomIdMap(); return fGeomIdMap;}
     
     /// Provide a file to override the standard geometry.  Setting the
     /// geometry file to any value other than "" will cause TManager to
@@ -217,6 +222,12 @@ private:
     /// volumes in gGeoManager.
     void BuildGeomIdMap();
 
+    /// Make sure that the geometry id map has been built for the current
+    /// geometry.  Building the map requires a recursion through the entire
+    /// geometry, so it is postponed until the map is needed.  This can be
+    /// called from several threads, and the map is only built once.
+    void CheckGeomIdMap() const;
+
     /// An internal method to recurse through the entire ROOT geometry.  This
     /// does a depth first recursion through the geometry.  It passes a vector
     /// containing the volume names for the current recursion, and will keep
@@ -273,6 +284,18 @@ private:
     /// by this method.
     bool FindAndLoadGeometry(CP::TEvent* event);
 
+    /// Load the geometry from the override hash code or file if one has been
+    /// set.  This returns true if a new geometry was loaded.  This is used
+    /// by FindAndLoadGeometry.
+    bool LoadOverrideGeometry();
+
+    /// Load the override geometry and build the geometry id map before the
+    /// first event is read.  This only uses the override hash code or file
+    /// since the other geometry sources depend on the event.  It returns
+    /// true if an override geometry is loaded.  This is used by
+    /// CP::TManager::PrefetchGeometry() on a background thread.
+    bool PrefetchGeometry();
+
     /// Determine if the geometry should be looked for.  If this returns true,
     /// the a new geometry should be loaded.
     bool CheckGeometry(const CP::TEvent* const event);
@@ -309,6 +332,13 @@ private:
     /// The map between the RootIdKey and the GeomIdKey.
     RootIdMap fRootIdMap;
 
+#ifndef __CINT__
+    /// This is true when fGeomIdMap and fRootIdMap match the current
+    /// geometry (or there isn't a geometry to map).  The maps can be used
+    /// by several threads, so this is only set after the maps are built.
+    std::atomic<bool> fGeomIdMapBuilt;
+#endif
+
     /// The hash code for the geometry associated with fGeomIdMap and
     /// fRootIdMap.  This is used to short circuit the BuildGeomIdMap method.
     TSHAHashValue fGeomIdHashCode;
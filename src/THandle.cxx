@@ -1,6 +1,14 @@
 #include <iostream>
 #include <map>
 #include <set>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+
+#include <cstdlib>
+
+#include <execinfo.h>
 
 #include <TROOT.h>
 #include <TClass.h>
@@ -10,19 +18,171 @@
 #include "TCaptLog.hxx"
 
 namespace {
-    int gHandleBaseCount = 0;
-    int gLastHandleCount = 0;
-    std::set<CP::THandleBase*> *gHandleSet = NULL;
+    /// The default number of THandleBase allocations per sampled
+    /// allocation.  This is low enough to not be noticed in production.
+    const int kDefaultSamplingPeriod = 4096;
+
+    /// The number of stack frames saved for a sampled allocation.
+    const int kStackDepth = 12;
+
+    /// The maximum number of sampled allocations printed by
+    /// DumpHandleRegistry.
+    const int kMaximumDump = 50;
+
+    /// The allocation record for a sampled THandleBase.
+    struct HandleSample {
+        /// The registry interval (i.e. event) when the handle was created.
+        long fInterval;
+        /// The number of valid entries in fStack.
+        int fDepth;
+        /// The return addresses at the point of the allocation.
+        void* fStack[kStackDepth];
+    };
+
+    /// The handle counters and sampled allocations for one thread.  The
+    /// counters are only changed by the owning thread so the atomic
+    /// operations don't contend, but a handle can be deleted by a different
+    /// thread than created it, so the sampled allocations are protected by
+    /// a mutex (which is only taken for sampled handles).
+    struct HandleShard {
+        explicit HandleShard(int index)
+            : fIndex(index), fCreated(0), fDeleted(0),
+              fUntilSample(0), fPeriod(0),
+              fRandom(2463534242u + 97*index) {}
+
+        /// The index of this shard in Shards().
+        int fIndex;
+
+        /// The number of THandleBase objects created by this thread.
+        std::atomic<long> fCreated;
+
+        /// The number of THandleBase objects deleted by this thread.
+        std::atomic<long> fDeleted;
+
+        /// The number of allocations until the next sample.
+        long fUntilSample;
+
+        /// The sampling period used to choose fUntilSample.
+        int fPeriod;
+
+        /// The state of the random number generator used to jitter the
+        /// sampling so it doesn't alias with periodic allocation patterns.
+        unsigned int fRandom;
+
+        /// Protect fSamples.
+        std::mutex fMutex;
+
+        /// The sampled allocations that are still alive.
+        std::map<CP::THandleBase*, HandleSample> fSamples;
+    };
+
+    /// All of the shards that have been created.  Shards are never deleted
+    /// so the counts from threads that have finished are kept.  The vector
+    /// is created on first use and never deleted since handles can be
+    /// created and deleted during static initialization and destruction.
+    std::vector<HandleShard*>& Shards() {
+        static std::vector<HandleShard*>* shards
+            = new std::vector<HandleShard*>;
+        return *shards;
+    }
+    std::mutex gShardMutex;
+
+    /// The shard for the current thread.
+    thread_local HandleShard* tShard = NULL;
+
+    /// The average number of allocations per sample.  Zero disables
+    /// sampling.
+    std::atomic<int> gSamplingPeriod(kDefaultSamplingPeriod);
+
+    /// The current registry interval.  This is incremented each time the
+    /// shards are merged by CleanHandleRegistry (i.e. at event boundaries).
+    std::atomic<long> gInterval(0);
+
+    /// The first interval that will be reported by DumpHandleRegistry.
+    long gDumpInterval = 0;
+
+    /// The count of live handles when the registry was last merged.
+    long gLastHandleCount = 0;
+
+    HandleShard* GetShard() {
+        if (tShard) return tShard;
+        std::lock_guard<std::mutex> lock(gShardMutex);
+        tShard = new HandleShard(Shards().size());
+        Shards().push_back(tShard);
+        return tShard;
+    }
+
+    /// Decide if the next allocation on this thread should be sampled.
+    bool SampleNext(HandleShard* shard) {
+        int period = gSamplingPeriod.load(std::memory_order_relaxed);
+        if (period < 1) return false;
+        // Restart the count when the period changes so that the new period
+        // takes effect immediately.
+        if (period != shard->fPeriod) {
+            shard->fPeriod = period;
+            shard->fUntilSample = 0;
+        }
+        if (--shard->fUntilSample > 0) return false;
+        if (period == 1) {
+            shard->fUntilSample = 1;
+            return true;
+        }
+        // Choose the next gap uniformly in [1, 2*period) using xorshift.
+        unsigned int x = shard->fRandom;
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        shard->fRandom = x;
+        shard->fUntilSample = 1 + x % (2*period - 1);
+        return true;
+    }
+
+    /// Record the allocation site for a handle.
+    void AddSample(HandleShard* shard, CP::THandleBase* handle) {
+        HandleSample sample;
+        sample.fInterval = gInterval.load(std::memory_order_relaxed);
+        sample.fDepth = backtrace(sample.fStack, kStackDepth);
+        std::lock_guard<std::mutex> lock(shard->fMutex);
+        shard->fSamples[handle] = sample;
+    }
+
+    /// Get the symbols for the stack saved with a sampled allocation.  The
+    /// frames for the registry and THandleBase constructor are skipped.
+    std::vector<std::string> SampleSymbols(const HandleSample& sample) {
+        std::vector<std::string> result;
+        char** symbols = backtrace_symbols(sample.fStack, sample.fDepth);
+        if (!symbols) return result;
+        for (int i = 2; i < sample.fDepth; ++i) {
+            result.push_back(symbols[i]);
+        }
+        free(symbols);
+        return result;
+    }
+
+    /// Forget a sampled handle that is being deleted.
+    void RemoveSample(int index, CP::THandleBase* handle) {
+        HandleShard* shard = NULL;
+        {
+            std::lock_guard<std::mutex> lock(gShardMutex);
+            if (index < 0 || (int) Shards().size() <= index) return;
+            shard = Shards()[index];
+        }
+        std::lock_guard<std::mutex> lock(shard->fMutex);
+        shard->fSamples.erase(handle);
+    }
 }
 
 ClassImp(CP::THandleBase);
-CP::THandleBase::THandleBase() : fCount(0), fHandleCount(0) {
-    ++gHandleBaseCount;
-    if (gHandleSet) gHandleSet->insert(this);
+CP::THandleBase::THandleBase() : fCount(0), fHandleCount(0),
+                                 fSampleShard(-1) {
+    HandleShard* shard = GetShard();
+    shard->fCreated.fetch_add(1,std::memory_order_relaxed);
+    if (SampleNext(shard)) {
+        fSampleShard = shard->fIndex;
+        AddSample(shard,this);
+    }
 }
 CP::THandleBase::~THandleBase() {
-    --gHandleBaseCount;
-    if (gHandleSet) gHandleSet->erase(this);
+    GetShard()->fDeleted.fetch_add(1,std::memory_order_relaxed);
+    if (fSampleShard >= 0) RemoveSample(fSampleShard,this);
 }
 
 ClassImp(CP::THandleBaseDeletable);
@@ -52,57 +212,125 @@ void CP::THandleBaseUndeletable::DeleteObject() {
 }
 
 bool CP::CleanHandleRegistry(bool) {
-    bool result = (gHandleBaseCount==gLastHandleCount);
+    // Merge the shards.  The counts from the other threads may be changing
+    // while this is summed, so this is only exact at an event boundary when
+    // the other threads are idle.
+    long handleBaseCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(gShardMutex);
+        for (std::vector<HandleShard*>::iterator s = Shards().begin();
+             s != Shards().end(); ++s) {
+            handleBaseCount += (*s)->fCreated.load(std::memory_order_relaxed);
+            handleBaseCount -= (*s)->fDeleted.load(std::memory_order_relaxed);
+        }
+    }
+    // Start a new interval.  Handles sampled during the interval that just
+    // ended are the ones reported by DumpHandleRegistry.
+    gDumpInterval = gInterval.fetch_add(1);
+    bool result = (handleBaseCount==gLastHandleCount);
     if (!result) {
         CaptLog("CleanHandleRegistry::"
-                 << " Handle Count: " << gHandleBaseCount 
-                 << " Change: " << gHandleBaseCount - gLastHandleCount);
-        gLastHandleCount = gHandleBaseCount;
+                 << " Handle Count: " << handleBaseCount 
+                 << " Change: " << handleBaseCount - gLastHandleCount);
+        gLastHandleCount = handleBaseCount;
     }
     return result;
 }
 
 void CP::DumpHandleRegistry() {
-    if (!gHandleSet) return;
-    if (gHandleSet->empty()) return;
-    CaptLog("Existing handles: " << gHandleSet->size());
+    // Collect the surviving samples from the last interval.
+    std::vector< std::pair<CP::THandleBase*, HandleSample> > samples;
+    {
+        std::lock_guard<std::mutex> lock(gShardMutex);
+        for (std::vector<HandleShard*>::iterator s = Shards().begin();
+             s != Shards().end(); ++s) {
+            std::lock_guard<std::mutex> shardLock((*s)->fMutex);
+            for (std::map<CP::THandleBase*,HandleSample>::iterator h
+                     = (*s)->fSamples.begin();
+                 h != (*s)->fSamples.end(); ++h) {
+                if (h->second.fInterval < gDumpInterval) continue;
+                samples.push_back(*h);
+            }
+        }
+    }
+    if (samples.empty()) return;
+    CaptLog("Existing handles: " << samples.size()
+            << " (sampled 1 in " << GetHandleSamplingPeriod() << ")");
     CP::TCaptLog::IncreaseIndentation();
-    for (std::set<CP::THandleBase*>::iterator h = gHandleSet->begin();
-         h != gHandleSet->end();
-         ++h) {
-        CP::THandleBase* handleBase = *h;
+    int dumped = 0;
+    for (std::vector< std::pair<CP::THandleBase*,HandleSample> >::iterator h
+             = samples.begin();
+         h != samples.end() && dumped < kMaximumDump;
+         ++h, ++dumped) {
+        CP::THandleBase* handleBase = h->first;
         CaptLog(std::hex << "(0x" << handleBase << ")");
-        if (handleBase) {
+        CP::TCaptLog::IncreaseIndentation();
+        TObject *object = handleBase->GetObject();
+        CaptLog(std::hex << "-> (0x" << object << ")");
+        if (object) {
             CP::TCaptLog::IncreaseIndentation();
-            TObject *object = handleBase->GetObject();
-            CaptLog(std::hex << "-> (0x" << object << ")");
-            if (object) {
-                CP::TCaptLog::IncreaseIndentation();
-                CaptLog("Class: " << object->ClassName());
-                CaptLog("Name: " << object->GetName());
-                CP::TCaptLog::DecreaseIndentation();
-                if (CP::TCaptLog::GetDebugLevel()>CP::TCaptLog::ErrorLevel) {
-                    object->ls();
-                }
+            CaptLog("Class: " << object->ClassName());
+            CaptLog("Name: " << object->GetName());
+            CP::TCaptLog::DecreaseIndentation();
+            if (CP::TCaptLog::GetDebugLevel()>CP::TCaptLog::ErrorLevel) {
+                object->ls();
+            }
+        }
+        std::vector<std::string> symbols = SampleSymbols(h->second);
+        if (!symbols.empty()) {
+            CaptLog("Allocated at:");
+            CP::TCaptLog::IncreaseIndentation();
+            for (std::vector<std::string>::iterator s = symbols.begin();
+                 s != symbols.end(); ++s) {
+                CaptLog(*s);
             }
             CP::TCaptLog::DecreaseIndentation();
         }
+        CP::TCaptLog::DecreaseIndentation();
+    }
+    if (dumped < (int) samples.size()) {
+        CaptLog("... " << samples.size() - dumped << " more handles");
     }
     CP::TCaptLog::DecreaseIndentation();
 } 
 
+std::vector<std::string>
+CP::GetHandleAllocationSite(const CP::TVHandle& handle) {
+    std::vector<std::string> result;
+    CP::THandleBase* handleBase = handle.GetInternalHandle();
+    if (!handleBase) return result;
+    std::lock_guard<std::mutex> lock(gShardMutex);
+    for (std::vector<HandleShard*>::iterator s = Shards().begin();
+         s != Shards().end(); ++s) {
+        std::lock_guard<std::mutex> shardLock((*s)->fMutex);
+        std::map<CP::THandleBase*,HandleSample>::iterator h
+            = (*s)->fSamples.find(handleBase);
+        if (h == (*s)->fSamples.end()) continue;
+        return SampleSymbols(h->second);
+    }
+    return result;
+}
+
 void CP::EnableHandleRegistry(bool enable) {
-    if (enable && !gHandleSet) {
+    if (enable) {
         CaptLog("Enable the handle registry");
-        gHandleSet = new std::set<CP::THandleBase*>;
+        SetHandleSamplingPeriod(1);
     }
     else { 
         CaptLog("Disable the handle registry");
-        delete gHandleSet;
-        gHandleSet = NULL;
+        SetHandleSamplingPeriod(kDefaultSamplingPeriod);
     }
 }
 
+void CP::SetHandleSamplingPeriod(int period) {
+    if (period < 0) period = 0;
+    gSamplingPeriod.store(period);
+}
+
+int CP::GetHandleSamplingPeriod() {
+    return gSamplingPeriod.load();
+}
+
 ClassImp(CP::TVHandle);
 CP::TVHandle::TVHandle() {Default(NULL);}
 CP::TVHandle::~TVHandle() {}
@@ -129,22 +357,34 @@ void CP::TVHandle::Link(const CP::TVHandle& rhs) {
 
 void CP::TVHandle::Unlink() {
     if (!fHandle) return;
-    fHandle->CheckHandle();
-    if (!IsWeak()) fHandle->DecrementReferenceCount();
-    fHandle->DecrementHandleCount();
-    CheckSurvival();
+    CP::THandleBase* handle = fHandle;
     fHandle = NULL;
+    handle->CheckHandle();
+    // The decrements return the new count so that only the thread that
+    // removes the last reference deletes the object (or the handle).  If the
+    // reference count reaches zero, no strong handles are referencing the
+    // object so delete it, but leave the THandleBase for any weak handles.
+    if (!IsWeak() && handle->DecrementReferenceCount() < 1) {
+        handle->DeleteObject();
+    }
+    // The handle counter is zero so nothing (no strong, or weak handles) is
+    // using this THandleBase and it should be deleted.  This also deletes the
+    // object (if it still exists).
+    if (handle->DecrementHandleCount() < 1) {
+        handle->DeleteObject();
+        delete handle;
+    }
 }
 
 void CP::TVHandle::MakeWeak() {
     if (IsWeak()) return;
     SetBit(kWeakHandle,true);
     // Decrement the reference count to the object, but leave the handle count
-    // unchanged.
+    // unchanged.  The handle is still referenced by this object, so only the
+    // object can be deleted.
     if (!fHandle) return;
     fHandle->CheckHandle();
-    fHandle->DecrementReferenceCount();
-    CheckSurvival();
+    if (fHandle->DecrementReferenceCount() < 1) fHandle->DeleteObject();
 }
 
 void CP::TVHandle::MakeLock() {
@@ -152,33 +392,14 @@ void CP::TVHandle::MakeLock() {
     SetBit(kWeakHandle,false);
     // Increment the reference count to the object, but leave the handle count
     // unchanged, but only if there is a valid handle, and a valid object.
+    // This isn't protected against another thread deleting the object, so
+    // the caller must know the object is still owned by a strong handle.
     if (!fHandle) return;
     if (!fHandle->GetObject()) return;
     fHandle->CheckHandle();
     fHandle->IncrementReferenceCount();
 }
 
-void CP::TVHandle::CheckSurvival() {
-    // The handle doesn't exist, so just return.
-    if (!fHandle) return;
-    // Check for old handles.
-    fHandle->CheckHandle();
-    // The handle counter is zero so nothing (no strong, or weak handles) is
-    // using this THandleBase and it should be deleted.  This also deletes the
-    // object.
-    if (fHandle->GetHandleCount() < 1) {
-        fHandle->DeleteObject();
-        delete fHandle;
-        fHandle = NULL;
-        return;
-    }
-    // The reference counter is zero, so no strong handles are referencing the
-    // object.  Delete the object, but leave the THandleBase.
-    if (fHandle->GetReferenceCount() < 1) {
-        fHandle->DeleteObject();
-    }
-}
-
 TObject* CP::TVHandle::GetPointerValue() const {
     if (!fHandle) return NULL;
     return fHandle->GetObject();
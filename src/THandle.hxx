@@ -11,6 +11,7 @@
 
 #include "ECore.hxx"
 #include "TCaptLog.hxx"
+#include "TEventArena.hxx"
 
 namespace CP {
     EXCEPTION(EHandle,ECore);
@@ -45,8 +46,7 @@ namespace CP {
         void Link(const TVHandle& rhs);
 
         /// Remove a reference to the object being held by removing this
-        /// THandle from the reference list.  Returns true if the last
-        /// reference is removed.
+        /// THandle from the reference list.
         void Unlink();
 
         /// Safely get the pointer value for this handle.  This hides the
@@ -94,11 +94,6 @@ namespace CP {
         virtual void ls(Option_t *opt = "") const;
         
     private:
-        /// Check if the object, or the handle to the object should be
-        /// deleted.  This can be safely called even if the object and handle
-        /// don't exist.
-        void CheckSurvival();
-        
         /// The reference counted handle. This handle contains the pointer to
         /// the actual data object.
         THandleBase* fHandle;
@@ -337,31 +332,43 @@ namespace CP {
     /// object.  The THandleBase objects contain the actual pointer that is
     /// being reference counted.  When the THandleBase object is deleted, the
     /// pointer is also deleted.  This object maintains the reference count.
+    ///
+    /// The reference and handle counts are updated atomically so that
+    /// handles referring to the same object can be copied and destroyed on
+    /// different threads.  Increments are relaxed, and decrements use
+    /// acquire-release ordering so that the thread removing the last
+    /// reference sees all of the changes made through the other references
+    /// before the object is deleted.  Weak handles are not protected against
+    /// the object being deleted by another thread, so a thread must hold a
+    /// regular (owning) handle to safely use the object.
     class THandleBase : public TObject {
     public:
         THandleBase();
         virtual ~THandleBase();
 
-        int GetReferenceCount() const {return fCount;}
-        int GetHandleCount() const {return fHandleCount;}
-        void CheckHandle() {if (fHandleCount<fCount) fHandleCount=fCount;}
+        /// Allocate from the current event arena (see TEventArena).
+        EVENT_ARENA_ALLOCATED;
+
+        int GetReferenceCount() const;
+        int GetHandleCount() const;
+
+        /// Make sure the handle count is at least as large as the reference
+        /// count.  This fixes THandleBase objects read from files that were
+        /// written before the handle count was saved.
+        void CheckHandle();
         
         // Increment/decrement the count of objects that own the object.  This
-        // doesn't include any weak references.
-        void IncrementReferenceCount() {++fCount;}
-        void DecrementReferenceCount() {if (fCount>0) --fCount;}
+        // doesn't include any weak references.  The decrement returns the
+        // new reference count.
+        void IncrementReferenceCount();
+        int DecrementReferenceCount();
 
         // Increment/decrement the count of objects referencing this
         // THandleBase object.  This includes the count of handles owning the
         // object as well as the weak handles that are referencing the object,
-        // but don't own it.
-        void IncrementHandleCount() {
-            ++fHandleCount;
-            if (fHandleCount > 30000) {
-                CaptError("To many handles for object: " << fHandleCount);
-            }
-        }
-        void DecrementHandleCount() {if (fHandleCount>0) --fHandleCount;}
+        // but don't own it.  The decrement returns the new handle count.
+        void IncrementHandleCount();
+        int DecrementHandleCount();
 
         // Return the current pointer to the object.
         virtual TObject* GetObject() const = 0;
@@ -388,6 +395,11 @@ namespace CP {
         /// The number of references to the handle.
         unsigned short fHandleCount;
 
+        /// The handle registry shard holding the allocation record for this
+        /// object, or -1 if the allocation wasn't sampled (see
+        /// CP::SetHandleSamplingPeriod()).
+        int fSampleShard; //! Don't Save
+
         ClassDef(THandleBase,3);
     };
 
@@ -434,6 +446,58 @@ namespace CP {
 //////////////////////////////////////////////////////////////////
 // Implementation of methods.
 //////////////////////////////////////////////////////////////////
+inline int CP::THandleBase::GetReferenceCount() const {
+    return __atomic_load_n(&fCount, __ATOMIC_ACQUIRE);
+}
+
+inline int CP::THandleBase::GetHandleCount() const {
+    return __atomic_load_n(&fHandleCount, __ATOMIC_ACQUIRE);
+}
+
+inline void CP::THandleBase::CheckHandle() {
+    unsigned short count = __atomic_load_n(&fCount, __ATOMIC_RELAXED);
+    unsigned short handles = __atomic_load_n(&fHandleCount, __ATOMIC_RELAXED);
+    // This almost never happens, so don't worry about the loop.
+    while (handles < count) {
+        if (__atomic_compare_exchange_n(&fHandleCount, &handles, count, true,
+                                        __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) break;
+    }
+}
+
+inline void CP::THandleBase::IncrementReferenceCount() {
+    __atomic_add_fetch(&fCount, 1, __ATOMIC_RELAXED);
+}
+
+inline int CP::THandleBase::DecrementReferenceCount() {
+    unsigned short count = __atomic_load_n(&fCount, __ATOMIC_RELAXED);
+    do {
+        if (count < 1) return 0;
+    } while (!__atomic_compare_exchange_n(&fCount, &count, count-1, true,
+                                          __ATOMIC_ACQ_REL,
+                                          __ATOMIC_RELAXED));
+    return count-1;
+}
+
+inline void CP::THandleBase::IncrementHandleCount() {
+    unsigned short count = __atomic_add_fetch(&fHandleCount, 1,
+                                              __ATOMIC_RELAXED);
+    if (count > 30000) {
+        CaptError("To many handles for object: " << count);
+    }
+}
+
+inline int CP::THandleBase::DecrementHandleCount() {
+    unsigned short count = __atomic_load_n(&fHandleCount, __ATOMIC_RELAXED);
+    do {
+        if (count < 1) return 0;
+    } while (!__atomic_compare_exchange_n(&fHandleCount, &count, count-1,
+                                          true,
+                                          __ATOMIC_ACQ_REL,
+                                          __ATOMIC_RELAXED));
+    return count-1;
+}
+
 template <class T>
 CP::THandle<T>::THandle(T* pointee) {
     THandleBase *base = NULL;
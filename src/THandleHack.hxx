@@ -1,28 +1,57 @@
 #ifndef THandleHack_hxx_Seen
 #define THandleHack_hxx_Seen
 
+#include <string>
+#include <vector>
+
 namespace CP {
+    class TVHandle;
+
     /// A useful debugging/memory leak detecting routine to find places where
     /// THandle objects are somehow being misused.  I used it to find a
     /// THitSelection that was not correctly deleted, and which was causing a
-    /// huge memory leak.
+    /// huge memory leak.  This returns false if the number of live handles
+    /// has changed since the last call.  The handles are counted separately
+    /// by each thread, and the counts are merged when this is called, so it
+    /// should be called at an event boundary.  Each call starts a new
+    /// interval for CP::DumpHandleRegistry().
     bool CleanHandleRegistry(bool eraseAll = false);
     
-    /// Dump a list of all the handles that have not been deleted.  To be used
-    /// for debugging, the user must have first called
-    /// CreateHandleRegistry().
+    /// Dump a list of the sampled handles that were created before the last
+    /// call to CP::CleanHandleRegistry() (i.e. during the last event) and
+    /// have not been deleted.  The class of the object and the stack where
+    /// the handle was created are printed.  Only a fraction of the handles
+    /// are sampled (see CP::SetHandleSamplingPeriod()), so a leak that
+    /// happens once per event might take several events to show up.
     void DumpHandleRegistry();
 
-    /// Enable or disable an internal set of all active handles.  If called
-    /// with an argument of "true", this will create an internal handle
-    /// registry and cause your program to run very slowly.  If called with an
-    /// argument of "false", the internal registry will be deleted (if it
-    /// exists).  After CP::EnableHandleRegistry(true) is called, the
-    /// CP::DumpHandleRegistry() function will print a list of handles
-    /// remaining in memory.
+    /// Get the stack where the object referenced by a handle was allocated.
+    /// The stack is only recorded for sampled allocations, so this returns
+    /// an empty vector if the allocation wasn't sampled, or the handle is
+    /// empty.  The frames are formatted by backtrace_symbols(), and the
+    /// innermost frame is first.
+    std::vector<std::string> GetHandleAllocationSite(const TVHandle& handle);
+
+    /// Enable or disable the registry of all active handles.  If called
+    /// with an argument of "true", every handle allocation will be recorded
+    /// which will cause your program to run slowly.  If called with an
+    /// argument of "false", the registry returns to the default sampling.
+    /// After CP::EnableHandleRegistry(true) is called, the
+    /// CP::DumpHandleRegistry() function will print all of the handles
+    /// leaked during the last event.
     ///
     /// The CP::EnableHandleRegistry() and CP::DumpHandleRegistry() are used
     /// by the event loop when it is run using the "-H" command line option.
     void EnableHandleRegistry(bool create);
+
+    /// Set the average number of handle allocations per recorded allocation.
+    /// A period of one records every allocation, and zero disables the
+    /// recording (the handles are still counted).  The default records
+    /// about one allocation in 4096 which is cheap enough to leave on.
+    void SetHandleSamplingPeriod(int period);
+
+    /// Get the average number of handle allocations per recorded
+    /// allocation.
+    int GetHandleSamplingPeriod();
 }
 #endif
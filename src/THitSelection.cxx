@@ -3,15 +3,131 @@
 //
 
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
 #include "THitSelection.hxx"
 
 ClassImp(CP::THitSelection);
 
-CP::THitSelection::THitSelection(const char* name, 
-                             const char* title)
-    : CP::TDatum(name,title) { }
+namespace {
+    /// The smallest selection that will be indexed.  Smaller selections use
+    /// a linear search since it's faster than building the hash.
+    const std::size_t kMinimumIndexSize = 32;
+
+    /// The pointer used to identify a hit in the index.  This matches the
+    /// THandle equality operator which compares the object pointers.
+    const CP::THit* HitKey(const CP::THandle<CP::THit>& hit) {
+        return GetPointer(hit);
+    }
+
+    /// The number of mutexes protecting the indexes.
+    const std::size_t kIndexMutexes = 64;
+
+    /// Get the mutex protecting the index of a selection.  The index is
+    /// built by const methods, so several threads reading the same
+    /// selection can try to build it at once.  The mutexes are shared by
+    /// address so that a selection doesn't need to carry one.  These are
+    /// never deleted so selections can be used during the program exit.
+    std::mutex& IndexMutex(const CP::THitSelection* selection) {
+        static std::mutex* mutexes = new std::mutex[kIndexMutexes];
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(selection);
+        return mutexes[(address/sizeof(void*)) % kIndexMutexes];
+    }
+
+    /// The number of membership indexes that have been built.
+    std::atomic<long> gIndexBuilds(0);
+
+    /// A code for an entry in the selection that's added to the checksum
+    /// of the selection.  This uses the handle's internal pointer so the
+    /// hit isn't read.  The bits are mixed so that the sum of the codes
+    /// changes when an entry is replaced.
+    std::uint64_t EntryCode(const CP::THandle<CP::THit>& hit) {
+        std::uint64_t code
+            = reinterpret_cast<std::uintptr_t>(hit.GetInternalHandle());
+        code ^= code >> 31;
+        code *= 0x9e3779b97f4a7c15ULL;
+        code ^= code >> 29;
+        return code;
+    }
+
+    /// A set of hit pointers used for the set operations.
+    typedef std::unordered_set<const CP::THit*> HitSet;
+
+    void FillHitSet(const CP::THitSelection& hits, HitSet& set) {
+        set.reserve(hits.size());
+        for (CP::THitSelection::const_iterator h = hits.begin();
+             h != hits.end(); ++h) {
+            set.insert(HitKey(*h));
+        }
+    }
+}
+
+/// The membership index.  This counts the number of times each hit appears
+/// in the selection (push_back allows duplicates), and remembers how many of
+/// the selection entries have been added to the index so that hits appended
+/// with push_back can be indexed just-in-time.  The sum of the entry codes
+/// is kept so that an entry changed through a reference is noticed.
+class CP::THitSelection::TIndex {
+public:
+    TIndex() : fIndexedSize(0), fModifications(0), fChecksum(0) {}
+
+    /// Add an entry to the index.
+    void Add(const CP::THandle<CP::THit>& hit) {
+        ++fCount[HitKey(hit)];
+        fChecksum += EntryCode(hit);
+    }
+
+    /// Remove one copy of an entry from the index.
+    void Remove(const CP::THandle<CP::THit>& hit) {
+        std::unordered_map<const CP::THit*,int>::iterator c
+            = fCount.find(HitKey(hit));
+        if (c == fCount.end()) return;
+        if (--(c->second) < 1) fCount.erase(c);
+        fChecksum -= EntryCode(hit);
+    }
+
+    /// Check if the hit is in the index.
+    bool Contains(const CP::THit* hit) const {
+        return fCount.find(hit) != fCount.end();
+    }
+
+    /// The number of copies of each hit in the selection.
+    std::unordered_map<const CP::THit*,int> fCount;
+
+    /// The number of selection entries that have been indexed.
+    std::size_t fIndexedSize;
+
+    /// The modification count of the selection when it was indexed.
+    unsigned int fModifications;
+
+    /// The sum of the entry codes for the indexed entries.
+    std::uint64_t fChecksum;
+};
+
+CP::THitSelection::THitSelection(const char* name,
+                                 const char* title)
+    : CP::TDatum(name,title), fIndex(NULL), fModifications(0) { }
+
+CP::THitSelection::THitSelection(const CP::THitSelection& rhs)
+    : CP::TDatum(rhs), std::vector< CP::THandle<CP::THit> >(rhs),
+      fIndex(NULL), fModifications(0) { }
 
-CP::THitSelection::~THitSelection() { }
+CP::THitSelection::~THitSelection() {
+    delete fIndex;
+}
+
+CP::THitSelection&
+CP::THitSelection::operator = (const CP::THitSelection& rhs) {
+    if (this == &rhs) return *this;
+    CP::TDatum::operator = (rhs);
+    std::vector< CP::THandle<CP::THit> >::operator = (rhs);
+    Modified();
+    return *this;
+}
 
 void CP::THitSelection::push_back(const CP::THandle<CP::THit>& hit) {
     if (!hit) {
@@ -21,16 +137,162 @@ void CP::THitSelection::push_back(const CP::THandle<CP::THit>& hit) {
     std::vector< CP::THandle<CP::THit> >::push_back(hit);
 }
 
+CP::THitSelection::TIndex* CP::THitSelection::GetIndex(bool force) const {
+    std::lock_guard<std::mutex> lock(IndexMutex(this));
+    if (!fIndex) {
+        if (!force && size() < kMinimumIndexSize) return NULL;
+        fIndex = new TIndex;
+        fIndex->fModifications = fModifications - 1;
+    }
+    // The selection has been changed (other than by appending hits) since
+    // it was indexed, so start over.  The checksum catches the entries that
+    // were changed through a reference or an iterator.  It only reads the
+    // handles, so it's much cheaper than a search.
+    bool rebuild = (fIndex->fModifications != fModifications
+                    || fIndex->fIndexedSize > size());
+    if (!rebuild) {
+        std::uint64_t checksum = 0;
+        for (const_iterator h = begin();
+             h != begin() + fIndex->fIndexedSize; ++h) {
+            checksum += EntryCode(*h);
+        }
+        rebuild = (checksum != fIndex->fChecksum);
+    }
+    if (rebuild) {
+        ++gIndexBuilds;
+        fIndex->fCount.clear();
+        fIndex->fIndexedSize = 0;
+        fIndex->fModifications = fModifications;
+        fIndex->fChecksum = 0;
+    }
+    // Index any hits that have been added since the last time the index was
+    // used.
+    if (fIndex->fIndexedSize < size()) {
+        fIndex->fCount.reserve(size());
+        for (const_iterator h = begin() + fIndex->fIndexedSize;
+             h != end(); ++h) {
+            fIndex->Add(*h);
+        }
+        fIndex->fIndexedSize = size();
+    }
+    return fIndex;
+}
+
+long CP::THitSelection::GetIndexBuildCount() {
+    return gIndexBuilds.load();
+}
+
+void CP::THitSelection::InvalidateIndex() const {
+    delete fIndex;
+    fIndex = NULL;
+}
+
+bool CP::THitSelection::Contains(const CP::THandle<CP::THit>& hit) const {
+    TIndex* index = GetIndex();
+    if (index) return index->Contains(HitKey(hit));
+    return (std::find(begin(), end(), hit) != end());
+}
+
 void CP::THitSelection::AddHit(const CP::THandle<CP::THit>& hit) {
-    CP::THitSelection::iterator location
-        = std::find(begin(), end(), hit);
-    if (location == end()) push_back(hit);
+    if (Contains(hit)) return;
+    push_back(hit);
 }
 
 void CP::THitSelection::RemoveHit(const CP::THandle<CP::THit>& hit) {
-    CP::THitSelection::iterator location
-        = std::find(begin(), end(), hit);
-    if (location != end()) erase(location);
+    TIndex* index = GetIndex();
+    if (index && !index->Contains(HitKey(hit))) return;
+    // Use the base class methods so the index is kept.
+    BaseVector::iterator location
+        = std::find(BaseVector::begin(), BaseVector::end(), hit);
+    if (location == BaseVector::end()) return;
+    if (index) index->Remove(*location);
+    BaseVector::erase(location);
+    if (index) index->fIndexedSize = size();
+}
+
+void CP::THitSelection::AddHits(const CP::THitSelection& hits) {
+    if (&hits == this) return;
+    TIndex* index = GetIndex(true);
+    reserve(size() + hits.size());
+    for (const_iterator h = hits.begin(); h != hits.end(); ++h) {
+        const CP::THit* key = HitKey(*h);
+        if (index->Contains(key)) continue;
+        push_back(*h);
+        index->Add(*h);
+        index->fIndexedSize = size();
+    }
+}
+
+void CP::THitSelection::RemoveHits(const CP::THitSelection& hits) {
+    if (&hits == this) {
+        clear();
+        return;
+    }
+    HitSet remove;
+    FillHitSet(hits, remove);
+    iterator last = begin();
+    for (iterator h = begin(); h != end(); ++h) {
+        if (remove.find(HitKey(*h)) != remove.end()) continue;
+        if (last != h) *last = *h;
+        ++last;
+    }
+    erase(last, end());
+}
+
+void CP::THitSelection::RetainHits(const CP::THitSelection& hits) {
+    if (&hits == this) return;
+    HitSet retain;
+    FillHitSet(hits, retain);
+    iterator last = begin();
+    for (iterator h = begin(); h != end(); ++h) {
+        if (retain.find(HitKey(*h)) == retain.end()) continue;
+        if (last != h) *last = *h;
+        ++last;
+    }
+    erase(last, end());
+}
+
+CP::THitSelection::iterator CP::THitSelection::erase(iterator position) {
+    Modified();
+    return std::vector< CP::THandle<CP::THit> >::erase(position);
+}
+
+CP::THitSelection::iterator CP::THitSelection::erase(iterator first,
+                                                     iterator last) {
+    Modified();
+    return std::vector< CP::THandle<CP::THit> >::erase(first,last);
+}
+
+CP::THitSelection::iterator
+CP::THitSelection::insert(iterator position,
+                          const CP::THandle<CP::THit>& hit) {
+    if (!hit) {
+        CaptSevere("Attempting to insert a NULL hit");
+        throw CP::EInvalidHit();
+    }
+    Modified();
+    return std::vector< CP::THandle<CP::THit> >::insert(position,hit);
+}
+
+void CP::THitSelection::insert(iterator position, size_type n,
+                               const CP::THandle<CP::THit>& hit) {
+    if (!hit) {
+        CaptSevere("Attempting to insert a NULL hit");
+        throw CP::EInvalidHit();
+    }
+    Modified();
+    std::vector< CP::THandle<CP::THit> >::insert(position,n,hit);
+}
+
+void CP::THitSelection::swap(CP::THitSelection& hits) {
+    Modified();
+    hits.Modified();
+    std::vector< CP::THandle<CP::THit> >::swap(hits);
+}
+
+void CP::THitSelection::clear() {
+    Modified();
+    std::vector< CP::THandle<CP::THit> >::clear();
 }
 
 void CP::THitSelection::ls(Option_t* opt) const {
@@ -41,7 +303,7 @@ void CP::THitSelection::ls(Option_t* opt) const {
         || option.find("hits") != std::string::npos) {
         TROOT::IncreaseDirLevel();
         for (const_iterator v = begin();
-             v != end(); 
+             v != end();
              ++v) {
             v->ls(opt);
         }
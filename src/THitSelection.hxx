@@ -10,6 +10,7 @@
 #include "ECore.hxx"
 #include "TDatum.hxx"
 #include "THit.hxx"
+#include "TEventArena.hxx"
 
 namespace CP {
     class THitSelection;
@@ -22,12 +23,37 @@ namespace CP {
 
 /// A container of THitHandle objects for the hit detector information.  This
 /// is an enhanced vector that works well with ROOT.
+///
+/// The membership tests used by AddHit(), RemoveHit(), Contains() and the
+/// set operations (AddHits(), RemoveHits(), and RetainHits()) use a hash
+/// index of the hit pointers once the selection is large enough to make it
+/// worthwhile.  The index is not saved, and is built just-in-time.  Hits
+/// appended with push_back() are added to the index the next time it is
+/// used.  The std::vector methods that change the structure of the
+/// selection (e.g. erase(), insert() and clear()) are wrapped so that they
+/// count a modification, and the index is rebuilt the next time it's used
+/// after a modification.  The element access and iterators are not
+/// wrapped, so reading a non-const selection doesn't throw away the index.
+/// Instead, the index keeps a checksum of the indexed entries which is
+/// checked before each use, so an entry that is changed through a
+/// reference, an iterator or the std::vector base class causes a rebuild.
+/// InvalidateIndex() can be used to force a rebuild.
 class CP::THitSelection : public TDatum, public std::vector< THandle<THit> > {
 public:
+    /// The std::vector base class.
+    typedef std::vector< CP::THandle<CP::THit> > BaseVector;
+
     THitSelection(const char* name="hits", 
                   const char* title="Hit Handles");
+    THitSelection(const THitSelection& rhs);
     virtual ~THitSelection();
 
+    /// Allocate from the current event arena (see TEventArena).
+    EVENT_ARENA_ALLOCATED;
+
+    /// Assign the hits (and name) of another selection.
+    THitSelection& operator = (const THitSelection& rhs);
+
     /// This is the usual std::vector::push_back, but enhanced to make
     /// sure that only valid hits are inserted into the THitSelection.
     virtual void push_back(const CP::THandle<CP::THit>& hit);
@@ -39,13 +65,100 @@ public:
     virtual void AddHit(const CP::THandle<CP::THit>&);
 
     /// A convenience method to make sure that a hit is not in a
-    /// THitSelection.
+    /// THitSelection.  The order of the other hits is not changed, so this
+    /// is linear in the size of the selection when the hit is found (the
+    /// following hits are moved down).  Use RemoveHits() to remove many hits
+    /// in a single pass.
     virtual void RemoveHit(const CP::THandle<CP::THit>&);
 
+    /// Check if a hit is in the THitSelection.
+    bool Contains(const CP::THandle<CP::THit>& hit) const;
+
+    /// Add all of the hits in another selection that are not already in this
+    /// selection (the set union).  The order of the existing hits is not
+    /// changed, and the new hits are appended in the order they are found
+    /// in the other selection.  This is linear in the size of both
+    /// selections.
+    virtual void AddHits(const CP::THitSelection& hits);
+
+    /// Remove all of the hits that are in another selection (the set
+    /// difference).  The order of the remaining hits is not changed.  This is
+    /// linear in the size of both selections.
+    virtual void RemoveHits(const CP::THitSelection& hits);
+
+    /// Remove all of the hits that are not in another selection (the set
+    /// intersection).  The order of the remaining hits is not changed.  This
+    /// is linear in the size of both selections.
+    virtual void RetainHits(const CP::THitSelection& hits);
+
+    /// @{ As per the std::vector methods.  These count a modification so
+    /// that the membership index is rebuilt the next time it's used.
+    void pop_back() {Modified(); BaseVector::pop_back();}
+    void resize(size_type n) {Modified(); BaseVector::resize(n);}
+    void resize(size_type n, const CP::THandle<CP::THit>& hit) {
+        Modified();
+        BaseVector::resize(n,hit);
+    }
+    void assign(size_type n, const CP::THandle<CP::THit>& hit) {
+        Modified();
+        BaseVector::assign(n,hit);
+    }
+    template <class InputIterator>
+    void assign(InputIterator first, InputIterator last) {
+        Modified();
+        BaseVector::assign(first,last);
+    }
+    iterator erase(iterator position);
+    iterator erase(iterator first, iterator last);
+    iterator insert(iterator position, const CP::THandle<CP::THit>& hit);
+    void insert(iterator position, size_type n,
+                const CP::THandle<CP::THit>& hit);
+    template <class InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last) {
+        Modified();
+        BaseVector::insert(position,first,last);
+    }
+    void swap(BaseVector& hits) {Modified(); BaseVector::swap(hits);}
+    void swap(THitSelection& hits);
+    void clear();
+    /// @}
+
+    /// Force the membership index to be rebuilt the next time that it is
+    /// used.  Changed entries are found by the index checksum, so this is
+    /// only needed to be certain after changing the hits without using the
+    /// THitSelection methods.
+    void InvalidateIndex() const;
+
+    /// The number of times that a membership index has been built (for all
+    /// selections).  This is intended for testing.
+    static long GetIndexBuildCount();
+
     /// Print the data vector information.
     virtual void ls(Option_t* opt = "") const;
 
 private:
+    /// The type of the hash index used for the membership tests.  This is
+    /// defined in the implementation file.
+    class TIndex;
+
+    /// Count a change to the structure of the selection that isn't an
+    /// append.
+    void Modified() {++fModifications;}
+
+    /// Get the membership index, building or updating it as needed.  This
+    /// returns NULL if the selection is too small to need an index, unless
+    /// the index is forced.  The index is built under a lock, so several
+    /// threads can read the same selection.
+    TIndex* GetIndex(bool force=false) const;
+
+    /// The lazily built membership index.
+    mutable TIndex* fIndex; //! Don't Save
+
+    /// The number of changes to the structure (other than appending hits).
+    /// The index is rebuilt when this doesn't match the value when the
+    /// index was built.
+    unsigned int fModifications; //! Don't Save
+
     ClassDef(THitSelection,2);
 };
 #endif
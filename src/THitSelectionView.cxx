@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <limits>
+
+#include "THitSelectionView.hxx"
+
+CP::THitSelectionView::THitSelectionView(const CP::THitSelection& hits)
+    : fTreeLeaves(1) {
+    fHits.reserve(hits.size());
+    fUpperBound.reserve(hits.size());
+    fGeomEntries.reserve(hits.size());
+    fTimeEntries.reserve(hits.size());
+
+    // Make one pass through the hits to collect the keys.  This is the only
+    // place the (virtual) hit methods are called.
+    for (CP::THitSelection::const_iterator h = hits.begin();
+         h != hits.end(); ++h) {
+        if (!(*h)) continue;
+        unsigned int index = fHits.size();
+        fHits.push_back(*h);
+        double lower = (*h)->GetTimeLowerBound();
+        double upper = (*h)->GetTimeUpperBound();
+        if (upper < lower) std::swap(lower,upper);
+        fUpperBound.push_back(upper);
+        fTimeEntries.push_back(TimeEntry(lower,index));
+        if ((*h)->GetGeomIdCount() < 1) continue;
+        fGeomEntries.push_back(GeomEntry((*h)->GetGeomId().AsInt(),index));
+    }
+
+    std::sort(fGeomEntries.begin(), fGeomEntries.end());
+    std::sort(fTimeEntries.begin(), fTimeEntries.end());
+
+    // Build the tree of the latest upper bounds for the time range search.
+    while (fTreeLeaves < fTimeEntries.size()) fTreeLeaves *= 2;
+    fTreeUpper.assign(2*fTreeLeaves, -std::numeric_limits<double>::max());
+    for (std::size_t i = 0; i < fTimeEntries.size(); ++i) {
+        fTreeUpper[fTreeLeaves+i] = fUpperBound[fTimeEntries[i].second];
+    }
+    for (std::size_t i = fTreeLeaves-1; i > 0; --i) {
+        fTreeUpper[i] = std::max(fTreeUpper[2*i], fTreeUpper[2*i+1]);
+    }
+
+    // Find the running latest upper bound for the nearest hit search.
+    fLatestUpper.resize(fTimeEntries.size());
+    for (std::size_t i = 0; i < fTimeEntries.size(); ++i) {
+        fLatestUpper[i] = i;
+        if (i < 1) continue;
+        unsigned int latest = fLatestUpper[i-1];
+        if (fUpperBound[fTimeEntries[latest].second] 
+            >= fUpperBound[fTimeEntries[i].second]) {
+            fLatestUpper[i] = latest;
+        }
+    }
+}
+
+CP::THitSelectionView::~THitSelectionView() {}
+
+std::size_t CP::THitSelectionView::GetGeomIdRange(CP::TGeometryId low, 
+                                                  CP::TGeometryId high,
+                                                  Hits& hits) const {
+    std::vector<GeomEntry>::const_iterator first 
+        = std::lower_bound(fGeomEntries.begin(), fGeomEntries.end(),
+                           GeomEntry(low.AsInt(),0));
+    std::vector<GeomEntry>::const_iterator last
+        = std::upper_bound(first, fGeomEntries.end(),
+                           GeomEntry(high.AsInt(),
+                                     std::numeric_limits<unsigned int>::max()));
+    std::size_t count = 0;
+    for (; first < last; ++first) {
+        hits.push_back(fHits[first->second]);
+        ++count;
+    }
+    return count;
+}
+
+std::size_t CP::THitSelectionView::GetGeomIdHits(CP::TGeometryId id,
+                                                 Hits& hits) const {
+    return GetGeomIdRange(id,id,hits);
+}
+
+std::size_t CP::THitSelectionView::GetTimeRange(double start, double stop,
+                                                Hits& hits) const {
+    if (stop < start) return 0;
+    // Only the hits that start before the end of the range can overlap it.
+    std::size_t count 
+        = std::upper_bound(fTimeEntries.begin(), fTimeEntries.end(),
+                           TimeEntry(stop,
+                                     std::numeric_limits<unsigned int>::max()))
+        - fTimeEntries.begin();
+    if (count < 1) return 0;
+    return CollectTimeRange(1, 0, fTreeLeaves, count, start, hits);
+}
+
+std::size_t 
+CP::THitSelectionView::CollectTimeRange(std::size_t node, std::size_t first,
+                                        std::size_t width, std::size_t count,
+                                        double start, Hits& hits) const {
+    // Skip the nodes that start after the range, or where all of the hits
+    // end before the range.
+    if (first >= count) return 0;
+    if (fTreeUpper[node] < start) return 0;
+    if (width < 2) {
+        hits.push_back(fHits[fTimeEntries[first].second]);
+        return 1;
+    }
+    width /= 2;
+    std::size_t found 
+        = CollectTimeRange(2*node, first, width, count, start, hits);
+    found += CollectTimeRange(2*node+1, first+width, width, count,
+                              start, hits);
+    return found;
+}
+
+std::size_t CP::THitSelectionView::GetCoincidentHits(const CP::THit& hit,
+                                                     double window,
+                                                     Hits& hits) const {
+    double lower = hit.GetTimeLowerBound();
+    double upper = hit.GetTimeUpperBound();
+    if (upper < lower) std::swap(lower,upper);
+    return GetTimeRange(lower-window, upper+window, hits);
+}
+
+CP::THandle<CP::THit> CP::THitSelectionView::GetNearestTime(double t) const {
+    if (fTimeEntries.empty()) return CP::THandle<CP::THit>();
+
+    // The first hit that starts after the time.  The hits after this one are
+    // all further away.
+    std::vector<TimeEntry>::const_iterator after 
+        = std::upper_bound(fTimeEntries.begin(), fTimeEntries.end(),
+                           TimeEntry(t,
+                                     std::numeric_limits<unsigned int>::max()));
+
+    double bestDistance = std::numeric_limits<double>::max();
+    unsigned int best = 0;
+    if (after != fTimeEntries.begin()) {
+        // Of the hits that start before the time, the closest is the one
+        // that ends last.
+        unsigned int latest = fLatestUpper[after-fTimeEntries.begin()-1];
+        best = fTimeEntries[latest].second;
+        bestDistance = std::max(0.0, t - fUpperBound[best]);
+    }
+    if (after != fTimeEntries.end() && after->first - t < bestDistance) {
+        best = after->second;
+    }
+
+    return fHits[best];
+}
@@ -0,0 +1,115 @@
+#ifndef THitSelectionView_hxx_seen
+#define THitSelectionView_hxx_seen
+
+#include <vector>
+
+#include "THit.hxx"
+#include "THitSelection.hxx"
+#include "TGeometryId.hxx"
+
+namespace CP {
+    class THitSelectionView;
+}
+
+/// A read-only view of the hits in a THitSelection that is sorted by the
+/// geometry identifier and by the hit time so that range and neighbor
+/// queries don't need to scan (and make virtual calls on) every hit.  The
+/// view is built on demand, and holds handles to the hits so it remains
+/// valid if the original selection changes (the changes won't be reflected
+/// in the view).  The hit times are taken from THit::GetTimeLowerBound() and
+/// THit::GetTimeUpperBound(), and the geometry identifier is the first one
+/// returned by THit::GetGeomId().  A typical use is to look for hits that
+/// are coincident with a PDS hit.
+///
+/// \code
+/// CP::THitSelectionView wires(*event.GetHits("drift"));
+/// CP::THitSelectionView::Hits coincident;
+/// wires.GetCoincidentHits(*pdsHit, 1*unit::microsecond, coincident);
+/// \endcode
+///
+/// All of the query methods append to the output vector (it's not cleared)
+/// and return the number of hits that were appended.  Hits are returned in
+/// the order of the key being searched.  The geometry queries take O(log n
+/// + k) for n hits in the view and k hits returned.  The time queries use a
+/// tree of the latest upper bound of the hits so that hits ending before
+/// the range aren't looked at, and take O((k+1) log n) no matter how wide
+/// the hit time intervals are.
+class CP::THitSelectionView {
+public:
+    /// The type of container used to return hits from a query.
+    typedef std::vector< CP::THandle<CP::THit> > Hits;
+
+    /// Build a view of the hits in a selection.
+    explicit THitSelectionView(const CP::THitSelection& hits);
+    ~THitSelectionView();
+
+    /// The number of hits in the view.
+    std::size_t size() const {return fHits.size();}
+
+    /// Get all of the hits with a geometry identifier in the range [low,
+    /// high].  The order of the geometry identifiers is the order of the
+    /// integer representation (see TGeometryId::operator <).
+    std::size_t GetGeomIdRange(CP::TGeometryId low, CP::TGeometryId high,
+                               Hits& hits) const;
+
+    /// Get all of the hits with a particular geometry identifier.
+    std::size_t GetGeomIdHits(CP::TGeometryId id, Hits& hits) const;
+
+    /// Get all of the hits where the time interval between the lower and
+    /// upper bound overlaps the interval [start, stop].
+    std::size_t GetTimeRange(double start, double stop, Hits& hits) const;
+
+    /// Get all of the hits that overlap the time interval of a hit after the
+    /// interval is extended by "window" on both ends.  The hit itself is
+    /// returned if it is part of the view.
+    std::size_t GetCoincidentHits(const CP::THit& hit, double window,
+                                  Hits& hits) const;
+
+    /// Get the hit with the time interval closest to a time.  If the time is
+    /// inside of a hit's interval, then the distance is zero, and if the
+    /// time is inside of several intervals, one of them is returned.  This
+    /// returns a NULL handle if the view is empty.
+    CP::THandle<CP::THit> GetNearestTime(double time) const;
+
+private:
+    /// The geometry key and the index of the hit in fHits.
+    typedef std::pair<int, unsigned int> GeomEntry;
+
+    /// The lower bound of the time interval and the index of the hit in
+    /// fHits.
+    typedef std::pair<double, unsigned int> TimeEntry;
+
+    /// The hits in the view.
+    Hits fHits;
+
+    /// The upper bounds of the hit time intervals (indexed by the hit).
+    std::vector<double> fUpperBound;
+
+    /// The hits sorted by geometry identifier.
+    std::vector<GeomEntry> fGeomEntries;
+
+    /// The hits sorted by the lower bound of the time interval.
+    std::vector<TimeEntry> fTimeEntries;
+
+    /// For each entry in fTimeEntries, the index of the entry (at or before
+    /// the current one) with the latest upper bound.  This is used to find
+    /// the nearest hit without scanning.
+    std::vector<unsigned int> fLatestUpper;
+
+    /// A binary tree over fTimeEntries holding the latest upper bound of the
+    /// hits below each node.  Node 1 is the root, the children of node i are
+    /// nodes 2i and 2i+1, and the leaf for entry j is node fTreeLeaves+j.
+    std::vector<double> fTreeUpper;
+
+    /// The number of leaves in fTreeUpper (a power of two).
+    std::size_t fTreeLeaves;
+
+    /// Add the hits below a node of fTreeUpper that overlap [start, stop] to
+    /// the output.  The node covers the entries starting at "first", and
+    /// only the first "count" entries of fTimeEntries start before the end
+    /// of the range.
+    std::size_t CollectTimeRange(std::size_t node, std::size_t first,
+                                 std::size_t width, std::size_t count,
+                                 double start, Hits& hits) const;
+};
+#endif
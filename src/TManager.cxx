@@ -7,8 +7,12 @@
 //
 
 #include <ctime>
+#include <cstdlib>
 #include <memory>
 #include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 #include <iomanip>
 #include <iostream>
@@ -16,6 +20,7 @@
 #include <fstream>
 
 #include <TSystem.h>
+#include <TROOT.h>
 #include <TTimeStamp.h>
 #include <TDatabasePDG.h>
 #include <TFile.h>
@@ -158,6 +163,39 @@ namespace {
     };
     // Create a private geometry lookup.
     CP::TManager::GeometryLookup* gDefaultGeometryLookup = NULL;
+
+    /// The thread loading the geometry for TManager::PrefetchGeometry().
+    /// This is NULL when the geometry isn't being prefetched, and is
+    /// protected by PrefetchMutex().
+    std::thread* gPrefetchThread = NULL;
+
+    /// This is true while gPrefetchThread might need to be joined.  It lets
+    /// GeomId() skip the mutex after the prefetch is finished.
+    std::atomic<bool> gPrefetching(false);
+
+    /// This is true on the thread prefetching the geometry.
+    thread_local bool gPrefetchingThread = false;
+
+    /// Protect the prefetch thread.  This is never deleted so that it can be
+    /// used during the program exit.
+    std::mutex& PrefetchMutex() {
+        static std::mutex* mutex = new std::mutex;
+        return *mutex;
+    }
+
+    /// Wait for the geometry prefetch to finish.  This does nothing when
+    /// called on the prefetch thread.
+    void WaitForPrefetch() {
+        if (!gPrefetching.load()) return;
+        if (gPrefetchingThread) return;
+        std::lock_guard<std::mutex> lock(PrefetchMutex());
+        if (!gPrefetchThread) return;
+        gPrefetchThread->join();
+        delete gPrefetchThread;
+        gPrefetchThread = NULL;
+        gPrefetching.store(false);
+    }
+
 }
 
 /// The private constructor for the database
@@ -301,12 +339,47 @@ CP::TDigitManager& CP::TManager::Digits(void) {
 }
 
 CP::TGeomIdManager& CP::TManager::GeomId(void) {
+    WaitForPrefetch();
     if (!fGeomId) {
         fGeomId = new CP::TGeomIdManager();
     }
     return *fGeomId;
 }
 
+bool CP::TManager::PrefetchGeometry() {
+    CP::TGeomIdManager& geomId = GeomId();
+    if (!geomId.GetGeometryHashOverride().Valid()
+        && geomId.GetGeometryFileOverride().empty()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(PrefetchMutex());
+    if (gPrefetchThread) return true;
+
+    // The geometry is read on a different thread than the input file.
+    ROOT::EnableThreadSafety();
+
+    // Make sure the thread is finished before ROOT is torn down if the
+    // geometry is never used.
+    static bool registered = false;
+    if (!registered) std::atexit(WaitForPrefetch);
+    registered = true;
+
+    CaptNamedInfo("Geometry","Prefetch the override geometry");
+    gPrefetching.store(true);
+    CP::TGeomIdManager* manager = &geomId;
+    gPrefetchThread = new std::thread([manager] () {
+            gPrefetchingThread = true;
+            try {
+                manager->PrefetchGeometry();
+            }
+            catch (...) {
+                CaptError("Exception while prefetching the geometry");
+            }
+        });
+    return true;
+}
+
 CP::TInputManager& CP::TManager::Input(void) {
     if (!fInputManager) {
         fInputManager = new CP::TInputManager();
@@ -266,6 +266,15 @@ public:
     /// accessed through TGeomIdManager.
     TGeomIdManager& GeomId(void);
 
+    /// Start loading the override geometry (see SetGeometryOverride()) and
+    /// building the geometry id map on a background thread.  This lets the
+    /// geometry be read while the first input file is being opened.
+    /// GeomId() and Geometry() wait for the background thread to finish, so
+    /// the geometry is used exactly as if it had been loaded for the first
+    /// event.  This returns false (and does nothing) if an override geometry
+    /// hasn't been set since the other geometry sources need an event.
+    bool PrefetchGeometry();
+
     /// @{ Provide a file to override the standard geometry.  Setting the
     /// geometry file to any value other than "" will cause TManager to
     /// override the standard (default) geometry with the one found in the
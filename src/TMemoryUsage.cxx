@@ -1,87 +1,113 @@
 #include <TMemoryUsage.hxx>
+#include <TResourceSampler.hxx>
 #include <TCaptLog.hxx>
 #include "TH1F.h"
 #include <algorithm>
 
 namespace {
-    struct CmpMemResident {
-        /// Comparison operator for selecting which ProcInfo_t has the
-        /// large resident memory value.
-        bool operator()(ProcInfo_t lhs, ProcInfo_t rhs) {
-            return lhs.fMemResident < rhs.fMemResident;
-        }
-    };
-    struct CmpMemVirtual {
-        /// Comparison operator for selecting which ProcInfo_t has the
-        /// large virtual memory value.
-        bool operator()(ProcInfo_t lhs, ProcInfo_t rhs) {
-            return lhs.fMemVirtual < rhs.fMemVirtual;
-        }
-    };
+    /// The maximum number of bins in the memory histograms.
+    const int kMaxBins = 1000;
 }
 
-CP::TMemoryUsage::TMemoryUsage(): fEnabled(false) {}
+CP::TMemoryUsage::TMemoryUsage(): fEnabled(false), fSampler(NULL) {}
 
-CP::TMemoryUsage::~TMemoryUsage() {}
+CP::TMemoryUsage::~TMemoryUsage() {
+    delete fSampler;
+}
 
 void CP::TMemoryUsage::Enable(bool enable) {
     if (enable) CaptNamedInfo("MEM","Enabling logging of memory usage");
     else CaptNamedInfo("MEM","Disabling logging of memory usage");
     fEnabled = enable;
+    if (fEnabled) {
+        if (!fSampler) fSampler = new CP::TResourceSampler();
+        fSampler->Start();
+    }
+    else if (fSampler) fSampler->Stop();
 }
 
-void CP::TMemoryUsage::LogMemory() {
+void CP::TMemoryUsage::LogMemory(int run, int event) {
     if (!fEnabled) return;
-    ProcInfo_t info;
-    gSystem->GetProcInfo(&info);
-    fEventMemory.push_back(info);
+    fSampler->SetEvent(run,event);
 }
 
 void CP::TMemoryUsage::Write(CP::TRootOutput* output) {
     if (!fEnabled) return;
 
+    // Record the memory at the end of the job.
+    fSampler->Sample();
+    std::vector<CP::TResourceSampler::TSample> samples
+        = fSampler->GetSamples();
+
     if (output && output->IsOpen()) {
 
         CaptNamedInfo("MEM","Writing memory usage histograms to file");
         output->cd();
         
-        // Create the histograms we need.
-        int numBins = fEventMemory.size();
+        // Create the histograms we need.  There is one bin per event until
+        // there are too many events, and then each bin covers several
+        // events.
+        long events = std::max(1L, fSampler->GetEventCount());
+        int numBins = std::min(events, (long) kMaxBins);
         TH1F hMemRes("memory_resident", "Resident memory usage", 
-                     numBins, 0, numBins);
+                     numBins, 0, events);
         hMemRes.GetXaxis()->SetTitle("Event");
         hMemRes.GetYaxis()->SetTitle("Resident memory (GB)");
         
         TH1F hMemVirt("memory_virtual", "Virtual memory usage", 
-                      numBins, 0, numBins);
+                      numBins, 0, events);
         hMemVirt.GetXaxis()->SetTitle("Event");
         hMemVirt.GetYaxis()->SetTitle("Virtual memory (GB)");
         
-        // Convert the vector of memory usage to entries in the
-        // histograms. Memory usage is converted from KB to GB
-        // for easier human-based parsing of the numbers.
-        int bin = 1;
-        for (std::vector<ProcInfo_t>::iterator it = fEventMemory.begin(); 
-             it != fEventMemory.end(); 
-             it++, bin++) {
-            ProcInfo_t info = (*it);
-            hMemRes.SetBinContent(bin, info.fMemResident / (1024. * 1024.));
-            hMemVirt.SetBinContent(bin, info.fMemVirtual / (1024. * 1024.));
+        // Find the largest memory usage in each bin.  A sample taken during
+        // an event is put in the bin for that event (the events are counted
+        // from zero).  Memory usage is converted from KB to GB for easier
+        // human-based parsing of the numbers.
+        std::vector<double> resident(numBins, 0.0);
+        std::vector<double> virtualMemory(numBins, 0.0);
+        std::vector<double> lastResident(numBins, -1.0);
+        std::vector<double> lastVirtual(numBins, -1.0);
+        for (std::vector<CP::TResourceSampler::TSample>::iterator s
+                 = samples.begin();
+             s != samples.end(); ++s) {
+            long event = std::max(0L, s->fEvents-1);
+            int bin = std::min((long) numBins-1, event*numBins/events);
+            double res = s->fResident / (1024. * 1024.);
+            double virt = s->fVirtual / (1024. * 1024.);
+            resident[bin] = std::max(resident[bin], res);
+            virtualMemory[bin] = std::max(virtualMemory[bin], virt);
+            lastResident[bin] = res;
+            lastVirtual[bin] = virt;
+        }
+
+        // The samples are taken at a fixed interval, so there are bins
+        // without a sample when the events are fast.  An empty bin gets the
+        // last sample taken before it since that's the best estimate of the
+        // memory during those events.
+        double carryResident = 0.0;
+        double carryVirtual = 0.0;
+        for (int bin = 0; bin < numBins; ++bin) {
+            if (lastResident[bin] < 0.0) {
+                resident[bin] = carryResident;
+                virtualMemory[bin] = carryVirtual;
+            }
+            else {
+                carryResident = lastResident[bin];
+                carryVirtual = lastVirtual[bin];
+            }
+            hMemRes.SetBinContent(bin+1, resident[bin]);
+            hMemVirt.SetBinContent(bin+1, virtualMemory[bin]);
         }
         
         hMemRes.Write();
         hMemVirt.Write();
+
+        fSampler->Write(output);
     }
     
     // Log the peak memory usage.
-    double maxMemResident = 
-        (std::max_element(fEventMemory.begin(), 
-                          fEventMemory.end(), 
-                          CmpMemResident()))->fMemResident;
-    double maxMemVirtual  = 
-        (std::max_element(fEventMemory.begin(), 
-                          fEventMemory.end(), 
-                          CmpMemVirtual()))->fMemVirtual;
+    double maxMemResident = fSampler->GetPeakResident();
+    double maxMemVirtual  = fSampler->GetPeakVirtual();
     
     CaptNamedLog("MEM","Maximum resident memory usage: " 
                   << (maxMemResident / (1024. * 1024.)) << " GB");
@@ -2,11 +2,11 @@
 #define TMemoryUsage_hxx_seen
 #include <TRootOutput.hxx>
 #include <typeinfo>
-#include <TSystem.h>
 #include <vector>
 
 namespace CP {
     class TMemoryUsage;
+    class TResourceSampler;
 };
 
 /// This utility class can be used to generate histograms of the memory used
@@ -14,6 +14,9 @@ namespace CP {
 /// Enable().  The expected usage is to call LogMemory() once per event, and
 /// Write() once all event have been processed.  This class is used inside the
 /// default eventLoop, so it isn't generally used outside of this library.
+/// The memory is sampled by a TResourceSampler on a background thread, so
+/// the memory used between events is seen, and the memory needed to keep
+/// the record doesn't grow with the number of events.
 class CP::TMemoryUsage {
 public:
     /// Construct the memory usage class with logging disabled.
@@ -26,34 +29,33 @@ public:
     /// the argument is false, then memory logging is disabled.
     void Enable(bool enable = true);
 
-    /// Log the current memory usage.  Record the current memory being used by
-    /// the process.  If Enable() has not been called, this function does
-    /// nothing.  In general, the memory usage should be logged once per
-    /// event, but it can be called any number of times.  Logging memory
-    /// requires saving two float and two longs into a vector.
-    void LogMemory();
+    /// Log the start of an event.  The memory samples are associated with
+    /// the number of calls to LogMemory() (and the run and event numbers)
+    /// when they are taken.  If Enable() has not been called, this function
+    /// does nothing.  In general, this should be called once per event, but
+    /// it can be called any number of times.  This only saves the event
+    /// numbers, so it is very cheap.
+    void LogMemory(int run = -1, int event = -1);
 
     /// Write histograms of the memory usage to an output file.  Write
     /// histograms of the resident and virtual memory usage of the program to
     /// the top-level directory of the output file.  The histograms are
-    /// indexed by the number of calls to LogMemory().  If Enable() has not
-    /// been called, this function does nothing.
+    /// indexed by the number of calls to LogMemory(), and each bin has the
+    /// largest memory seen while the events in the bin were processed.  A
+    /// bin without any samples (the events were faster than the sampling
+    /// period) has the last sample taken before the bin.  The
+    /// samples are also written as a TTree named "resourceTimeline" (see
+    /// TResourceSampler).  If Enable() has not been called, this function
+    /// does nothing.
     void Write(CP::TRootOutput* output);
     
 private:
     /// Whether to log memory usage. Set using Enable()
     bool fEnabled;
     
-    /// Record of the memory usage each time LogMemory() is called.
-    ///
-    /// From TSystem.h:
-    ///   struct ProcInfo_t {
-    ///     Float_t fCpuUser; // user time used by this process in seconds
-    ///     Float_t fCpuSys; // system time used by this process in seconds
-    ///     Long_t fMemResident; // resident memory used by this process in KB
-    ///     Long_t fMemVirtual; // virtual memory used by this process in KB
-    ///   }
-    std::vector<ProcInfo_t> fEventMemory;
+    /// The sampler that records the memory usage.  This is created by
+    /// Enable().
+    CP::TResourceSampler* fSampler;
 };
 #endif
 
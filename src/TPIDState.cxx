@@ -9,7 +9,7 @@ ClassImp(CP::TPIDState);
 CP::TPIDState::TPIDState(): TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
-    Init();
+    Init(fStorage);
 }
 
 CP::TPIDState::TPIDState(const CP::TTrackState& tstate): TMReconState(this) {
@@ -18,7 +18,7 @@ CP::TPIDState::TPIDState(const CP::TTrackState& tstate): TMReconState(this) {
               std::back_inserter(fFieldNames));
 
 
-    Init();
+    Init(fStorage);
 
     // retrieve the position and it's covariance. 
     for(int i = 0;i < TMPositionState::GetSize(); ++i) {
@@ -84,7 +84,7 @@ CP::TPIDState::TPIDState(const CP::TShowerState& tstate): TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
 
-    Init();
+    Init(fStorage);
 
     // retrieve the position and it's covariance. 
     for(int i = 0;i < TMPositionState::GetSize(); ++i) {
@@ -137,36 +137,23 @@ CP::TPIDState::TPIDState(const CP::TPIDState& init)
   : TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
-    Init();
+    Init(fStorage);
 
-    for (int i=0; i<GetSize(); ++i) {
-        SetValue(i,init.GetValue(i));
-    }
-
-    for (int i=0; i<GetSize(); ++i) {
-        for (int j=0; j<GetSize(); ++j) {
-            SetCovarianceValue(i,j,init.GetCovarianceValue(i,j));
-        }
-    }
-    
+    CopyValues(init);
 }
 
 CP::TPIDState& CP::TPIDState::operator=(const CP::TPIDState& rhs) {
     if (this == &rhs) return *this;
 
-    for (int i=0; i<GetSize(); ++i) {
-        SetValue(i,rhs.GetValue(i));
-    }
+    CopyValues(rhs);
 
-    for (int i=0; i<GetSize(); ++i) {
-        for (int j=0; j<GetSize(); ++j) {
-            SetCovarianceValue(i,j,rhs.GetCovarianceValue(i,j));
-        }
-    }
-    
     return *this;
 }
 
+CP::TReconState* CP::TPIDState::CopyState() const {
+    return new CP::TPIDState(*this);
+}
+
 CP::TPIDState::~TPIDState() {}
 
 CP::TCorrValues CP::TPIDState::ProjectState(
@@ -180,11 +167,11 @@ CP::TCorrValues CP::TPIDState::ProjectState(
         const int offset = posState->GetPositionIndex();
         for (int i = 0; i < TMPositionState::GetSize(); ++i) {
             values.SetValue(i+base, 
-                            posState->GetThis().fValues.GetValue(i+offset));
+                            posState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMPositionState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    posState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    posState->GetThis().GetCovarianceValue(i+offset,
                                                                    j+offset));
             }
         }
@@ -196,11 +183,11 @@ CP::TCorrValues CP::TPIDState::ProjectState(
         const int offset = dirState->GetDirectionIndex();
         for (int i = 0; i < TMDirectionState::GetSize(); ++i) {
             values.SetValue(i+base, 
-                            dirState->GetThis().fValues.GetValue(i+offset));
+                            dirState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMDirectionState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    dirState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    dirState->GetThis().GetCovarianceValue(i+offset,
                                                                    j+offset));
             }
         }
@@ -212,11 +199,11 @@ CP::TCorrValues CP::TPIDState::ProjectState(
         const int offset = momState->GetMomentumIndex();
         for (int i = 0; i < TMMomentumState::GetSize(); ++i) {
             values.SetValue(i+base,
-                            momState->GetThis().fValues.GetValue(i+offset));
+                            momState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMMomentumState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    momState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    momState->GetThis().GetCovarianceValue(i+offset,
                                                                     j+offset));
             }
         }
@@ -228,11 +215,11 @@ CP::TCorrValues CP::TPIDState::ProjectState(
         const int offset = chgState->GetChargeIndex();
         for (int i = 0; i < TMChargeState::GetSize(); ++i) {
             values.SetValue(i+base,
-                            chgState->GetThis().fValues.GetValue(i+offset));
+                            chgState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMChargeState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    chgState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    chgState->GetThis().GetCovarianceValue(i+offset,
                                                                     j+offset));
             }
         }
@@ -2,6 +2,7 @@
 #define TPIDState_hxx_seen
 
 #include "TReconState.hxx"
+#include "TReconStateView.hxx"
 #include "TTrackState.hxx"
 #include "TShowerState.hxx"
 #include "TReconNode.hxx"
@@ -31,6 +32,9 @@ public:
     virtual ~TPIDState();
     virtual TPIDState& operator=(const CP::TPIDState& rhs);
 
+    /// Make a new copy of the state.
+    virtual CP::TReconState* CopyState() const;
+
     /// Return the number of entries for the Direction in the TCorrValues
     /// vector.
     static int GetSize() {
@@ -42,6 +46,25 @@ public:
     /// The projection operator to get the full state.
     static CP::TCorrValues ProjectState(const CP::THandle<CP::TReconState>& state);
 
+private:
+    /// The fixed size storage for the state values.
+    TReconStateStorage<9> fStorage; //! Don't Save
+
     ClassDef(TPIDState,2);
 };
+
+#ifndef __CINT__
+namespace CP {
+    /// The compile time layout of the TPIDState fields.
+    template <> struct TReconStateLayout<CP::TPIDState> {
+        enum {
+            kPosition = 0,
+            kDirection = 4,
+            kMomentum = 7,
+            kCharge = 8,
+            kSize = 9
+        };
+    };
+}
+#endif
 #endif
@@ -10,6 +10,7 @@
 #include "TDataVector.hxx"
 #include "THitSelection.hxx"
 #include "TReconState.hxx"
+#include "TEventArena.hxx"
 
 namespace CP {
     class TReconBase;
@@ -91,6 +92,9 @@ public:
 public:
     virtual ~TReconBase();
 
+    /// Allocate from the current event arena (see TEventArena).
+    EVENT_ARENA_ALLOCATED;
+
     /// Get the name of the algorithm that created this reconstruction object.
     std::string GetAlgorithmName() const {return fAlgorithm;}
 
@@ -193,7 +197,10 @@ public:
     }
 
     /// Provide a non-constant version of the node container so that nodes can
-    /// be added.
+    /// be added.  The nodes of a shallow copy (e.g.
+    /// TReconTrack::ShallowCopy()) are shared with the original object, so
+    /// an existing node should be changed through
+    /// TReconNodeContainer::GetWritableNode().
     CP::TReconNodeContainer& GetNodes() {
         if (!fNodes) {
             CaptError("TReconBase without a TReconNodeContainer:"
@@ -3,10 +3,16 @@
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
 
 #include "TReconCluster.hxx"
 #include "TReconNode.hxx"
 #include "HEPUnits.hxx"
+#include "SymmetricEigen3.hxx"
 
 ClassImp(CP::TReconCluster);
 
@@ -17,23 +23,34 @@ CP::TReconCluster::TReconCluster()
 }
 
 CP::TReconCluster::TReconCluster(const CP::TReconCluster& cluster)
+    : TReconCluster(cluster,false) {}
+
+CP::TReconCluster::TReconCluster(const CP::TReconCluster& cluster,
+                                 bool shareNodes)
     : CP::TReconBase(cluster), fMoments(3), fTemporariesInitialized(false) {
     fNodes = new TReconNodeContainerImpl<CP::TClusterState>;
     
-    // Copy the nodes.  Create new nodes with TClusterState's
-    CP::TReconNodeContainer::const_iterator in;
-    for (in=cluster.GetNodes().begin(); in!=cluster.GetNodes().end();in++){
-        CP::THandle<CP::TReconNode> node(new CP::TReconNode);
-        CP::THandle<CP::TReconBase> object = (*in)->GetObject();
-        node->SetObject(object);
-        CP::THandle<CP::TClusterState> tstate = (*in)->GetState();
-        if (tstate){
-            CP::THandle<CP::TReconState> pstate(new CP::TClusterState(*tstate));
-            node->SetState(pstate);
+    if (shareNodes) {
+        // Share the nodes with the original object (see ShallowCopy()).
+        fNodes->ShareNodes(cluster.GetNodes());
+    }
+    else {
+        // Copy the nodes.  Create new nodes with TClusterState's
+        CP::TReconNodeContainer::const_iterator in;
+        for (in=cluster.GetNodes().begin(); in!=cluster.GetNodes().end();
+             ++in) {
+            CP::THandle<CP::TReconNode> node(new CP::TReconNode);
+            CP::THandle<CP::TReconBase> object = (*in)->GetObject();
+            node->SetObject(object);
+            CP::THandle<CP::TClusterState> tstate = (*in)->GetState();
+            if (tstate) {
+                CP::THandle<CP::TReconState> pstate(
+                    new CP::TClusterState(*tstate));
+                node->SetState(pstate);
+            }
+            node->SetQuality((*in)->GetQuality());
+            fNodes->push_back(node);
         }
-        node->SetQuality((*in)->GetQuality());
-        
-        fNodes->push_back(node);
     }
     
     
@@ -48,6 +65,10 @@ CP::TReconCluster::TReconCluster(const CP::TReconCluster& cluster)
 
 CP::TReconCluster::~TReconCluster() {}
 
+CP::TReconCluster* CP::TReconCluster::ShallowCopy() const {
+    return new CP::TReconCluster(*this,true);
+}
+
 double CP::TReconCluster::GetEDeposit() const {
     // I'm being a bit pedantic and casting to the base mix-in class.  This
     // could just as well cast to a TClusterState.
@@ -136,6 +157,224 @@ void CP::TReconCluster::SetMoments(const TMatrixT<double>& moments) {
     }
 }
 
+namespace {
+    /// The fields of the cluster state in the order used while summing the
+    /// hits.
+    enum {kCharge, kX, kY, kZ, kT, kFields};
+
+    /// The hit attributes used to fill a cluster.  These are read once
+    /// through the THit interface and saved in a contiguous array so that
+    /// the sums are simple loops over memory.
+    struct HitAttributes {
+        double fValue[kFields];
+        double fSigma[kFields];
+        double fRMS[kFields];
+    };
+
+    /// The values, covariance and moments calculated from the hits.
+    struct ClusterSummary {
+        double fValue[kFields];
+        double fCovariance[kFields][kFields];
+        double fMoments[3][3];
+    };
+
+    void GatherHit(const CP::THit& hit, HitAttributes& attr) {
+        const double charge = hit.GetCharge();
+        const TVector3& pos = hit.GetPosition();
+        const TVector3& unc = hit.GetUncertainty();
+        const TVector3& rms = hit.GetRMS();
+        attr.fValue[kCharge] = charge;
+        attr.fSigma[kCharge] = std::sqrt(charge);
+        attr.fRMS[kCharge] = 0.0;
+        for (int i=0; i<3; ++i) {
+            attr.fValue[kX+i] = pos[i];
+            attr.fSigma[kX+i] = unc[i];
+            attr.fRMS[kX+i] = rms[i];
+        }
+        attr.fValue[kT] = hit.GetTime();
+        attr.fSigma[kT] = hit.GetTimeUncertainty();
+        attr.fRMS[kT] = hit.GetTimeRMS();
+    }
+
+    /// Calculate the cluster state and moments in a single pass over the
+    /// hits.  The energy deposit is the sum of the charges, and the other
+    /// values are averaged weighted by the inverse variance.  The sums are
+    /// made relative to the first hit (the "shifted data" algorithm) so
+    /// that the covariance and moments don't lose precision when the
+    /// cluster is far from the origin.
+    void SummarizeHits(const HitAttributes* hits, std::size_t count,
+                       ClusterSummary& summary) {
+        double shift[kFields];
+        double meanSum[kFields];
+        double meanNorm[kFields];
+        double hitWeights[kFields];
+        // The sums for the covariance, with a weight of 1/(sig_r*sig_c).
+        // The sum of the weighted differences is kept for the full matrix
+        // since sumWD[r][c] is the sum of weight_rc*d_r.
+        double sumW[kFields][kFields];
+        double sumWD[kFields][kFields];
+        double sumWDD[kFields][kFields];
+        double dof[kFields][kFields];
+        // The sums for the charge weighted moments.
+        double chargeSum = 0.0;
+        double sumQD[3];
+        double sumQDD[3][3];
+        for (int r=0; r<kFields; ++r) {
+            shift[r] = hits[0].fValue[r];
+            meanSum[r] = meanNorm[r] = hitWeights[r] = 0.0;
+            for (int c=0; c<kFields; ++c) {
+                sumW[r][c] = sumWD[r][c] = sumWDD[r][c] = dof[r][c] = 0.0;
+            }
+        }
+        for (int r=0; r<3; ++r) {
+            sumQD[r] = 0.0;
+            for (int c=0; c<3; ++c) sumQDD[r][c] = 0.0;
+        }
+
+        for (std::size_t h = 0; h < count; ++h) {
+            const HitAttributes& hit = hits[h];
+            double d[kFields];
+            double inv[kFields];
+            for (int r=0; r<kFields; ++r) {
+                d[r] = hit.fValue[r] - shift[r];
+                inv[r] = 1.0/hit.fSigma[r];
+            }
+            meanSum[kCharge] += d[kCharge];
+            meanNorm[kCharge] += 1.0;
+            for (int r=kX; r<kFields; ++r) {
+                meanSum[r] += inv[r]*inv[r]*d[r];
+                meanNorm[r] += inv[r]*inv[r];
+            }
+            for (int r=0; r<kFields; ++r) {
+                hitWeights[r] += inv[r]*inv[r];
+                for (int c=0; c<kFields; ++c) {
+                    const double weight = inv[r]*inv[c];
+                    sumW[r][c] += weight;
+                    sumWD[r][c] += weight*d[r];
+                    sumWDD[r][c] += weight*d[r]*d[c];
+                    dof[r][c] += hit.fRMS[r]*hit.fRMS[c]*weight/3.0;
+                }
+            }
+            const double charge = hit.fValue[kCharge];
+            chargeSum += charge;
+            for (int r=0; r<3; ++r) {
+                sumQD[r] += charge*d[kX+r];
+                for (int c=0; c<3; ++c) {
+                    sumQDD[r][c] += charge*d[kX+r]*d[kX+c];
+                }
+                sumQDD[r][r] += charge*hit.fRMS[kX+r]*hit.fRMS[kX+r];
+            }
+        }
+        dof[kT][kT] = count;
+
+        // The energy deposit is a sum, not an average.
+        summary.fValue[kCharge] = meanSum[kCharge] + count*shift[kCharge];
+        for (int r=kX; r<kFields; ++r) {
+            if (meanNorm[r] > 0) {
+                summary.fValue[r] = shift[r] + meanSum[r]/meanNorm[r];
+            }
+            else summary.fValue[r] = 0.0;
+        }
+
+        // The offset of the average from the shift.
+        double delta[kFields];
+        for (int r=0; r<kFields; ++r) delta[r] = summary.fValue[r]-shift[r];
+
+        for (int r=0; r<kFields; ++r) {
+            for (int c=r; c<kFields; ++c) {
+                // The weighted RMS of the hits around the average.
+                double cov = 0.0;
+                if (sumW[r][c] > 0) {
+                    cov = sumWDD[r][c] 
+                        - delta[c]*sumWD[r][c] - delta[r]*sumWD[c][r]
+                        + delta[r]*delta[c]*sumW[r][c];
+                    cov /= sumW[r][c];
+                }
+                // Turn the RMS into a covariance of the mean.
+                if (dof[r][c] > 0.9) cov /= std::sqrt(dof[r][c]);
+                else if (r == c) cov = CP::TCorrValues::kFreeValue;
+                else cov = 0.0;
+                // Add the correction for finite size of the hits.
+                if (r == c && hitWeights[r] >= 1E-8) cov += 1.0/hitWeights[r];
+                summary.fCovariance[r][c] = cov;
+                summary.fCovariance[c][r] = cov;
+            }
+        }
+
+        // Fix the variance of the deposited energy.  This assumes it's
+        // Poisson distributed.
+        summary.fCovariance[kCharge][kCharge] = summary.fValue[kCharge];
+
+        // The moments are the charge weighted average squared difference
+        // from the cluster position.
+        for (int r=0; r<3; ++r) {
+            for (int c=r; c<3; ++c) {
+                double moment = 0.0;
+                // No divide by zero please!
+                if (chargeSum > 1E-6) {
+                    moment = sumQDD[r][c]
+                        - delta[kX+c]*sumQD[r] - delta[kX+r]*sumQD[c]
+                        + delta[kX+r]*delta[kX+c]*chargeSum;
+                    moment /= chargeSum;
+                }
+                else if (r == c) {
+                    // There were no measurements on this axis so spread the
+                    // charge over the entire range of the detector
+                    // (i.e. +-"10 m + epsilon")
+                    moment = 1E+9;
+                }
+                summary.fMoments[r][c] = moment;
+                summary.fMoments[c][r] = moment;
+            }
+        }
+    }
+
+    /// Find the distance to the furthest hit from the center along each of
+    /// the axes (in units of the axis length).
+    void FindExtents(const HitAttributes* hits, std::size_t count,
+                     const TVector3& center, const TVector3* axes,
+                     double* extents) {
+        for (int a=0; a<3; ++a) extents[a] = 0.0;
+        for (std::size_t h = 0; h < count; ++h) {
+            const HitAttributes& hit = hits[h];
+            TVector3 diff(hit.fValue[kX]-center.X(),
+                          hit.fValue[kY]-center.Y(),
+                          hit.fValue[kZ]-center.Z());
+            double size = std::sqrt(hit.fRMS[kX]*hit.fRMS[kX]
+                                    + hit.fRMS[kY]*hit.fRMS[kY]
+                                    + hit.fRMS[kZ]*hit.fRMS[kZ]);
+            for (int a=0; a<3; ++a) {
+                extents[a] = std::max(extents[a],
+                                      size + std::abs(diff*axes[a]));
+            }
+        }
+        for (int a=0; a<3; ++a) extents[a] /= axes[a].Mag();
+    }
+
+    /// The array of hit attributes used by the thread while filling a
+    /// cluster.  It's kept so the memory is reused.
+    std::vector<HitAttributes>& ScratchAttributes() {
+        static thread_local std::vector<HitAttributes> attributes;
+        return attributes;
+    }
+
+    /// Read the attributes for a range of hits into the scratch array.
+    std::vector<HitAttributes>& GatherHits(
+        CP::THitSelection::const_iterator begin,
+        CP::THitSelection::const_iterator end) {
+        std::vector<HitAttributes>& attributes = ScratchAttributes();
+        attributes.resize(end-begin);
+        std::vector<HitAttributes>::iterator attr = attributes.begin();
+        for (CP::THitSelection::const_iterator h = begin; h != end; ++h) {
+            GatherHit(**h, *(attr++));
+        }
+        return attributes;
+    }
+
+    /// The minimum number of clusters given to a thread by FillClusters.
+    const std::size_t kClustersPerThread = 64;
+}
+
 void CP::TReconCluster::UpdateFromHits() {
     fTemporariesInitialized = false;
     // Make sure there is a hit container.
@@ -147,203 +386,131 @@ void CP::TReconCluster::UpdateFromHits() {
     CP::THitSelection::const_iterator end = hits->end();
     if (end-beg < 1) return;
 
+    // Read the hit attributes once, and then sum them.
+    std::vector<HitAttributes>& attributes = GatherHits(beg,end);
+    ClusterSummary summary;
+    SummarizeHits(&attributes[0], attributes.size(), summary);
+    SetFromHits(attributes.size(), summary.fValue,
+                &summary.fCovariance[0][0], &summary.fMoments[0][0]);
+}
+
+void CP::TReconCluster::SetFromHits(int hitCount, const double* values,
+                                    const double* covariance,
+                                    const double* moments) {
     fStatus = CP::TReconBase::kSuccess;
     fQuality = 1.0;
-    fNDOF = std::max(1,int(end-beg-1));
+    fNDOF = std::max(1,hitCount-1);
     CP::THandle<CP::TClusterState> state = GetState();
-    
-    int dim = state->GetDimensions();
-    TVectorT<double> vals(dim);
-    TVectorT<double> sigs(dim);
-    TVectorT<double> rms(dim);
 
     // Save the index into the state for each of the values.
-    int eDep = state->GetEDepositIndex();
-    int posX = state->GetXIndex();
-    int posY = state->GetYIndex();
-    int posZ = state->GetZIndex();
-    int posT = state->GetTIndex();
-
-    // Find the energy deposit and the average position.
-    TVectorT<double> stateValues(dim);
-    TVectorT<double> stateNorms(dim);
-    for (CP::THitSelection::const_iterator h = beg;
-         h != end;
-         ++h) {
-        vals(eDep) = (*h)->GetCharge();
-        sigs(eDep) = 1.0;
-
-        vals(posX) = (*h)->GetPosition().X();
-        sigs(posX) = (*h)->GetUncertainty().X();
-
-        vals(posY) = (*h)->GetPosition().Y();
-        sigs(posY) = (*h)->GetUncertainty().Y();
-
-        vals(posZ) = (*h)->GetPosition().Z();
-        sigs(posZ) = (*h)->GetUncertainty().Z();
-
-        vals(posT) = (*h)->GetTime();
-        sigs(posT) = (*h)->GetTimeUncertainty();
-
-        for (int i=0; i<dim; ++i) {
-            stateValues(i) += vals(i)/(sigs(i)*sigs(i));
-            stateNorms(i) += 1/(sigs(i)*sigs(i));
-        }
-    }
-        
-    stateNorms(0) = 1.0;
-    for (int i=0; i<dim; ++i) {
-        if (stateNorms(i) > 0) stateValues(i) /= stateNorms(i);
-    }
+    int index[kFields];
+    index[kCharge] = state->GetEDepositIndex();
+    index[kX] = state->GetXIndex();
+    index[kY] = state->GetYIndex();
+    index[kZ] = state->GetZIndex();
+    index[kT] = state->GetTIndex();
 
-    // Estimate the covariance of cluster state values.
-    TMatrixTSym<double> stateCov(dim);
-    // This counts the weight for each bin of the covariance.
-    TMatrixTSym<double> weights(dim);
-    // This counts the number of degrees of freedom contributing to each bin.
-    TMatrixTSym<double> dof(dim);
-    for (CP::THitSelection::const_iterator h = beg;
-         h != end;
-         ++h) {
-        vals(eDep) = (*h)->GetCharge() - stateValues(eDep);
-        sigs(eDep) = std::sqrt((*h)->GetCharge());
-        rms(eDep) = 0.0;
-
-        vals(posX) = (*h)->GetPosition().X() - stateValues(posX);
-        sigs(posX) = (*h)->GetUncertainty().X();
-        rms(posX) = (*h)->GetRMS().X();
-
-        vals(posY) = (*h)->GetPosition().Y() - stateValues(posY);
-        sigs(posY) = (*h)->GetUncertainty().Y();
-        rms(posY) = (*h)->GetRMS().Y();
-        
-        vals(posZ) = (*h)->GetPosition().Z() - stateValues(posZ);
-        sigs(posZ) = (*h)->GetUncertainty().Z();
-        rms(posZ) = (*h)->GetRMS().Z();
-
-        vals(posT) = (*h)->GetTime() - stateValues(posT);
-        sigs(posT) = (*h)->GetTimeUncertainty();
-        rms(posT) = (*h)->GetTimeRMS();
-
-        for (int row = 0; row<dim; ++row) {
-            for (int col = row; col<dim; ++col) {
-                double weight = 1.0/(sigs(row)*sigs(col));
-                stateCov(row,col) += weight*vals(row)*vals(col);
-                weights(row,col) += weight;
-                double degrees 
-                    = 4*rms(row)*rms(col)/(12*sigs(row)*sigs(col));
-                if (row == posT && col == posT) degrees = 1.0;
-                dof(row,col) += degrees;
-            }
+    // Set the state value and covariance.
+    for (int row=0; row<kFields; ++row) {
+        state->SetValue(index[row],values[row]);
+        for (int col=0; col<=row; ++col) {
+            state->SetCovarianceValue(index[row],index[col],
+                                      covariance[row*kFields+col]);
         }
     }
 
-    // Turn the "stateCov" variable into the RMS.
-    for (int row = 0; row<dim; ++row) {
-        for (int col = row; col<dim; ++col) {
-            if (weights(row,col)>0) stateCov(row,col) /= weights(row,col);
-            else stateCov(row,col) = 0.0;
-            stateCov(col,row) = stateCov(row,col);
-        }
-    }
+    SetMoments(moments[0], moments[4], moments[8],
+               moments[1], moments[2], moments[5]);
+}
 
-    // Turn the RMS into a covariance of the mean (This is almost a repeat of
-    // turning the value into an RMS.
-    for (int row = 0; row<dim; ++row) {
-        for (int col = row; col<dim; ++col) {
-            if (dof(row,col)>0.9) stateCov(row,col) /= std::sqrt(dof(row,col));
-            else if (row==col) stateCov(row,col) = CP::TCorrValues::kFreeValue;
-            else stateCov(row,col) = 0.0;
-            stateCov(col,row) = stateCov(row,col);
-        }
+void CP::TReconCluster::FillClusters(const char* name,
+                                     const CP::THitSelection& hits,
+                                     const std::vector<int>& labels,
+                                     CP::TReconObjectContainer& clusters,
+                                     int threads) {
+    if (labels.size() != hits.size()) {
+        CaptError("Cluster labels (" << labels.size() << ")"
+                  << " don't match the hits (" << hits.size() << ")");
+        throw EClusterLabels();
     }
 
-    // Add the correction for finite size of the hits.
-    TVectorT<double> hitWeights(dim);
-    for (CP::THitSelection::const_iterator h = beg;
-         h != end;
-         ++h) {
-        sigs(eDep) = std::sqrt((*h)->GetCharge());
-        sigs(posX) = (*h)->GetUncertainty().X();
-        sigs(posY) = (*h)->GetUncertainty().Y();
-        sigs(posZ) = (*h)->GetUncertainty().Z();
-        sigs(posT) = (*h)->GetTimeUncertainty();
-
-        for (int idx = 0; idx<dim; ++idx) {
-            double weight = 1.0/(sigs(idx)*sigs(idx));
-            hitWeights(idx) += weight;
-        }
-    }
-    
-    for (int idx = 0; idx<dim; ++idx) {
-        if (hitWeights(idx)<1E-8) continue;
-        stateCov(idx,idx) += 1.0/hitWeights(idx);
+    // Order the hits by label.
+    std::vector<std::size_t> order;
+    order.reserve(hits.size());
+    for (std::size_t i = 0; i < labels.size(); ++i) {
+        if (labels[i] >= 0) order.push_back(i);
     }
-    
-    // Fix the variance of the deposited energy.  This assumes it's Poisson
-    // distributed.
-    stateCov(eDep,eDep) = stateValues(eDep);
-
-    // Set the state value and covariance.
-    for (int row=0; row<dim; ++row) {
-        state->SetValue(row,stateValues(row));
-        for (int col=0; col<dim; ++col) {
-            state->SetCovarianceValue(row,col,stateCov(row,col));
-            state->SetCovarianceValue(col,row,stateCov(row,col));
+    std::stable_sort(order.begin(), order.end(),
+                     [&labels](std::size_t a, std::size_t b) {
+                         return labels[a] < labels[b];
+                     });
+
+    // Read the hit attributes in label order, and find where each cluster
+    // starts.  The last entry in "first" is the end of the last cluster.
+    std::vector<HitAttributes> attributes(order.size());
+    std::vector<std::size_t> first;
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        GatherHit(*hits[order[i]], attributes[i]);
+        if (i == 0 || labels[order[i]] != labels[order[i-1]]) {
+            first.push_back(i);
         }
     }
-
-    // Find the moments of the cluster.  This could be done as part of the
-    // covariance calculation, but is seperated so it's easier to see what is
-    // going on.
-    TMatrixTSym<double> moments(3);
-    TMatrixTSym<double> chargeSum(3);
-    TVector3 center(state->GetValue(posX), 
-                    state->GetValue(posY), 
-                    state->GetValue(posZ));
-
-    // Calculate the charge weighted "sum of squared differences".
-    for (CP::THitSelection::const_iterator h = beg;
-         h != end;
-         ++h) {
-        TVector3 diff = (*h)->GetPosition() - center;
-        for (int row = 0; row<3; ++row) {
-            for (int col = row; col<3; ++col) {
-                moments(row,col) += diff(row)*diff(col)*(*h)->GetCharge();
-                // Correct for the finite size of the hit.
-                if (row==col) {
-                    double r = (*h)->GetRMS()[row];
-                    moments(row,col) += r*r*(*h)->GetCharge();
-                }
-                chargeSum(row,col) += (*h)->GetCharge();
-            }
+    first.push_back(order.size());
+    const std::size_t count = first.size()-1;
+
+    // Create the clusters on this thread so they are allocated from the
+    // current event arena.
+    std::vector< CP::THandle<CP::TReconCluster> > built;
+    built.reserve(count);
+    for (std::size_t c = 0; c < count; ++c) {
+        CP::THandle<CP::TReconCluster> cluster(new CP::TReconCluster);
+        cluster->fAlgorithm = std::string(name);
+        CP::THitSelection* clusterHits = new THitSelection("clusterHits");
+        clusterHits->reserve(first[c+1]-first[c]);
+        for (std::size_t i = first[c]; i < first[c+1]; ++i) {
+            clusterHits->push_back(hits[order[i]]);
         }
+        cluster->AddHits(clusterHits);
+        built.push_back(cluster);
     }
 
-    // Turn this into the average square difference (i.e. the moments)
-    for (int row = 0; row<3; ++row) {
-        for (int col = row; col<3; ++col) {
-            // No divide by zero please!
-            if (chargeSum(row,col) > 1E-6) {
-                moments(row,col) = moments(row,col)/chargeSum(row,col);
-            } 
-            else if (row == col) {
-                // There were no measurements on this axis so spread the
-                // charge over the entire range of the detector 
-                // (i.e. +-"10 m + epsilon")
-                moments(row,col) = 1E+9;
+    // Fill the clusters.  Each cluster is only touched by one thread.
+    std::atomic<std::size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorLock;
+    auto fill = [&]() {
+        try {
+            for (std::size_t c = next++; c < count; c = next++) {
+                const HitAttributes* clusterHits = &attributes[first[c]];
+                const std::size_t hitCount = first[c+1]-first[c];
+                TReconCluster& cluster = *built[c];
+                ClusterSummary summary;
+                SummarizeHits(clusterHits, hitCount, summary);
+                cluster.SetFromHits(hitCount, summary.fValue,
+                                    &summary.fCovariance[0][0],
+                                    &summary.fMoments[0][0]);
+                cluster.FillTemporaries();
             }
-            else {
-                // There were no measurements so the aren't any off-axis
-                // correlations.
-                moments(row,col) = 0;
-            }
-            // Keep it symmetric.
-            moments(col,row) = moments(row,col);
         }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(errorLock);
+            if (!error) error = std::current_exception();
+            next = count;
+        }
+    };
+
+    std::size_t workers = threads;
+    if (threads < 1) workers = std::thread::hardware_concurrency();
+    workers = std::min(workers, count/kClustersPerThread);
+    std::vector<std::thread> pool;
+    for (std::size_t w = 1; w < workers; ++w) {
+        pool.push_back(std::thread(fill));
     }
+    fill();
+    for (std::size_t w = 0; w < pool.size(); ++w) pool[w].join();
+    if (error) std::rethrow_exception(error);
 
-    SetMoments(moments);
+    for (std::size_t c = 0; c < count; ++c) clusters.push_back(built[c]);
 }
 
 void CP::TReconCluster::ls(Option_t *opt) const {
@@ -396,22 +563,39 @@ void CP::TReconCluster::ls(Option_t *opt) const {
 
 void CP::TReconCluster::FillTemporaries() const {
     if (fTemporariesInitialized) return;
-    fTemporariesInitialized = true;
 
-    TVectorF eigenValues;
-    TMatrixF eigenVectors(GetMoments().EigenVectors(eigenValues));
+    double moments[6];
+    double eigenValues[3];
+    double eigenVectors[9];
+    PackMoments(moments);
+    CP::Tools::SymmetricEigen3(moments, eigenValues, eigenVectors);
+    SetAxes(eigenValues, eigenVectors);
+}
+
+void CP::TReconCluster::PackMoments(double* packed) const {
+    packed[0] = fMoments(0,0);
+    packed[1] = fMoments(1,1);
+    packed[2] = fMoments(2,2);
+    packed[3] = fMoments(0,1);
+    packed[4] = fMoments(0,2);
+    packed[5] = fMoments(1,2);
+}
+
+void CP::TReconCluster::SetAxes(const double* eigenValues,
+                                const double* eigenVectors) const {
+    fTemporariesInitialized = true;
 
     // Long axis comes first.
-    fLongAxis.SetXYZ(eigenVectors(0,0), eigenVectors(1,0), eigenVectors(2,0));
-    fLongAxis = std::sqrt(eigenValues(0))*fLongAxis;
+    fLongAxis.SetXYZ(eigenVectors[0], eigenVectors[3], eigenVectors[6]);
+    fLongAxis = std::sqrt(eigenValues[0])*fLongAxis;
 
     // Major axis comes second.
-    fMajorAxis.SetXYZ(eigenVectors(0,1), eigenVectors(1,1), eigenVectors(2,1));
-    fMajorAxis = std::sqrt(eigenValues(1))*fMajorAxis;
+    fMajorAxis.SetXYZ(eigenVectors[1], eigenVectors[4], eigenVectors[7]);
+    fMajorAxis = std::sqrt(eigenValues[1])*fMajorAxis;
 
     // Minor axis comes last.
-    fMinorAxis.SetXYZ(eigenVectors(0,2), eigenVectors(1,2), eigenVectors(2,2));
-    fMinorAxis = std::sqrt(eigenValues(2))*fMinorAxis;
+    fMinorAxis.SetXYZ(eigenVectors[2], eigenVectors[5], eigenVectors[8]);
+    fMinorAxis = std::sqrt(eigenValues[2])*fMinorAxis;
 
     const double epsilon = 1E-6;
     if (fLongAxis.X() < -epsilon) {
@@ -441,6 +625,32 @@ void CP::TReconCluster::FillTemporaries() const {
 
 }
 
+void CP::TReconCluster::FillAxes(const CP::TReconObjectContainer& objects) {
+    std::vector<const CP::TReconCluster*> clusters;
+    clusters.reserve(objects.size());
+    for (CP::TReconObjectContainer::const_iterator o = objects.begin();
+         o != objects.end(); ++o) {
+        const CP::TReconCluster* cluster
+            = dynamic_cast<const CP::TReconCluster*>(GetPointer(*o));
+        if (!cluster) continue;
+        if (cluster->fTemporariesInitialized) continue;
+        clusters.push_back(cluster);
+    }
+    if (clusters.empty()) return;
+
+    std::vector<double> moments(6*clusters.size());
+    std::vector<double> eigenValues(3*clusters.size());
+    std::vector<double> eigenVectors(9*clusters.size());
+    for (std::size_t c = 0; c < clusters.size(); ++c) {
+        clusters[c]->PackMoments(&moments[6*c]);
+    }
+    CP::Tools::SymmetricEigen3(clusters.size(), &moments[0],
+                               &eigenValues[0], &eigenVectors[0]);
+    for (std::size_t c = 0; c < clusters.size(); ++c) {
+        clusters[c]->SetAxes(&eigenValues[3*c], &eigenVectors[9*c]);
+    }
+}
+
 const TVector3& CP::TReconCluster::GetLongAxis() const {
     FillTemporaries();
     return fLongAxis;
@@ -457,49 +667,30 @@ const TVector3& CP::TReconCluster::GetMinorAxis() const {
 }
 
 double CP::TReconCluster::GetLongExtent() const {
-    FillTemporaries();
-
-    double maxLen = 0.0;
-    CP::THandle<CP::THitSelection> hits = GetHits();
-    for (CP::THitSelection::iterator h = hits->begin(); 
-         h != hits->end(); ++h) {
-        TVector3 diff = (*h)->GetPosition() - GetPosition().Vect();
-        maxLen = std::max(maxLen,
-                          (*h)->GetRMS().Mag() + std::abs(diff*fLongAxis));
-    }
-    maxLen /= fLongAxis.Mag();
-    return maxLen;
-
+    double extents[3];
+    GetExtents(extents);
+    return extents[0];
 }
 
 double CP::TReconCluster::GetMajorExtent() const {
-    FillTemporaries();
-
-    double maxLen = 0.0;
-    CP::THandle<CP::THitSelection> hits = GetHits();
-    for (CP::THitSelection::iterator h = hits->begin(); 
-         h != hits->end(); ++h) {
-        TVector3 diff = (*h)->GetPosition() - GetPosition().Vect();
-        maxLen = std::max(maxLen, 
-                          (*h)->GetRMS().Mag() + std::abs(diff*fMajorAxis));
-    }
-    maxLen /= fMajorAxis.Mag();
-    return maxLen;
-
+    double extents[3];
+    GetExtents(extents);
+    return extents[1];
 }
 
 double CP::TReconCluster::GetMinorExtent() const {
-    FillTemporaries();
+    double extents[3];
+    GetExtents(extents);
+    return extents[2];
+}
 
-    double maxLen = 0.0;
+void CP::TReconCluster::GetExtents(double* extents) const {
+    FillTemporaries();
     CP::THandle<CP::THitSelection> hits = GetHits();
-    for (CP::THitSelection::iterator h = hits->begin(); 
-         h != hits->end(); ++h) {
-        TVector3 diff = (*h)->GetPosition() - GetPosition().Vect();
-        maxLen = std::max(maxLen,
-                          (*h)->GetRMS().Mag() + std::abs(diff*fMinorAxis));
-    }
-    maxLen /= fMinorAxis.Mag();
-    return maxLen;
-
+    std::vector<HitAttributes>& attributes = ScratchAttributes();
+    attributes.clear();
+    if (hits) GatherHits(hits->begin(), hits->end());
+    TVector3 axes[3] = {fLongAxis, fMajorAxis, fMinorAxis};
+    FindExtents(attributes.empty() ? NULL : &attributes[0],
+                attributes.size(), GetPosition().Vect(), axes, extents);
 }
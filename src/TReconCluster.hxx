@@ -1,6 +1,8 @@
 #ifndef TReconCluster_hxx_seen
 #define TReconCluster_hxx_seen
 
+#include <vector>
+
 #include <TMatrixT.h>
 #include <TMatrixTSym.h>
 
@@ -14,6 +16,7 @@ namespace CP {
 
     EXCEPTION(EReconCluster,ECore);
     EXCEPTION(EMomentsSize,EReconCluster);
+    EXCEPTION(EClusterLabels,EReconCluster);
 }
 
 /// Represent an extended energy deposition centered at a position (i.e. a
@@ -39,6 +42,15 @@ public:
 
     virtual ~TReconCluster();
 
+    /// Make a copy of the cluster that shares the nodes (and their states)
+    /// with this cluster instead of copying them, which is much cheaper than
+    /// the copy constructor when only a few nodes will be changed (e.g. for
+    /// a refit).  After this is called, a node of either cluster must be
+    /// changed through TReconNodeContainer::GetWritableNode() and
+    /// TReconNode::GetWritableState(), since changing a shared node in
+    /// place changes both objects.  The caller owns the new cluster.
+    CP::TReconCluster* ShallowCopy() const;
+
     /// Return a handle to the state.
     CP::THandle<CP::TClusterState> GetState() const {
         return GetReconState();
@@ -118,6 +130,28 @@ public:
         FillFromHits(name, hits.begin(), hits.end());
     }
 
+    /// Build one cluster for each distinct label.  The label vector has an
+    /// entry for each hit in the hit selection, and hits with a negative
+    /// label are not used.  The clusters are appended to the container in
+    /// increasing label order.  Each cluster is filled the same way as
+    /// FillFromHits, and the moments and axes are also calculated so they
+    /// don't need to be found later.  The clusters are filled using
+    /// up to "threads" threads (zero means one per hardware thread), but
+    /// the objects are created by the calling thread.  This is much faster
+    /// than calling FillFromHits for each cluster when there are many small
+    /// clusters since the hits are only read once.
+    ///
+    /// \code
+    /// CP::TReconObjectContainer clusters("clusters");
+    /// CP::TReconCluster::FillClusters("myClustering", *hits, labels, 
+    ///                                 clusters);
+    /// \endcode
+    static void FillClusters(const char* name,
+                             const CP::THitSelection& hits,
+                             const std::vector<int>& labels,
+                             CP::TReconObjectContainer& clusters,
+                             int threads = 0);
+
     /// List the results of in the cluster.
     virtual void ls(Option_t* opt = "") const; 
 
@@ -136,6 +170,13 @@ public:
     /// minor axis, and the magnitude is equal to the moment along the axis.
     const TVector3& GetMinorAxis() const;
 
+    /// Calculate the long, major and minor axes for all of the clusters in a
+    /// container.  Objects that aren't clusters, and clusters that already
+    /// have their axes calculated, are skipped.  This gives the same result
+    /// as calling GetLongAxis() for each cluster, but solves the eigen
+    /// problems together.
+    static void FillAxes(const CP::TReconObjectContainer& objects);
+
     /// A convenience routine to return the distance to the furthest hit from
     /// the cluster position along the long axis of the cluster.
     double GetLongExtent() const;
@@ -149,19 +190,36 @@ public:
     double GetMinorExtent() const;
 
 private:
+    /// Copy constructor that shares the nodes with the original cluster when
+    /// shareNodes is true (see ShallowCopy()).
+    TReconCluster(const CP::TReconCluster& cluster, bool shareNodes);
 
     /// Fill all of the fields of the cluster based on the hits.
     void UpdateFromHits();
 
+    /// Set the state, moments and fit status of the cluster.  The values
+    /// and covariance are for the energy deposit, X, Y, Z and T (in that
+    /// order), and the covariance and moments are stored by row.
+    void SetFromHits(int hitCount, const double* values,
+                     const double* covariance, const double* moments);
+
     /// The moments for this cluster.
     MomentMatrix fMoments;
     
-    /// The caches state of the temporaries.
+    /// The cached state of the temporaries.
     mutable bool fTemporariesInitialized; //! Don't Save
 
     /// Fill the temporary fields.
     void FillTemporaries() const;
 
+    /// Set the axes from the eigenvalues and eigenvectors of the moments (in
+    /// the order returned by CP::Tools::SymmetricEigen3).
+    void SetAxes(const double* values, const double* vectors) const;
+
+    /// Copy the moments into an array in the order used by
+    /// CP::Tools::SymmetricEigen3.
+    void PackMoments(double* packed) const;
+
     /// The cached length of the cluster calculated from the eigenvectors of
     /// the moments.
     mutable TVector3 fLongAxis; //! Don't Save
@@ -174,6 +232,12 @@ private:
     /// the eigenvectors of the moments.
     mutable TVector3 fMinorAxis; //! Don't Save
 
+    /// Find the extents along the long, major and minor axes (in that
+    /// order) with one pass over the hits.  The extents aren't cached since
+    /// they depend on the hits and the position which can be changed
+    /// without the cluster knowing.
+    void GetExtents(double* extents) const;
+
     ClassDef(TReconCluster,1);
 };
 #endif
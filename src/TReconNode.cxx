@@ -1,13 +1,23 @@
 
+#include <typeinfo>
+
 #include "TReconNode.hxx"
 
 ClassImp(CP::TReconNode);
 
 CP::TReconNode::TReconNode()
-    : fQuality(0.) { }
+    : fQuality(0.), fShared(false), fSharedState(false) { }
 
 CP::TReconNode::~TReconNode() {}
 
+CP::THandle<CP::TReconState> CP::TReconNode::GetWritableState() {
+    if (fSharedState && fState) {
+        fState = CP::THandle<CP::TReconState>(fState->CopyState());
+    }
+    fSharedState = false;
+    return fState;
+}
+
 void CP::TReconNode::ls(Option_t *opt) const {
     std::string option(opt);
 
@@ -49,6 +59,35 @@ CP::TReconNodeContainer::TReconNodeContainer() {}
 
 CP::TReconNodeContainer::~TReconNodeContainer() {}
 
+void CP::TReconNodeContainer::ShareNodes(
+    const CP::TReconNodeContainer& nodes) {
+    if (typeid(*this) != typeid(nodes)) {
+        // The nodes might not have the right type of state for this
+        // container, so check each one.
+        for (const_iterator n = nodes.begin(); n != nodes.end(); ++n) {
+            push_back(*n);
+            (*n)->fShared = true;
+        }
+        return;
+    }
+    insert(end(), nodes.begin(), nodes.end());
+    for (const_iterator n = nodes.begin(); n != nodes.end(); ++n) {
+        (*n)->fShared = true;
+    }
+}
+
+CP::THandle<CP::TReconNode>
+CP::TReconNodeContainer::GetWritableNode(std::size_t i) {
+    CP::THandle<CP::TReconNode>& node = at(i);
+    if (node->fShared) {
+        CP::THandle<CP::TReconNode> copy(new CP::TReconNode(*node));
+        copy->fShared = false;
+        copy->fSharedState = true;
+        node = copy;
+    }
+    return node;
+}
+
 void CP::TReconNodeContainer::ls(Option_t *opt) const {
     TROOT::IndentLevel();
     std::cout << ClassName() << "(" << this << ")::" << std::endl;
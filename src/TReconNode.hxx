@@ -8,6 +8,7 @@
 #include "TReconBase.hxx"
 #include "TReconState.hxx"
 #include "TCaptLog.hxx"
+#include "TEventArena.hxx"
 
 namespace CP {
     class TReconNode;
@@ -36,9 +37,20 @@ public:
     TReconNode();
     virtual ~TReconNode();
 
-    /// Get the state associated with this node.
+    /// Allocate from the current event arena (see TEventArena).
+    EVENT_ARENA_ALLOCATED;
+
+    /// Get the state associated with this node.  The state may be shared
+    /// with a node made by TReconNodeContainer::GetWritableNode(), so it
+    /// should be changed through GetWritableState().
     CP::THandle<CP::TReconState> GetState() const {return fState;}
 
+    /// Get the state associated with this node so that it can be changed.
+    /// If the state is shared with the node this was copied from (see
+    /// TReconNodeContainer::GetWritableNode()), this node is given its own
+    /// copy of the state first (copy-on-write).
+    CP::THandle<CP::TReconState> GetWritableState();
+
     /// Set the state associated with this node.
     void SetState(CP::THandle<CP::TReconState>& state) {fState = state;}
 
@@ -60,6 +72,7 @@ public:
     virtual void ls(Option_t *opt = "") const;
 
 private:
+    friend class TReconNodeContainer;
 
     /// The state associated with the object.
     CP::THandle<CP::TReconState> fState;
@@ -70,6 +83,14 @@ private:
     /// A log likelihood for the association of the object with the state.
     float fQuality;
 
+    /// The node has been added to more than one container by
+    /// TReconNodeContainer::ShareNodes().
+    bool fShared; //! Don't Save
+
+    /// The state is shared with the node this was copied from by
+    /// TReconNodeContainer::GetWritableNode().
+    bool fSharedState; //! Don't Save
+
     ClassDef(TReconNode,2);
 };
 
@@ -97,6 +118,21 @@ public:
         throw std::exception();
     }
 
+    /// Add the nodes from another container to this one without copying
+    /// them, so the nodes are shared by both containers.  This is used to
+    /// make the shallow copies of the reconstruction objects (e.g.
+    /// TReconTrack::ShallowCopy()).  After this is called, a node in either
+    /// container (and its state) must be changed through GetWritableNode()
+    /// since changing it in place changes both containers.
+    void ShareNodes(const CP::TReconNodeContainer& nodes);
+
+    /// Get a node so that it can be changed.  If the node was shared by
+    /// ShareNodes(), it is replaced by a copy that shares the same state and
+    /// object (copy-on-write).  The state of the returned node should be
+    /// changed using TReconNode::GetWritableState().  A node that was never
+    /// shared is returned without being copied.
+    CP::THandle<CP::TReconNode> GetWritableNode(std::size_t i);
+
     /// Print the object information.
     virtual void ls(Option_t *opt = "") const;
 
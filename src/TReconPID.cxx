@@ -12,27 +12,34 @@ CP::TReconPID::TReconPID() {
 }
 
 
-void CP::TReconPID::CopyTReconPID(const CP::TReconPID& pid){
+void CP::TReconPID::CopyTReconPID(const CP::TReconPID& pid,
+                                  bool shareNodes){
     fNodes = new TReconNodeContainerImpl<CP::TPIDState>;
     
     fParticleId = pid.GetParticleId();
     fParticleWeight = pid.GetPIDWeight();
     
-    // Copy the nodes 
-    // Create new nodes with TPIDState's 
-    CP::TReconNodeContainer::const_iterator in;
-    for (in=pid.GetNodes().begin(); in!=pid.GetNodes().end();in++){
-        CP::THandle<CP::TReconNode> node(new CP::TReconNode);
-        CP::THandle<CP::TReconBase> object = (*in)->GetObject();
-        node->SetObject(object);
-        CP::THandle<CP::TPIDState> tstate = (*in)->GetState();
-        if (tstate){
-            CP::THandle<CP::TReconState> pstate(new CP::TPIDState(*tstate));
-            node->SetState(pstate);
+    if (shareNodes) {
+        // Share the nodes with the original object (see ShallowCopy()).
+        fNodes->ShareNodes(pid.GetNodes());
+    }
+    else {
+        // Copy the nodes.  Create new nodes with TPIDState's
+        CP::TReconNodeContainer::const_iterator in;
+        for (in=pid.GetNodes().begin(); in!=pid.GetNodes().end();
+             ++in) {
+            CP::THandle<CP::TReconNode> node(new CP::TReconNode);
+            CP::THandle<CP::TReconBase> object = (*in)->GetObject();
+            node->SetObject(object);
+            CP::THandle<CP::TPIDState> tstate = (*in)->GetState();
+            if (tstate) {
+                CP::THandle<CP::TReconState> pstate(
+                    new CP::TPIDState(*tstate));
+                node->SetState(pstate);
+            }
+            node->SetQuality((*in)->GetQuality());
+            fNodes->push_back(node);
         }
-        node->SetQuality((*in)->GetQuality());
-        
-        fNodes->push_back(node);
     }
     
     
@@ -54,8 +61,11 @@ CP::TReconPID::TReconPID(const CP::TReconPID& pid, int i)
 
 
 CP::TReconPID::TReconPID(const CP::TReconPID& pid)
+    : TReconPID(pid,false) {}
+
+CP::TReconPID::TReconPID(const CP::TReconPID& pid, bool shareNodes)
     : CP::TReconBase(pid) {
-    CopyTReconPID(pid);
+    CopyTReconPID(pid,shareNodes);
     // copy the alternates
     CP::TReconObjectContainer::const_iterator it;
     for (it = pid.GetAlternates().begin();
@@ -65,6 +75,10 @@ CP::TReconPID::TReconPID(const CP::TReconPID& pid)
     }
 }
 
+CP::TReconPID* CP::TReconPID::ShallowCopy() const {
+    return new CP::TReconPID(*this,true);
+}
+
 
 CP::TReconPID::TReconPID(CP::THandle<CP::TReconTrack> track)
     : CP::TReconBase(*track){
@@ -21,6 +21,15 @@ public:
     TReconPID(const CP::TReconPID& pid); 
     virtual ~TReconPID();
 
+    /// Make a copy of the PID that shares the nodes (and their states)
+    /// with this PID instead of copying them, which is much cheaper than
+    /// the copy constructor when only a few nodes will be changed (e.g. for
+    /// a refit).  After this is called, a node of either PID must be
+    /// changed through TReconNodeContainer::GetWritableNode() and
+    /// TReconNode::GetWritableState(), since changing a shared node in
+    /// place changes both objects.  The caller owns the new PID.
+    CP::TReconPID* ShallowCopy() const;
+
     /// Constructors for promotion.  This converts tracks or showers into a
     /// PID with particle type "kNotSet".
     TReconPID(CP::THandle<CP::TReconTrack> track);
@@ -184,10 +193,15 @@ private:
     ///  Copy constructor that does not copy alternates (used only internally)
     TReconPID(const CP::TReconPID& pid,int);
 
+    /// Copy constructor that shares the nodes with the original PID when
+    /// shareNodes is true (see ShallowCopy()).
+    TReconPID(const CP::TReconPID& pid, bool shareNodes);
+
     /// it copies all information in a TReconPID except the alternates to
     /// avoid infinite recursion in alternates. It is used by the copy
-    /// constructors
-    void CopyTReconPID(const CP::TReconPID& pid);
+    /// constructors.  The nodes are shared instead of copied when
+    /// shareNodes is true.
+    void CopyTReconPID(const CP::TReconPID& pid, bool shareNodes = false);
 
     /// The particle id.
     ParticleId fParticleId;
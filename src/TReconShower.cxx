@@ -8,25 +8,35 @@ CP::TReconShower::TReconShower() {
 }
 
 CP::TReconShower::TReconShower(const CP::TReconShower& shower)
+    : TReconShower(shower,false) {}
+
+CP::TReconShower::TReconShower(const CP::TReconShower& shower,
+                               bool shareNodes)
     : CP::TReconBase(shower) {
     
     fNodes = new TReconNodeContainerImpl<CP::TShowerState>;
     
-    // Copy the nodes 
-    // Create new nodes with TShowerState's 
-    CP::TReconNodeContainer::const_iterator in;
-    for (in=shower.GetNodes().begin(); in!=shower.GetNodes().end();in++){
-        CP::THandle<CP::TReconNode> node(new CP::TReconNode);
-        CP::THandle<CP::TReconBase> object = (*in)->GetObject();
-        node->SetObject(object);
-        CP::THandle<CP::TShowerState> tstate = (*in)->GetState();
-        if (tstate){
-            CP::THandle<CP::TReconState> pstate(new CP::TShowerState(*tstate));
-            node->SetState(pstate);
+    if (shareNodes) {
+        // Share the nodes with the original object (see ShallowCopy()).
+        fNodes->ShareNodes(shower.GetNodes());
+    }
+    else {
+        // Copy the nodes.  Create new nodes with TShowerState's
+        CP::TReconNodeContainer::const_iterator in;
+        for (in=shower.GetNodes().begin(); in!=shower.GetNodes().end();
+             ++in) {
+            CP::THandle<CP::TReconNode> node(new CP::TReconNode);
+            CP::THandle<CP::TReconBase> object = (*in)->GetObject();
+            node->SetObject(object);
+            CP::THandle<CP::TShowerState> tstate = (*in)->GetState();
+            if (tstate) {
+                CP::THandle<CP::TReconState> pstate(
+                    new CP::TShowerState(*tstate));
+                node->SetState(pstate);
+            }
+            node->SetQuality((*in)->GetQuality());
+            fNodes->push_back(node);
         }
-        node->SetQuality((*in)->GetQuality());
-        
-        fNodes->push_back(node);
     }
     
     
@@ -41,6 +51,10 @@ CP::TReconShower::TReconShower(const CP::TReconShower& shower)
 
 CP::TReconShower::~TReconShower() {}
 
+CP::TReconShower* CP::TReconShower::ShallowCopy() const {
+    return new CP::TReconShower(*this,true);
+}
+
 double CP::TReconShower::GetEDeposit() const {
     THandle<CP::TShowerState> state = GetState();
     if (!state) throw EMissingField();
@@ -28,6 +28,15 @@ public:
 
     virtual ~TReconShower();
 
+    /// Make a copy of the shower that shares the nodes (and their states)
+    /// with this shower instead of copying them, which is much cheaper than
+    /// the copy constructor when only a few nodes will be changed (e.g. for
+    /// a refit).  After this is called, a node of either shower must be
+    /// changed through TReconNodeContainer::GetWritableNode() and
+    /// TReconNode::GetWritableState(), since changing a shared node in
+    /// place changes both objects.  The caller owns the new shower.
+    CP::TReconShower* ShallowCopy() const;
+
     /// Return a handle to the state.
     CP::THandle<CP::TShowerState> GetState() const {
         return GetReconState();
@@ -60,6 +69,11 @@ public:
     /// Get the shower opening angle
     double GetConeAngle() const;
 
+private:
+    /// Copy constructor that shares the nodes with the original shower when
+    /// shareNodes is true (see ShallowCopy()).
+    TReconShower(const CP::TReconShower& shower, bool shareNodes);
+
     ClassDef(TReconShower,1);
 };
 #endif
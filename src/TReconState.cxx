@@ -1,21 +1,43 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 
 #include <TROOT.h>
+#include <TBuffer.h>
+#include <TClass.h>
 
 #include "TCaptLog.hxx"
 #include "TReconState.hxx"
 
 ClassImp(CP::TReconState);
 
-CP::TReconState::TReconState() { }
+CP::TReconState::TReconState()
+    : fStorageValues(NULL), fStorageCovariance(NULL), fStorageSize(0) { }
 
 CP::TReconState::TReconState(const TReconState& state) 
-    : TObject(state), fValues(state.fValues), fFieldNames(state.fFieldNames) { }
+    : TObject(state), fValues(state.GetCorrValues()),
+      fFieldNames(state.fFieldNames),
+      fStorageValues(NULL), fStorageCovariance(NULL), fStorageSize(0) { }
 
 CP::TReconState::~TReconState() { }
 
+CP::TReconState* CP::TReconState::CopyState() const {
+    return new CP::TReconState(*this);
+}
+
+CP::TReconState& CP::TReconState::operator=(const TReconState& rhs) {
+    if (this == &rhs) return *this;
+    TObject::operator=(rhs);
+    if (!fStorageValues) {
+        fValues = rhs.GetCorrValues();
+        fFieldNames = rhs.fFieldNames;
+        return *this;
+    }
+    CopyValues(rhs);
+    return *this;
+}
+
 std::string CP::TReconState::GetStateFields(void) const {
     // Construct a type name out of the field names.  This in turn is used by
     // the TCorrValues class to construct a type hash which is used to make
@@ -36,56 +58,188 @@ void CP::TReconState::Init() {
     fValues.SetType(GetStateFields().c_str());
 }
 
+void CP::TReconState::InitStorage(float* values, float* covariance,
+                                  int size) {
+    if (size != (int) fFieldNames.size()) {
+        CaptError("State storage size " << size
+                  << " doesn't match " << fFieldNames.size() << " fields");
+        throw EReconStateSize();
+    }
+    fStorageValues = values;
+    fStorageCovariance = covariance;
+    fStorageSize = size;
+    // All parameters are initially free (the same as TCorrValues).
+    std::fill(fStorageValues, fStorageValues+size, 0.0);
+    std::fill(fStorageCovariance, fStorageCovariance+size*(size+1)/2, 0.0);
+    for (int i=0; i<size; ++i) {
+        fStorageCovariance[CovarianceIndex(i,i)] = TCorrValues::kFreeValue;
+    }
+    fValues.ResizeTo(0);
+}
+
+void CP::TReconState::CheckStorageIndex(int i) const {
+    if (i<0) {
+        CaptError("Negative element index: " << i);
+        throw ECorrValuesRange();
+    }
+    if (fStorageSize<=i) {
+        CaptError("Out of bounds element index: " << i 
+                   << " (dim is " << fStorageSize << ")");
+        throw ECorrValuesRange();
+    }
+}
+
+void CP::TReconState::CopyValues(const TReconState& src) {
+    if (src.GetDimensions() != GetDimensions()) {
+        CaptError("Cannot copy a state with " << src.GetDimensions()
+                  << " dimensions into " << GetDimensions());
+        throw EReconStateSize();
+    }
+    if (fStorageValues && src.fStorageValues) {
+        std::copy(src.fStorageValues, src.fStorageValues+fStorageSize,
+                  fStorageValues);
+        std::copy(src.fStorageCovariance,
+                  src.fStorageCovariance+fStorageSize*(fStorageSize+1)/2,
+                  fStorageCovariance);
+        return;
+    }
+    for (int i=0; i<GetDimensions(); ++i) {
+        SetValue(i,src.GetValue(i));
+        for (int j=0; j<=i; ++j) {
+            SetCovarianceValue(i,j,src.GetCovarianceValue(i,j));
+        }
+    }
+}
+
+CP::TCorrValues CP::TReconState::GetCorrValues() const {
+    if (!fStorageValues) return fValues;
+    TCorrValues values(fStorageSize);
+    values.SetType(GetStateFields().c_str());
+    for (int i=0; i<fStorageSize; ++i) {
+        values.SetValue(i,fStorageValues[i]);
+        for (int j=0; j<=i; ++j) {
+            values.SetCovarianceValue(
+                i,j,fStorageCovariance[CovarianceIndex(i,j)]);
+        }
+    }
+    return values;
+}
+
 int CP::TReconState::GetDimensions() const {
+    if (fStorageValues) return fStorageSize;
     return fValues.GetDimensions();
 }
 
 double CP::TReconState::GetValue(int i) const {
-    return fValues.GetValue(i);
+    if (!fStorageValues) return fValues.GetValue(i);
+    CheckStorageIndex(i);
+    return fStorageValues[i];
 }
 
 void CP::TReconState::SetValue(int i, double val) {
-    return fValues.SetValue(i, val);
+    if (!fStorageValues) return fValues.SetValue(i, val);
+    CheckStorageIndex(i);
+    fStorageValues[i] = val;
 }
 
 double CP::TReconState::GetCovarianceValue(int i, int j) const {
-    return fValues.GetCovarianceValue(i,j);
+    if (!fStorageValues) return fValues.GetCovarianceValue(i,j);
+    CheckStorageIndex(i);
+    CheckStorageIndex(j);
+    return fStorageCovariance[CovarianceIndex(i,j)];
 }
 
 void CP::TReconState::SetCovarianceValue(int i, int j, double val) {
-    fValues.SetCovarianceValue(i,j,val);
+    if (!fStorageValues) return fValues.SetCovarianceValue(i,j,val);
+    CheckStorageIndex(i);
+    CheckStorageIndex(j);
+    fStorageCovariance[CovarianceIndex(i,j)] = val;
 }
 
 void CP::TReconState::SetFree(int i) {
-    fValues.SetFree(i);
+    if (!fStorageValues) return fValues.SetFree(i);
+    CheckStorageIndex(i);
+    for (int j=0; j<fStorageSize; ++j) {
+        fStorageCovariance[CovarianceIndex(i,j)] = 0.0;
+    }
+    fStorageCovariance[CovarianceIndex(i,i)] = TCorrValues::kFreeValue;
 }
 
 bool CP::TReconState::IsFree(int i) const {
-    return fValues.IsFree(i);
+    return IsFree(GetCovarianceValue(i,i));
 }
 
 bool CP::TReconState::IsFree(double v) const {
-    return fValues.IsFree(v);
+    return TCorrValues::IsFree(v);
 }
 
 void CP::TReconState::SetFixed(int i) {
-    fValues.SetFixed(i);
+    if (!fStorageValues) return fValues.SetFixed(i);
+    CheckStorageIndex(i);
+    for (int j=0; j<fStorageSize; ++j) {
+        fStorageCovariance[CovarianceIndex(i,j)] = 0.0;
+    }
+    fStorageCovariance[CovarianceIndex(i,i)] = TCorrValues::kFixedValue;
 }
 
 bool CP::TReconState::IsFixed(int i) const {
-    return fValues.IsFixed(i);
+    return IsFixed(GetCovarianceValue(i,i));
 }
 
 bool CP::TReconState::IsFixed(double v) const {
-    return fValues.IsFixed(v);
+    return TCorrValues::IsFixed(v);
 }
 
 void CP::TReconState::Validate() {
-    fValues.Validate(true);
+    if (!fStorageValues) {
+        fValues.Validate(true);
+        return;
+    }
+    // The stored covariance is always symmetric, so just make sure the free
+    // and fixed parameters are not correlated.
+    for (int i=0; i<fStorageSize; ++i) {
+        if (IsFixed(i)) SetFixed(i);
+        if (IsFree(i)) SetFree(i);
+    }
 }
 
 CP::TCorrValues CP::TReconState::ProjectState(const CP::THandle<CP::TReconState>& state) {
-    return state->fValues;
+    return state->GetCorrValues();
+}
+
+// The values in the fixed size storage are copied into fValues while the
+// state is written, and out of fValues after it is read, so the file
+// contains the same TCorrValues as a state without fixed size storage.
+void CP::TReconState::Streamer(TBuffer& R__b) {
+    if (R__b.IsReading()) {
+        R__b.ReadClassBuffer(CP::TReconState::Class(), this);
+        if (!fStorageValues) return;
+        if (fValues.GetDimensions() != fStorageSize) {
+            CaptError("Saved state has " << fValues.GetDimensions()
+                      << " dimensions, but expected " << fStorageSize);
+            fStorageValues = NULL;
+            fStorageCovariance = NULL;
+            fStorageSize = 0;
+            return;
+        }
+        for (int i=0; i<fStorageSize; ++i) {
+            fStorageValues[i] = fValues.GetValue(i);
+            for (int j=0; j<=i; ++j) {
+                fStorageCovariance[CovarianceIndex(i,j)]
+                    = fValues.GetCovarianceValue(i,j);
+            }
+        }
+        fValues.ResizeTo(0);
+    }
+    else {
+        if (!fStorageValues) {
+            R__b.WriteClassBuffer(CP::TReconState::Class(), this);
+            return;
+        }
+        fValues = GetCorrValues();
+        R__b.WriteClassBuffer(CP::TReconState::Class(), this);
+        fValues.ResizeTo(0);
+    }
 }
 
 /// Print the object information.
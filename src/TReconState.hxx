@@ -15,9 +15,11 @@
 #include "TCorrValues.hxx"
 #include "THandle.hxx"
 #include "TCaptLog.hxx"
+#include "TEventArena.hxx"
 
 namespace CP {
     class TReconState;
+    template <int N> class TReconStateStorage;
     class TMReconState;
     class TMEDepositState;
     class TMPositionState;
@@ -35,8 +37,30 @@ namespace CP {
     class TTrackState;
     class TPIDState;
     class TVertexState;
+
+    EXCEPTION(EReconState, ECore);
+    EXCEPTION(EReconStateSize, EReconState);
 }
 
+/// Fixed size storage for the values and covariance of a state with N
+/// fields.  The instantiated state classes (e.g. CP::TTrackState) know their
+/// size at compile time, so they hold one of these as a member and attach it
+/// to the TReconState (see TReconState::Init()).  The values are held in
+/// inline arrays so creating and destroying a state doesn't allocate the
+/// vector and matrix used by TCorrValues.  The covariance is symmetric, so
+/// only the lower triangle is stored.
+template <int N> class CP::TReconStateStorage {
+public:
+    /// The number of fields in the state.
+    enum {kSize = N, kCovarianceSize = N*(N+1)/2};
+
+    /// The values of the fields.
+    float fValue[N];
+
+    /// The lower triangle of the covariance, stored by row.
+    float fCovariance[N*(N+1)/2];
+};
+
 /// The TReconState class represents the value of parameters and covariances
 /// associated with reconstruction objects.  It does not contain general
 /// status information such as the goodness, degree's of freedom, or objects
@@ -47,12 +71,30 @@ namespace CP {
 /// derived from, and it provides minimal operations.  The main purpose of
 /// this class is to allow polymorphic vectors of states.  However, it
 /// provides some minimal access to the contained data.
+///
+/// The state values are usually held in fixed size storage provided by the
+/// instantiated class (see CP::TReconStateStorage).  The values are copied
+/// into fValues when the state is written so the saved format is the same
+/// as for a state that keeps the values in the TCorrValues object.
 class CP::TReconState: public TObject {
 public:
     TReconState();
     TReconState(const CP::TReconState& state);
     virtual ~TReconState();
 
+    /// Copy the state values and covariance.  If the state uses fixed size
+    /// storage, the right hand side must have the same dimensions.
+    TReconState& operator=(const CP::TReconState& rhs);
+
+    /// Allocate from the current event arena (see TEventArena).
+    EVENT_ARENA_ALLOCATED;
+
+    /// Make a new copy of the state with the same class.  This is used to
+    /// give a TReconNode its own copy of a state that is shared with other
+    /// nodes (see TReconNode::GetWritableState()).  The instantiated state
+    /// classes override this.
+    virtual CP::TReconState* CopyState() const;
+
     /// Return a string with all of the state field names.  This name is used
     /// to build a type has for the state.
     std::string GetStateFields() const;
@@ -123,17 +165,63 @@ protected:
     friend class TPIDState;
     friend class TVertexState;
 
+#ifndef __CINT__
+    template <class T> friend class TReconStateView;
+#endif
+
     /// A final initialization routine that is called in the constructor of
     /// the instantiated class.  This builds the actual state vector.
     void Init();
 
+#ifndef __CINT__
+    /// A final initialization routine that is called in the constructor of
+    /// the instantiated class when the state values are held in fixed size
+    /// storage.  The storage must have one entry for each field name, and
+    /// must live as long as the state (it is usually a member of the
+    /// instantiated class).
+    template <int N> void Init(TReconStateStorage<N>& storage) {
+        InitStorage(storage.fValue, storage.fCovariance, N);
+    }
+#endif
+
+    /// Attach the fixed size storage for the state values.  This is used by
+    /// Init(TReconStateStorage&).
+    void InitStorage(float* values, float* covariance, int size);
+
+    /// Copy the values and covariance from another state with the same
+    /// dimensions.
+    void CopyValues(const CP::TReconState& src);
+
+    /// Return the state values as a TCorrValues object.
+    CP::TCorrValues GetCorrValues() const;
+
     /// The vector of correlated values (a vector and a covariance) that holds
-    /// the state information.
+    /// the state information.  When the state has fixed size storage, this
+    /// is empty except while the state is being written.
     TCorrValues fValues;
 
     /// A vector of parameter names.  This identifies the fields in the state.
     std::vector<std::string> fFieldNames;
 
+private:
+    /// Check that an index is inside the fixed size storage.
+    void CheckStorageIndex(int i) const;
+
+    /// Return the position of a covariance element in the fixed size
+    /// storage.
+    static int CovarianceIndex(int i, int j) {
+        return (i<j) ? j*(j+1)/2 + i : i*(i+1)/2 + j;
+    }
+
+    /// The fixed size storage for the values (NULL if fValues is used).
+    float* fStorageValues; //! Don't Save
+
+    /// The fixed size storage for the covariance.
+    float* fStorageCovariance; //! Don't Save
+
+    /// The number of fields in the fixed size storage.
+    int fStorageSize; //! Don't Save
+
     ClassDef(TReconState,1);
 };
 
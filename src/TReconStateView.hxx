@@ -0,0 +1,146 @@
+#ifndef TReconStateView_hxx_seen
+#define TReconStateView_hxx_seen
+
+#include <TLorentzVector.h>
+#include <TVector3.h>
+
+#include "TReconState.hxx"
+
+namespace CP {
+    /// The compile time layout of the fields in an instantiated state class
+    /// (e.g. TTrackState).  This is specialized in the header for each state
+    /// class, and defines an enum with the index of the first entry for
+    /// each property in the state (e.g. kEDeposit, kPosition, kDirection),
+    /// and the number of entries in the state (kSize).  The indices are the
+    /// same as the ones returned by the mix-in classes (e.g.
+    /// TMPositionState::GetPositionIndex()), but are known when the code is
+    /// compiled, so they don't need to be looked up through the virtual base
+    /// classes.  A property that isn't part of a state doesn't have an
+    /// entry, so code that uses it won't compile.
+    template <class T> struct TReconStateLayout;
+
+    template <class T> class TReconStateView;
+}
+
+#ifndef __CINT__
+/// Direct access to the values and covariance of an instantiated state
+/// class (e.g. TTrackState) using the compile time layout in
+/// TReconStateLayout<T>.  This is intended for fitting code that is written
+/// as a template over the state type, and that needs to access the state
+/// fields many times.  The view doesn't check the indices at run time, and
+/// doesn't go through the virtual base classes of the state, so the
+/// accessors reduce to a load or a store.
+///
+/// \code
+/// template <class State>
+/// void Propagate(State& state, double step) {
+///     CP::TReconStateView<State> view(state);
+///     typedef typename CP::TReconStateView<State>::Layout Layout;
+///     for (int i=0; i<3; ++i) {
+///         view.Value(Layout::kPosition+i)
+///             += step*view.Value(Layout::kDirection+i);
+///     }
+/// }
+/// \endcode
+///
+/// The view refers to the state, so the state must exist as long as the
+/// view is used.  The accessors for a property (e.g. GetMass()) only
+/// compile if the state has that property.
+template <class T>
+class CP::TReconStateView {
+public:
+    /// The layout of the fields in the state.
+    typedef CP::TReconStateLayout<T> Layout;
+
+    /// Make a view of a state.  This throws EReconStateSize if the state
+    /// doesn't hold the values in fixed size storage with the size given by
+    /// the layout (e.g. a state read from a file with a different format).
+    explicit TReconStateView(T& state)
+        : fValues(state.fStorageValues),
+          fCovariance(state.fStorageCovariance) {
+        if (!fValues || state.fStorageSize != Layout::kSize) {
+            throw CP::EReconStateSize();
+        }
+    }
+
+    /// The number of entries in the state.
+    static int GetDimensions() {return Layout::kSize;}
+
+    /// Get a reference to a value.
+    float& Value(int i) const {return fValues[i];}
+
+    /// Get a reference to a value with an index that is checked when the
+    /// code is compiled.
+    template <int I> float& Value() const {
+        typedef char IndexInsideState[(0<=I && I<Layout::kSize) ? 1 : -1];
+        (void) sizeof(IndexInsideState);
+        return fValues[I];
+    }
+
+    /// Get a reference to a covariance element.  The covariance is
+    /// symmetric, so (i,j) and (j,i) refer to the same element.
+    float& Covariance(int i, int j) const {
+        return fCovariance[(i<j) ? j*(j+1)/2 + i : i*(i+1)/2 + j];
+    }
+
+    /// @{ Get and set the energy deposit.
+    double GetEDeposit() const {return fValues[Layout::kEDeposit];}
+    void SetEDeposit(double v) const {fValues[Layout::kEDeposit] = v;}
+    /// @}
+
+    /// @{ Get and set the position.
+    TLorentzVector GetPosition() const {
+        const float* p = fValues + Layout::kPosition;
+        return TLorentzVector(p[0], p[1], p[2], p[3]);
+    }
+    void SetPosition(const TLorentzVector& pos) const {
+        float* p = fValues + Layout::kPosition;
+        p[0] = pos.X(); p[1] = pos.Y(); p[2] = pos.Z(); p[3] = pos.T();
+    }
+    /// @}
+
+    /// @{ Get and set the direction.
+    TVector3 GetDirection() const {
+        const float* d = fValues + Layout::kDirection;
+        return TVector3(d[0], d[1], d[2]);
+    }
+    void SetDirection(const TVector3& dir) const {
+        float* d = fValues + Layout::kDirection;
+        d[0] = dir.X(); d[1] = dir.Y(); d[2] = dir.Z();
+    }
+    /// @}
+
+    /// @{ Get and set the mass.
+    double GetMass() const {return fValues[Layout::kMass];}
+    void SetMass(double v) const {fValues[Layout::kMass] = v;}
+    /// @}
+
+    /// @{ Get and set the width.
+    double GetWidth() const {return fValues[Layout::kWidth];}
+    void SetWidth(double v) const {fValues[Layout::kWidth] = v;}
+    /// @}
+
+    /// @{ Get and set the cone angle.
+    double GetCone() const {return fValues[Layout::kCone];}
+    void SetCone(double v) const {fValues[Layout::kCone] = v;}
+    /// @}
+
+    /// @{ Get and set the momentum.
+    double GetMomentum() const {return fValues[Layout::kMomentum];}
+    void SetMomentum(double v) const {fValues[Layout::kMomentum] = v;}
+    /// @}
+
+    /// @{ Get and set the charge.
+    double GetCharge() const {return fValues[Layout::kCharge];}
+    void SetCharge(double v) const {fValues[Layout::kCharge] = v;}
+    /// @}
+
+private:
+    /// The fixed size storage for the state values.
+    float* fValues;
+
+    /// The fixed size storage for the lower triangle of the covariance.
+    float* fCovariance;
+};
+#endif
+#endif
@@ -1,6 +1,6 @@
 #ifdef __CINT__
 
-#pragma link C++ class CP::TReconState+;
+#pragma link C++ class CP::TReconState-;
 #pragma link C++ class CP::THandle<CP::TReconState>+;
 
 #endif
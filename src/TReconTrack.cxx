@@ -10,24 +10,33 @@ CP::TReconTrack::TReconTrack() {
 }
 
 CP::TReconTrack::TReconTrack(const CP::TReconTrack& track)
+    : TReconTrack(track,false) {}
+
+CP::TReconTrack::TReconTrack(const CP::TReconTrack& track, bool shareNodes)
     : CP::TReconBase(track) {
     fNodes = new TReconNodeContainerImpl<CP::TTrackState>;
     
-    // Copy the nodes 
-    // Create new nodes with TTrackState's 
-    CP::TReconNodeContainer::const_iterator in;
-    for (in=track.GetNodes().begin(); in!=track.GetNodes().end(); ++in){
-        CP::THandle<CP::TReconNode> node(new CP::TReconNode);
-        CP::THandle<CP::TReconBase> object = (*in)->GetObject();
-        node->SetObject(object);
-        CP::THandle<CP::TTrackState> tstate = (*in)->GetState();
-        if (tstate) {
-            CP::THandle<CP::TReconState> pstate(new CP::TTrackState(*tstate));
-            node->SetState(pstate);
+    if (shareNodes) {
+        // Share the nodes with the original object (see ShallowCopy()).
+        fNodes->ShareNodes(track.GetNodes());
+    }
+    else {
+        // Copy the nodes.  Create new nodes with TTrackState's
+        CP::TReconNodeContainer::const_iterator in;
+        for (in=track.GetNodes().begin(); in!=track.GetNodes().end();
+             ++in) {
+            CP::THandle<CP::TReconNode> node(new CP::TReconNode);
+            CP::THandle<CP::TReconBase> object = (*in)->GetObject();
+            node->SetObject(object);
+            CP::THandle<CP::TTrackState> tstate = (*in)->GetState();
+            if (tstate) {
+                CP::THandle<CP::TReconState> pstate(
+                    new CP::TTrackState(*tstate));
+                node->SetState(pstate);
+            }
+            node->SetQuality((*in)->GetQuality());
+            fNodes->push_back(node);
         }
-        node->SetQuality((*in)->GetQuality());
-        
-        fNodes->push_back(node);
     }
 
     if (track.GetState()) {
@@ -50,6 +59,10 @@ CP::TReconTrack::TReconTrack(const CP::TReconTrack& track)
 
 CP::TReconTrack::~TReconTrack() {}
 
+CP::TReconTrack* CP::TReconTrack::ShallowCopy() const {
+    return new CP::TReconTrack(*this,true);
+}
+
 double CP::TReconTrack::GetEDeposit() const {
     THandle<CP::TTrackState> state = GetState();
     if (!state) throw EMissingField();
@@ -121,10 +134,12 @@ void CP::TReconTrack::ReverseTrack() {
     // Reverse the order of the nodes.
     std::reverse(GetNodes().begin(), GetNodes().end());
 
-    // Reverse the state directions.
-    for (CP::TReconNodeContainer::iterator n = GetNodes().begin();
-         n != GetNodes().end(); ++n) {
-        CP::THandle<CP::TTrackState> state = (*n)->GetState();
+    // Reverse the state directions.  The nodes may be shared with a copy of
+    // the track, so get writable nodes and states.
+    CP::TReconNodeContainer& nodes = GetNodes();
+    for (std::size_t n = 0; n < nodes.size(); ++n) {
+        CP::THandle<CP::TTrackState> state
+            = nodes.GetWritableNode(n)->GetWritableState();
         state->SetDirection(-state->GetDirection());
     }
     
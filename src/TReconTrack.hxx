@@ -35,6 +35,15 @@ public:
 
     virtual ~TReconTrack();
 
+    /// Make a copy of the track that shares the nodes (and their states)
+    /// with this track instead of copying them, which is much cheaper than
+    /// the copy constructor when only a few nodes will be changed (e.g. for
+    /// a refit).  After this is called, a node of either track must be
+    /// changed through TReconNodeContainer::GetWritableNode() and
+    /// TReconNode::GetWritableState(), since changing a shared node in
+    /// place changes both objects.  The caller owns the new track.
+    CP::TReconTrack* ShallowCopy() const;
+
     /// Return a handle to the state.  The state at the front end of the track
     /// is not necessarily the same as the state at the first node.  For
     /// instance, the first node may have a finite extent, and the starting
@@ -99,6 +108,9 @@ public:
     virtual void ls(Option_t* opt = "") const; 
 
 private:
+    /// Copy constructor that shares the nodes with the original track when
+    /// shareNodes is true (see ShallowCopy()).
+    TReconTrack(const CP::TReconTrack& track, bool shareNodes);
 
     /// The state of the track at the back end.
     CP::TTrackState* fBackState;
@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <TTree.h>
+
+#include "TResourceSampler.hxx"
+#include "TRootOutput.hxx"
+#include "TCaptLog.hxx"
+
+namespace {
+    long long WallTime() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+CP::TResourceSampler::TResourceSampler(double interval, int capacity)
+    : fInterval(interval), fCapacity(capacity), fStride(1),
+      fPendingCount(0), fPeakResident(0), fPeakVirtual(0), fStart(0),
+      fEvents(0), fRun(-1), fEvent(-1), fStopping(false) {
+    if (fInterval <= 0.0) fInterval = 1.0;
+    if (fCapacity < 2) fCapacity = 2;
+    fSamples.reserve(fCapacity);
+}
+
+CP::TResourceSampler::~TResourceSampler() {
+    Stop();
+}
+
+void CP::TResourceSampler::Start() {
+    if (IsRunning()) return;
+    if (fStart == 0) fStart = WallTime();
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fStopping = false;
+    }
+    TakeSample();
+    fThread = std::thread(&CP::TResourceSampler::Run, this);
+}
+
+void CP::TResourceSampler::Stop() {
+    if (!IsRunning()) return;
+    {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fStopping = true;
+    }
+    fWake.notify_all();
+    fThread.join();
+    TakeSample();
+}
+
+bool CP::TResourceSampler::IsRunning() const {
+    return fThread.joinable();
+}
+
+void CP::TResourceSampler::SetEvent(int run, int event) {
+    fRun.store(run, std::memory_order_relaxed);
+    fEvent.store(event, std::memory_order_relaxed);
+    fEvents.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CP::TResourceSampler::Sample() {
+    if (fStart == 0) fStart = WallTime();
+    TakeSample();
+}
+
+void CP::TResourceSampler::Run() {
+    std::chrono::nanoseconds interval(
+        static_cast<long long>(1E9*fInterval));
+    std::unique_lock<std::mutex> lock(fMutex);
+    while (!fStopping) {
+        if (fWake.wait_for(lock, interval, [this] {return fStopping;})) {
+            break;
+        }
+        lock.unlock();
+        TakeSample();
+        lock.lock();
+    }
+}
+
+void CP::TResourceSampler::Merge(const TSample& earlier, TSample& later) {
+    later.fResident = std::max(earlier.fResident, later.fResident);
+    later.fVirtual = std::max(earlier.fVirtual, later.fVirtual);
+    later.fOpenFiles = std::max(earlier.fOpenFiles, later.fOpenFiles);
+}
+
+void CP::TResourceSampler::TakeSample() {
+    // Read /proc before taking the lock since it's slow.
+    TSample sample;
+    ReadProc(sample);
+    sample.fTime = 1E-9*(WallTime() - fStart);
+    sample.fEvents = fEvents.load(std::memory_order_relaxed);
+    sample.fRun = fRun.load(std::memory_order_relaxed);
+    sample.fEvent = fEvent.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    fPeakResident = std::max(fPeakResident, sample.fResident);
+    fPeakVirtual = std::max(fPeakVirtual, sample.fVirtual);
+
+    // Accumulate samples until there are enough to save one.
+    if (fPendingCount > 0) Merge(fPending, sample);
+    fPending = sample;
+    if (++fPendingCount < fStride) return;
+    fSamples.push_back(fPending);
+    fPendingCount = 0;
+    if (fSamples.size() < fCapacity) return;
+
+    // The ring is full, so merge the saved samples in pairs.
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i+1 < fSamples.size(); i += 2) {
+        Merge(fSamples[i], fSamples[i+1]);
+        fSamples[kept++] = fSamples[i+1];
+    }
+    if (fSamples.size() % 2 == 1) fSamples[kept++] = fSamples.back();
+    fSamples.resize(kept);
+    fStride *= 2;
+    CaptNamedDebug("MEM","Resource samples merged.  Spacing is "
+                   << GetSampleSpacing() << " s");
+}
+
+std::vector<CP::TResourceSampler::TSample>
+CP::TResourceSampler::GetSamples() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    std::vector<TSample> samples(fSamples);
+    if (fPendingCount > 0) samples.push_back(fPending);
+    return samples;
+}
+
+long CP::TResourceSampler::GetEventCount() const {
+    return fEvents.load(std::memory_order_relaxed);
+}
+
+double CP::TResourceSampler::GetSampleSpacing() const {
+    return fInterval*fStride;
+}
+
+long CP::TResourceSampler::GetPeakResident() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fPeakResident;
+}
+
+long CP::TResourceSampler::GetPeakVirtual() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fPeakVirtual;
+}
+
+bool CP::TResourceSampler::ReadProc(TSample& sample) {
+    sample.fTime = 0.0;
+    sample.fEvents = 0;
+    sample.fRun = -1;
+    sample.fEvent = -1;
+    sample.fResident = 0;
+    sample.fVirtual = 0;
+    sample.fCpuUser = 0.0;
+    sample.fCpuSystem = 0.0;
+    sample.fReadBytes = 0;
+    sample.fWriteBytes = 0;
+    sample.fOpenFiles = 0;
+
+    bool found = true;
+    std::string line;
+
+    // The memory in kilobytes.
+    {
+        std::ifstream status("/proc/self/status");
+        if (!status) found = false;
+        while (std::getline(status,line)) {
+            std::istringstream words(line);
+            std::string key;
+            long value;
+            if (!(words >> key >> value)) continue;
+            if (key == "VmRSS:") sample.fResident = value;
+            else if (key == "VmSize:") sample.fVirtual = value;
+        }
+    }
+
+    // The CPU time in clock ticks.  The utime and stime are the 14th and
+    // 15th fields, and the fields are counted after the command name (which
+    // can have spaces) so the state is the 3rd field.
+    {
+        std::ifstream stat("/proc/self/stat");
+        line.clear();
+        std::getline(stat,line);
+        std::string::size_type close = line.rfind(')');
+        if (close == std::string::npos) found = false;
+        else {
+            std::istringstream fields(line.substr(close+1));
+            std::string field;
+            for (int i = 3; i<14; ++i) fields >> field;
+            unsigned long long user = 0;
+            unsigned long long system = 0;
+            fields >> user >> system;
+            double ticks = sysconf(_SC_CLK_TCK);
+            if (ticks <= 0) ticks = 100;
+            sample.fCpuUser = user/ticks;
+            sample.fCpuSystem = system/ticks;
+        }
+    }
+
+    // The bytes read and written.  This isn't available on every system, so
+    // it doesn't count as a failure.
+    {
+        std::ifstream io("/proc/self/io");
+        while (std::getline(io,line)) {
+            std::istringstream words(line);
+            std::string key;
+            long long value;
+            if (!(words >> key >> value)) continue;
+            if (key == "rchar:") sample.fReadBytes = value;
+            else if (key == "wchar:") sample.fWriteBytes = value;
+        }
+    }
+
+    // The open files.  The directory being read has a descriptor that isn't
+    // counted.
+    DIR* fds = opendir("/proc/self/fd");
+    if (!fds) found = false;
+    else {
+        int count = 0;
+        for (struct dirent* entry = readdir(fds);
+             entry; entry = readdir(fds)) {
+            if (entry->d_name[0] == '.') continue;
+            ++count;
+        }
+        closedir(fds);
+        sample.fOpenFiles = std::max(0, count-1);
+    }
+
+    return found;
+}
+
+void CP::TResourceSampler::Write(CP::TRootOutput* output) {
+    if (!output || !output->IsOpen()) return;
+    std::vector<TSample> samples = GetSamples();
+    if (samples.empty()) return;
+
+    CaptNamedInfo("MEM","Writing the resource timeline to file");
+    output->cd();
+
+    TSample entry;
+    TTree tree("resourceTimeline", "Resources used by the process");
+    tree.Branch("time", &entry.fTime, "time/D");
+    tree.Branch("events", &entry.fEvents, "events/L");
+    tree.Branch("run", &entry.fRun, "run/I");
+    tree.Branch("event", &entry.fEvent, "event/I");
+    tree.Branch("resident", &entry.fResident, "resident/L");
+    tree.Branch("virtual", &entry.fVirtual, "virtual/L");
+    tree.Branch("cpuUser", &entry.fCpuUser, "cpuUser/D");
+    tree.Branch("cpuSystem", &entry.fCpuSystem, "cpuSystem/D");
+    tree.Branch("readBytes", &entry.fReadBytes, "readBytes/L");
+    tree.Branch("writeBytes", &entry.fWriteBytes, "writeBytes/L");
+    tree.Branch("openFiles", &entry.fOpenFiles, "openFiles/I");
+    for (std::vector<TSample>::iterator s = samples.begin();
+         s != samples.end(); ++s) {
+        entry = *s;
+        tree.Fill();
+    }
+    tree.Write();
+}
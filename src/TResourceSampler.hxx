@@ -0,0 +1,177 @@
+#ifndef TResourceSampler_hxx_seen
+#define TResourceSampler_hxx_seen
+
+#include <vector>
+
+#ifndef __CINT__
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace CP {
+    class TResourceSampler;
+    class TRootOutput;
+}
+
+/// Sample the resources used by the process on a background thread.  At a
+/// fixed interval, the sampler reads the resident and virtual memory, the
+/// user and system CPU time, the bytes read and written, and the number of
+/// open files from /proc, and saves them with the number of the event being
+/// processed.  The samples are kept in a ring of fixed size.  When the ring
+/// is full, neighboring samples are merged so the ring always covers the
+/// whole job, and the interval between the saved samples doubles.  The
+/// merged sample keeps the largest memory and open file values, so the
+/// peaks aren't lost.  This is used by TMemoryUsage when the eventLoop "-u"
+/// option is given.
+///
+/// \code
+/// CP::TResourceSampler sampler;
+/// sampler.Start();
+/// for (...) {
+///     sampler.SetEvent(event.GetRunId(), event.GetEventId());
+///     ...
+/// }
+/// sampler.Stop();
+/// sampler.Write(output);
+/// \endcode
+class CP::TResourceSampler {
+public:
+    /// The resources used by the process at one time.
+    struct TSample {
+        /// The time of the sample in seconds since the sampler was started.
+        double fTime;
+
+        /// The number of calls to SetEvent() before the sample.
+        long fEvents;
+
+        /// The run and event number set by the last call to SetEvent().
+        int fRun;
+        int fEvent;
+
+        /// The resident and virtual memory in kilobytes.
+        long fResident;
+        long fVirtual;
+
+        /// The user and system CPU time in seconds.
+        double fCpuUser;
+        double fCpuSystem;
+
+        /// The bytes read and written by the process (including the bytes
+        /// that came from, or went to, the page cache).
+        long long fReadBytes;
+        long long fWriteBytes;
+
+        /// The number of open file descriptors.
+        int fOpenFiles;
+    };
+
+    /// Construct a sampler that takes a sample every "interval" seconds and
+    /// keeps up to "capacity" samples.  The sampler isn't started.
+    explicit TResourceSampler(double interval = 1.0, int capacity = 4096);
+
+    /// Stop the sampler.
+    ~TResourceSampler();
+
+    /// Start sampling on a background thread.  A sample is taken
+    /// immediately.
+    void Start();
+
+    /// Stop the background thread.  A final sample is taken so the end of
+    /// the job is recorded.
+    void Stop();
+
+    /// Check if the background thread is running.
+    bool IsRunning() const;
+
+    /// Set the event being processed.  This is cheap enough to call for
+    /// every event.
+    void SetEvent(int run, int event);
+
+    /// Take a sample now (in addition to the samples taken by the thread).
+    void Sample();
+
+    /// Get a copy of the saved samples in time order.
+    std::vector<TSample> GetSamples() const;
+
+    /// Get the number of calls to SetEvent().
+    long GetEventCount() const;
+
+    /// Get the time between the saved samples in seconds.  This starts as
+    /// the sampling interval, and doubles each time the ring is decimated.
+    double GetSampleSpacing() const;
+
+    /// Get the largest resident and virtual memory in kilobytes.  These are
+    /// found from all of the samples that were taken, not just the saved
+    /// samples.
+    long GetPeakResident() const;
+    long GetPeakVirtual() const;
+
+    /// Write the saved samples to the top-level directory of the output file
+    /// as a TTree named "resourceTimeline".  The output may be NULL, and
+    /// then nothing is written.
+    void Write(CP::TRootOutput* output);
+
+    /// Read the current resources used by this process from /proc.  The
+    /// time and event fields are not filled.  This returns false (and
+    /// fills the fields that can't be read with zeros) if /proc isn't
+    /// available.
+    static bool ReadProc(TSample& sample);
+
+private:
+    TResourceSampler(const TResourceSampler&);
+    TResourceSampler& operator = (const TResourceSampler&);
+
+#ifndef __CINT__
+    /// Take a sample and add it to the ring.
+    void TakeSample();
+
+    /// Merge the sample into the sample that follows it in time.
+    static void Merge(const TSample& earlier, TSample& later);
+
+    /// The body of the background thread.
+    void Run();
+
+    /// The time between samples taken by the thread in seconds.
+    double fInterval;
+
+    /// The maximum number of saved samples.
+    std::size_t fCapacity;
+
+    /// The number of samples merged into each saved sample.
+    long fStride;
+
+    /// The number of samples merged into fPending.
+    long fPendingCount;
+
+    /// The sample being accumulated until fStride samples have been taken.
+    TSample fPending;
+
+    /// The saved samples in time order.
+    std::vector<TSample> fSamples;
+
+    /// The largest memory values seen.
+    long fPeakResident;
+    long fPeakVirtual;
+
+    /// The time the sampler was started (in nanoseconds).
+    long long fStart;
+
+    /// The event information set by SetEvent().
+    std::atomic<long> fEvents;
+    std::atomic<int> fRun;
+    std::atomic<int> fEvent;
+
+    /// Protect the samples.
+    mutable std::mutex fMutex;
+
+    /// Wake the background thread to stop.
+    std::condition_variable fWake;
+    bool fStopping;
+
+    /// The background thread.
+    std::thread fThread;
+#endif
+};
+#endif
@@ -13,6 +13,7 @@
 #include "TManager.hxx"
 #include "TInputManager.hxx"
 #include "TCaptLog.hxx"
+#include "TEventProfiler.hxx"
 
 namespace {
     class TRootInputBuilder : public CP::TVInputBuilder {
@@ -139,6 +140,7 @@ CP::TEvent* CP::TRootInput::PreviousEvent(int skip) {
 }
 
 CP::TEvent* CP::TRootInput::ReadEvent(Int_t n) {
+    CP::TEventProfiler::TTimer timer("TRootInput");
     // Read the n'th event (starting from 0) in the file
     fSequence = n;
     if (fSequence<0) {
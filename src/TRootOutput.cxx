@@ -14,6 +14,7 @@
 #include "TEvent.hxx"
 #include "TManager.hxx"
 #include "TCaptLog.hxx"
+#include "TEventProfiler.hxx"
 
 ClassImp(CP::TRootOutput);
 
@@ -64,6 +65,7 @@ int CP::TRootOutput::GetEventsWritten(void) {return fEventsWritten;}
 
 void CP::TRootOutput::WriteEvent(CP::TEvent& event) {
     if (!IsAttached()) return;
+    CP::TEventProfiler::TTimer timer("TRootOutput");
     // Copy the pointer into the location attached to the file.
     fEventPointer = &event;
     // Put the event into the tree;
@@ -1,5 +1,6 @@
 #include "TRuntimeParameters.hxx"
 #include "TUnitsTable.hxx"
+#include "TSHA1.hxx"
 
 #include "HEPUnits.hxx"
 #include "HEPConstants.hxx"
@@ -9,14 +10,39 @@
 #include <sstream>
 #include <cstdlib>
 #include <algorithm>
+#include <utility>
 #include <functional>
 #include <string>
 #include <locale>
+#include <mutex>
+#include <sys/stat.h>
 
 CP::TRuntimeParameters* 
 CP::TRuntimeParameters::fTRuntimeParameters = NULL;
 
-CP::TRuntimeParameters::TRuntimeParameters() {
+std::atomic<CP::TRuntimeParameters::TValue*>
+CP::TRuntimeParameters::fPublished(NULL);
+
+namespace {
+    /// Protect the parameter values, the override files, and the values
+    /// published to the parameter handles.  This is never deleted so that
+    /// handles can be used during the program exit.
+    std::mutex& HandleMutex() {
+        static std::mutex* mutex = new std::mutex;
+        return *mutex;
+    }
+
+    /// Get the modification time of a file, or zero if the file doesn't
+    /// exist.
+    std::time_t ModificationTime(const std::string& fileName) {
+        struct stat status;
+        if (stat(fileName.c_str(), &status) != 0) return 0;
+        return status.st_mtime;
+    }
+}
+
+CP::TRuntimeParameters::TRuntimeParameters()
+    : fLastOverrideCheck(0), fPublishedCapacity(0) {
 
     CaptLog("Initializing CP::TRuntimeParameters");
 
@@ -65,6 +91,30 @@ void CP::TRuntimeParameters::ReadInputFile(std::string fileName,
         }
     }
   
+    Parameters values;
+    ParseInputFile(inputFile, fileName, values);
+    inputFile.close();
+
+    // Save the parameters; but only if the parameter isn't already
+    // 'constant'
+    for (Parameters::iterator v = values.begin(); v != values.end(); ++v) {
+        if (fConstants.find(v->first) != fConstants.end()) continue;
+        fRuntimeParameters[v->first] = v->second;
+        // If fixParameters bool is set, fix this parameter now.
+        if (fixParameters) {
+            CaptLog("Override parameter \"" 
+                    << v->first
+                    << "\" = \""
+                    << v->second
+                    << "\"");
+            fConstants.insert(v->first);
+        }
+    }
+}
+
+void CP::TRuntimeParameters::ParseInputFile(std::istream& inputFile,
+                                            const std::string& fileName,
+                                            Parameters& values) {
     int inputState = 0;
     std::string inputString;
     std::string parameterName;
@@ -100,20 +150,8 @@ void CP::TRuntimeParameters::ReadInputFile(std::string fileName,
         }
         else if (inputState == 4) {	
             if (inputString == ">") {
-                // Finished reading. Save parameter; but only if the parameter
-                // isn't already 'constant'
-                if (fConstants.find(parameterName) == fConstants.end()) {
-                    fRuntimeParameters[parameterName] = parValue;
-                    // If fixParameters bool is set, fix this parameter now.
-                    if (fixParameters) {
-                        CaptLog("Override parameter \"" 
-                                << parameterName
-                                << "\" = \""
-                                << parValue
-                                << "\"");
-                        fConstants.insert(parameterName);
-                    }
-                }
+                // Finished reading. Save parameter.
+                values[parameterName] = parValue;
                 inputState = 0;
             }
             else if (inputString == "<") {
@@ -148,7 +186,6 @@ void CP::TRuntimeParameters::ReadInputFile(std::string fileName,
                    << "Badly formatted parameters file."); 
         throw CP::EBadParameterFile();
     }  
-    inputFile.close();
 }
 
 
@@ -181,8 +218,9 @@ CP::TRuntimeParameters::TryLoadingParametersFile(std::string parameterName) {
     std::transform(packageROOT.begin(), packageROOT.end(),packageROOT.begin(),
                    (int(*)(int)) std::toupper);
     
-    std::string dirName =  std::getenv(packageROOT.c_str()) 
-        + std::string("/parameters/");
+    const char* packageDir = std::getenv(packageROOT.c_str());
+    if (!packageDir) return false;
+    std::string dirName = packageDir + std::string("/parameters/");
 
     // Now try reading in this file.  Last input variable is set to true,
     // indicating that we don't want to throw exception if a file is not found.
@@ -198,9 +236,90 @@ CP::TRuntimeParameters::TryLoadingParametersFile(std::string parameterName) {
 void CP::TRuntimeParameters::ReadParamOverrideFile(std::string filename) {
     CaptLog("Using TRuntimeParameters override file = " << filename);
 
+    std::lock_guard<std::mutex> lock(HandleMutex());
+
     // Setting final input variable to true forces the parameters
     // that are loaded to be 'fixed'; ie immutable.
     ReadInputFile(filename,"",false,true);
+    fOverrideFiles.push_back(std::make_pair(filename,
+                                            ModificationTime(filename)));
+    PublishParameters();
+}
+
+bool CP::TRuntimeParameters::ReloadParamOverrideFiles() {
+    std::lock_guard<std::mutex> lock(HandleMutex());
+    return ReloadOverrideFiles();
+}
+
+void CP::TRuntimeParameters::ClearParamOverrideFiles() {
+    std::lock_guard<std::mutex> lock(HandleMutex());
+    fOverrideFiles.clear();
+}
+
+bool CP::TRuntimeParameters::ReloadOverrideFiles() {
+    // Read all of the files before changing any values.  The modification
+    // times are saved first so that a bad file isn't read again until it
+    // changes.  Parameters in earlier files take precedence, the same as
+    // when the files were first read.
+    Parameters reloaded;
+    for (std::size_t f = 0; f<fOverrideFiles.size(); ++f) {
+        const std::string& fileName = fOverrideFiles[f].first;
+        fOverrideFiles[f].second = ModificationTime(fileName);
+        CaptLog("Reloading TRuntimeParameters override file = " 
+                << fileName);
+        std::ifstream inputFile(fileName.c_str());
+        if (!inputFile) {
+            CaptError("Cannot open override file '" << fileName << "'."
+                      << "  Parameters are not changed.");
+            return false;
+        }
+        Parameters values;
+        try {
+            ParseInputFile(inputFile, fileName, values);
+        }
+        catch (CP::EBadParameterFile&) {
+            CaptError("Cannot reload override file '" << fileName << "'."
+                      << "  Parameters are not changed.");
+            return false;
+        }
+        reloaded.insert(values.begin(), values.end());
+    }
+
+    for (Parameters::iterator v = reloaded.begin();
+         v != reloaded.end(); ++v) {
+        if (fSingleOverrides.find(v->first) != fSingleOverrides.end()) {
+            continue;
+        }
+        Parameters::iterator old = fRuntimeParameters.find(v->first);
+        if (old != fRuntimeParameters.end() && old->second == v->second) {
+            continue;
+        }
+        CaptLog("Override parameter \"" 
+                << v->first
+                << "\" = \""
+                << v->second
+                << "\"");
+        fRuntimeParameters[v->first] = v->second;
+        fConstants.insert(v->first);
+    }
+
+    PublishParameters();
+    return true;
+}
+
+bool CP::TRuntimeParameters::CheckParamOverrideFiles() {
+    std::lock_guard<std::mutex> lock(HandleMutex());
+    if (fOverrideFiles.empty()) return false;
+    std::time_t now = std::time(NULL);
+    if (now == fLastOverrideCheck) return false;
+    fLastOverrideCheck = now;
+    for (std::size_t f = 0; f<fOverrideFiles.size(); ++f) {
+        if (ModificationTime(fOverrideFiles[f].first) 
+            != fOverrideFiles[f].second) {
+            return ReloadOverrideFiles();
+        }
+    }
+    return false;
 }
 
 void CP::TRuntimeParameters::SetOverrideParameter(std::string name,
@@ -212,22 +331,118 @@ void CP::TRuntimeParameters::SetOverrideParameter(std::string name,
             << override
             << "\"");
 
+    std::lock_guard<std::mutex> lock(HandleMutex());
+
     std::istringstream line(override);
     std::string value;
     std::string unit;
-    if (!(line >> value >> unit)) {
-        fConstants.insert(name);
-        fRuntimeParameters[name] = override;
-        return;
+    if (line >> value >> unit) {
+        value = CP::TUnitsTable::Get().ConvertWithUnit(override);
     }
-    
-    value = CP::TUnitsTable::Get().ConvertWithUnit(override);
+    else value = override;
+
     fConstants.insert(name);
-    fRuntimeParameters[name] = override;
-    
+    fSingleOverrides.insert(name);
+    fRuntimeParameters[name] = value;
+    PublishParameters();
+}
+
+CP::TSHAHashValue
+CP::TRuntimeParameters::GetParameterHash(const std::string& prefix) {
+    std::lock_guard<std::mutex> lock(HandleMutex());
+
+    Parameters::iterator first = fRuntimeParameters.lower_bound(prefix);
+    if ((first == fRuntimeParameters.end()
+         || first->first.compare(0,prefix.size(),prefix) != 0)
+        && prefix.find(".") != std::string::npos) {
+        TryLoadingParametersFile(prefix);
+        first = fRuntimeParameters.lower_bound(prefix);
+    }
+
+    // The names and values include the terminating null so that they can't
+    // run together.
+    CP::TSHA1 sha;
+    for (Parameters::iterator p = first; p != fRuntimeParameters.end(); ++p) {
+        if (p->first.compare(0,prefix.size(),prefix) != 0) break;
+        sha.Input(p->first.c_str(), p->first.size()+1);
+        sha.Input(p->second.c_str(), p->second.size()+1);
+    }
+    unsigned int hash[5];
+    sha.Result(hash);
+    return CP::TSHAHashValue(hash);
+}
+
+int CP::TRuntimeParameters::ResolveParameter(const std::string& name) {
+    std::lock_guard<std::mutex> lock(HandleMutex());
+
+    std::map<std::string,int>::iterator index = fHandleIndex.find(name);
+    if (index != fHandleIndex.end()) return index->second;
+
+    if (!FindParameter(name)) {
+        CaptError("CP::TRuntimeParameters::ResolveParameter "
+                  << "Cannot find parameter '" << name << "'.");
+        throw CP::ENonexistantParameter();
+    }
+
+    // Make space for the value.  The old array is left for any readers.
+    TValue* values = fPublished.load(std::memory_order_acquire);
+    if (fHandleNames.size() >= fPublishedCapacity) {
+        std::size_t capacity = std::max<std::size_t>(64,2*fPublishedCapacity);
+        TValue* grown = new TValue[capacity];
+        std::copy(values, values + fHandleNames.size(), grown);
+        fPublished.store(grown, std::memory_order_release);
+        fPublishedCapacity = capacity;
+        values = grown;
+    }
+
+    // The new value is past the end of the values being read, so it can be
+    // filled in place.
+    int result = fHandleNames.size();
+    FillValue(fRuntimeParameters[name], values[result]);
+    fHandleNames.push_back(name);
+    fHandleIndex[name] = result;
+    return result;
+}
+
+void CP::TRuntimeParameters::PublishParameters() {
+    if (fHandleNames.empty()) return;
+    TValue* values = new TValue[fPublishedCapacity];
+    for (std::size_t i = 0; i<fHandleNames.size(); ++i) {
+        FillValue(fRuntimeParameters[fHandleNames[i]], values[i]);
+    }
+    fPublished.store(values, std::memory_order_release);
+}
+
+bool CP::TRuntimeParameters::ConvertToBool(const std::string& value) {
+    std::locale loc;
+    std::string val = value;
+    for (std::string::iterator c = val.begin(); c != val.end(); ++c) {
+        *c = std::tolower(*c,loc);
+    }
+    if (val == "y") return true;
+    if (val == "yes") return true;
+    if (val == "true") return true;
+    if (val == "n") return false;
+    if (val == "no") return false;
+    if (val == "false") return false;
+    return atoi(val.c_str());
+}
+
+void CP::TRuntimeParameters::FillValue(const std::string& value,
+                                       TValue& result) {
+    result.fString = value;
+    result.fDouble = atof(value.c_str());
+    result.fInteger = atoi(value.c_str());
+    result.fBoolean = ConvertToBool(value);
 }
 
 bool CP::TRuntimeParameters::HasParameter(std::string parameterName) {
+    std::lock_guard<std::mutex> lock(HandleMutex());
+    return FindParameter(parameterName);
+}
+
+bool 
+CP::TRuntimeParameters::FindParameter(const std::string& parameterName) {
     Parameters::iterator i = fRuntimeParameters.find(parameterName);
 
     if (i != fRuntimeParameters.end()) {
@@ -245,19 +460,9 @@ bool CP::TRuntimeParameters::HasParameter(std::string parameterName) {
 
 bool CP::TRuntimeParameters::GetParameterB(std::string parameterName) {
   
-    if (HasParameter(parameterName)) {
-        std::locale loc;
-        std::string val = fRuntimeParameters[parameterName].c_str();
-        for (std::string::iterator c = val.begin(); c != val.end(); ++c) {
-            *c = std::tolower(*c,loc);
-        }
-        if (val == "y") return true;
-        if (val == "yes") return true;
-        if (val == "true") return true;
-        if (val == "n") return true;
-        if (val == "no") return false;
-        if (val == "false") return false;
-        return GetParameterI(parameterName);
+    std::lock_guard<std::mutex> lock(HandleMutex());
+    if (FindParameter(parameterName)) {
+        return ConvertToBool(fRuntimeParameters[parameterName]);
     } 
     else {
         CaptError("CP::TRuntimeParameters::GetParameterAsInteger "
@@ -269,7 +474,8 @@ bool CP::TRuntimeParameters::GetParameterB(std::string parameterName) {
 
 int CP::TRuntimeParameters::GetParameterI(std::string parameterName) {
   
-    if (HasParameter(parameterName)) {
+    std::lock_guard<std::mutex> lock(HandleMutex());
+    if (FindParameter(parameterName)) {
         return atoi(fRuntimeParameters[parameterName].c_str());
     } 
     else {
@@ -284,7 +490,8 @@ int CP::TRuntimeParameters::GetParameterI(std::string parameterName) {
 
 double CP::TRuntimeParameters::GetParameterD(std::string parameterName) {
 
-    if (HasParameter(parameterName)) {
+    std::lock_guard<std::mutex> lock(HandleMutex());
+    if (FindParameter(parameterName)) {
         return atof(fRuntimeParameters[parameterName].c_str());
     }
     else { 
@@ -299,7 +506,8 @@ double CP::TRuntimeParameters::GetParameterD(std::string parameterName) {
 
 std::string CP::TRuntimeParameters::GetParameterS(std::string parameterName) {
 
-    if (HasParameter(parameterName)) {
+    std::lock_guard<std::mutex> lock(HandleMutex());
+    if (FindParameter(parameterName)) {
         return fRuntimeParameters[parameterName];
     }
     else {
@@ -2,12 +2,19 @@
 #define TRuntimeParameters_hxx_seen
 
 #include "ECore.hxx"
+#include "TSHAHashValue.hxx"
 
 #include <iostream>
 #include <string>
 #include <fstream>
 #include <map>
 #include <set>
+#include <vector>
+#include <ctime>
+
+#ifndef __CINT__
+#include <atomic>
+#endif
 
 namespace CP {
     class TRuntimeParameters;
@@ -42,6 +49,20 @@ namespace CP {
 /// comments.
 /// \endcode
 ///
+/// Code that reads a parameter often (e.g. inside of a loop over hits)
+/// should use a TParameter handle.  The handle finds the parameter when it
+/// is constructed, and then returns the value without a map lookup or a
+/// string conversion.  Handles can be read from any thread, and the other
+/// methods take a lock so they can also be called from any thread.
+///
+/// \code
+/// CP::TRuntimeParameters::TParameter<double> 
+///     crosstalk("elecSim.MAPD.Crosstalk");
+/// for (...) {
+///     double x = crosstalk.Get();
+/// }
+/// \endcode
+///
 /// This is described in detail in the \ref runtimeParameters documentation. 
 class CP::TRuntimeParameters {
 public:
@@ -84,6 +105,97 @@ public:
     /// single parameter value.
    void SetOverrideParameter(std::string name, std::string value);
 
+    /// Read all of the override files given to ReadParamOverrideFile()
+    /// again, and publish the new values to the TParameter handles.  The
+    /// handles see all of the new values at once.  Parameters set with
+    /// SetOverrideParameter() are not changed, and a parameter that has
+    /// been removed from an override file keeps its last value.  If a file
+    /// can't be read, an error is printed and none of the values are
+    /// changed.  This returns true if the files were read.
+    bool ReloadParamOverrideFiles();
+
+    /// Reload the override files if any of them have been modified since
+    /// they were read.  The files are checked at most once a second, so this
+    /// is cheap enough to call for each event (the default eventLoop calls
+    /// it before each event when it is run with the -w option).  This
+    /// returns true if the files were reloaded.
+    bool CheckParamOverrideFiles();
+
+    /// Forget the override files given to ReadParamOverrideFile() so that
+    /// they aren't reloaded.  The parameter values are not changed.
+    void ClearParamOverrideFiles();
+
+    /// Get a hash code of the names and values of all of the parameters
+    /// with names starting with the prefix (e.g. "captRecon.tpcClusters").
+    /// If there aren't any, the parameters file for the package named by
+    /// the prefix is read first.  This is used by TAlgorithmCache to notice
+    /// when the configuration of an algorithm has changed.
+    CP::TSHAHashValue GetParameterHash(const std::string& prefix);
+
+    /// The value of a parameter converted to each of the supported types.
+    /// The value is never changed after it is published.
+    struct TValue {
+        std::string fString;
+        double fDouble;
+        int fInteger;
+        bool fBoolean;
+    };
+
+    /// A typed handle to a parameter.  The parameter is found when the
+    /// handle is constructed (and ENonexistantParameter is thrown if it
+    /// doesn't exist).  The value is converted once when it is read from the
+    /// parameter files, so Get() only loads the published values and
+    /// doesn't take a lock.  The type can be double, int, bool or
+    /// std::string.  When the override files are reloaded, the handles
+    /// return the new values, so code that needs a consistent value during
+    /// a loop should copy the value before the loop.
+    template <typename T> class TParameter {
+    public:
+        explicit TParameter(const std::string& name)
+            : fName(name),
+              fIndex(CP::TRuntimeParameters::Get().ResolveParameter(name)) {}
+
+        /// Get the name of the parameter.
+        const std::string& GetName() const {return fName;}
+
+        /// Get the current value of the parameter.
+        T Get() const {
+            T value;
+            Convert(CP::TRuntimeParameters::GetValue(fIndex), value);
+            return value;
+        }
+
+        operator T () const {return Get();}
+
+    private:
+        static void Convert(const TValue& v, double& out) {
+            out = v.fDouble;
+        }
+        static void Convert(const TValue& v, int& out) {
+            out = v.fInteger;
+        }
+        static void Convert(const TValue& v, bool& out) {
+            out = v.fBoolean;
+        }
+        static void Convert(const TValue& v, std::string& out) {
+            out = v.fString;
+        }
+
+        std::string fName;
+        int fIndex;
+    };
+
+#ifndef __CINT__
+    /// [Internal method] Get the published value for a handle.
+    static const TValue& GetValue(int index) {
+        return fPublished.load(std::memory_order_acquire)[index];
+    }
+#endif
+
+    /// [Internal method] Find a parameter for a handle, and return the
+    /// index of the published value.
+    int ResolveParameter(const std::string& name);
+
 private:
     /// Yes, it's private...
     TRuntimeParameters();
@@ -102,6 +214,13 @@ private:
                        bool fixParameters = false);  
 
 
+    /// Check if a parameter exists, and try to read the parameters file if
+    /// it doesn't.  The handle mutex must be held.
+    bool FindParameter(const std::string& parameterName);
+
+    /// Read the override files again.  The handle mutex must be held.
+    bool ReloadOverrideFiles();
+
     /// Prints list of saved parameters
     void PrintListOfParameters();
 
@@ -114,6 +233,21 @@ private:
     typedef std::map<std::string, std::string, 
                      std::less<std::string> > Parameters;
 
+    /// Parse a parameters file into a map of names and values.
+    void ParseInputFile(std::istream& input,
+                        const std::string& fileName,
+                        Parameters& values);
+
+    /// Convert a parameter value into a boolean.
+    static bool ConvertToBool(const std::string& value);
+
+    /// Convert a parameter value into each of the supported types.
+    static void FillValue(const std::string& value, TValue& result);
+
+    /// Publish new values for all of the parameters that have handles.  The
+    /// handle mutex must be held.
+    void PublishParameters();
+
     /// map containing list of parameters and their values.
     Parameters fRuntimeParameters;
     
@@ -122,6 +256,36 @@ private:
     /// parameter override files.
     std::set<std::string> fConstants;
 
+    /// The parameters set by SetOverrideParameter().  These are not changed
+    /// when the override files are reloaded.
+    std::set<std::string> fSingleOverrides;
+
+    /// The override files in the order they were read, and the modification
+    /// time of each file when it was read.
+    std::vector< std::pair<std::string, std::time_t> > fOverrideFiles;
+
+    /// The last time that the override files were checked.
+    std::time_t fLastOverrideCheck;
+
+    /// The names of the parameters that have handles, indexed by the
+    /// position of the value in the published values.
+    std::vector<std::string> fHandleNames;
+
+    /// The position of the published value for each parameter that has a
+    /// handle.
+    std::map<std::string, int> fHandleIndex;
+
+#ifndef __CINT__
+    /// The values published to the TParameter handles.  A new array is
+    /// published each time the values change, and the old arrays are never
+    /// deleted (they might still be read).  While the array has space, the
+    /// values for new handles are added without publishing a new array.
+    static std::atomic<TValue*> fPublished;
+#endif
+
+    /// The number of values that fit in the published array.
+    std::size_t fPublishedCapacity;
+
     /// The static pointer to the singleton instance.
     static TRuntimeParameters* fTRuntimeParameters;
 };
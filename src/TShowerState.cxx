@@ -6,7 +6,7 @@ ClassImp(CP::TShowerState);
 CP::TShowerState::TShowerState(): TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
-    Init();
+    Init(fStorage);
 }
 
 CP::TShowerState::~TShowerState() {}
@@ -15,36 +15,23 @@ CP::TShowerState::TShowerState(const CP::TShowerState& init)
   : TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
-    Init();
+    Init(fStorage);
 
-    for (int i=0; i<GetSize(); ++i) {
-        SetValue(i,init.GetValue(i));
-    }
-
-    for (int i=0; i<GetSize(); ++i) {
-        for (int j=0; j<GetSize(); ++j) {
-            SetCovarianceValue(i,j,init.GetCovarianceValue(i,j));
-        }
-    }
-    
+    CopyValues(init);
 }
 
 CP::TShowerState& CP::TShowerState::operator=(const CP::TShowerState& rhs) {
     if (this == &rhs) return *this;
 
-    for (int i=0; i<GetSize(); ++i) {
-        SetValue(i,rhs.GetValue(i));
-    }
+    CopyValues(rhs);
 
-    for (int i=0; i<GetSize(); ++i) {
-        for (int j=0; j<GetSize(); ++j) {
-            SetCovarianceValue(i,j,rhs.GetCovarianceValue(i,j));
-        }
-    }
-    
     return *this;
 }
 
+CP::TReconState* CP::TShowerState::CopyState() const {
+    return new CP::TShowerState(*this);
+}
+
 CP::TCorrValues CP::TShowerState::ProjectState(const CP::THandle<CP::TReconState>& proj) {
     TCorrValues values(TShowerState::GetSize());
     values.SetType("EDeposit X Y Z T DX DY DZ C1 C2 ");
@@ -56,12 +43,12 @@ CP::TCorrValues CP::TShowerState::ProjectState(const CP::THandle<CP::TReconState
         for (int i = 0; i < TMEDepositState::GetSize(); ++i) {
             values.SetValue(i+base,
                             eDepositState->
-                            GetThis().fValues.GetValue(i+offset));
+                            GetThis().GetValue(i+offset));
             for (int j = 0; j < TMEDepositState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
                     eDepositState->
-                    GetThis().fValues.GetCovarianceValue(i+offset,
+                    GetThis().GetCovarianceValue(i+offset,
                                                          j+offset));
             }
         }
@@ -73,11 +60,11 @@ CP::TCorrValues CP::TShowerState::ProjectState(const CP::THandle<CP::TReconState
         const int offset = posState->GetPositionIndex();
         for (int i = 0; i < TMPositionState::GetSize(); ++i) {
             values.SetValue(i+base, 
-                            posState->GetThis().fValues.GetValue(i+offset));
+                            posState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMPositionState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    posState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    posState->GetThis().GetCovarianceValue(i+offset,
                                                                    j+offset));
             }
         }
@@ -89,11 +76,11 @@ CP::TCorrValues CP::TShowerState::ProjectState(const CP::THandle<CP::TReconState
         const int offset = dirState->GetDirectionIndex();
         for (int i = 0; i < TMDirectionState::GetSize(); ++i) {
             values.SetValue(i+base, 
-                            dirState->GetThis().fValues.GetValue(i+offset));
+                            dirState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMDirectionState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    dirState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    dirState->GetThis().GetCovarianceValue(i+offset,
                                                                    j+offset));
             }
         }
@@ -105,11 +92,11 @@ CP::TCorrValues CP::TShowerState::ProjectState(const CP::THandle<CP::TReconState
         const int offset = coneState->GetConeIndex();
         for (int i = 0; i < TMConeState::GetSize(); ++i) {
             values.SetValue(i+base,
-                            coneState->GetThis().fValues.GetValue(i+offset));
+                            coneState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMConeState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    coneState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    coneState->GetThis().GetCovarianceValue(i+offset,
                                                                     j+offset));
             }
         }
@@ -2,6 +2,7 @@
 #define TShowerState_hxx_seen
 
 #include "TReconState.hxx"
+#include "TReconStateView.hxx"
 #include "TReconNode.hxx"
 
 namespace CP {
@@ -26,6 +27,9 @@ public:
     virtual ~TShowerState();
     virtual TShowerState& operator=(const TShowerState& rhs);
 
+    /// Make a new copy of the state.
+    virtual CP::TReconState* CopyState() const;
+
     /// Return the number of entries for the Direction in the TCorrValues
     /// vector.
     static int GetSize() {
@@ -38,6 +42,25 @@ public:
     static CP::TCorrValues ProjectState(
         const CP::THandle<CP::TReconState>& state);
 
+private:
+    /// The fixed size storage for the state values.
+    TReconStateStorage<9> fStorage; //! Don't Save
+
     ClassDef(TShowerState,2);
 };
+
+#ifndef __CINT__
+namespace CP {
+    /// The compile time layout of the TShowerState fields.
+    template <> struct TReconStateLayout<CP::TShowerState> {
+        enum {
+            kEDeposit = 0,
+            kPosition = 1,
+            kDirection = 5,
+            kCone = 8,
+            kSize = 9
+        };
+    };
+}
+#endif
 #endif
@@ -2,6 +2,11 @@
 // $Id: TSingleHit.cxx,v 1.22 2012/06/18 15:32:24 mcgrew Exp $
 //
 #include <cmath>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <atomic>
+#include <mutex>
 
 #include <TGeoManager.h>
 #include <TGeoBBox.h>
@@ -9,11 +14,182 @@
 
 #include "TGeomIdManager.hxx"
 #include "TSingleHit.hxx"
+#include "THitSelection.hxx"
 #include "TManager.hxx"
 #include "HEPUnits.hxx"
 
 ClassImp(CP::TSingleHit);
 
+/// The geometry information for a single volume.  This is shared by all of
+/// the TSingleHit objects in the volume so that the rotation doesn't need to
+/// be copied into every hit.  The volumes for the current geometry are kept
+/// in a cache which holds a reference to each volume.  When the geometry or
+/// alignment changes, the cache releases its references, and each volume is
+/// deleted when the last hit using it is deleted.
+class CP::TSingleHit::TVolume {
+public:
+    TVolume() 
+        : fValid(false), fPosition(0,0,0),
+          fUncertainty(100*unit::meter,100*unit::meter,100*unit::meter),
+          fRMS(100*unit::meter,100*unit::meter,100*unit::meter),
+          fRotation(3,3), fReferences(1) {
+        fRotation.UnitMatrix();
+    }
+
+    /// True if the volume was found in the geometry.
+    bool fValid;
+
+    /// The global position of the center of the volume.
+    TVector3 fPosition;
+
+    /// The uncertainty of a hit in the volume in local coordinates.
+    TVector3 fUncertainty;
+
+    /// The spread of a hit in the volume in local coordinates.
+    TVector3 fRMS;
+
+    /// The rotation from local to global coordinates.
+    TMatrixD fRotation;
+
+    /// The number of hits (and caches) using the volume.
+    mutable std::atomic<int> fReferences;
+
+    /// The volume information used for hits that haven't been initialized,
+    /// or that have a geometry id that can't be found in the geometry.  This
+    /// isn't reference counted, and is never deleted.
+    static const TVolume* Default() {
+        static TVolume* defaultVolume = new TVolume;
+        return defaultVolume;
+    }
+
+    /// Add a reference to a volume, and return the volume.
+    static const TVolume* Attach(const TVolume* volume) {
+        if (volume && volume != Default()) {
+            volume->fReferences.fetch_add(1, std::memory_order_relaxed);
+        }
+        return volume;
+    }
+
+    /// Remove a reference to a volume, and delete it if this was the last
+    /// reference.
+    static void Release(const TVolume* volume) {
+        if (!volume || volume == Default()) return;
+        int references
+            = volume->fReferences.fetch_sub(1, std::memory_order_acq_rel);
+        if (references != 1) return;
+        delete volume;
+        --Count();
+    }
+
+    /// The lock protecting the cache and the geometry navigation.  This is
+    /// never deleted so that hits can be used during the program exit.
+    static std::mutex& Mutex() {
+        static std::mutex* mutex = new std::mutex;
+        return *mutex;
+    }
+
+    /// The number of volumes found in the geometry that haven't been
+    /// deleted.
+    static std::atomic<int>& Count() {
+        static std::atomic<int>* count = new std::atomic<int>(0);
+        return *count;
+    }
+
+    /// Make sure that the cache matches the currently loaded geometry.  This
+    /// must be called after the geometry has been checked using
+    /// TManager::Geometry(), and while holding the lock.
+    static void CheckCache() {
+        TCache& cache = Cache();
+        CP::TGeomIdManager& geomId = CP::TManager::Get().GeomId();
+        if (geomId.GetHash() == cache.fHash
+            && geomId.GetAlignmentId() == cache.fAlignment) return;
+        for (TCache::VolumeMap::iterator v = cache.fVolumes.begin();
+             v != cache.fVolumes.end(); ++v) {
+            Release(v->second);
+        }
+        cache.fVolumes.clear();
+        cache.fHash = geomId.GetHash();
+        cache.fAlignment = geomId.GetAlignmentId();
+    }
+
+    /// Find the volume information for a geometry id, and fill it from the
+    /// geometry if it's not already in the cache.  This changes the current
+    /// node of the geometry, so the caller must push and pop the path.  This
+    /// must be called while holding the lock.
+    static const TVolume* Find(TGeoManager* geom, int id);
+
+private:
+    /// The cached volumes for the currently loaded geometry.
+    struct TCache {
+        /// The volumes keyed by the geometry id.
+        typedef std::map<int, const TVolume*> VolumeMap;
+        VolumeMap fVolumes;
+
+        /// The geometry hash and alignment associated with the volumes.
+        CP::TSHAHashValue fHash;
+        CP::TAlignmentId fAlignment;
+    };
+
+    /// Get the cache.  This is never deleted.
+    static TCache& Cache() {
+        static TCache* cache = new TCache;
+        return *cache;
+    }
+};
+
+const CP::TSingleHit::TVolume* 
+CP::TSingleHit::TVolume::Find(TGeoManager* geom, int id) {
+    TCache& cache = Cache();
+    TCache::VolumeMap::iterator v = cache.fVolumes.find(id);
+    if (v != cache.fVolumes.end()) return v->second;
+
+    if (!CP::TManager::Get().GeomId().CdId(CP::TGeometryId(id))) {
+        cache.fVolumes[id] = Default();
+        return Default();
+    }
+
+    TVolume* volume = new TVolume;
+    volume->fValid = true;
+    ++Count();
+
+    // Find the global position
+    double local[3] = {0,0,0};
+    double master[3] = {0,0,0};
+    geom->LocalToMaster(local,master);
+    volume->fPosition.SetXYZ(master[0],master[1],master[2]);
+    
+    // Find the size of the object.
+    TGeoNode* node = geom->GetCurrentNode();
+    TGeoBBox *shape 
+        = dynamic_cast<TGeoBBox*>(node->GetVolume()->GetShape());
+    if (shape) {
+        volume->fUncertainty.SetXYZ(shape->GetDX(), 
+                                    shape->GetDY(), 
+                                    shape->GetDZ());
+        volume->fUncertainty = volume->fUncertainty*(2.0/std::sqrt(12.0));
+    }
+
+    TVector3& rms = volume->fRMS;
+    rms = volume->fUncertainty;
+    if (rms.X() < 1.5*unit::mm/std::sqrt(12.0)) {
+        rms.SetX(1.5*unit::mm/std::sqrt(12.0));
+    }
+    if (rms.Y() < 1.5*unit::mm/std::sqrt(12.0)) {
+        rms.SetY(1.5*unit::mm/std::sqrt(12.0));
+    }
+    if (rms.Z() < 1.5*unit::mm/std::sqrt(12.0)) {
+        rms.SetZ(1.5*unit::mm/std::sqrt(12.0));
+    }
+
+    // Need to check if the TGeomManager current matrix is an active or
+    // passive rotation.
+    volume->fRotation.SetMatrixArray(
+        geom->GetCurrentMatrix()->GetRotationMatrix());
+
+    cache.fVolumes[id] = volume;
+    return volume;
+}
+
 CP::TSingleHit::TSingleHit() 
     : fGeomId(0), 
       fCharge(0), fChargeUncertainty(1*unit::coulomb),
@@ -21,7 +197,8 @@ CP::TSingleHit::TSingleHit()
       fInitialized(false),
       fPosition(0,0,0), 
       fUncertainty(100*unit::meter,100*unit::meter,100*unit::meter),
-      fRMS(100*unit::meter,100*unit::meter,100*unit::meter) {
+      fRMS(100*unit::meter,100*unit::meter,100*unit::meter),
+      fVolume(TVolume::Default()) {
     SetBit(kCanDelete,false);
 }
 
@@ -30,14 +207,36 @@ CP::TSingleHit::TSingleHit(const CP::TSingleHit& h)
       fCharge(h.fCharge), fChargeUncertainty(h.fChargeUncertainty),
       fTime(h.fTime), fTimeUncertainty(h.fTimeUncertainty),
       fTimeRMS(h.fTimeRMS),
-      fInitialized(h.fInitialized),
+      fInitialized(h.IsInitialized()),
       fPosition(h.fPosition),
       fUncertainty(h.fUncertainty),
-      fRMS(h.fRMS) {
+      fRMS(h.fRMS),
+      fVolume(TVolume::Attach(h.fVolume)) {
     SetBit(kCanDelete,false);
 }
 
-CP::TSingleHit::~TSingleHit() { }
+CP::TSingleHit& CP::TSingleHit::operator = (const CP::TSingleHit& h) {
+    if (this == &h) return *this;
+    CP::THit::operator = (h);
+    fGeomId = h.fGeomId;
+    fCharge = h.fCharge;
+    fChargeUncertainty = h.fChargeUncertainty;
+    fTime = h.fTime;
+    fTimeUncertainty = h.fTimeUncertainty;
+    fTimeRMS = h.fTimeRMS;
+    fPosition = h.fPosition;
+    fUncertainty = h.fUncertainty;
+    fRMS = h.fRMS;
+    const TVolume* volume = TVolume::Attach(h.fVolume);
+    TVolume::Release(fVolume);
+    fVolume = volume;
+    fInitialized.store(h.IsInitialized(), std::memory_order_release);
+    return *this;
+}
+
+CP::TSingleHit::~TSingleHit() {
+    TVolume::Release(fVolume);
+}
 
 //////////////////////////////////////////////////
 // Getter methods for CP::TSingleHit
@@ -51,93 +250,83 @@ CP::TGeometryId CP::TSingleHit::GetGeomId(int i) const {
 double CP::TSingleHit::GetCharge(void) const {return fCharge;}
 
 double CP::TSingleHit::GetChargeUncertainty(void) const {
-    if (!fInitialized) const_cast<CP::TSingleHit*>(this)->Initialize();
+    if (!IsInitialized()) {
+        const_cast<CP::TSingleHit*>(this)->Initialize();
+    }
     return fChargeUncertainty;
 }
 
 double CP::TSingleHit::GetTime(void) const {
-    if (!fInitialized) const_cast<CP::TSingleHit*>(this)->Initialize();
+    if (!IsInitialized()) {
+        const_cast<CP::TSingleHit*>(this)->Initialize();
+    }
     return fTime;
 }
 
 double CP::TSingleHit::GetTimeRMS(void) const {
-    if (!fInitialized) const_cast<CP::TSingleHit*>(this)->Initialize();
+    if (!IsInitialized()) {
+        const_cast<CP::TSingleHit*>(this)->Initialize();
+    }
     return fTimeRMS;
 }
 
 const TVector3& CP::TSingleHit::GetPosition(void) const {
-    if (!fInitialized) const_cast<CP::TSingleHit*>(this)->Initialize();
+    if (!IsInitialized()) {
+        const_cast<CP::TSingleHit*>(this)->Initialize();
+    }
     return fPosition;
 }
 
 const TMatrixD& CP::TSingleHit::GetRotation(void) const {
-    if (!fInitialized) const_cast<CP::TSingleHit*>(this)->Initialize();
-    return fRotation;
+    if (!IsInitialized()) {
+        const_cast<CP::TSingleHit*>(this)->Initialize();
+    }
+    return fVolume->fRotation;
 }
 
 const TVector3& CP::TSingleHit::GetRMS(void) const {
-    if (!fInitialized) const_cast<CP::TSingleHit*>(this)->Initialize(); 
+    if (!IsInitialized()) {
+        const_cast<CP::TSingleHit*>(this)->Initialize();
+    }
     return fRMS;
 }
 
 const TVector3& CP::TSingleHit::GetUncertainty(void) const {
-    if (!fInitialized) const_cast<CP::TSingleHit*>(this)->Initialize();
+    if (!IsInitialized()) {
+        const_cast<CP::TSingleHit*>(this)->Initialize();
+    }
     return fUncertainty;
 }
 
 double CP::TSingleHit::GetTimeUncertainty(void) const {
-    if (!fInitialized) const_cast<CP::TSingleHit*>(this)->Initialize();
+    if (!IsInitialized()) {
+        const_cast<CP::TSingleHit*>(this)->Initialize();
+    }
     return fTimeUncertainty;
 }
 
 bool CP::TSingleHit::InitializeGeneric() {
     TGeoManager* geom = CP::TManager::Get().Geometry();
+    std::lock_guard<std::mutex> lock(TVolume::Mutex());
+    // Another thread may have initialized the hit while waiting for the lock.
+    if (IsInitialized()) return fVolume->fValid;
+    TVolume::CheckCache();
     geom->PushPath();
-    if (!CP::TManager::Get().GeomId().CdId(TGeometryId(fGeomId))) {
-        geom->PopPath();
-        fPosition.SetXYZ(0,0,0);
-        double v = 100*unit::meter;
-        fUncertainty.SetXYZ(v,v,v);
-        fRMS.SetXYZ(v,v,v);
-        fRotation.ResizeTo(3,3);
-        fRotation.Zero();
-        fRotation(0,0) = 1;
-        fRotation(1,1) = 1;
-        fRotation(2,2) = 1;
-        return false;
-    }
-    TGeoNode* node = geom->GetCurrentNode();
-
-    // Find the global position
-    double local[3] = {0,0,0};
-    double master[3] = {0,0,0};
-    geom->LocalToMaster(local,master);
-    fPosition.SetXYZ(master[0],master[1],master[2]);
-    
-    // Find the size of the object.
-    TGeoBBox *shape = dynamic_cast<TGeoBBox*>(node->GetVolume()->GetShape());
-    fUncertainty.SetXYZ(shape->GetDX(), shape->GetDY(), shape->GetDZ());
-    fUncertainty = fUncertainty*(2.0/std::sqrt(12.0));
-    
-    fRMS = fUncertainty;
-    if (fRMS.X() < 1.5*unit::mm/std::sqrt(12.0)) {
-        fRMS.SetX(1.5*unit::mm/std::sqrt(12.0));
-    }
-    if (fRMS.Y() < 1.5*unit::mm/std::sqrt(12.0)) {
-        fRMS.SetY(1.5*unit::mm/std::sqrt(12.0));
-    }
-    if (fRMS.Z() < 1.5*unit::mm/std::sqrt(12.0)) {
-        fRMS.SetZ(1.5*unit::mm/std::sqrt(12.0));
-    }
-
-    // Need to check if the TGeomManager current matrix is an active or
-    // passive rotation.
-    fRotation.ResizeTo(3,3);
-    fRotation.SetMatrixArray(geom->GetCurrentMatrix()->GetRotationMatrix());
-
+    const TVolume* volume = TVolume::Find(geom,fGeomId);
     geom->PopPath();
-    
-    return true;
+    SetVolume(volume);
+    return volume->fValid;
+}
+
+void CP::TSingleHit::SetVolume(const TVolume* volume) {
+    fPosition = volume->fPosition;
+    fUncertainty = volume->fUncertainty;
+    fRMS = volume->fRMS;
+    volume = TVolume::Attach(volume);
+    TVolume::Release(fVolume);
+    fVolume = volume;
+    // Publish the fields to the threads that read them without the lock.
+    fInitialized.store(true, std::memory_order_release);
 }
 
 void CP::TSingleHit::Initialize(void) {
@@ -148,7 +337,6 @@ void CP::TSingleHit::Initialize(void) {
             // most general.
             InitializeGeneric();
         } while (false);
-        fInitialized = true;
     }
     catch (std::exception& e) {
         CaptSevere("TSingleHit Exception: " << e.what());
@@ -160,3 +348,54 @@ void CP::TSingleHit::Initialize(void) {
         return;
     }
 }
+
+int CP::TSingleHit::InitializeGeometry(const CP::THitSelection& hits) {
+    // Collect the hits that need to be initialized and sort them by the
+    // geometry id so each volume is only looked up once.
+    std::vector< std::pair<int, CP::TSingleHit*> > singles;
+    singles.reserve(hits.size());
+    for (CP::THitSelection::const_iterator h = hits.begin(); 
+         h != hits.end(); ++h) {
+        CP::TSingleHit* hit = dynamic_cast<CP::TSingleHit*>(GetPointer(*h));
+        if (!hit) continue;
+        if (hit->IsInitialized()) continue;
+        singles.push_back(std::make_pair(hit->fGeomId, hit));
+    }
+    if (singles.empty()) return 0;
+    std::sort(singles.begin(), singles.end());
+
+    TGeoManager* geom = NULL;
+    try {
+        geom = CP::TManager::Get().Geometry();
+    }
+    catch (std::exception& e) {
+        CaptSevere("TSingleHit Exception: " << e.what());
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(TVolume::Mutex());
+    TVolume::CheckCache();
+
+    geom->PushPath();
+    int initialized = 0;
+    const TVolume* volume = NULL;
+    int volumeId = 0;
+    for (std::vector< std::pair<int, CP::TSingleHit*> >::iterator s
+             = singles.begin();
+         s != singles.end(); ++s) {
+        CP::TSingleHit* hit = s->second;
+        if (hit->IsInitialized()) continue;
+        if (!volume || s->first != volumeId) {
+            volume = TVolume::Find(geom,s->first);
+            volumeId = s->first;
+        }
+        hit->SetVolume(volume);
+        ++initialized;
+    }
+    geom->PopPath();
+
+    return initialized;
+}
+
+int CP::TSingleHit::GetVolumeCount() {
+    return TVolume::Count().load();
+}
@@ -3,10 +3,15 @@
 
 #include "THit.hxx"
 
+#ifndef __CINT__
+#include <atomic>
+#endif
+
 class TGeoManager;
 
 namespace CP {
     class TSingleHit;
+    class THitSelection;
     class TMCHit;
     class TDataHit;
     class TWritableMCHit;
@@ -26,6 +31,7 @@ private:
     // as a THit class.
     TSingleHit();
     TSingleHit(const TSingleHit&);
+    TSingleHit& operator = (const TSingleHit&);
 
 public:
     virtual ~TSingleHit();
@@ -96,10 +102,49 @@ public:
 
     virtual int GetGeomIdCount(void) const {return 1;}
 
+    /// Fill the geometry related fields for all of the TSingleHit objects in
+    /// a hit selection in a single pass through the geometry.  The hits are
+    /// sorted by geometry identifier so that each volume is only looked up
+    /// once, and hits in the same volume share the cached volume information
+    /// (including the rotation).  Hits that are not derived from TSingleHit,
+    /// or which have already been initialized are skipped.  This returns the
+    /// number of hits that were initialized.  Calling this before a loop over
+    /// the hits is optional, but avoids the just-in-time geometry lookup
+    /// inside of the individual getters.
+    ///
+    /// \code
+    /// CP::THandle<CP::THitSelection> hits = event.GetHits("drift");
+    /// CP::TSingleHit::InitializeGeometry(*hits);
+    /// \endcode
+    static int InitializeGeometry(const CP::THitSelection& hits);
+
+    /// Get the number of volumes with cached geometry information.  This
+    /// includes the volumes for an earlier geometry (or alignment) that are
+    /// still used by hits.  The volume information is deleted when the
+    /// geometry has changed and the last hit using it is deleted.
+    static int GetVolumeCount();
+
 private: 
+    /// The geometry information for a volume.  This is shared by all of the
+    /// hits in the volume, and is reference counted by the hits.
+    class TVolume;
+
+    /// Use the geometry information for a volume.  This must be called while
+    /// holding the volume cache lock.
+    void SetVolume(const TVolume* volume);
+
     /// Fill all of the geometry related fields from the geometry data base.
     void Initialize();
 
+#ifndef __CINT__
+    /// Check if the geometry related fields have been filled.  The fields
+    /// are filled by SetVolume() before the flag is set, so a hit that is
+    /// initialized by another thread can be read without the lock.
+    bool IsInitialized() const {
+        return fInitialized.load(std::memory_order_acquire);
+    }
+#endif
+
     /// A helper routine to handle the generic geometry data base (for now,
     /// this is everything).
     bool InitializeGeneric();
@@ -123,9 +168,12 @@ protected:
     /// The RMS of the timing.
     Float_t fTimeRMS;
 
+#ifndef __CINT__
     /// This is set to true if the fast access fields below have been
-    /// initialized.
-    bool fInitialized; //! Don't Save
+    /// initialized.  It's set after the fields are filled (see
+    /// IsInitialized()).
+    std::atomic<bool> fInitialized; //! Don't Save
+#endif
 
     /// The central position of the hit.  This is the center of the wire in
     /// the global coordinate system.
@@ -137,8 +185,9 @@ protected:
     /// The spread of the hit position in local coordinates
     TVector3 fRMS; //! Don't Save
 
-    /// The rotation of the hit.
-    TMatrixD fRotation; //! Don't Save
+    /// The cached geometry information for the volume.  This holds the
+    /// rotation, and is shared by all of the hits in the volume.
+    const TVolume* fVolume; //! Don't Save
 
     ClassDef(TSingleHit,5);
 };
@@ -6,7 +6,7 @@ ClassImp(CP::TTrackState);
 CP::TTrackState::TTrackState(): TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
-    Init();
+    Init(fStorage);
 }
 
 CP::TTrackState::~TTrackState() {}
@@ -15,36 +15,23 @@ CP::TTrackState::TTrackState(const CP::TTrackState& init)
   : TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
-    Init();
+    Init(fStorage);
 
-    for (int i=0; i<GetSize(); ++i) {
-        SetValue(i,init.GetValue(i));
-    }
-
-    for (int i=0; i<GetSize(); ++i) {
-        for (int j=0; j<GetSize(); ++j) {
-            SetCovarianceValue(i,j,init.GetCovarianceValue(i,j));
-        }
-    }
-    
+    CopyValues(init);
 }
 
 CP::TTrackState& CP::TTrackState::operator=(const CP::TTrackState& rhs) {
     if (this == &rhs) return *this;
 
-    for (int i=0; i<GetSize(); ++i) {
-        SetValue(i,rhs.GetValue(i));
-    }
+    CopyValues(rhs);
 
-    for (int i=0; i<GetSize(); ++i) {
-        for (int j=0; j<GetSize(); ++j) {
-            SetCovarianceValue(i,j,rhs.GetCovarianceValue(i,j));
-        }
-    }
-    
     return *this;
 }
 
+CP::TReconState* CP::TTrackState::CopyState() const {
+    return new CP::TTrackState(*this);
+}
+
 CP::TCorrValues CP::TTrackState::ProjectState(
     const CP::THandle<CP::TReconState>& proj) {
     TCorrValues values(TTrackState::GetSize());
@@ -57,12 +44,12 @@ CP::TCorrValues CP::TTrackState::ProjectState(
         for (int i = 0; i < TMEDepositState::GetSize(); ++i) {
             values.SetValue(i+base,
                             eDepositState->
-                            GetThis().fValues.GetValue(i+offset));
+                            GetThis().GetValue(i+offset));
             for (int j = 0; j < TMEDepositState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
                     eDepositState->
-                    GetThis().fValues.GetCovarianceValue(i+offset,
+                    GetThis().GetCovarianceValue(i+offset,
                                                          j+offset));
             }
         }
@@ -74,11 +61,11 @@ CP::TCorrValues CP::TTrackState::ProjectState(
         const int offset = posState->GetPositionIndex();
         for (int i = 0; i < TMPositionState::GetSize(); ++i) {
             values.SetValue(i+base, 
-                            posState->GetThis().fValues.GetValue(i+offset));
+                            posState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMPositionState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    posState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    posState->GetThis().GetCovarianceValue(i+offset,
                                                                    j+offset));
             }
         }
@@ -90,11 +77,11 @@ CP::TCorrValues CP::TTrackState::ProjectState(
         const int offset = dirState->GetDirectionIndex();
         for (int i = 0; i < TMDirectionState::GetSize(); ++i) {
             values.SetValue(i+base, 
-                            dirState->GetThis().fValues.GetValue(i+offset));
+                            dirState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMDirectionState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    dirState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    dirState->GetThis().GetCovarianceValue(i+offset,
                                                                    j+offset));
             }
         }
@@ -106,11 +93,11 @@ CP::TCorrValues CP::TTrackState::ProjectState(
         const int offset = curvState->GetMassIndex();
         for (int i = 0; i < TMMassState::GetSize(); ++i) {
             values.SetValue(i+base,
-                            curvState->GetThis().fValues.GetValue(i+offset));
+                            curvState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMMassState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    curvState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    curvState->GetThis().GetCovarianceValue(i+offset,
                                                                     j+offset));
             }
         }
@@ -122,11 +109,11 @@ CP::TCorrValues CP::TTrackState::ProjectState(
         const int offset = widthState->GetWidthIndex();
         for (int i = 0; i < TMWidthState::GetSize(); ++i) {
             values.SetValue(i+base,
-                            widthState->GetThis().fValues.GetValue(i+offset));
+                            widthState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMWidthState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    widthState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    widthState->GetThis().GetCovarianceValue(i+offset,
                                                                     j+offset));
             }
         }
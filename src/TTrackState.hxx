@@ -2,6 +2,7 @@
 #define TTrackState_hxx_seen
 
 #include "TReconState.hxx"
+#include "TReconStateView.hxx"
 #include "TReconNode.hxx"
 
 namespace CP {
@@ -27,6 +28,9 @@ public:
     virtual ~TTrackState();
     virtual TTrackState& operator=(const TTrackState& rhs);
 
+    /// Make a new copy of the state.
+    virtual CP::TReconState* CopyState() const;
+
     /// Return the number of entries for the Direction in the TCorrValues
     /// vector.
     static int GetSize() {
@@ -38,7 +42,26 @@ public:
     /// The projection operator to get the full state.
     static CP::TCorrValues ProjectState(const CP::THandle<CP::TReconState>& state);
 
+private:
+    /// The fixed size storage for the state values.
+    TReconStateStorage<10> fStorage; //! Don't Save
+
     ClassDef(TTrackState,2);
 };
 
+#ifndef __CINT__
+namespace CP {
+    /// The compile time layout of the TTrackState fields.
+    template <> struct TReconStateLayout<CP::TTrackState> {
+        enum {
+            kEDeposit = 0,
+            kPosition = 1,
+            kDirection = 5,
+            kMass = 8,
+            kWidth = 9,
+            kSize = 10
+        };
+    };
+}
+#endif
 #endif
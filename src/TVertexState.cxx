@@ -6,7 +6,7 @@ ClassImp(CP::TVertexState);
 CP::TVertexState::TVertexState(): TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
-    Init();
+    Init(fStorage);
 }
 
 CP::TVertexState::~TVertexState() {}
@@ -15,36 +15,23 @@ CP::TVertexState::TVertexState(const CP::TVertexState& init)
   : TMReconState(this) {
     std::copy(fLocalNames.begin(), fLocalNames.end(), 
               std::back_inserter(fFieldNames));
-    Init();
+    Init(fStorage);
 
-    for (int i=0; i<GetSize(); ++i) {
-        SetValue(i,init.GetValue(i));
-    }
-
-    for (int i=0; i<GetSize(); ++i) {
-        for (int j=0; j<GetSize(); ++j) {
-            SetCovarianceValue(i,j,init.GetCovarianceValue(i,j));
-        }
-    }
-    
+    CopyValues(init);
 }
 
 CP::TVertexState& CP::TVertexState::operator=(const CP::TVertexState& rhs) {
     if (this == &rhs) return *this;
 
-    for (int i=0; i<GetSize(); ++i) {
-        SetValue(i,rhs.GetValue(i));
-    }
+    CopyValues(rhs);
 
-    for (int i=0; i<GetSize(); ++i) {
-        for (int j=0; j<GetSize(); ++j) {
-            SetCovarianceValue(i,j,rhs.GetCovarianceValue(i,j));
-        }
-    }
-    
     return *this;
 }
 
+CP::TReconState* CP::TVertexState::CopyState() const {
+    return new CP::TVertexState(*this);
+}
+
 CP::TCorrValues CP::TVertexState::ProjectState(
     const CP::THandle<TReconState>& proj) {
     TCorrValues values(TVertexState::GetSize());
@@ -56,11 +43,11 @@ CP::TCorrValues CP::TVertexState::ProjectState(
         const int offset = posState->GetPositionIndex();
         for (int i = 0; i < TMPositionState::GetSize(); ++i) {
             values.SetValue(i+base, 
-                            posState->GetThis().fValues.GetValue(i+offset));
+                            posState->GetThis().GetValue(i+offset));
             for (int j = 0; j < TMPositionState::GetSize(); ++j) {
                 values.SetCovarianceValue(
                     i+base, j+base,
-                    posState->GetThis().fValues.GetCovarianceValue(i+offset,
+                    posState->GetThis().GetCovarianceValue(i+offset,
                                                                    j+offset));
             }
         }
@@ -2,6 +2,7 @@
 #define TVertexState_hxx_seen
 
 #include "TReconState.hxx"
+#include "TReconStateView.hxx"
 #include "TReconNode.hxx"
 
 namespace CP {
@@ -24,6 +25,9 @@ public:
     TVertexState(const TVertexState& init);
     virtual TVertexState& operator=(const TVertexState& rhs);
 
+    /// Make a new copy of the state.
+    virtual CP::TReconState* CopyState() const;
+
     /// Return the number of entries for the Direction in the TCorrValues
     /// vector.
     static int GetSize() {
@@ -34,6 +38,22 @@ public:
     static CP::TCorrValues ProjectState(const 
                                         CP::THandle<CP::TReconState>& state);
     
+private:
+    /// The fixed size storage for the state values.
+    TReconStateStorage<4> fStorage; //! Don't Save
+
     ClassDef(TVertexState,2);
 };
+
+#ifndef __CINT__
+namespace CP {
+    /// The compile time layout of the TVertexState fields.
+    template <> struct TReconStateLayout<CP::TVertexState> {
+        enum {
+            kPosition = 0,
+            kSize = 4
+        };
+    };
+}
+#endif
 #endif
@@ -9,8 +9,10 @@
 #include "THandleHack.hxx"
 #include "TCaptLog.hxx"
 #include "TMemoryUsage.hxx"
+#include "TEventProfiler.hxx"
 #include "TRuntimeParameters.hxx"
 #include "TInputManager.hxx"
+#include "TEventArena.hxx"
 
 #include <iostream>
 #include <sstream>
@@ -47,6 +49,9 @@ namespace {
         std::cout << "    -a                Read all events";
         if (readCount<1) std::cout << " [Default]";
         std::cout << std::endl;
+
+        std::cout << "    -A                Allocate event objects in an arena"
+                  << std::endl;
         
         std::cout << "    -c <file>         Set the logging config file name"
                   << std::endl;
@@ -73,9 +78,12 @@ namespace {
                   << std::endl;
         
         std::cout << "    -g                Don't save geometry in output"
+                  << std::endl
+                  << "                      (and don't read it unless it's"
+                  << " used)"
                   << std::endl;
         
-        std::cout << "    -H                Debug THandle (slow)"
+        std::cout << "    -H                Record every THandle allocation"
                   << std::endl;
         
 
@@ -112,11 +120,17 @@ namespace {
         }
 
         std::cout << "    -u                Log the memory and CPU usage"
+                  << std::endl
+                  << "                      and save a profile of each event"
                   << std::endl;
 
         std::cout << "    -v                Increase the verbosity"
                   << std::endl;
         
+        std::cout << "    -w                Reread the -R override files "
+                  << "when they change"
+                  << std::endl;
+
         std::cout << "    -V <name>=[quiet,log,info,verbose]"
                   << std::endl
                   << "                      Change the named log level"
@@ -147,11 +161,14 @@ int CP::eventLoop(int argc, char** argv,
     std::vector<std::string> outputNames;
     std::vector<TRootOutput*> outputFiles;
     bool preventSavedGeometry = false;
+    bool reloadOverrideFiles = false;
     std::string geometryFile = "";
     int targetRun = -1;
     int targetEvent = -1;
     int exitStatus = 0;
     TMemoryUsage memoryUsage;
+    TEventProfiler eventProfiler;
+    std::unique_ptr<TEventArena> arena;
 
     // If this is not zero, then only accept triggers matched in this mask.
     signal(SIGSEGV, SIG_DFL);
@@ -160,7 +177,7 @@ int CP::eventLoop(int argc, char** argv,
 
     // Process the options.
     for (;;) {
-        int c = getopt(argc, argv, "ac:dD:f:G:gHn:o:O:qr:R:s:t:uvV:");
+        int c = getopt(argc, argv, "aAc:dD:f:G:gHn:o:O:qr:R:s:t:uvV:w");
         if (c<0) break;
         switch (c) {
         case 'a':
@@ -169,6 +186,12 @@ int CP::eventLoop(int argc, char** argv,
             readCount = 0;
             break;
         }
+        case 'A':
+        {
+            // Allocate the objects created by the user code from an arena.
+            arena.reset(new TEventArena);
+            break;
+        }
         case 'c':
         {
             configName = strdup(optarg);
@@ -318,8 +341,9 @@ int CP::eventLoop(int argc, char** argv,
         }
         case 'u':
         {
-          // Enable logging of memory usage
+          // Enable logging of memory usage and the event profile
           memoryUsage.Enable();
+          eventProfiler.Enable();
           break;
         }
         case 'v':
@@ -363,6 +387,12 @@ int CP::eventLoop(int argc, char** argv,
             }
             break;
         }
+        case 'w':
+        {
+            // Reread the override files when they are changed.
+            reloadOverrideFiles = true;
+            break;
+        }
         default:
             eventLoopUsage(programName,userCode,defaultReadCount);
         }
@@ -460,6 +490,8 @@ int CP::eventLoop(int argc, char** argv,
 
     if (geometryFile != "") {
         TManager::Get().SetGeometryOverride(geometryFile);
+        // Read the geometry while the first input file is opened.
+        TManager::Get().PrefetchGeometry();
     }
 
     int totalRead = 0;
@@ -513,6 +545,8 @@ int CP::eventLoop(int argc, char** argv,
 
             userCode.BeginFile(input.get());
             
+            // The profile of the first event includes reading it.
+            eventProfiler.Mark();
             std::unique_ptr<TEvent> event(input->FirstEvent());
 
             // Position to the first event in the file to read.  This might
@@ -538,12 +572,19 @@ int CP::eventLoop(int argc, char** argv,
 
                 ++totalRead;
 
+                // Pick up any changes to the parameter override files.
+                if (reloadOverrideFiles) {
+                    CP::TRuntimeParameters::Get().CheckParamOverrideFiles();
+                }
+
                 lastEventId = event->GetEventId();
                 lastRunId = event->GetRunId();
-                memoryUsage.LogMemory();
+                memoryUsage.LogMemory(lastRunId,lastEventId);
                 
                 int saveEvent = -1;
                 try {
+                    TEventArena::TScope arenaScope(arena.get());
+                    TEventProfiler::TTimer timer("Process");
                     if (!outputFiles.empty()) outputFiles.front()->cd();
                     saveEvent = userCode.Process(*event,outputFiles.size());
                 }
@@ -575,6 +616,7 @@ int CP::eventLoop(int argc, char** argv,
                 }
                 
                 event.reset(NULL);
+                if (arena) arena->Reset();
                 if (!CleanHandleRegistry()) {
                     DumpHandleRegistry();
                     CaptError("WARNING: Memory Leak in "
@@ -583,6 +625,7 @@ int CP::eventLoop(int argc, char** argv,
                               << lastEventId 
                               << "," << lastRunId << ")");
                 }
+                eventProfiler.LogEvent(lastRunId,lastEventId);
                 
                 if (totalRead>(nextOutput-0.5)) {
                     nextOutput *= std::sqrt(10);
@@ -639,11 +682,13 @@ int CP::eventLoop(int argc, char** argv,
              ++ file) {
             userCode.Finalize(*file);
             memoryUsage.Write(*file);
+            eventProfiler.Write(*file);
         }
     }
     else {
         userCode.Finalize((CP::TRootOutput*) NULL);
         memoryUsage.Write((CP::TRootOutput*) NULL);
+        eventProfiler.Write((CP::TRootOutput*) NULL);
     }
     
     std::cout << "Total Events Read: " << totalRead << std::endl;
@@ -0,0 +1,139 @@
+// Replace the global allocation operators so that CP::TEventProfiler can
+// count the allocations.  This is built as the separate captEventAllocHook
+// library so that the operators are only replaced in programs that ask for
+// it (by linking with -lcaptEventAllocHook, or with LD_PRELOAD).  The
+// memory is managed with malloc and free as usual.
+#include <cstdlib>
+#include <new>
+
+#include "TEventProfiler.hxx"
+
+namespace {
+    /// Allocate memory for operator new, and count the allocation.
+    void* CountedAllocate(std::size_t size) {
+        CP::TEventProfiler::CountAllocation(size);
+        if (size == 0) size = 1;
+        for (;;) {
+            void* memory = std::malloc(size);
+            if (memory) return memory;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+
+#ifdef __cpp_aligned_new
+    /// Allocate aligned memory for operator new, and count the allocation.
+    void* CountedAllocate(std::size_t size, std::align_val_t alignment) {
+        CP::TEventProfiler::CountAllocation(size);
+        std::size_t align = static_cast<std::size_t>(alignment);
+        if (align < sizeof(void*)) align = sizeof(void*);
+        if (size == 0) size = 1;
+        for (;;) {
+            void* memory = NULL;
+            if (posix_memalign(&memory, align, size) == 0) return memory;
+            std::new_handler handler = std::get_new_handler();
+            if (!handler) throw std::bad_alloc();
+            handler();
+        }
+    }
+#endif
+
+    /// Tell the profiler that the allocations are counted when the library
+    /// is loaded.
+    struct InstallHook {
+        InstallHook() {CP::TEventProfiler::InstallAllocationHook();}
+    } gInstallHook;
+}
+
+void* operator new(std::size_t size) {
+    return CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return CountedAllocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return CountedAllocate(size);
+    }
+    catch (...) {
+        return NULL;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return CountedAllocate(size);
+    }
+    catch (...) {
+        return NULL;
+    }
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+#ifdef __cpp_aligned_new
+// The aligned versions (C++17) are replaced too so that every allocation is
+// counted, and every block is released by the matching operator.
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return CountedAllocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return CountedAllocate(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+    try {
+        return CountedAllocate(size, alignment);
+    }
+    catch (...) {
+        return NULL;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+    try {
+        return CountedAllocate(size, alignment);
+    }
+    catch (...) {
+        return NULL;
+    }
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+#endif
@@ -0,0 +1,60 @@
+#ifndef TTestHit_hxx_seen
+#define TTestHit_hxx_seen
+
+#include <cmath>
+
+#include <TVector3.h>
+#include <TMatrixD.h>
+
+#include "THit.hxx"
+#include "TGeometryId.hxx"
+
+namespace CP {
+    class TTestHit;
+}
+
+/// A hit with a fixed position, charge and time interval that doesn't need a
+/// geometry.  This is only used by the tests and benchmarks, so that they
+/// can make hits with known values.
+class CP::TTestHit : public CP::THit {
+public:
+    /// Make a hit at a position.  The hit is two ns wide and centered on the
+    /// time, and doesn't have a geometry id.
+    TTestHit(const TVector3& pos, double charge, double time)
+        : fPosition(pos), fUncertainty(1.0,1.0,1.0), fRMS(1.0,1.0,1.0),
+          fCharge(charge), fLower(time-1.0), fUpper(time+1.0) {}
+
+    /// Make a hit with a geometry id that covers a time interval.  The hit
+    /// is at the origin with a unit charge.
+    TTestHit(int id, double lower, double upper)
+        : fPosition(0.0,0.0,0.0), fUncertainty(1.0,1.0,1.0),
+          fRMS(1.0,1.0,1.0), fGeomId(id),
+          fCharge(1.0), fLower(lower), fUpper(upper) {}
+
+    virtual ~TTestHit() {}
+
+    double GetCharge() const {return fCharge;}
+    double GetChargeUncertainty() const {return std::sqrt(fCharge);}
+    double GetTime() const {return 0.5*(fLower+fUpper);}
+    double GetTimeUncertainty() const {return 1.0;}
+    double GetTimeRMS() const {return 0.5*(fUpper-fLower);}
+    double GetTimeLowerBound() const {return fLower;}
+    double GetTimeUpperBound() const {return fUpper;}
+    const TVector3& GetPosition() const {return fPosition;}
+    const TVector3& GetUncertainty() const {return fUncertainty;}
+    const TVector3& GetRMS() const {return fRMS;}
+    const TMatrixD& GetRotation() const {return fRotation;}
+    CP::TGeometryId GetGeomId(int i=0) const {return fGeomId;}
+    int GetGeomIdCount() const {return 1;}
+
+private:
+    TVector3 fPosition;
+    TVector3 fUncertainty;
+    TVector3 fRMS;
+    CP::TGeometryId fGeomId;
+    double fCharge;
+    double fLower;
+    double fUpper;
+    TMatrixD fRotation;
+};
+#endif
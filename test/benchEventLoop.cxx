@@ -0,0 +1,275 @@
+// A benchmark for the event loop operations.  This generates synthetic
+// events with a configurable size (a container of TPulseDigit objects, a
+// selection of hits that reference the digits, and an algorithm result with
+// recon objects) and times writing the events, reading them back, looking
+// up objects with TDatum::Get, copying the hit handles, resolving the digit
+// proxies, and building clusters.  The results are printed one per line as
+// "operation.quantity value" so that the output of two versions can be
+// compared with diff (or any script).  The rates in MB/s are the number of
+// bytes that the events take in the output file, so they are comparable
+// between the operations.
+//
+// Usage: benchEventLoop [digits] [hits] [recon] [events] [file]
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#include <TVector3.h>
+#include <TMatrixD.h>
+
+#include "TEvent.hxx"
+#include "TRootInput.hxx"
+#include "TRootOutput.hxx"
+#include "TDigitContainer.hxx"
+#include "TDigitProxy.hxx"
+#include "TPulseDigit.hxx"
+#include "TTPCChannelId.hxx"
+#include "TDataHit.hxx"
+#include "THitSelection.hxx"
+#include "TAlgorithmResult.hxx"
+#include "TReconCluster.hxx"
+#include "CaptGeomId.hxx"
+
+#include "TTestHit.hxx"
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double Seconds(Clock::time_point start, Clock::time_point stop) {
+        double elapsed = std::chrono::duration_cast<
+            std::chrono::nanoseconds>(stop-start).count();
+        return 1E-9*elapsed;
+    }
+
+    /// The sizes of the synthetic events.
+    struct TEventSize {
+        int fDigits;
+        int fHits;
+        int fRecon;
+    };
+
+    /// Fill an event with digits, hits that reference the digits, and an
+    /// algorithm result with clusters.  The event must be the current event
+    /// so that the hits can resolve the digit proxies.
+    void FillEvent(CP::TEvent& event, const TEventSize& size) {
+        CP::TDigitContainer* digits = new CP::TDigitContainer("drift");
+        for (int i=0; i<size.fDigits; ++i) {
+            CP::TPulseDigit::Vector adcs(32);
+            for (std::size_t s=0; s<adcs.size(); ++s) {
+                adcs[s] = 2048 + (i+s)%64;
+            }
+            digits->push_back(
+                new CP::TPulseDigit(CP::TTPCChannelId((i/2048)%3,
+                                                      (i/64)%32, i%64),
+                                    i%1000, adcs));
+        }
+        event.Get<CP::TDataVector>("digits")->push_back(digits);
+
+        CP::THitSelection* hits = new CP::THitSelection("bench");
+        for (int i=0; i<size.fHits; ++i) {
+            CP::TWritableDataHit hit;
+            hit.SetGeomId(CP::GeomId::Captain::Wire(i%3, i%300));
+            hit.SetCharge(1.0 + i%17);
+            hit.SetTime(10.0*(i%1000));
+            if (size.fDigits > 0) {
+                hit.SetDigit(CP::TDigitProxy(*digits, i%size.fDigits));
+            }
+            hits->push_back(CP::THandle<CP::THit>(new CP::TDataHit(hit)));
+        }
+        event.Get<CP::TDataVector>("hits")->push_back(hits);
+
+        CP::TAlgorithmResult* result
+            = new CP::TAlgorithmResult("benchResult", "Benchmark Result");
+        CP::TReconObjectContainer* objects
+            = new CP::TReconObjectContainer("clusters");
+        for (int i=0; i<size.fRecon; ++i) {
+            CP::THandle<CP::TReconCluster> cluster(new CP::TReconCluster);
+            CP::THandle<CP::TClusterState> state = cluster->GetState();
+            state->SetEDeposit(1.0 + i);
+            state->SetPosition(1.0*i, 2.0*i, 3.0*i, 4.0*i);
+            cluster->SetQuality(0.5);
+            objects->push_back(cluster);
+        }
+        result->AddResultsContainer(objects);
+        event.AddFit(result);
+    }
+
+    /// Print the rates for an operation that was applied to "events"
+    /// events.  The bytes are the size of the events in the file.
+    void PrintRates(const std::string& name, double seconds, long events,
+                    double bytes) {
+        if (seconds <= 0.0) seconds = 1E-9;
+        std::cout << name << ".events_per_s " << events/seconds << std::endl;
+        std::cout << name << ".mb_per_s " << 1E-6*bytes/seconds << std::endl;
+    }
+
+    /// Look up the event contents by name.
+    long LookupObjects(CP::TEvent& event, int lookups) {
+        long found = 0;
+        for (int i=0; i<lookups; ++i) {
+            if (event.Get<CP::TDigitContainer>("~/digits/drift")) ++found;
+            if (event.Get<CP::THitSelection>("~/hits/bench")) ++found;
+            if (event.Get<CP::TReconObjectContainer>(
+                    "~/fits/benchResult/clusters")) ++found;
+        }
+        return found;
+    }
+
+    /// Copy each hit handle in the event.
+    long CopyHandles(CP::TEvent& event) {
+        CP::THandle<CP::THitSelection> hits = event.GetHits("bench");
+        if (!hits) return 0;
+        long copies = 0;
+        for (CP::THitSelection::iterator h = hits->begin();
+             h != hits->end(); ++h) {
+            CP::THandle<CP::THit> copy(*h);
+            if (copy) ++copies;
+        }
+        return copies;
+    }
+
+    /// Resolve the digit proxy of each hit.  The hits have just been read,
+    /// so the proxies don't have a cached digit yet.
+    long ResolveProxies(CP::TEvent& event) {
+        CP::THandle<CP::THitSelection> hits = event.GetHits("bench");
+        if (!hits) return 0;
+        long resolved = 0;
+        for (CP::THitSelection::iterator h = hits->begin();
+             h != hits->end(); ++h) {
+            if ((*h)->GetDigitCount() < 1) continue;
+            if (*(*h)->GetDigit()) ++resolved;
+        }
+        return resolved;
+    }
+
+    /// Make the hits and labels for building "clusters" clusters.
+    void MakeClusterHits(int hitCount, int clusters,
+                         CP::THitSelection& hits, std::vector<int>& labels) {
+        if (clusters < 1) clusters = 1;
+        for (int i=0; i<hitCount; ++i) {
+            int c = i%clusters;
+            TVector3 pos(100.0*c + i%7, 50.0*c + i%5, 10.0*c + i%3);
+            hits.push_back(CP::THandle<CP::THit>(
+                               new CP::TTestHit(pos, 1.0+i%4, 10.0*i)));
+            labels.push_back(c);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    TEventSize size;
+    size.fDigits = 1000;
+    size.fHits = 1000;
+    size.fRecon = 50;
+    long events = 100;
+    std::string fileName = "benchEventLoop.root";
+    if (argc > 1) size.fDigits = std::atoi(argv[1]);
+    if (argc > 2) size.fHits = std::atoi(argv[2]);
+    if (argc > 3) size.fRecon = std::atoi(argv[3]);
+    if (argc > 4) events = std::atol(argv[4]);
+    if (argc > 5) fileName = argv[5];
+    if (size.fDigits < 0) size.fDigits = 0;
+    if (size.fHits < 0) size.fHits = 0;
+    if (size.fRecon < 0) size.fRecon = 0;
+    if (events < 1) events = 1;
+
+    std::cout << "config.digits " << size.fDigits << std::endl;
+    std::cout << "config.hits " << size.fHits << std::endl;
+    std::cout << "config.recon " << size.fRecon << std::endl;
+    std::cout << "config.events " << events << std::endl;
+
+    // Write the events.  The events are filled before the clock is started
+    // so that only the output is timed.
+    double seconds = 0.0;
+    {
+        CP::TRootOutput output(fileName.c_str(), "RECREATE");
+        for (long i=0; i<events; ++i) {
+            CP::TEvent event(CP::TEventContext(0,1,0,i,0,0));
+            FillEvent(event,size);
+            Clock::time_point start = Clock::now();
+            output.WriteEvent(event);
+            seconds += Seconds(start,Clock::now());
+        }
+        Clock::time_point start = Clock::now();
+        output.Close();
+        seconds += Seconds(start,Clock::now());
+    }
+    double bytes = 0.0;
+    struct stat status;
+    if (stat(fileName.c_str(), &status) == 0) bytes = status.st_size;
+    std::cout << "file.bytes_per_event " << bytes/events << std::endl;
+    PrintRates("write", seconds, events, bytes);
+
+    // Read the events back, and time the in memory operations on each event
+    // as it is read.
+    double readSeconds = 0.0;
+    double lookupSeconds = 0.0;
+    double copySeconds = 0.0;
+    double proxySeconds = 0.0;
+    long readEvents = 0;
+    long checksum = 0;
+    const int lookups = 100;
+    {
+        CP::TRootInput input(fileName.c_str(), "OLD");
+        Clock::time_point start = Clock::now();
+        CP::TEvent* event = input.FirstEvent();
+        readSeconds += Seconds(start,Clock::now());
+        while (event && !input.EndOfFile()) {
+            ++readEvents;
+
+            start = Clock::now();
+            checksum += LookupObjects(*event, lookups);
+            lookupSeconds += Seconds(start,Clock::now());
+
+            start = Clock::now();
+            checksum += CopyHandles(*event);
+            copySeconds += Seconds(start,Clock::now());
+
+            start = Clock::now();
+            checksum += ResolveProxies(*event);
+            proxySeconds += Seconds(start,Clock::now());
+
+            delete event;
+            start = Clock::now();
+            event = input.NextEvent();
+            readSeconds += Seconds(start,Clock::now());
+        }
+        delete event;
+        input.Close();
+    }
+    std::remove(fileName.c_str());
+    if (readEvents != events) {
+        std::cout << "error.events_read " << readEvents << std::endl;
+    }
+    if (readEvents < 1) return 1;
+    PrintRates("read", readSeconds, readEvents, bytes);
+    PrintRates("lookup", lookupSeconds, readEvents, bytes);
+    std::cout << "lookup.ns_per_get "
+              << 1E9*lookupSeconds/(3.0*lookups*readEvents) << std::endl;
+    PrintRates("handle_copy", copySeconds, readEvents, bytes);
+    PrintRates("proxy", proxySeconds, readEvents, bytes);
+
+    // Build the clusters from the hits.  Each event builds one cluster for
+    // each recon object.
+    CP::THitSelection hits;
+    std::vector<int> labels;
+    MakeClusterHits(size.fHits, size.fRecon, hits, labels);
+    seconds = 0.0;
+    for (long i=0; i<events; ++i) {
+        CP::TReconObjectContainer clusters("clusters");
+        Clock::time_point start = Clock::now();
+        CP::TReconCluster::FillClusters("bench", hits, labels, clusters, 1);
+        seconds += Seconds(start,Clock::now());
+        checksum += clusters.size();
+    }
+    PrintRates("cluster", seconds, events, bytes);
+
+    std::cout << "checksum " << checksum << std::endl;
+
+    return 0;
+}
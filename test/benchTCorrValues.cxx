@@ -0,0 +1,132 @@
+// A micro-benchmark for the TCorrValues Hessian.  This times finding the
+// Hessian after the covariance has changed (which uses the fixed size
+// Cholesky inversion for small dimensions), getting a cached Hessian, and
+// inverting the same covariance with TMatrixT the way the Hessian used to
+// be found.  The results are printed as the time per call in nanoseconds
+// for each dimension.
+//
+// Usage: benchTCorrValues [iterations]
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <vector>
+
+#include <TMatrixT.h>
+#include <TMatrixTSym.h>
+
+#include "TCorrValues.hxx"
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double NanosecondsPerCall(Clock::time_point start,
+                              Clock::time_point stop,
+                              long iterations) {
+        double elapsed = std::chrono::duration_cast<
+            std::chrono::nanoseconds>(stop-start).count();
+        return elapsed/iterations;
+    }
+
+    /// Fill a positive definite covariance with correlations between all of
+    /// the parameters.
+    void FillCovariance(CP::TCorrValues& values) {
+        int dim = values.GetDimensions();
+        for (int i=0; i<dim; ++i) {
+            for (int j=0; j<dim; ++j) {
+                double cov = std::pow(0.5,std::abs(i-j))*(i+1)*(j+1);
+                values.SetCovarianceValue(i,j,cov);
+            }
+        }
+    }
+
+    /// Change the covariance and get the Hessian each iteration.
+    double UpdateHessian(CP::TCorrValues& values, long iterations) {
+        double sum = 0.0;
+        for (long i=0; i<iterations; ++i) {
+            values.SetCovarianceValue(0,0,1.0 + 1E-6*(i%2));
+            sum += values.GetHessian()(0,0);
+        }
+        return sum;
+    }
+
+    /// Get the cached Hessian each iteration.
+    double CachedHessian(const CP::TCorrValues& values, long iterations) {
+        double sum = 0.0;
+        for (long i=0; i<iterations; ++i) {
+            sum += values.GetHessian()(0,0);
+        }
+        return sum;
+    }
+
+    /// Invert the covariance with TMatrixT each iteration.  This follows
+    /// the general TCorrValues calculation (the list of parameters that are
+    /// neither fixed nor free, a new Hessian, and a TMatrixT temporary).
+    double MatrixHessian(const CP::TCorrValues& values, long iterations) {
+        int dim = values.GetDimensions();
+        double sum = 0.0;
+        for (long i=0; i<iterations; ++i) {
+            std::vector<int> goodList;
+            for (int j=0; j<dim; ++j) {
+                if (values.IsFixed(j)) continue;
+                if (values.IsFree(j)) continue;
+                goodList.push_back(j);
+            }
+            TMatrixTSym<float>* hessian = new TMatrixTSym<float>(dim);
+            TMatrixT<float> h(goodList.size(),goodList.size());
+            for (unsigned int r=0; r<goodList.size(); ++r) {
+                for (unsigned int c=r; c<goodList.size(); ++c) {
+                    h(c,r) = h(r,c)
+                        = values.GetCovariance()(goodList[r],goodList[c]);
+                }
+            }
+            h.Invert();
+            for (unsigned int r=0; r<goodList.size(); ++r) {
+                for (unsigned int c=0; c<goodList.size(); ++c) {
+                    (*hessian)(goodList[r],goodList[c]) = h(r,c);
+                }
+            }
+            sum += (*hessian)(0,0);
+            delete hessian;
+        }
+        return sum;
+    }
+}
+
+int main(int argc, char **argv) {
+    long iterations = 1000000;
+    if (argc > 1) iterations = std::atol(argv[1]);
+    if (iterations < 1) iterations = 1;
+
+    int dimensions[] = {3, 5, 10, 12};
+    double check = 0.0;
+    for (int d=0; d<4; ++d) {
+        CP::TCorrValues values(dimensions[d]);
+        FillCovariance(values);
+
+        Clock::time_point start = Clock::now();
+        check += UpdateHessian(values,iterations);
+        Clock::time_point stop = Clock::now();
+        std::cout << "dim " << dimensions[d]
+                  << " hessian " << NanosecondsPerCall(start,stop,iterations)
+                  << " ns";
+
+        start = Clock::now();
+        check += CachedHessian(values,iterations);
+        stop = Clock::now();
+        std::cout << " cached " << NanosecondsPerCall(start,stop,iterations)
+                  << " ns";
+
+        start = Clock::now();
+        check += MatrixHessian(values,iterations);
+        stop = Clock::now();
+        std::cout << " TMatrixT " << NanosecondsPerCall(start,stop,iterations)
+                  << " ns" << std::endl;
+    }
+
+    // Use the result so the calculations aren't optimized away.
+    if (check == 0.0) std::cout << "check " << check << std::endl;
+
+    return 0;
+}
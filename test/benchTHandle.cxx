@@ -0,0 +1,93 @@
+// A micro-benchmark for the THandle reference counting.  This times the
+// basic handle operations (copy, destroy, and making a weak handle) on a
+// single thread, and then with several threads copying handles to the same
+// object.  The results are printed as the time per operation in
+// nanoseconds.
+//
+// Usage: benchTHandle [iterations] [threads]
+
+#include <iostream>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "TMCHit.hxx"
+#include "THandle.hxx"
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double NanosecondsPerCall(Clock::time_point start,
+                              Clock::time_point stop,
+                              long iterations) {
+        double elapsed = std::chrono::duration_cast<
+            std::chrono::nanoseconds>(stop-start).count();
+        return elapsed/iterations;
+    }
+
+    /// Copy and destroy a handle "iterations" times.
+    void CopyHandles(CP::THandle<CP::THit> handle, long iterations) {
+        for (long i=0; i<iterations; ++i) {
+            CP::THandle<CP::THit> copy(handle);
+        }
+    }
+
+    /// Copy a handle, make it weak, and then destroy it.
+    void WeakHandles(CP::THandle<CP::THit> handle, long iterations) {
+        for (long i=0; i<iterations; ++i) {
+            CP::THandle<CP::THit> copy(handle);
+            copy.MakeWeak();
+        }
+    }
+
+    /// Create and destroy a new handle (and object) each iteration.
+    void CreateHandles(long iterations) {
+        for (long i=0; i<iterations; ++i) {
+            CP::THandle<CP::THit> handle(new CP::TMCHit());
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    long iterations = 10000000;
+    int threadCount = 4;
+    if (argc > 1) iterations = std::atol(argv[1]);
+    if (argc > 2) threadCount = std::atoi(argv[2]);
+    if (iterations < 1) iterations = 1;
+    if (threadCount < 1) threadCount = 1;
+
+    CP::THandle<CP::THit> handle(new CP::TMCHit());
+
+    Clock::time_point start = Clock::now();
+    CopyHandles(handle,iterations);
+    Clock::time_point stop = Clock::now();
+    std::cout << "copy " << NanosecondsPerCall(start,stop,iterations)
+              << " ns" << std::endl;
+
+    start = Clock::now();
+    WeakHandles(handle,iterations);
+    stop = Clock::now();
+    std::cout << "weak " << NanosecondsPerCall(start,stop,iterations)
+              << " ns" << std::endl;
+
+    long creations = iterations/10 + 1;
+    start = Clock::now();
+    CreateHandles(creations);
+    stop = Clock::now();
+    std::cout << "create " << NanosecondsPerCall(start,stop,creations)
+              << " ns" << std::endl;
+
+    std::vector<std::thread> threads;
+    start = Clock::now();
+    for (int t=0; t<threadCount; ++t) {
+        threads.push_back(std::thread(CopyHandles,handle,iterations));
+    }
+    for (std::size_t t=0; t<threads.size(); ++t) threads[t].join();
+    stop = Clock::now();
+    std::cout << "shared-copy " << threadCount << " threads "
+              << NanosecondsPerCall(start,stop,iterations*threadCount)
+              << " ns" << std::endl;
+
+    return 0;
+}
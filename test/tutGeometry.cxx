@@ -20,6 +20,9 @@
 #include "TGeometryId.hxx"
 #include "TGeomIdManager.hxx"
 #include "CaptGeomId.hxx"
+#include "TSingleHit.hxx"
+#include "TMCHit.hxx"
+#include "THitSelection.hxx"
 #include "HEPUnits.hxx"
 
 namespace tut {
@@ -294,5 +297,79 @@ namespace tut {
         ensure_equals("Call backs called", localGeometryChange.fCallCount,1);
     }
 
+    /// Test that the batch initialization of the hit geometry matches the
+    /// lazy initialization, that the cached volume information is replaced
+    /// when the alignment changes, and that the old volume information is
+    /// deleted with the last hit using it.
+    template<> template<>
+    void testGeometry::test<9> () {
+        ensure("Have valid geometry", gGeoManager != NULL);
+
+        CP::THitSelection* hits = new CP::THitSelection("hits");
+        for (int i=0; i<4; ++i) {
+            CP::TWritableMCHit wHit;
+            wHit.SetGeomId(CP::GeomId::Captain::Plane(i/2));
+            hits->push_back(CP::THandle<CP::THit>(new CP::TMCHit(wHit)));
+        }
+        ensure_equals("Hits are initialized",
+                      CP::TSingleHit::InitializeGeometry(*hits), 4);
+        ensure_equals("Initialized hits are skipped",
+                      CP::TSingleHit::InitializeGeometry(*hits), 0);
+        int volumes = CP::TSingleHit::GetVolumeCount();
+
+        TVector3 position;
+        CP::TManager::Get().GeomId().GetPosition(
+            CP::GeomId::Captain::Plane(0), position);
+        TVector3 oldPosition = (*hits)[0]->GetPosition();
+        ensure_distance("Hit is at the volume center",
+                        (oldPosition-position).Mag(), 0.0, 0.01*unit::mm);
+        ensure("Hits in a volume share the rotation",
+               &(*hits)[0]->GetRotation() == &(*hits)[1]->GetRotation());
+        ensure("Hits in different volumes have different rotations",
+               &(*hits)[0]->GetRotation() != &(*hits)[2]->GetRotation());
+
+        CP::TWritableMCHit wLazy;
+        wLazy.SetGeomId(CP::GeomId::Captain::Plane(0));
+        CP::TMCHit* lazy = new CP::TMCHit(wLazy);
+        ensure_distance("Lazy initialization matches",
+                        (lazy->GetPosition()-oldPosition).Mag(),
+                        0.0, 0.01*unit::mm);
+        ensure("Lazy initialization uses the cached rotation",
+               &lazy->GetRotation() == &(*hits)[0]->GetRotation());
+        ensure_equals("Lazy initialization uses the cached volume",
+                      CP::TSingleHit::GetVolumeCount(), volumes);
+
+        // Change the alignment so the cached volumes are replaced.
+        alignmentLookup.fGeomIdZShift.clear();
+        alignmentLookup.fGeomIdZShift.push_back(
+            std::pair<CP::TGeometryId,double>(CP::GeomId::Captain::Plane(0),
+                                              2*unit::mm));
+        CP::TManager::Get().RegisterAlignmentLookup(&alignmentLookup);
+        CP::TManager::Get().GeomId().ApplyAlignment(NULL);
+
+        CP::THitSelection* moved = new CP::THitSelection("moved");
+        CP::TWritableMCHit wMoved;
+        wMoved.SetGeomId(CP::GeomId::Captain::Plane(0));
+        moved->push_back(CP::THandle<CP::THit>(new CP::TMCHit(wMoved)));
+        ensure_equals("Hit is initialized after the alignment",
+                      CP::TSingleHit::InitializeGeometry(*moved), 1);
+        ensure_distance("Aligned hit is moved",
+                        ((*moved)[0]->GetPosition()-oldPosition).Mag(),
+                        2.0*unit::mm, 0.1*unit::mm);
+        ensure_distance("Old hit is not moved",
+                        ((*hits)[0]->GetPosition()-oldPosition).Mag(),
+                        0.0, 0.01*unit::mm);
+        ensure_equals("Old volumes are kept by the old hits",
+                      CP::TSingleHit::GetVolumeCount(), volumes+1);
+
+        delete hits;
+        delete lazy;
+        ensure_equals("Old volumes are deleted with the old hits",
+                      CP::TSingleHit::GetVolumeCount(), volumes-1);
+        delete moved;
+        ensure_equals("Current volumes are kept by the cache",
+                      CP::TSingleHit::GetVolumeCount(), volumes-1);
+    }
+
 };
 #endif
@@ -0,0 +1,279 @@
+#include <cstdio>
+#include <string>
+#include <tut.h>
+
+#include <TDirectory.h>
+
+#include "TAlgorithmCache.hxx"
+#include "TAlgorithm.hxx"
+#include "TAlgorithmResult.hxx"
+#include "THitSelection.hxx"
+#include "TMCHit.hxx"
+#include "TRuntimeParameters.hxx"
+
+namespace {
+    /// An algorithm that counts the number of times it is run.  The result
+    /// has the status of the input, and refers to the drift hits of the
+    /// input.
+    class TCountAlgorithm : public CP::TAlgorithm {
+    public:
+        TCountAlgorithm(const char* name, const char* version = "v1")
+            : CP::TAlgorithm(name), fCalls(0) {
+            SetVersion(version);
+        }
+
+        CP::THandle<CP::TAlgorithmResult>
+        Process(const CP::TAlgorithmResult& input,
+                const CP::TAlgorithmResult&,
+                const CP::TAlgorithmResult&) {
+            ++fCalls;
+            CP::THandle<CP::TAlgorithmResult> result = CreateResult();
+            result->SetStatus(input.GetStatus());
+            CP::THandle<CP::THitSelection> drift = input.GetHits("drift");
+            if (drift) {
+                CP::THitSelection* hits = new CP::THitSelection("drift");
+                hits->AddHits(*drift);
+                result->AddHits(hits);
+            }
+            return result;
+        }
+
+        int fCalls;
+    };
+
+    /// A datum without a dictionary, so it can't be serialized.
+    class TUnhashableDatum : public CP::TDatum {
+    public:
+        TUnhashableDatum() : CP::TDatum("unhashable") {}
+    };
+
+    /// Make a result with a hit selection of MC hits.
+    CP::TAlgorithmResult* MakeInput(int hits, double charge) {
+        CP::THitSelection selection("drift");
+        for (int i = 0; i<hits; ++i) {
+            CP::TWritableMCHit wHit;
+            wHit.SetCharge(charge+i);
+            wHit.SetTime(10.0*i);
+            selection.push_back(
+                CP::THandle<CP::THit>(new CP::TMCHit(wHit)));
+        }
+        return new CP::TAlgorithmResult(selection);
+    }
+}
+
+namespace tut {
+    struct baseTAlgorithmCache {
+        baseTAlgorithmCache() {
+            // Run before each test.  Start each test with an empty cache.
+            std::remove("tutTAlgorithmCache.root");
+        }
+        ~baseTAlgorithmCache() {
+            // Run after each test.
+            std::remove("tutTAlgorithmCache.root");
+        }
+    };
+
+    // Declare the test
+    typedef test_group<baseTAlgorithmCache>::object testTAlgorithmCache;
+    test_group<baseTAlgorithmCache> groupTAlgorithmCache("TAlgorithmCache");
+
+    // Test that the key changes with the algorithm, the version, and the
+    // contents of the inputs.
+    template<> template<>
+    void testTAlgorithmCache::test<1> () {
+        CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+        TCountAlgorithm a("a");
+        TCountAlgorithm a2("a","v2");
+        TCountAlgorithm b("b");
+
+        CP::TAlgorithmResult* input = MakeInput(5, 1.0);
+        CP::TAlgorithmResult* same = MakeInput(5, 1.0);
+        CP::TAlgorithmResult* charge = MakeInput(5, 2.0);
+        CP::TAlgorithmResult* fewer = MakeInput(4, 1.0);
+
+        CP::TSHAHashValue key = cache.GetKey(a,*input);
+        ensure("Key is valid", key.Valid());
+        ensure_equals("Same inputs have the same key",
+                      cache.GetKey(a,*same), key);
+        ensure("Charge changes the key", cache.GetKey(a,*charge) != key);
+        ensure("Hits change the key", cache.GetKey(a,*fewer) != key);
+        ensure("Version changes the key", cache.GetKey(a2,*input) != key);
+        ensure("Algorithm changes the key", cache.GetKey(b,*input) != key);
+        ensure("Input order changes the key",
+               cache.GetKey(a,*input,*charge)
+               != cache.GetKey(a,*charge,*input));
+
+        delete input;
+        delete same;
+        delete charge;
+        delete fewer;
+    }
+
+    // Test that the key changes with the runtime parameters used by the
+    // algorithm, and not with the other parameters.
+    template<> template<>
+    void testTAlgorithmCache::test<2> () {
+        CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+        TCountAlgorithm a("a");
+        CP::TAlgorithmResult* input = MakeInput(3, 1.0);
+
+        CP::TRuntimeParameters& parameters = CP::TRuntimeParameters::Get();
+        parameters.SetOverrideParameter("tutTAlgorithmCache.a.cut","1");
+        parameters.SetOverrideParameter("tutTAlgorithmCache.b.cut","1");
+        CP::TSHAHashValue unused = cache.GetKey(a,*input);
+        cache.AddParameters(a,"tutTAlgorithmCache.a.");
+        CP::TSHAHashValue key = cache.GetKey(a,*input);
+        ensure("Parameters change the key", key != unused);
+
+        parameters.SetOverrideParameter("tutTAlgorithmCache.b.cut","2");
+        ensure_equals("Other parameters don't change the key",
+                      cache.GetKey(a,*input), key);
+
+        parameters.SetOverrideParameter("tutTAlgorithmCache.a.cut","2");
+        ensure("Changed parameter changes the key",
+               cache.GetKey(a,*input) != key);
+
+        parameters.SetOverrideParameter("tutTAlgorithmCache.a.cut","1");
+        ensure_equals("Restored parameter restores the key",
+                      cache.GetKey(a,*input), key);
+
+        delete input;
+    }
+
+    // Test that an algorithm is run when its result isn't in the cache.
+    template<> template<>
+    void testTAlgorithmCache::test<3> () {
+        CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+        TCountAlgorithm a("a");
+        CP::TAlgorithmResult* input = MakeInput(3, 1.0);
+        input->SetStatus("input");
+
+        CP::THandle<CP::TAlgorithmResult> result = cache.Process(a,*input);
+        ensure("Result is returned", result);
+        ensure_equals("Result status", result->GetStatus(),
+                      std::string("input"));
+        ensure_equals("Algorithm was run", a.fCalls, 1);
+        ensure_equals("Cache miss is counted", cache.GetMissCount(), 1);
+
+        delete input;
+    }
+
+    // Test that an algorithm with an input that can't be hashed is always
+    // run, and the result isn't saved.
+    template<> template<>
+    void testTAlgorithmCache::test<4> () {
+        CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+        TCountAlgorithm a("a");
+        CP::TAlgorithmResult* input = MakeInput(3, 1.0);
+        input->AddDatum(new TUnhashableDatum);
+
+        ensure("Key is not valid", !cache.GetKey(a,*input).Valid());
+        cache.Process(a,*input);
+        cache.Process(a,*input);
+        ensure_equals("Algorithm is always run", a.fCalls, 2);
+        ensure_equals("Cache is not used", cache.GetHitCount(), 0);
+
+        delete input;
+    }
+
+    // Test that opening the cache doesn't change the current directory.
+    template<> template<>
+    void testTAlgorithmCache::test<5> () {
+        TDirectory* current = gDirectory;
+        CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+        ensure("Current directory is kept", gDirectory == current);
+    }
+
+    // Test that running an algorithm a second time on the same input uses
+    // the cached result.
+    template<> template<>
+    void testTAlgorithmCache::test<6> () {
+        CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+        TCountAlgorithm a("a");
+        CP::TAlgorithmResult* input = MakeInput(3, 1.0);
+        input->SetStatus("input");
+
+        cache.Process(a,*input);
+        CP::THandle<CP::TAlgorithmResult> result = cache.Process(a,*input);
+        ensure("Cached result is returned", result);
+        ensure_equals("Cached result status", result->GetStatus(),
+                      std::string("input"));
+        ensure_equals("Algorithm was run once", a.fCalls, 1);
+        ensure_equals("Cache hit is counted", cache.GetHitCount(), 1);
+        ensure_equals("Cache miss is counted", cache.GetMissCount(), 1);
+
+        delete input;
+    }
+
+    // Test that a result saved in the sidecar file is found after the file
+    // is opened again.
+    template<> template<>
+    void testTAlgorithmCache::test<7> () {
+        TCountAlgorithm a("a");
+        CP::TAlgorithmResult* input = MakeInput(3, 1.0);
+        {
+            CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+            cache.Process(a,*input);
+            ensure_equals("First cache misses", cache.GetMissCount(), 1);
+        }
+        {
+            CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+            CP::THandle<CP::TAlgorithmResult> result
+                = cache.Process(a,*input);
+            ensure("Result is read from the file", result);
+            ensure_equals("Reopened cache hits", cache.GetHitCount(), 1);
+            ensure_equals("Algorithm was run once", a.fCalls, 1);
+        }
+        delete input;
+    }
+
+    // Test that the hits in a cached result are the input hits, and not
+    // copies of them.
+    template<> template<>
+    void testTAlgorithmCache::test<8> () {
+        CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+        TCountAlgorithm a("a");
+        CP::TAlgorithmResult* input = MakeInput(5, 1.0);
+        CP::THandle<CP::THitSelection> inputHits = input->GetHits("drift");
+
+        cache.Process(a,*input);
+        CP::THandle<CP::TAlgorithmResult> result = cache.Process(a,*input);
+        ensure_equals("Cache hit is counted", cache.GetHitCount(), 1);
+        CP::THandle<CP::THitSelection> hits = result->GetHits("drift");
+        ensure("Cached result has hits", hits);
+        ensure_equals("Cached hit count", hits->size(), inputHits->size());
+        for (std::size_t i = 0; i<hits->size(); ++i) {
+            ensure("Cached hit is the input hit",
+                   CP::GetPointer((*hits)[i])
+                   == CP::GetPointer((*inputHits)[i]));
+        }
+
+        delete input;
+    }
+
+    // Test that the second algorithm of a chain is found in the cache when
+    // the result of the first algorithm is read from the cache.
+    template<> template<>
+    void testTAlgorithmCache::test<9> () {
+        TCountAlgorithm a("a");
+        TCountAlgorithm b("b");
+        CP::TAlgorithmResult* input = MakeInput(5, 1.0);
+        {
+            CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+            CP::THandle<CP::TAlgorithmResult> first = cache.Process(a,*input);
+            cache.Process(b,*first);
+            ensure_equals("First pass misses", cache.GetMissCount(), 2);
+        }
+        {
+            CP::TAlgorithmCache cache("tutTAlgorithmCache.root");
+            CP::THandle<CP::TAlgorithmResult> first = cache.Process(a,*input);
+            CP::THandle<CP::TAlgorithmResult> second
+                = cache.Process(b,*first);
+            ensure("Second stage result", second);
+            ensure_equals("Second pass hits", cache.GetHitCount(), 2);
+            ensure_equals("First stage was run once", a.fCalls, 1);
+            ensure_equals("Second stage was run once", b.fCalls, 1);
+        }
+        delete input;
+    }
+};
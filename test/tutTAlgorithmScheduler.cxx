@@ -0,0 +1,215 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tut.h>
+
+#include "TAlgorithmScheduler.hxx"
+#include "TAlgorithm.hxx"
+#include "TAlgorithmResult.hxx"
+#include "TEvent.hxx"
+#include "THitSelection.hxx"
+
+namespace {
+    /// An algorithm that records the events it sees, and makes a result
+    /// with a status built from its name, the event, and the input status.
+    class TTestAlgorithm : public CP::TAlgorithm {
+    public:
+        TTestAlgorithm(const char* name)
+            : CP::TAlgorithm(name), fRendezvous(NULL), fMet(false),
+              fFail(false) {}
+
+        CP::THandle<CP::TAlgorithmResult>
+        Process(const CP::TAlgorithmResult& input,
+                const CP::TAlgorithmResult& input1,
+                const CP::TAlgorithmResult& input2) {
+            int event = GetEvent().GetEventId();
+            {
+                std::lock_guard<std::mutex> lock(fMutex);
+                fEvents.push_back(event);
+            }
+            if (fRendezvous) Meet();
+            if (fFail) throw CP::EAlgorithmWithoutEvent();
+            CP::THandle<CP::TAlgorithmResult> result = CreateResult();
+            std::ostringstream status;
+            status << GetName() << event << "[" << input.GetStatus()
+                   << "," << input1.GetStatus() << "]";
+            result->SetStatus(status.str());
+            return result;
+        }
+
+        /// Wait (for up to two seconds) for another algorithm sharing the
+        /// rendezvous to be running at the same time.
+        void Meet() {
+            ++(*fRendezvous);
+            std::chrono::steady_clock::time_point stop
+                = std::chrono::steady_clock::now()
+                + std::chrono::seconds(2);
+            while (std::chrono::steady_clock::now() < stop) {
+                if (fRendezvous->load() > 1) {
+                    fMet = true;
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        std::vector<int> fEvents;
+        std::mutex fMutex;
+        std::atomic<int>* fRendezvous;
+        bool fMet;
+        bool fFail;
+    };
+
+    /// Make an event with a hit selection named "drift".
+    CP::TEvent* MakeEvent(int id) {
+        CP::TEvent* event = new CP::TEvent(CP::TEventContext(0,1,0,id,0,0));
+        event->Get<CP::TDataVector>("hits")->push_back(
+            new CP::THitSelection("drift"));
+        return event;
+    }
+}
+
+namespace tut {
+    struct baseTAlgorithmScheduler {
+        baseTAlgorithmScheduler() {
+            // Run before each test.
+        }
+        ~baseTAlgorithmScheduler() {
+            // Run after each test.
+        }
+    };
+
+    // Declare the test
+    typedef test_group<baseTAlgorithmScheduler>::object
+    testTAlgorithmScheduler;
+    test_group<baseTAlgorithmScheduler>
+    groupTAlgorithmScheduler("TAlgorithmScheduler");
+
+    // Test that a diamond of algorithms gets the right inputs, that the
+    // independent algorithms run at the same time, and that the results are
+    // added to the event.
+    template<> template<>
+    void testTAlgorithmScheduler::test<1> () {
+        TTestAlgorithm a("a");
+        TTestAlgorithm b("b");
+        TTestAlgorithm c("c");
+        TTestAlgorithm d("d");
+        std::atomic<int> rendezvous(0);
+        b.fRendezvous = &rendezvous;
+        c.fRendezvous = &rendezvous;
+
+        CP::TAlgorithmScheduler scheduler(4);
+        scheduler.AddAlgorithm(&d, "~/fits/join", "left", "~/fits/right");
+        scheduler.AddAlgorithm(&a, "~/fits/first", "~/hits/drift");
+        scheduler.AddAlgorithm(&b, "left", "first");
+        scheduler.AddAlgorithm(&c, "~/fits/right", "~/fits/first");
+
+        CP::TEvent* event = MakeEvent(7);
+        scheduler.Process(*event);
+
+        ensure("Independent algorithms ran together", b.fMet && c.fMet);
+        ensure_equals("No events pending", scheduler.GetPendingCount(), 0);
+        CP::THandle<CP::TAlgorithmResult> join = event->GetFit("join");
+        ensure("Final result is in the event", join);
+        ensure_equals("Final result status", join->GetStatus(),
+                      std::string("d7[b7[a7[,],],c7[a7[,],]]"));
+        ensure("First result is in the event", event->GetFit("first"));
+        ensure("Left result is in the event", event->GetFit("left"));
+        ensure("Right result is in the event", event->GetFit("right"));
+        delete event;
+    }
+
+    // Test that several events can be in flight, and that each algorithm
+    // sees the events in order.
+    template<> template<>
+    void testTAlgorithmScheduler::test<2> () {
+        TTestAlgorithm a("a");
+        TTestAlgorithm b("b");
+        TTestAlgorithm c("c");
+        CP::TAlgorithmScheduler scheduler(3,3);
+        scheduler.AddAlgorithm(&a, "a", "~/hits/drift");
+        scheduler.AddAlgorithm(&b, "b", "a");
+        scheduler.AddAlgorithm(&c, "c", "b", "a");
+
+        const int events = 10;
+        int submitted = 0;
+        int finished = 0;
+        for (;;) {
+            if (submitted < events) {
+                scheduler.Submit(MakeEvent(submitted++));
+                if (!scheduler.IsFull()) continue;
+            }
+            CP::TEvent* done = scheduler.Next();
+            if (!done) break;
+            ensure_equals("Events finish in order",
+                          (int) done->GetEventId(), finished);
+            CP::THandle<CP::TAlgorithmResult> result = done->GetFit("c");
+            ensure("Last result is in the event", result);
+            std::ostringstream status;
+            status << "c" << finished << "[b" << finished
+                   << "[a" << finished << "[,],],a" << finished << "[,]]";
+            ensure_equals("Last result status",
+                          result->GetStatus(), status.str());
+            ++finished;
+            delete done;
+        }
+        ensure_equals("All events finished", finished, events);
+        TTestAlgorithm* algorithms[] = {&a, &b, &c};
+        for (int i = 0; i<3; ++i) {
+            ensure_equals("Algorithm saw every event",
+                          (int) algorithms[i]->fEvents.size(), events);
+            for (int e = 0; e<events; ++e) {
+                ensure_equals("Algorithm saw the events in order",
+                              algorithms[i]->fEvents[e], e);
+            }
+        }
+    }
+
+    // Test that the algorithms depending on a failed algorithm, or on a
+    // missing input, are skipped, and that cycles are found.
+    template<> template<>
+    void testTAlgorithmScheduler::test<3> () {
+        {
+            TTestAlgorithm a("a");
+            TTestAlgorithm b("b");
+            TTestAlgorithm c("c");
+            TTestAlgorithm d("d");
+            a.fFail = true;
+            CP::TAlgorithmScheduler scheduler(2);
+            scheduler.AddAlgorithm(&a, "a", "~/hits/drift");
+            scheduler.AddAlgorithm(&b, "b", "a");
+            scheduler.AddAlgorithm(&c, "c", "~/hits/missing");
+            scheduler.AddAlgorithm(&d, "d", "~/hits/drift");
+            CP::TEvent* event = MakeEvent(1);
+            scheduler.Process(*event);
+            ensure("Failed algorithm has no result", !event->GetFit("a"));
+            ensure("Dependent algorithm has no result", !event->GetFit("b"));
+            ensure("Dependent algorithm was not run", b.fEvents.empty());
+            ensure("Algorithm without input was not run", c.fEvents.empty());
+            ensure("Independent algorithm has a result", event->GetFit("d"));
+            delete event;
+        }
+
+        TTestAlgorithm a("a");
+        TTestAlgorithm b("b");
+        CP::TAlgorithmScheduler scheduler(1);
+        scheduler.AddAlgorithm(&a, "a", "b");
+        scheduler.AddAlgorithm(&b, "b", "a");
+        CP::TEvent* event = MakeEvent(2);
+        bool found = false;
+        try {
+            scheduler.Submit(event);
+        }
+        catch (CP::EAlgorithmCycle&) {
+            found = true;
+        }
+        ensure("Cycle is found", found);
+        ensure_equals("Event is not in flight",
+                      scheduler.GetPendingCount(), 0);
+        delete event;
+    }
+};
@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <tut.h>
+
+#include "TBinaryLog.hxx"
+
+namespace tut {
+    struct baseTBinaryLog {
+        baseTBinaryLog() {
+            // Run before each test.
+            CP::TBinaryLog::Open("tutTBinaryLog.dump",16);
+        }
+        ~baseTBinaryLog() {
+            // Run after each test.
+            CP::TBinaryLog::Close();
+            std::remove("tutTBinaryLog.dump");
+        }
+
+        /// Dump the ring and decode it into lines.
+        std::vector<std::string> DecodeRing() {
+            std::vector<std::string> lines;
+            ensure("Ring is dumped", CP::TBinaryLog::Dump());
+            std::ifstream input("tutTBinaryLog.dump",
+                                std::ios::in|std::ios::binary);
+            std::ostringstream output;
+            ensure("Dump is decoded", CP::TBinaryLog::Decode(input,output));
+            std::istringstream text(output.str());
+            std::string line;
+            while (std::getline(text,line)) lines.push_back(line);
+            return lines;
+        }
+    };
+
+    // Declare the test
+    typedef test_group<baseTBinaryLog>::object testTBinaryLog;
+    test_group<baseTBinaryLog> groupTBinaryLog("TBinaryLog");
+
+    // Test that the arguments are recorded and decoded.
+    template<> template<>
+    void testTBinaryLog::test<1> () {
+        std::string name("volume");
+        CaptBinaryDebug("{} {} at {} {}", name, -42, 2.5, true);
+        CaptBinaryWarn("unsigned {} char {}", 7u, 'x');
+        CaptBinaryTrace("NOT RECORDED {}", 1);
+        std::vector<std::string> lines = DecodeRing();
+        ensure("Messages are decoded", lines.size() >= 2);
+        std::string debug = lines[lines.size()-2];
+        std::string warn = lines[lines.size()-1];
+        ensure("Debug message is decoded",
+               debug.find("DEBUG: ") != std::string::npos
+               && debug.find(": volume -42 at 2.5 true")
+               != std::string::npos);
+        ensure("Warning message is decoded",
+               warn.find("WARNING: ") != std::string::npos
+               && warn.find(": unsigned 7 char x") != std::string::npos);
+    }
+
+    // Test that the ring keeps the most recent messages, and that long
+    // strings are truncated.
+    template<> template<>
+    void testTBinaryLog::test<2> () {
+        std::string longString(100,'a');
+        for (int i=0; i<40; ++i) {
+            CaptBinaryDebug("message {} {}", i, longString);
+        }
+        std::vector<std::string> lines = DecodeRing();
+        ensure_equals("Ring size plus overwrite note",
+                      lines.size(), (std::size_t) 17);
+        ensure("Overwritten messages are noted",
+               lines[0].find("earlier messages were overwritten")
+               != std::string::npos);
+        ensure("First kept message", lines[1].find(": message 24 a")
+               != std::string::npos);
+        ensure("Last message", lines[16].find(": message 39 a")
+               != std::string::npos);
+        ensure("String is truncated",
+               lines[16].find(longString) == std::string::npos);
+    }
+
+    // Test that messages aren't recorded when the log is closed.
+    template<> template<>
+    void testTBinaryLog::test<3> () {
+        CaptBinaryDebug("before close");
+        CP::TBinaryLog::Close();
+        ensure_equals("Closed log level", CP::TBinaryLog::GetLevel(),
+                      CP::TCaptLog::SilentLevel);
+        CaptBinarySevere("NOT RECORDED");
+        std::vector<std::string> lines = DecodeRing();
+        ensure("Last message before close",
+               lines.back().find(": before close") != std::string::npos);
+    }
+
+    // Test that the arguments after one that doesn't fit are dropped, and
+    // that pointers are saved as addresses.
+    template<> template<>
+    void testTBinaryLog::test<4> () {
+        double big = 1.5;
+        CaptBinaryDebug("{} {} {} {} {} {}", 1, 2, 3, 4, 5, 'Q');
+        CaptBinaryDebug("pointer {} flag {}", &big, false);
+        std::vector<std::string> lines = DecodeRing();
+        ensure("Messages are decoded", lines.size() >= 2);
+        std::string dropped = lines[lines.size()-2];
+        std::string pointer = lines[lines.size()-1];
+        ensure("Arguments that fit are kept",
+               dropped.find(": 1 2 3 4 ...") != std::string::npos);
+        ensure("Arguments after a dropped one are not kept",
+               dropped.find(" Q") == std::string::npos);
+        std::ostringstream address;
+        address << ": pointer 0x" << std::hex
+                << reinterpret_cast<std::uintptr_t>(&big) << " flag false";
+        ensure("Pointer is saved as an address",
+               pointer.find(address.str()) != std::string::npos);
+    }
+};
@@ -0,0 +1,157 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tut.h>
+
+#include "TCaptLog.hxx"
+
+namespace tut {
+    struct baseTCaptLog {
+        baseTCaptLog() {
+            // Run before each test.
+            fLevel = CP::TCaptLog::GetLogLevel();
+            CP::TCaptLog::SetLogLevel(CP::TCaptLog::LogLevel);
+            CP::TCaptLog::SetLogStream(&fOutput);
+        }
+        ~baseTCaptLog() {
+            // Run after each test.
+            CP::TCaptLog::SetAsynchronous(false);
+            CP::TCaptLog::SetLogStream(NULL);
+            CP::TCaptLog::SetLogLevel(fLevel);
+        }
+
+        /// Write messages from several threads at once.  Each message is
+        /// formatted in several pieces.
+        void WriteFromThreads(int threadCount, int messageCount) {
+            std::vector<std::thread> threads;
+            for (int t=0; t<threadCount; ++t) {
+                threads.push_back(std::thread([t, messageCount] () {
+                            for (int i=0; i<messageCount; ++i) {
+                                CaptLog("thread " << t << " message " << i
+                                        << " end");
+                            }
+                        }));
+            }
+            for (std::size_t t=0; t<threads.size(); ++t) threads[t].join();
+        }
+
+        /// Check that the messages written by WriteFromThreads are complete
+        /// and in order for each thread.
+        void CheckMessages(int threadCount, int messageCount) {
+            std::vector<int> next(threadCount,0);
+            std::istringstream input(fOutput.str());
+            std::string line;
+            while (std::getline(input,line)) {
+                if (line.compare(0,2,"% ") != 0) continue;
+                std::istringstream words(line.substr(2));
+                std::string thread, message, end;
+                int t = -1;
+                int i = -1;
+                words >> thread >> t >> message >> i >> end;
+                ensure_equals("Message is complete", end, std::string("end"));
+                ensure("Thread is valid", 0 <= t && t < threadCount);
+                ensure_equals("Message is in order", i, next[t]);
+                ++next[t];
+            }
+            for (int t=0; t<threadCount; ++t) {
+                ensure_equals("All messages written", next[t], messageCount);
+            }
+        }
+
+        std::ostringstream fOutput;
+        CP::TCaptLog::LogPriority fLevel;
+    };
+
+    // Declare the test
+    typedef test_group<baseTCaptLog>::object testTCaptLog;
+    test_group<baseTCaptLog> groupTCaptLog("TCaptLog");
+
+    // Test that messages from several threads are not mixed together.
+    template<> template<>
+    void testTCaptLog::test<1> () {
+        WriteFromThreads(4,500);
+        CheckMessages(4,500);
+    }
+
+    // Test that the asynchronous output writes all of the messages.
+    template<> template<>
+    void testTCaptLog::test<2> () {
+        CP::TCaptLog::SetAsynchronous(true);
+        ensure("Output is asynchronous", CP::TCaptLog::IsAsynchronous());
+        WriteFromThreads(4,500);
+        CP::TCaptLog::Flush();
+        CheckMessages(4,500);
+
+        // Messages queued when the output is stopped are still written.
+        fOutput.str("");
+        CaptLog("thread 0 message 0 end");
+        CP::TCaptLog::SetAsynchronous(false);
+        ensure("Output is synchronous", !CP::TCaptLog::IsAsynchronous());
+        CaptLog("thread 0 message 1 end");
+        CheckMessages(1,2);
+    }
+
+    /// Write a message while another message is being formatted.
+    std::string NestedMessage() {
+        CaptLog("inner");
+        return "outer";
+    }
+
+    // Test a message written while another message is being formatted, and
+    // that the format of one message doesn't leak into the next.
+    template<> template<>
+    void testTCaptLog::test<3> () {
+        CaptLog(std::hex << 255 << " " << NestedMessage());
+        CaptLog(255);
+        ensure_equals("Nested messages written",
+                      fOutput.str().substr(fOutput.str().find("% ")),
+                      std::string("% inner\n% ff outer\n% 255\n"));
+    }
+
+    /// Write a named message from a single call site.
+    void NamedMessage(int i) {
+        CaptNamedInfo("tutTCaptLog","named " << i);
+    }
+
+    // Test that the cached level of a named macro follows changes to the
+    // trace level and the default level.
+    template<> template<>
+    void testTCaptLog::test<4> () {
+        NamedMessage(0);
+        CP::TCaptLog::SetLogLevel("tutTCaptLog",CP::TCaptLog::InfoLevel);
+        NamedMessage(1);
+        CP::TCaptLog::SetLogLevel("tutTCaptLog",CP::TCaptLog::LogLevel);
+        NamedMessage(2);
+        CP::TCaptLog::SetLogLevel("otherTrace",CP::TCaptLog::InfoLevel);
+        NamedMessage(3);
+        CP::TCaptLog::SetLogLevel("tutTCaptLog",CP::TCaptLog::InfoLevel);
+        NamedMessage(4);
+        ensure_equals("Named messages written",
+                      fOutput.str().substr(fOutput.str().find("%% ")),
+                      std::string("%% [tutTCaptLog] named 1\n"
+                                  "%% [tutTCaptLog] named 4\n"));
+        CP::TCaptLog::SetLogLevel("tutTCaptLog",CP::TCaptLog::LogLevel);
+    }
+
+    /// Write a message with a trace that doesn't have a level.
+    void DefaultMessage(int i) {
+        CaptNamedInfo("tutDefault","default " << i);
+    }
+
+    // Test that the cached level of a named macro follows changes to the
+    // default level.
+    template<> template<>
+    void testTCaptLog::test<5> () {
+        DefaultMessage(0);
+        CP::TCaptLog::SetLogLevel(CP::TCaptLog::InfoLevel);
+        DefaultMessage(1);
+        CP::TCaptLog::SetLogLevel(CP::TCaptLog::LogLevel);
+        DefaultMessage(2);
+        ensure_equals("Default messages written",
+                      fOutput.str().substr(fOutput.str().find("%% ")),
+                      std::string("%% [tutDefault] default 1\n"));
+    }
+
+};
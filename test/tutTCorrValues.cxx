@@ -381,4 +381,67 @@ namespace tut {
     }
 
 
+    /// Test the Hessian for the sizes that use the fast inversion and the
+    /// general inversion, and that the cached Hessian is updated.
+    template<> template<>
+    void testTCorrValues::test<15> () {
+        int sizes[] = {1, 3, 10, 12};
+        for (int s = 0; s < 4; ++s) {
+            int dim = sizes[s];
+            CP::TCorrValues u(dim+2);
+            for (int i=0; i<dim; ++i) {
+                for (int j=0; j<dim; ++j) {
+                    double cov = std::pow(0.5,std::abs(i-j))*(i+1)*(j+1);
+                    u.SetCovarianceValue(i,j,cov);
+                }
+            }
+            u.SetFree(dim);
+            u.SetFixed(dim+1);
+            const TMatrixTSym<float>& hessian = u.GetHessian();
+            for (int i=0; i<dim; ++i) {
+                for (int j=0; j<dim; ++j) {
+                    double prod = 0.0;
+                    for (int k=0; k<dim; ++k) {
+                        prod += hessian(i,k)*u.GetCovarianceValue(k,j);
+                    }
+                    ensure_distance("Hessian is the covariance inverse",
+                                    prod, (i==j) ? 1.0 : 0.0, 1E-4);
+                }
+                ensure_distance("Free parameter is not correlated",
+                                hessian(i,dim), 0.0, 1E-10);
+                ensure_distance("Fixed parameter is not correlated",
+                                hessian(i,dim+1), 0.0, 1E-10);
+            }
+            ensure_distance("Free parameter Hessian",
+                            hessian(dim,dim)*CP::TCorrValues::kFreeValue,
+                            1.0, 1E-5);
+        }
+
+        // The cached Hessian is updated when the covariance changes.
+        CP::TCorrValues v(2);
+        v.SetCovarianceValue(0,0,4.0);
+        v.SetCovarianceValue(1,1,1.0);
+        ensure_distance("Initial Hessian", v.GetHessian()(0,0), 0.25, 1E-6);
+        v.SetCovarianceValue(0,0,2.0);
+        ensure_distance("Updated Hessian", v.GetHessian()(0,0), 0.5, 1E-6);
+        CP::TCorrValues w(2);
+        w.GetHessian();
+        w = v;
+        ensure_distance("Assigned Hessian", w.GetHessian()(0,0), 0.5, 1E-6);
+        v.SetFixed(0);
+        ensure_distance("Fixed Hessian",
+                        v.GetHessian()(0,0)*CP::TCorrValues::kFixedValue,
+                        1.0, 1E-5);
+
+        // A covariance that isn't positive definite uses the general
+        // inversion.
+        CP::TCorrValues x(2);
+        x.SetCovarianceValue(0,0,1.0);
+        x.SetCovarianceValue(1,1,1.0);
+        x.SetCovarianceValue(0,1,2.0);
+        ensure_distance("Indefinite Hessian diagonal",
+                        x.GetHessian()(0,0), -1.0/3.0, 1E-6);
+        ensure_distance("Indefinite Hessian off-diagonal",
+                        x.GetHessian()(0,1), 2.0/3.0, 1E-6);
+    }
 };
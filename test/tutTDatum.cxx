@@ -9,6 +9,7 @@
 #include "TDataVector.hxx"
 #include "TDataSymLink.hxx"
 #include "TRealDatum.hxx"
+#include "TDatumPath.hxx"
 
 namespace tut {
 
@@ -41,6 +42,30 @@ namespace tut {
             // Run after each test.
             delete fVector;
         }
+
+        /// Find a datum by checking every element (from last to first, so
+        /// the temporary objects are checked first).  This is used to check
+        /// TDataVector::FindDatum.
+        CP::TDatum* LinearFind(CP::TDataVector& vector, const char* name) {
+            CP::TDatumCompareName compare(name);
+            for (CP::TDataVector::reverse_iterator v = vector.rbegin(); 
+                 v != vector.rend(); ++v) {
+                if (compare(*v)) return *v;
+            }
+            return NULL;
+        }
+
+        /// Check that FindDatum agrees with LinearFind for names "n0" to
+        /// "n9" and a name that doesn't exist.
+        void CheckFind(CP::TDataVector& vector, const std::string& what) {
+            for (int i=0; i<11; ++i) {
+                std::ostringstream name;
+                name << "n" << i;
+                ensure(what + ": Found " + name.str(),
+                       vector.FindDatum(name.str().c_str())
+                       == LinearFind(vector,name.str().c_str()));
+            }
+        }
         
     };
 
@@ -505,4 +530,149 @@ namespace tut {
         ++v;
         ensure("Element is end",v == vector->rend());
     }
+
+    // Test that a TDatumPath finds the same objects as a string name.
+    template <> template <>
+    void testTDatum::test<27> () {
+        CP::THandle<CP::TDatum> start
+            = fVector->Get<CP::TDatum>("child.2/child.2.3");
+        const char* names[] = {
+            "", ".", "..", "../child.2.2", "../../child.1/child.1.4",
+            "~/", "~/child.3/child.3.2", "//", "//parent",
+            "//parent/child.3/child.3.2", "//other/child.3",
+            "/child.2/child.2.2", "/parent/child.4", "~/child.9",
+            "~/child.3/./child.3.1", ".x", NULL};
+        for (int i=0; names[i]; ++i) {
+            CP::TDatumPath path(names[i]);
+            CP::THandle<CP::TDatum> expected
+                = start->Get<CP::TDatum>(names[i]);
+            CP::THandle<CP::TDatum> found = start->Get<CP::TDatum>(path);
+            ensure(std::string("Path found expected object: ") + names[i],
+                   GetPointer(expected) == GetPointer(found));
+            found = start->Get<CP::TDatum>(path);
+            ensure(std::string("Cached path found expected object: ")
+                   + names[i],
+                   GetPointer(expected) == GetPointer(found));
+        }
+        CP::TDatumPath bad("~child.3");
+        try {
+            start->Get<CP::TDatum>(bad);
+            fail("Illegal path should throw");
+        }
+        catch (CP::EBadName&) {}
+    }
+
+    // Test that a cached TDatumPath notices when the tree changes.
+    template <> template <>
+    void testTDatum::test<28> () {
+        CP::TDatumPath path("~/child.1/extra");
+        CP::THandle<CP::TDatum> start = fVector->Get<CP::TDatum>("child.0");
+        ensure("Missing object not found", !start->Get<CP::TDatum>(path));
+
+        CP::THandle<CP::TDataVector> child
+            = fVector->Get<CP::TDataVector>("child.1");
+        CP::TDatum* extra = new CP::TDatum("extra");
+        child->AddDatum(extra);
+        ensure("New object is found",
+               GetPointer(start->Get<CP::TDatum>(path)) == extra);
+
+        CP::TDatum* temporary = new CP::TDatum("extra");
+        child->AddTemporary(temporary);
+        ensure("Temporary object is found",
+               GetPointer(start->Get<CP::TDatum>(path)) == temporary);
+
+        temporary->SetName("renamed");
+        ensure("Renamed temporary is not found",
+               GetPointer(start->Get<CP::TDatum>(path)) == extra);
+
+        child->erase(extra);
+        delete extra;
+        ensure("Erased object is not found", !start->Get<CP::TDatum>(path));
+        ensure("Has works with a path", !start->Has<CP::TDatum>(path));
+    }
+
+    // Test that the name index in a large TDataVector finds the last object
+    // added with a name as the vector is changed.
+    template <> template <>
+    void testTDatum::test<29> () {
+        CP::TDataVector vector("indexed");
+        for (int i=0; i<40; ++i) {
+            std::ostringstream name;
+            name << "n" << i%10;
+            vector.push_back(new CP::TDatum(name.str().c_str()));
+        }
+        CheckFind(vector,"Main storage");
+
+        vector.AddTemporary(new CP::TDatum("n3"));
+        vector.AddTemporary(new CP::TDatum("n3"));
+        vector.AddTemporary(new CP::TDatum("n4"));
+        CheckFind(vector,"Temporary storage");
+
+        CP::TDatum* last = vector.FindDatum("n3");
+        vector.erase(last);
+        delete last;
+        CheckFind(vector,"Erase last temporary");
+
+        last = vector.FindDatum("n5");
+        vector.erase(last);
+        delete last;
+        CheckFind(vector,"Erase last object");
+
+        CP::TDatum* only = new CP::TDatum("n10");
+        vector.insert(vector.begin(),only);
+        ensure("Inserted object found", vector.FindDatum("n10") == only);
+        CheckFind(vector,"Insert new name");
+
+        vector.insert(vector.begin(),new CP::TDatum("n7"));
+        CheckFind(vector,"Insert existing name");
+
+        vector.push_back(new CP::TDatum("n7"));
+        CheckFind(vector,"Push back existing name");
+
+        vector.FindDatum("n1")->SetName("n2");
+        CheckFind(vector,"Renamed object");
+
+        while (vector.size() > 20) {
+            CP::TDatum* element = vector[20];
+            vector.erase(element);
+            delete element;
+        }
+        CheckFind(vector,"Erase several objects");
+    }
+
+    // Test that the generation is kept separately for each tree, and only
+    // changes when the tree changes.
+    template <> template <>
+    void testTDatum::test<30> () {
+        CP::TDataVector first("first");
+        CP::TDataVector second("second");
+        CP::TDatum* child = new CP::TDatum("child");
+        first.AddDatum(child);
+        ensure("Trees have different generations",
+               first.GetGeneration() != second.GetGeneration());
+        ensure_equals("Child has the generation of the root",
+                      child->GetGeneration(), first.GetGeneration());
+
+        unsigned long generation = first.GetGeneration();
+        second.AddDatum(new CP::TDatum("other"));
+        ensure_equals("Other tree doesn't change the generation",
+                      first.GetGeneration(), generation);
+
+        child->SetName("renamed");
+        ensure("Rename changes the generation",
+               first.GetGeneration() != generation);
+
+        generation = first.GetGeneration();
+        unsigned long secondGeneration = second.GetGeneration();
+        first.erase(child);
+        ensure("Removing changes the generation",
+               first.GetGeneration() != generation);
+        ensure("Removed datum has a new generation",
+               child->GetGeneration() != first.GetGeneration());
+        second.AddDatum(child);
+        ensure("Adding changes the generation",
+               second.GetGeneration() != secondGeneration);
+        ensure_equals("Moved child has the generation of the new root",
+                      child->GetGeneration(), second.GetGeneration());
+    }
 };
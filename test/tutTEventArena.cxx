@@ -0,0 +1,87 @@
+#include <tut.h>
+
+#include "TEventArena.hxx"
+#include "TReconCluster.hxx"
+#include "THitSelection.hxx"
+#include "THandleHack.hxx"
+
+namespace tut {
+    struct baseTEventArena {
+        baseTEventArena() {
+            // Run before each test.
+        }
+        ~baseTEventArena() {
+            // Run after each test.
+        }
+    };
+
+    // Declare the test
+    typedef test_group<baseTEventArena>::object testTEventArena;
+    test_group<baseTEventArena> groupTEventArena("TEventArena");
+
+    // Test that objects are allocated from the arena only while it's
+    // current, and that the blocks are reused after everything is deleted.
+    template<> template<>
+    void testTEventArena::test<1> () {
+        {
+            CP::TEventArena arena(64*1024);
+            ensure("No current arena", !CP::TEventArena::GetCurrent());
+            {
+                CP::TEventArena::TScope scope(&arena);
+                ensure("Arena is current",
+                       CP::TEventArena::GetCurrent() == &arena);
+                CP::THandle<CP::TReconCluster> cluster(
+                    new CP::TReconCluster);
+                CP::THandle<CP::THitSelection> hits(
+                    new CP::THitSelection);
+                // At least the cluster, the hit selection, and the handle
+                // bases (the cluster also creates a state).
+                ensure("Objects allocated from the arena",
+                       arena.GetLiveCount() >= 4);
+                ensure("Bytes allocated", arena.GetAllocatedBytes() > 0);
+            }
+            ensure("Arena is not current", !CP::TEventArena::GetCurrent());
+            ensure_equals("Objects deleted", arena.GetLiveCount(), 0);
+
+            CP::THandle<CP::TReconCluster> heap(new CP::TReconCluster);
+            ensure_equals("Heap object not in the arena",
+                          arena.GetLiveCount(), 0);
+
+            arena.Reset();
+            ensure_equals("Blocks are reused", arena.GetAbandonedCount(), 0);
+            ensure_equals("Allocation count reset",
+                          arena.GetAllocatedBytes(), (unsigned) 0);
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+
+    // Test that an object surviving past the end of the event stays valid.
+    template<> template<>
+    void testTEventArena::test<2> () {
+        {
+            CP::THandle<CP::TReconCluster> survivor;
+            {
+                CP::TEventArena arena(64*1024);
+                {
+                    CP::TEventArena::TScope scope(&arena);
+                    survivor = CP::THandle<CP::TReconCluster>(
+                        new CP::TReconCluster);
+                    survivor->SetAlgorithmName("survivor");
+                    for (int i=0; i<1000; ++i) {
+                        CP::THandle<CP::TReconCluster> tmp(
+                            new CP::TReconCluster);
+                    }
+                }
+                arena.Reset();
+                ensure_equals("Blocks are abandoned",
+                              arena.GetAbandonedCount(), 1);
+                ensure_equals("New blocks are empty",
+                              arena.GetLiveCount(), 0);
+            }
+            ensure_equals("Survivor is valid after the arena is deleted",
+                          survivor->GetAlgorithmName(),
+                          std::string("survivor"));
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+};
@@ -0,0 +1,81 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <tut.h>
+
+#include "TEventProfiler.hxx"
+
+namespace tut {
+    struct baseTEventProfiler {
+        baseTEventProfiler() {
+            // Run before each test.
+        }
+        ~baseTEventProfiler() {
+            // Run after each test.
+        }
+    };
+
+    // Declare the test
+    typedef test_group<baseTEventProfiler>::object testTEventProfiler;
+    test_group<baseTEventProfiler> groupTEventProfiler("TEventProfiler");
+
+    // Test that the time and the allocations for an event are recorded.
+    template<> template<>
+    void testTEventProfiler::test<1> () {
+        CP::TEventProfiler profiler;
+        profiler.Enable();
+        profiler.Mark();
+        {
+            CP::TEventProfiler::TTimer timer("tutStage");
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            for (int i=0; i<100; ++i) delete new std::vector<int>(10);
+        }
+        profiler.LogEvent(1,2);
+        profiler.LogEvent(1,3);
+
+        ensure_equals("Two events recorded",
+                      profiler.GetEvents().size(), (std::size_t) 2);
+        const CP::TEventProfiler::TEventRecord& first
+            = profiler.GetEvents()[0];
+        int stage = CP::TEventProfiler::GetStage("tutStage");
+        ensure_equals("Stage name", CP::TEventProfiler::GetStageName(stage),
+                      std::string("tutStage"));
+        ensure_equals("Run recorded", first.fRun, 1);
+        ensure_equals("Event recorded", first.fEvent, 2);
+        ensure("Wall time recorded", first.fWallTime >= 0.02);
+        ensure("Stage time recorded", first.fStageTimes[stage] >= 0.02);
+        ensure("Stage time is inside the wall time",
+               first.fStageTimes[stage] <= first.fWallTime);
+        if (CP::TEventProfiler::IsCountingAllocations()) {
+            ensure("Allocations counted", first.fAllocations >= 200);
+            ensure("Allocated bytes counted",
+                   first.fAllocatedBytes >= 100*10*(long long) sizeof(int));
+        }
+        else {
+            ensure_equals("Allocations not available",
+                          first.fAllocations, -1LL);
+            ensure_equals("Allocated bytes not available",
+                          first.fAllocatedBytes, -1LL);
+        }
+        ensure_equals("Second event has no stage time",
+                      profiler.GetEvents()[1].fStageTimes[stage], 0.0);
+    }
+
+    // Test that nothing is recorded when the profiler isn't enabled.
+    template<> template<>
+    void testTEventProfiler::test<2> () {
+        CP::TEventProfiler profiler;
+        profiler.Mark();
+        {
+            CP::TEventProfiler::TTimer timer("tutDisabledStage");
+        }
+        profiler.LogEvent(1,2);
+        ensure("No events recorded", profiler.GetEvents().empty());
+        int stages = CP::TEventProfiler::GetStageCount();
+        for (int i=0; i<stages; ++i) {
+            ensure("Disabled stage not created",
+                   CP::TEventProfiler::GetStageName(i)
+                   != "tutDisabledStage");
+        }
+    }
+};
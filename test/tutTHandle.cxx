@@ -1,4 +1,7 @@
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 #include <tut.h>
 
 #include "THit.hxx"
@@ -310,4 +313,62 @@ namespace tut {
         ensure("Handle Registry is clean", CP::CleanHandleRegistry());
     }
 
+    // Test that handles to the same object can be copied and destroyed on
+    // several threads at once.
+    template <> template <>
+    void testTHandle::test<11> () {
+        {
+            CP::THandle<CP::THit> a(CanDelete());
+            CP::THandle<CP::THit> weak(a); weak.MakeWeak();
+            std::vector<std::thread> threads;
+            for (int t=0; t<4; ++t) {
+                threads.push_back(std::thread([a] () {
+                            for (int i=0; i<10000; ++i) {
+                                CP::THandle<CP::THit> copy(a);
+                                CP::THandle<CP::THit> weakCopy(copy);
+                                weakCopy.MakeWeak();
+                            }
+                        }));
+            }
+            for (std::size_t t=0; t<threads.size(); ++t) threads[t].join();
+            ensure("Weak handle is valid after threads", weak);
+            a = CP::THandle<CP::THit>();
+            ensure("Weak handle is reset", !weak);
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+
+    // Test that the handle registry sees handles that survive past an
+    // event boundary when every allocation is recorded.
+    template <> template <>
+    void testTHandle::test<12> () {
+        int period = CP::GetHandleSamplingPeriod();
+        CP::SetHandleSamplingPeriod(1);
+        ensure_equals("Sampling period set", CP::GetHandleSamplingPeriod(), 1);
+        CP::CleanHandleRegistry();
+        {
+            CP::THandle<CP::THit> survivor(CanDelete());
+            ensure("Surviving handle is seen", !CP::CleanHandleRegistry());
+            std::vector<std::string> site
+                = CP::GetHandleAllocationSite(survivor);
+            ensure("Sampled allocation site is recorded", !site.empty());
+            CP::THandle<CP::THit> copy(survivor);
+            ensure("Copy shares the allocation site",
+                   CP::GetHandleAllocationSite(copy) == site);
+            CP::DumpHandleRegistry();
+        }
+        ensure("Deleted handle is seen", !CP::CleanHandleRegistry());
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+        CP::SetHandleSamplingPeriod(0);
+        {
+            CP::THandle<CP::THit> unsampled(CanDelete());
+            ensure("Unsampled allocation site is not recorded",
+                   CP::GetHandleAllocationSite(unsampled).empty());
+        }
+        ensure("Empty handle has no allocation site",
+               CP::GetHandleAllocationSite(CP::THandle<CP::THit>()).empty());
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+        CP::SetHandleSamplingPeriod(period);
+    }
+
 };
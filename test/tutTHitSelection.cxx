@@ -0,0 +1,378 @@
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <tut.h>
+
+#include "THitSelection.hxx"
+#include "THitSelectionView.hxx"
+#include "TMCHit.hxx"
+#include "THandleHack.hxx"
+
+#include "TTestHit.hxx"
+
+namespace tut {
+    struct baseTHitSelection {
+        baseTHitSelection() {
+            // Run before each test.
+        }
+        ~baseTHitSelection() {
+            // Run after each test.
+        }
+
+        /// Make a selection with "count" new hits.  The charge is set to the
+        /// index of the hit.
+        void MakeHits(CP::THitSelection& hits, int count) {
+            CP::TWritableMCHit wHit;
+            for (int i=0; i<count; ++i) {
+                wHit.SetCharge(i);
+                hits.push_back(CP::THandle<CP::THit>(new CP::TMCHit(wHit)));
+            }
+        }
+    };
+
+    // Declare the test
+    typedef test_group<baseTHitSelection>::object testTHitSelection;
+    test_group<baseTHitSelection> groupTHitSelection("THitSelection");
+
+    // Test AddHit and RemoveHit for small selections that don't use the
+    // membership index.
+    template<> template<>
+    void testTHitSelection::test<1> () {
+        {
+            CP::THitSelection hits;
+            MakeHits(hits,5);
+            ensure_equals("Hits created", hits.size(), (unsigned) 5);
+            hits.AddHit(hits[2]);
+            ensure_equals("Duplicate hit not added",
+                          hits.size(), (unsigned) 5);
+            CP::THandle<CP::THit> hit = hits[3];
+            hits.RemoveHit(hit);
+            ensure_equals("Hit removed", hits.size(), (unsigned) 4);
+            ensure("Removed hit not contained", !hits.Contains(hit));
+            hits.AddHit(hit);
+            ensure_equals("Removed hit added back",
+                          hits.size(), (unsigned) 5);
+            ensure("Added hit is contained", hits.Contains(hit));
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+
+    // Test AddHit and RemoveHit for large selections that use the membership
+    // index, including hits appended with push_back after the index is
+    // built.
+    template<> template<>
+    void testTHitSelection::test<2> () {
+        {
+            CP::THitSelection hits;
+            MakeHits(hits,100);
+            for (std::size_t i=0; i<hits.size(); i += 3) {
+                hits.AddHit(hits[i]);
+            }
+            ensure_equals("Duplicate hits not added",
+                          hits.size(), (unsigned) 100);
+
+            CP::THitSelection more;
+            MakeHits(more,10);
+            std::copy(more.begin(), more.end(), std::back_inserter(hits));
+            for (std::size_t i=0; i<more.size(); ++i) {
+                ensure("Appended hit is contained", hits.Contains(more[i]));
+                hits.AddHit(more[i]);
+            }
+            ensure_equals("Appended hits not added twice",
+                          hits.size(), (unsigned) 110);
+
+            CP::THandle<CP::THit> hit = hits[50];
+            hits.RemoveHit(hit);
+            ensure("Removed hit not contained", !hits.Contains(hit));
+            ensure_equals("Hit removed", hits.size(), (unsigned) 109);
+
+            hits.erase(hits.begin());
+            ensure_equals("Hit erased", hits.size(), (unsigned) 108);
+            ensure("First hit is still contained", hits.Contains(hits[0]));
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+
+    // Test the set operations.
+    template<> template<>
+    void testTHitSelection::test<3> () {
+        {
+            CP::THitSelection all;
+            MakeHits(all,60);
+
+            CP::THitSelection first;
+            std::copy(all.begin(), all.begin()+40, std::back_inserter(first));
+            CP::THitSelection second;
+            std::copy(all.begin()+20, all.end(), std::back_inserter(second));
+
+            CP::THitSelection both(first);
+            both.AddHits(second);
+            ensure_equals("Union size", both.size(), all.size());
+            for (std::size_t i=0; i<all.size(); ++i) {
+                ensure("Union order is preserved", both[i] == all[i]);
+            }
+
+            CP::THitSelection common(first);
+            common.RetainHits(second);
+            ensure_equals("Intersection size", common.size(), (unsigned) 20);
+            ensure("Intersection starts with first common hit",
+                   common.front() == all[20]);
+            ensure("Intersection ends with last common hit",
+                   common.back() == all[39]);
+
+            CP::THitSelection diff(first);
+            diff.RemoveHits(second);
+            ensure_equals("Difference size", diff.size(), (unsigned) 20);
+            ensure("Difference starts with first hit",
+                   diff.front() == all[0]);
+            ensure("Difference doesn't contain removed hit",
+                   !diff.Contains(all[20]));
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+
+    // Test the geometry id queries on a THitSelectionView.
+    template<> template<>
+    void testTHitSelection::test<4> () {
+        {
+            CP::THitSelection hits;
+            for (int i=0; i<20; ++i) {
+                hits.push_back(
+                    CP::THandle<CP::THit>(new CP::TTestHit(100-i,i,i+1)));
+            }
+            hits.push_back(CP::THandle<CP::THit>(new CP::TTestHit(90,50,51)));
+            CP::THitSelectionView view(hits);
+            ensure_equals("View size", view.size(), hits.size());
+
+            CP::THitSelectionView::Hits found;
+            ensure_equals("Geometry id range",
+                          view.GetGeomIdRange(CP::TGeometryId(85),
+                                              CP::TGeometryId(89),
+                                              found),
+                          (unsigned) 5);
+            ensure("Range is sorted by id",
+                   found.front()->GetGeomId() == CP::TGeometryId(85));
+            found.clear();
+            ensure_equals("Hits with geometry id",
+                          view.GetGeomIdHits(CP::TGeometryId(90),found),
+                          (unsigned) 2);
+            found.clear();
+            ensure_equals("Empty geometry id range",
+                          view.GetGeomIdRange(CP::TGeometryId(200),
+                                              CP::TGeometryId(300),
+                                              found),
+                          (unsigned) 0);
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+
+    // Test the time queries on a THitSelectionView.
+    template<> template<>
+    void testTHitSelection::test<5> () {
+        {
+            CP::THitSelection hits;
+            for (int i=0; i<20; ++i) {
+                hits.push_back(
+                    CP::THandle<CP::THit>(new CP::TTestHit(i,10*i,10*i+5)));
+            }
+            // A wide hit overlapping several others.
+            hits.push_back(CP::THandle<CP::THit>(new CP::TTestHit(50,12,48)));
+            CP::THitSelectionView view(hits);
+
+            CP::THitSelectionView::Hits found;
+            ensure_equals("Time range overlaps",
+                          view.GetTimeRange(34,52,found),
+                          (unsigned) 4);
+            found.clear();
+            ensure_equals("Time range in gap",
+                          view.GetTimeRange(6,8,found),
+                          (unsigned) 0);
+            found.clear();
+            ensure_equals("Coincident hits",
+                          view.GetCoincidentHits(*hits[3],5.0,found),
+                          (unsigned) 4);
+
+            ensure("Nearest hit containing time",
+                   view.GetNearestTime(101) == hits[10]);
+            ensure("Nearest hit before time",
+                   view.GetNearestTime(196) == hits[19]);
+            ensure("Nearest hit after time",
+                   view.GetNearestTime(-10) == hits[0]);
+            ensure("Nearest hit in gap",
+                   view.GetNearestTime(109) == hits[11]);
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+    // Test that the membership index follows changes made with the
+    // std::vector methods.
+    template<> template<>
+    void testTHitSelection::test<6> () {
+        {
+            CP::THitSelection hits;
+            MakeHits(hits,50);
+            CP::THitSelection other;
+            MakeHits(other,5);
+
+            // Replace the last hit using pop_back and push_back.
+            CP::THandle<CP::THit> last = hits.back();
+            ensure("Last hit is contained", hits.Contains(last));
+            hits.pop_back();
+            hits.push_back(other[0]);
+            ensure("Popped hit is not contained", !hits.Contains(last));
+            ensure("Pushed hit is contained", hits.Contains(other[0]));
+
+            // Replace an element by assignment.
+            CP::THandle<CP::THit> first = hits[0];
+            ensure("First hit is contained", hits.Contains(first));
+            hits[0] = other[1];
+            ensure("Replaced hit is not contained", !hits.Contains(first));
+            ensure("Assigned hit is contained", hits.Contains(other[1]));
+
+            // Replace an element through an iterator.
+            CP::THandle<CP::THit> second = hits[1];
+            ensure("Second hit is contained", hits.Contains(second));
+            *(hits.begin()+1) = other[2];
+            ensure("Overwritten hit is not contained",
+                   !hits.Contains(second));
+            ensure("Written hit is contained", hits.Contains(other[2]));
+
+            // Swap with a selection that is also indexed.
+            CP::THitSelection swapped;
+            MakeHits(swapped,40);
+            ensure("Swapped hit is contained", swapped.Contains(swapped[0]));
+            CP::THandle<CP::THit> mine = hits[10];
+            CP::THandle<CP::THit> theirs = swapped[10];
+            hits.swap(swapped);
+            ensure("Hit is contained after swap", hits.Contains(theirs));
+            ensure("Hit is gone after swap", !hits.Contains(mine));
+            ensure("Other hit is contained after swap",
+                   swapped.Contains(mine));
+
+            // Shrink and grow.
+            CP::THandle<CP::THit> dropped = hits[35];
+            hits.resize(35);
+            ensure("Resized hit is not contained", !hits.Contains(dropped));
+            hits.insert(hits.begin(), 2, other[3]);
+            ensure("Inserted hit is contained", hits.Contains(other[3]));
+            ensure_equals("Inserted hits", hits.size(), (unsigned) 37);
+            hits.assign(other.begin(), other.end());
+            ensure("Assigned hits replace the old hits",
+                   !hits.Contains(theirs));
+            ensure("Assigned hit is contained", hits.Contains(other[4]));
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+    // Test that the time range queries match a scan of all of the hits when
+    // a few of the hits are much wider than the others.
+    template<> template<>
+    void testTHitSelection::test<7> () {
+        {
+            CP::THitSelection hits;
+            for (int i=0; i<200; ++i) {
+                double lower = 7*i % 1000;
+                double width = 1 + (13*i % 5);
+                if (i % 50 == 0) width = 600;
+                hits.push_back(
+                    CP::THandle<CP::THit>(
+                        new CP::TTestHit(i,lower,lower+width)));
+            }
+            CP::THitSelectionView view(hits);
+            for (int q=0; q<40; ++q) {
+                double start = 25*q - 20;
+                double stop = start + (q % 3)*10;
+                std::size_t expected = 0;
+                for (std::size_t i=0; i<hits.size(); ++i) {
+                    if (hits[i]->GetTimeUpperBound() < start) continue;
+                    if (hits[i]->GetTimeLowerBound() > stop) continue;
+                    ++expected;
+                }
+                CP::THitSelectionView::Hits found;
+                ensure_equals("Time range matches a scan",
+                              view.GetTimeRange(start,stop,found),
+                              expected);
+                ensure_equals("Found hits returned", found.size(), expected);
+                for (std::size_t i=1; i<found.size(); ++i) {
+                    ensure("Hits are in time order",
+                           found[i-1]->GetTimeLowerBound()
+                           <= found[i]->GetTimeLowerBound());
+                }
+            }
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+
+    // Test that several threads can build the index of the same selection
+    // while they read it.
+    template<> template<>
+    void testTHitSelection::test<8> () {
+        {
+            CP::THitSelection hits;
+            MakeHits(hits,100);
+            CP::THitSelection other;
+            MakeHits(other,5);
+            // The readers only use the const methods, the same as the
+            // algorithms reading an input.
+            const CP::THitSelection& input = hits;
+            const CP::THitSelection& missing = other;
+            std::atomic<int> bad(0);
+            std::vector<std::thread> readers;
+            for (int t=0; t<4; ++t) {
+                readers.push_back(std::thread([&] () {
+                            for (std::size_t i=0; i<input.size(); ++i) {
+                                if (!input.Contains(input[i])) ++bad;
+                            }
+                            for (std::size_t i=0; i<missing.size(); ++i) {
+                                if (input.Contains(missing[i])) ++bad;
+                            }
+                        }));
+            }
+            for (std::size_t t=0; t<readers.size(); ++t) readers[t].join();
+            ensure_equals("Readers found the hits", bad.load(), 0);
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+
+    // Test that reading a selection through the non-const methods doesn't
+    // throw away the membership index, but a write through a reference or
+    // the std::vector base class is still noticed.
+    template<> template<>
+    void testTHitSelection::test<9> () {
+        {
+            CP::THitSelection hits;
+            MakeHits(hits,100);
+            CP::THitSelection other;
+            MakeHits(other,5);
+            ensure("First hit is contained", hits.Contains(hits[0]));
+
+            // Iterate over the non-const selection.
+            long builds = CP::THitSelection::GetIndexBuildCount();
+            for (CP::THitSelection::iterator h = hits.begin();
+                 h != hits.end(); ++h) {
+                ensure("Iterated hit is contained", hits.Contains(*h));
+            }
+            for (std::size_t i=0; i<hits.size(); ++i) {
+                ensure("Indexed hit is contained", hits.Contains(hits[i]));
+            }
+            ensure_equals("Iteration doesn't rebuild the index",
+                          CP::THitSelection::GetIndexBuildCount(), builds);
+
+            // Write through a reference taken before the membership test.
+            CP::THandle<CP::THit>& entry = hits[50];
+            CP::THandle<CP::THit> old = entry;
+            ensure("Entry is contained", hits.Contains(old));
+            entry = other[0];
+            ensure("Overwritten hit is not contained", !hits.Contains(old));
+            ensure("Written hit is contained", hits.Contains(other[0]));
+
+            // Write through the std::vector base class.
+            CP::THitSelection::BaseVector& base = hits;
+            old = base[20];
+            base[20] = other[1];
+            ensure("Base class write removes the hit", !hits.Contains(old));
+            ensure("Base class write adds the hit", hits.Contains(other[1]));
+        }
+        ensure("Handle Registry is clean", CP::CleanHandleRegistry());
+    }
+};
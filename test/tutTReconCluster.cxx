@@ -11,6 +11,8 @@
 #include "CaptGeomId.hxx"
 #include "HEPUnits.hxx"
 
+#include "TTestHit.hxx"
+
 namespace tut {
     struct baseTReconCluster {
         baseTReconCluster() {
@@ -572,4 +574,225 @@ namespace tut {
     }
 #endif /* TEST_FILLFROMHITS */
 
+    // Check that TReconCluster::FillFromHits gives the same covariance and
+    // moments for a cluster near the origin and one far from the origin.
+    template<> template<>
+    void testTReconCluster::test<11> () {
+        const TVector3 offsets[] = {
+            TVector3(1,0,0), TVector3(-1,0,0),
+            TVector3(0,2,0), TVector3(0,-2,0)};
+        const TVector3 centers[] = {
+            TVector3(0,0,0), TVector3(10*unit::m,-5*unit::m,20*unit::m)};
+        CP::TReconCluster clusters[2];
+        for (int c=0; c<2; ++c) {
+            CP::THitSelection hits;
+            for (int i=0; i<4; ++i) {
+                hits.push_back(CP::THandle<CP::THit>(
+                                   new CP::TTestHit(centers[c]+offsets[i],
+                                                10.0, 100.0+i)));
+            }
+            clusters[c].FillFromHits("test", hits);
+            ensure_distance("Cluster energy deposit",
+                            clusters[c].GetEDeposit(), 40.0, 1E-4);
+            ensure_lessthan("Cluster position",
+                            (clusters[c].GetPosition().Vect()
+                             -centers[c]).Mag(), 1E-3);
+            ensure_distance("Cluster time",
+                            clusters[c].GetPosition().T(), 101.5, 1E-4);
+            ensure_distance("Cluster XX moment",
+                            (double) clusters[c].GetMoments()(0,0),
+                            1.5, 1E-4);
+            ensure_distance("Cluster YY moment",
+                            (double) clusters[c].GetMoments()(1,1),
+                            3.0, 1E-4);
+            ensure_distance("Cluster ZZ moment",
+                            (double) clusters[c].GetMoments()(2,2),
+                            1.0, 1E-4);
+            ensure_distance("Cluster XY moment",
+                            (double) clusters[c].GetMoments()(0,1),
+                            0.0, 1E-4);
+        }
+
+        CP::THandle<CP::TClusterState> near = clusters[0].GetState();
+        CP::THandle<CP::TClusterState> far = clusters[1].GetState();
+        for (int i=0; i<near->GetDimensions(); ++i) {
+            for (int j=0; j<near->GetDimensions(); ++j) {
+                ensure_distance("Cluster covariance is translation invariant",
+                                far->GetCovarianceValue(i,j),
+                                near->GetCovarianceValue(i,j), 1E-4);
+            }
+        }
+    }
+
+    // Check that TReconCluster::FillClusters builds the same clusters as
+    // FillFromHits, both with one thread and with several threads.
+    template<> template<>
+    void testTReconCluster::test<12> () {
+        const int clusterCount = 300;
+        CP::THitSelection hits;
+        std::vector<int> labels;
+        for (int i=0; i<5*clusterCount; ++i) {
+            // Interleave the clusters, and add some unclustered hits.
+            int label = (i%7 == 3) ? -1 : (7*i)%clusterCount;
+            TVector3 pos(100.0*label + (i%5), 10.0*(i%3), 1.0*(i%11));
+            hits.push_back(CP::THandle<CP::THit>(
+                               new CP::TTestHit(pos, 1.0+i%4, 10.0*i)));
+            labels.push_back(label);
+        }
+
+        CP::TReconObjectContainer serial("serial");
+        CP::TReconCluster::FillClusters("test", hits, labels, serial, 1);
+        CP::TReconObjectContainer parallel("parallel");
+        CP::TReconCluster::FillClusters("test", hits, labels, parallel, 4);
+        ensure_equals("Serial clusters built",
+                      serial.size(), (unsigned) clusterCount);
+        ensure_equals("Parallel clusters built",
+                      parallel.size(), (unsigned) clusterCount);
+
+        for (int c=0; c<clusterCount; ++c) {
+            CP::THitSelection clusterHits;
+            for (std::size_t i=0; i<hits.size(); ++i) {
+                if (labels[i] == c) clusterHits.push_back(hits[i]);
+            }
+            CP::TReconCluster expected;
+            expected.FillFromHits("test", clusterHits);
+            CP::THandle<CP::TReconCluster> batch[2] = {
+                serial[c], parallel[c]};
+            for (int b=0; b<2; ++b) {
+                ensure("Batch cluster is a TReconCluster", batch[b]);
+                ensure_equals("Batch cluster hits",
+                              batch[b]->GetHits()->size(),
+                              clusterHits.size());
+                ensure_equals("Batch cluster degrees of freedom",
+                              batch[b]->GetNDOF(), expected.GetNDOF());
+                for (int i=0; i<5; ++i) {
+                    ensure_distance("Batch cluster state",
+                                    batch[b]->GetState()->GetValue(i),
+                                    expected.GetState()->GetValue(i),
+                                    1E-4);
+                    for (int j=0; j<5; ++j) {
+                        ensure_distance(
+                            "Batch cluster covariance",
+                            batch[b]->GetState()->GetCovarianceValue(i,j),
+                            expected.GetState()->GetCovarianceValue(i,j),
+                            1E-4);
+                    }
+                }
+                ensure_lessthan("Batch cluster long axis",
+                                (batch[b]->GetLongAxis()
+                                 - expected.GetLongAxis()).Mag(), 1E-4);
+                ensure_distance("Batch cluster long extent",
+                                batch[b]->GetLongExtent(),
+                                expected.GetLongExtent(), 1E-4);
+                ensure_distance("Batch cluster minor extent",
+                                batch[b]->GetMinorExtent(),
+                                expected.GetMinorExtent(), 1E-4);
+            }
+        }
+
+        labels.pop_back();
+        try {
+            CP::TReconObjectContainer bad("bad");
+            CP::TReconCluster::FillClusters("test", hits, labels, bad);
+            fail("Mismatched labels must throw");
+        }
+        catch (CP::EClusterLabels&) {}
+    }
+
+    // Test the axes for a rotated set of moments, and for moments with
+    // degenerate eigenvalues, using the single and the batched solver.
+    template<> template<>
+    void testTReconCluster::test<13> () {
+        // Moments diag(9,4,1) rotated about the Z axis by 30 degrees.
+        double c = std::cos(30*unit::degree);
+        double s = std::sin(30*unit::degree);
+        double xx = 9*c*c + 4*s*s;
+        double yy = 9*s*s + 4*c*c;
+        double xy = (9-4)*c*s;
+
+        CP::TReconCluster rotated;
+        rotated.SetMoments(xx, yy, 1.0, xy, 0.0, 0.0);
+        ensure_distance("Long axis length", rotated.GetLongAxis().Mag(),
+                        3.0, 1E-5);
+        ensure_distance("Major axis length", rotated.GetMajorAxis().Mag(),
+                        2.0, 1E-5);
+        ensure_distance("Minor axis length", rotated.GetMinorAxis().Mag(),
+                        1.0, 1E-5);
+        ensure_distance("Long axis X", rotated.GetLongAxis().X(),
+                        3*c, 1E-5);
+        ensure_distance("Long axis Y", rotated.GetLongAxis().Y(),
+                        3*s, 1E-5);
+        ensure_distance("Major axis direction",
+                        std::abs(rotated.GetMajorAxis()*TVector3(-s,c,0)),
+                        2.0, 1E-5);
+        ensure_distance("Minor axis direction",
+                        std::abs(rotated.GetMinorAxis().Z()), 1.0, 1E-5);
+
+        // A round cluster has degenerate eigenvalues, but the axes must
+        // still be orthogonal.
+        CP::TReconCluster round;
+        round.SetMoments(4.0, 4.0, 4.0, 0.0, 0.0, 0.0);
+        ensure_distance("Round long axis", round.GetLongAxis().Mag(),
+                        2.0, 1E-5);
+        ensure_distance("Round axes orthogonal",
+                        round.GetLongAxis()*round.GetMajorAxis(),
+                        0.0, 1E-5);
+        ensure_distance("Round minor axis", round.GetMinorAxis().Mag(),
+                        2.0, 1E-5);
+
+        // The batched solver gives the same answer.
+        CP::TReconObjectContainer clusters("clusters");
+        for (int i=0; i<10; ++i) {
+            CP::THandle<CP::TReconCluster> cluster(new CP::TReconCluster);
+            double scale = 1.0 + i;
+            cluster->SetMoments(scale*xx, scale*yy, scale,
+                                scale*xy, 0.1*i, -0.1*i);
+            clusters.push_back(cluster);
+        }
+        CP::TReconCluster::FillAxes(clusters);
+        for (int i=0; i<10; ++i) {
+            CP::THandle<CP::TReconCluster> cluster = clusters[i];
+            CP::TReconCluster single;
+            single.SetMoments(cluster->GetMoments());
+            ensure_lessthan("Batched long axis",
+                            (cluster->GetLongAxis()
+                             - single.GetLongAxis()).Mag(), 1E-5);
+            ensure_lessthan("Batched major axis",
+                            (cluster->GetMajorAxis()
+                             - single.GetMajorAxis()).Mag(), 1E-5);
+            ensure_lessthan("Batched minor axis",
+                            (cluster->GetMinorAxis()
+                             - single.GetMinorAxis()).Mag(), 1E-5);
+        }
+    }
+
+    // Check that the extents follow changes to the hits and the position
+    // after they have been used.
+    template<> template<>
+    void testTReconCluster::test<14> () {
+        CP::THitSelection hits;
+        for (int i=0; i<11; ++i) {
+            TVector3 pos(2.0*(i-5), 0.1*(i%3), 0.1*(i%2));
+            hits.push_back(CP::THandle<CP::THit>(
+                               new CP::TTestHit(pos, 1.0, 10.0*i)));
+        }
+        CP::TReconCluster cluster;
+        cluster.FillFromHits("test", hits);
+        double extent = cluster.GetLongExtent();
+        ensure_lessthan("Long extent is positive", 0.0, extent);
+
+        TLorentzVector pos = cluster.GetPosition();
+        cluster.GetState()->SetPosition(pos.X()+5.0, pos.Y(),
+                                        pos.Z(), pos.T());
+        ensure_lessthan("Extent follows the position",
+                        extent, cluster.GetLongExtent());
+        cluster.GetState()->SetPosition(pos);
+        ensure_distance("Extent follows the restored position",
+                        cluster.GetLongExtent(), extent, 1E-6);
+
+        cluster.GetHits()->push_back(CP::THandle<CP::THit>(
+                    new CP::TTestHit(TVector3(50.0,0.0,0.0), 1.0, 0.0)));
+        ensure_lessthan("Extent follows the hits",
+                        extent, cluster.GetLongExtent());
+    }
 };
@@ -20,6 +20,19 @@ namespace tut {
         }
     };
 
+    /// Move the position of a state along the direction using the compile
+    /// time layout.  This is an example of code written as a template over
+    /// the state type.
+    template <class State>
+    void MoveState(State& state, double step) {
+        CP::TReconStateView<State> view(state);
+        typedef typename CP::TReconStateView<State>::Layout Layout;
+        for (int i=0; i<3; ++i) {
+            view.Value(Layout::kPosition+i)
+                += step*view.Value(Layout::kDirection+i);
+        }
+    }
+
     // Declare the test
     typedef test_group<baseTReconState>::object testTReconState;
     test_group<baseTReconState> groupTReconState("TReconState");
@@ -216,4 +229,167 @@ namespace tut {
 
     }
 
+    // Test that states with fixed size storage copy, assign and project
+    // their values and covariance.
+    template<> template<>
+    void testTReconState::test<8> () {
+        CP::TTrackState s;
+        ensure_equals("Track state dimensionality",
+                      s.GetDimensions(), CP::TTrackState::GetSize());
+        for (int i = 0; i<s.GetDimensions(); ++i) {
+            ensure("Initial state is free", s.IsFree(i));
+            s.SetValue(i,10.0*i);
+            for (int j = 0; j<=i; ++j) {
+                s.SetCovarianceValue(i,j,i+0.1*j+1.0);
+            }
+        }
+        s.SetFixed(2);
+        ensure("Parameter is fixed", s.IsFixed(2));
+        ensure_distance("Fixed parameter is not correlated",
+                        s.GetCovarianceValue(5,2), 0.0, 1E-6);
+        ensure_distance("Covariance is symmetric",
+                        s.GetCovarianceValue(3,5),
+                        s.GetCovarianceValue(5,3), 1E-6);
+
+        CP::TTrackState copy(s);
+        CP::TTrackState assigned;
+        assigned = s;
+        CP::TCorrValues values 
+            = CP::TReconState::ProjectState(
+                CP::THandle<CP::TReconState>(new CP::TTrackState(s)));
+        ensure_equals("Projected dimensions",
+                      values.GetDimensions(), s.GetDimensions());
+        for (int i = 0; i<s.GetDimensions(); ++i) {
+            ensure_distance("Copied value",
+                            copy.GetValue(i), s.GetValue(i), 1E-6);
+            ensure_distance("Assigned value",
+                            assigned.GetValue(i), s.GetValue(i), 1E-6);
+            ensure_distance("Projected value",
+                            values.GetValue(i), s.GetValue(i), 1E-6);
+            for (int j = 0; j<s.GetDimensions(); ++j) {
+                ensure_distance("Copied covariance",
+                                copy.GetCovarianceValue(i,j),
+                                s.GetCovarianceValue(i,j), 1E-6);
+                ensure_distance("Assigned covariance",
+                                assigned.GetCovarianceValue(i,j),
+                                s.GetCovarianceValue(i,j), 1E-6);
+                ensure_distance("Projected covariance",
+                                values.GetCovarianceValue(i,j),
+                                s.GetCovarianceValue(i,j), 1E-6);
+            }
+        }
+
+        try {
+            s.GetValue(s.GetDimensions());
+            fail("Out of range index must throw");
+        }
+        catch (CP::ECorrValuesRange&) {}
+    }
+
+    // Test that the compile time layouts match the indices found through the
+    // mix-in classes, and test the state views.
+    template<> template<>
+    void testTReconState::test<9> () {
+        typedef CP::TReconStateLayout<CP::TClusterState> ClusterLayout;
+        CP::TClusterState cluster;
+        ensure_equals("Cluster EDeposit index",
+                      (int) ClusterLayout::kEDeposit,
+                      cluster.GetEDepositIndex());
+        ensure_equals("Cluster position index",
+                      (int) ClusterLayout::kPosition,
+                      cluster.GetPositionIndex());
+        ensure_equals("Cluster size",
+                      (int) ClusterLayout::kSize, cluster.GetDimensions());
+
+        typedef CP::TReconStateLayout<CP::TTrackState> TrackLayout;
+        CP::TTrackState track;
+        ensure_equals("Track EDeposit index",
+                      (int) TrackLayout::kEDeposit,
+                      track.GetEDepositIndex());
+        ensure_equals("Track position index",
+                      (int) TrackLayout::kPosition,
+                      track.GetPositionIndex());
+        ensure_equals("Track direction index",
+                      (int) TrackLayout::kDirection,
+                      track.GetDirectionIndex());
+        ensure_equals("Track mass index",
+                      (int) TrackLayout::kMass, track.GetMassIndex());
+        ensure_equals("Track width index",
+                      (int) TrackLayout::kWidth, track.GetWidthIndex());
+        ensure_equals("Track size",
+                      (int) TrackLayout::kSize, track.GetDimensions());
+
+        typedef CP::TReconStateLayout<CP::TShowerState> ShowerLayout;
+        CP::TShowerState shower;
+        ensure_equals("Shower EDeposit index",
+                      (int) ShowerLayout::kEDeposit,
+                      shower.GetEDepositIndex());
+        ensure_equals("Shower position index",
+                      (int) ShowerLayout::kPosition,
+                      shower.GetPositionIndex());
+        ensure_equals("Shower direction index",
+                      (int) ShowerLayout::kDirection,
+                      shower.GetDirectionIndex());
+        ensure_equals("Shower cone index",
+                      (int) ShowerLayout::kCone, shower.GetConeIndex());
+        ensure_equals("Shower size",
+                      (int) ShowerLayout::kSize, shower.GetDimensions());
+
+        typedef CP::TReconStateLayout<CP::TPIDState> PIDLayout;
+        CP::TPIDState pid;
+        ensure_equals("PID position index",
+                      (int) PIDLayout::kPosition, pid.GetPositionIndex());
+        ensure_equals("PID direction index",
+                      (int) PIDLayout::kDirection, pid.GetDirectionIndex());
+        ensure_equals("PID momentum index",
+                      (int) PIDLayout::kMomentum, pid.GetMomentumIndex());
+        ensure_equals("PID charge index",
+                      (int) PIDLayout::kCharge, pid.GetChargeIndex());
+        ensure_equals("PID size",
+                      (int) PIDLayout::kSize, pid.GetDimensions());
+
+        typedef CP::TReconStateLayout<CP::TVertexState> VertexLayout;
+        CP::TVertexState vertex;
+        ensure_equals("Vertex position index",
+                      (int) VertexLayout::kPosition,
+                      vertex.GetPositionIndex());
+        ensure_equals("Vertex size",
+                      (int) VertexLayout::kSize, vertex.GetDimensions());
+
+        // Values set through a view are seen by the mix-in classes.
+        CP::TReconStateView<CP::TTrackState> view(track);
+        view.SetEDeposit(2.5);
+        view.SetPosition(TLorentzVector(1.0,2.0,3.0,4.0));
+        view.SetDirection(TVector3(0.0,0.0,1.0));
+        view.SetMass(0.5);
+        view.SetWidth(0.25);
+        view.Covariance(TrackLayout::kMass,TrackLayout::kWidth) = 0.125;
+        ensure_distance("View EDeposit", track.GetEDeposit(), 2.5, 1E-6);
+        ensure_distance("View position", track.GetPosition().T(), 4.0, 1E-6);
+        ensure_distance("View direction",
+                        track.GetDirection().Z(), 1.0, 1E-6);
+        ensure_distance("View mass", track.GetMass(), 0.5, 1E-6);
+        ensure_distance("View width", track.GetWidth(), 0.25, 1E-6);
+        ensure_distance("View covariance",
+                        track.GetCovarianceValue(TrackLayout::kWidth,
+                                                 TrackLayout::kMass),
+                        0.125, 1E-6);
+        ensure_distance("View value with fixed index",
+                        view.Value<TrackLayout::kMass>(), 0.5, 1E-6);
+
+        // Values set through the mix-in classes are seen by a view.
+        shower.SetPosition(1.0,1.0,1.0,0.0);
+        shower.SetDirection(1.0,0.0,0.0);
+        shower.SetCone(0.75);
+        CP::TReconStateView<CP::TShowerState> showerView(shower);
+        ensure_distance("Shower view cone", showerView.GetCone(), 0.75, 1E-6);
+        ensure_distance("Shower view direction",
+                        showerView.GetDirection().X(), 1.0, 1E-6);
+
+        // The same template code works for different state classes.
+        MoveState(track,2.0);
+        MoveState(shower,2.0);
+        ensure_distance("Moved track", track.GetPosition().Z(), 5.0, 1E-6);
+        ensure_distance("Moved shower", shower.GetPosition().X(), 3.0, 1E-6);
+    }
 };
@@ -193,4 +193,105 @@ namespace tut {
 
     }
 
+    // Fill a track with nodes at x = 0, 1, 2, ... pointing along x.
+    void FillTestTrack(CP::TReconTrack& original) {
+        for (int i=0; i<5; ++i) {
+            CP::THandle<CP::TReconNode> node(new CP::TReconNode);
+            CP::THandle<CP::TReconBase> object(new CP::TReconCluster);
+            node->SetObject(object);
+            CP::THandle<CP::TTrackState> trackState(new CP::TTrackState);
+            trackState->SetPosition(TLorentzVector(i,0,0,0));
+            trackState->SetDirection(TVector3(1,0,0));
+            CP::THandle<CP::TReconState> state(trackState);
+            node->SetState(state);
+            node->SetQuality(i);
+            original.GetNodes().push_back(node);
+        }
+        original.GetFront()->SetDirection(TVector3(1,0,0));
+        original.GetBack()->SetDirection(TVector3(1,0,0));
+    }
+
+    // Test that a shallow copy of a track shares the nodes with the
+    // original until they are changed.
+    template<> template<>
+    void testTReconTrack::test<6> () {
+        CP::TReconTrack original;
+        FillTestTrack(original);
+
+        CP::TReconTrack* shallow = original.ShallowCopy();
+        CP::TReconTrack& copy = *shallow;
+        ensure_equals("Copy has the nodes",
+                      copy.GetNodes().size(), original.GetNodes().size());
+        for (std::size_t i=0; i<copy.GetNodes().size(); ++i) {
+            ensure("Copied node is shared",
+                   GetPointer(copy.GetNodes()[i])
+                   == GetPointer(original.GetNodes()[i]));
+        }
+
+        copy.ReverseTrack();
+        for (std::size_t i=0; i<original.GetNodes().size(); ++i) {
+            CP::THandle<CP::TTrackState> state
+                = original.GetNodes()[i]->GetState();
+            ensure_distance("Original node position unchanged",
+                            state->GetPosition().X(), 1.0*i, 1E-6);
+            ensure_distance("Original node direction unchanged",
+                            state->GetDirection().X(), 1.0, 1E-6);
+        }
+        for (std::size_t i=0; i<copy.GetNodes().size(); ++i) {
+            std::size_t j = copy.GetNodes().size() - i - 1;
+            ensure("Changed node is not shared",
+                   GetPointer(copy.GetNodes()[i])
+                   != GetPointer(original.GetNodes()[j]));
+            ensure("Changed node keeps the object",
+                   copy.GetNodes()[i]->GetObject()
+                   == original.GetNodes()[j]->GetObject());
+            ensure_distance("Changed node keeps the quality",
+                            copy.GetNodes()[i]->GetQuality(), 1.0*j, 1E-6);
+            CP::THandle<CP::TTrackState> state
+                = copy.GetNodes()[i]->GetState();
+            ensure_distance("Copied node position",
+                            state->GetPosition().X(), 1.0*j, 1E-6);
+            ensure_distance("Copied node direction reversed",
+                            state->GetDirection().X(), -1.0, 1E-6);
+        }
+
+        // A node that isn't shared is changed in place, even when there
+        // are other handles to it.
+        CP::THandle<CP::TReconNode> node = copy.GetNodes()[0];
+        CP::THandle<CP::TReconState> state = node->GetState();
+        ensure("Unshared node is not copied",
+               GetPointer(copy.GetNodes().GetWritableNode(0))
+               == GetPointer(node));
+        ensure("Unshared state is not copied",
+               GetPointer(node->GetWritableState()) == GetPointer(state));
+        delete shallow;
+    }
+
+    // Test that the copy constructor copies the nodes and their states.
+    template<> template<>
+    void testTReconTrack::test<7> () {
+        CP::TReconTrack original;
+        FillTestTrack(original);
+
+        CP::TReconTrack copy(original);
+        ensure_equals("Copy has the nodes",
+                      copy.GetNodes().size(), original.GetNodes().size());
+        for (std::size_t i=0; i<copy.GetNodes().size(); ++i) {
+            ensure("Copied node is not shared",
+                   GetPointer(copy.GetNodes()[i])
+                   != GetPointer(original.GetNodes()[i]));
+            ensure("Copied state is not shared",
+                   GetPointer(copy.GetNodes()[i]->GetState())
+                   != GetPointer(original.GetNodes()[i]->GetState()));
+            CP::THandle<CP::TTrackState> state
+                = copy.GetNodes()[i]->GetState();
+            state->SetPosition(TLorentzVector(-1,0,0,0));
+        }
+        for (std::size_t i=0; i<original.GetNodes().size(); ++i) {
+            CP::THandle<CP::TTrackState> state
+                = original.GetNodes()[i]->GetState();
+            ensure_distance("Original node position unchanged",
+                            state->GetPosition().X(), 1.0*i, 1E-6);
+        }
+    }
 };
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <tut.h>
+
+#include "TResourceSampler.hxx"
+
+namespace tut {
+    struct baseTResourceSampler {
+        baseTResourceSampler() {
+            // Run before each test.
+        }
+        ~baseTResourceSampler() {
+            // Run after each test.
+        }
+    };
+
+    // Declare the test
+    typedef test_group<baseTResourceSampler>::object testTResourceSampler;
+    test_group<baseTResourceSampler> groupTResourceSampler("TResourceSampler");
+
+    // Test that the process resources can be read.
+    template<> template<>
+    void testTResourceSampler::test<1> () {
+        CP::TResourceSampler::TSample sample;
+        if (!CP::TResourceSampler::ReadProc(sample)) return;
+        ensure("Resident memory is found", sample.fResident > 0);
+        ensure("Virtual memory is found",
+               sample.fVirtual >= sample.fResident);
+        ensure("Open files are found", sample.fOpenFiles >= 0);
+        ensure("CPU time is found", sample.fCpuUser >= 0.0);
+    }
+
+    // Test that the samples are merged when the ring is full, and that the
+    // peak memory is kept.
+    template<> template<>
+    void testTResourceSampler::test<2> () {
+        CP::TResourceSampler sampler(1.0, 8);
+        for (int i = 0; i<100; ++i) {
+            sampler.SetEvent(1,i);
+            sampler.Sample();
+        }
+        std::vector<CP::TResourceSampler::TSample> samples
+            = sampler.GetSamples();
+        ensure("Samples are bounded", samples.size() <= 9);
+        ensure("Samples are saved", samples.size() >= 4);
+        ensure_distance("Sample spacing has grown",
+                        sampler.GetSampleSpacing(), 16.0, 1E-6);
+        ensure_equals("Event count", sampler.GetEventCount(), 100L);
+        ensure_equals("Last event", samples.back().fEvent, 99);
+        for (std::size_t i = 1; i<samples.size(); ++i) {
+            ensure("Samples are in order",
+                   samples[i-1].fEvents <= samples[i].fEvents);
+        }
+        long peak = 0;
+        for (std::size_t i = 0; i<samples.size(); ++i) {
+            peak = std::max(peak, samples[i].fResident);
+        }
+        ensure_equals("Peak is kept", peak, sampler.GetPeakResident());
+    }
+
+    // Test that the background thread takes samples.
+    template<> template<>
+    void testTResourceSampler::test<3> () {
+        CP::TResourceSampler sampler(0.01, 16);
+        sampler.Start();
+        ensure("Sampler is running", sampler.IsRunning());
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        sampler.Stop();
+        ensure("Sampler is stopped", !sampler.IsRunning());
+        std::vector<CP::TResourceSampler::TSample> samples
+            = sampler.GetSamples();
+        ensure("Samples are taken", samples.size() >= 3);
+        ensure("Samples are bounded", samples.size() <= 17);
+        ensure("Time increases", samples.back().fTime > samples.front().fTime);
+    }
+};
@@ -0,0 +1,165 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <tut.h>
+
+#include "TRuntimeParameters.hxx"
+
+namespace tut {
+    struct baseTRuntimeParameters {
+        baseTRuntimeParameters() {
+            // Run before each test.
+        }
+        ~baseTRuntimeParameters() {
+            // Run after each test.
+        }
+
+        /// Write a parameter override file with a value for the test
+        /// parameters.
+        void WriteOverrideFile(const char* fileName,
+                               const std::string& value) {
+            std::ofstream output(fileName);
+            output << "An override file for the tests" << std::endl;
+            output << "< tutRuntime.double = " << value << " >" << std::endl;
+            output << "< tutRuntime.int = " << value << " >" << std::endl;
+            output << "< tutRuntime.bool = no >" << std::endl;
+            output << "< tutRuntime.string = value" << value << " >"
+                   << std::endl;
+        }
+    };
+
+    // Declare the test
+    typedef test_group<baseTRuntimeParameters>::object testTRuntimeParameters;
+    test_group<baseTRuntimeParameters>
+    groupTRuntimeParameters("TRuntimeParameters");
+
+    // Test that the parameter handles return the values, and follow a
+    // reload of the override file.
+    template<> template<>
+    void testTRuntimeParameters::test<1> () {
+        const char* fileName = "tutTRuntimeParameters.dat";
+        WriteOverrideFile(fileName,"10");
+        CP::TRuntimeParameters::Get().ReadParamOverrideFile(fileName);
+
+        CP::TRuntimeParameters::TParameter<double>
+            dValue("tutRuntime.double");
+        CP::TRuntimeParameters::TParameter<int> iValue("tutRuntime.int");
+        CP::TRuntimeParameters::TParameter<bool> bValue("tutRuntime.bool");
+        CP::TRuntimeParameters::TParameter<std::string>
+            sValue("tutRuntime.string");
+        ensure_distance("Double handle value", dValue.Get(), 10.0, 1E-6);
+        ensure_equals("Integer handle value", iValue.Get(), 10);
+        ensure("Boolean handle value", !bValue.Get());
+        ensure_equals("String handle value", sValue.Get(),
+                      std::string("value10"));
+        ensure_distance("Handle matches the map",
+                        CP::TRuntimeParameters::Get().GetParameterD(
+                            "tutRuntime.double"), 10.0, 1E-6);
+
+        WriteOverrideFile(fileName,"20");
+        ensure("Override file is reloaded",
+               CP::TRuntimeParameters::Get().ReloadParamOverrideFiles());
+        ensure_distance("Reloaded double value", dValue.Get(), 20.0, 1E-6);
+        ensure_equals("Reloaded integer value", iValue.Get(), 20);
+        ensure_equals("Reloaded string value", sValue.Get(),
+                      std::string("value20"));
+        ensure_equals("Reloaded map value",
+                      CP::TRuntimeParameters::Get().GetParameterI(
+                          "tutRuntime.int"), 20);
+
+        // A bad file doesn't change any of the values.
+        {
+            std::ofstream output(fileName);
+            output << "< tutRuntime.double 30 >" << std::endl;
+        }
+        ensure("Bad override file is not reloaded",
+               !CP::TRuntimeParameters::Get().ReloadParamOverrideFiles());
+        ensure_distance("Value after bad reload", dValue.Get(), 20.0, 1E-6);
+
+        // A single override isn't changed by a reload.
+        CP::TRuntimeParameters::Get().SetOverrideParameter("tutRuntime.int",
+                                                           "5");
+        ensure_equals("Single override value", iValue.Get(), 5);
+        WriteOverrideFile(fileName,"40");
+        CP::TRuntimeParameters::Get().ReloadParamOverrideFiles();
+        ensure_distance("Double value follows reload",
+                        dValue.Get(), 40.0, 1E-6);
+        ensure_equals("Single override is kept", iValue.Get(), 5);
+
+        // Forget the file before it's removed so that it isn't reloaded by
+        // the other tests.
+        CP::TRuntimeParameters::Get().ClearParamOverrideFiles();
+        std::remove(fileName);
+        ensure("Removed file is not reloaded",
+               CP::TRuntimeParameters::Get().ReloadParamOverrideFiles());
+        ensure_distance("Value is kept", dValue.Get(), 40.0, 1E-6);
+    }
+
+    // Test that the handles can be read while the values are being
+    // republished and new handles are being made.
+    template<> template<>
+    void testTRuntimeParameters::test<2> () {
+        CP::TRuntimeParameters::Get().SetOverrideParameter("tutRuntime.a",
+                                                           "1");
+        CP::TRuntimeParameters::Get().SetOverrideParameter("tutRuntime.b",
+                                                           "1");
+        CP::TRuntimeParameters::TParameter<int> a("tutRuntime.a");
+        std::atomic<bool> done(false);
+        std::atomic<int> bad(0);
+        std::thread reader([&] () {
+                while (!done) {
+                    int value = a.Get();
+                    if (value < 1 || value > 100) ++bad;
+                }
+            });
+        for (int i = 1; i <= 100; ++i) {
+            std::string value = std::to_string(i);
+            CP::TRuntimeParameters::Get().SetOverrideParameter(
+                "tutRuntime.a",value);
+            std::string name = "tutRuntime.c" + value;
+            CP::TRuntimeParameters::Get().SetOverrideParameter(name,value);
+            CP::TRuntimeParameters::TParameter<int> c(name);
+            ensure_equals("New handle value", c.Get(), i);
+        }
+        done = true;
+        reader.join();
+        ensure_equals("Reader saw valid values", bad.load(), 0);
+        ensure_equals("Final value", a.Get(), 100);
+    }
+
+    // Test that the boolean values are converted, and that the units are
+    // applied to a single override.
+    template<> template<>
+    void testTRuntimeParameters::test<3> () {
+        CP::TRuntimeParameters& parameters = CP::TRuntimeParameters::Get();
+        parameters.SetOverrideParameter("tutRuntime.n","n");
+        parameters.SetOverrideParameter("tutRuntime.y","Y");
+        parameters.SetOverrideParameter("tutRuntime.false","false");
+        parameters.SetOverrideParameter("tutRuntime.one","1");
+        ensure("Parameter \"n\" is false",
+               !parameters.GetParameterB("tutRuntime.n"));
+        ensure("Parameter \"Y\" is true",
+               parameters.GetParameterB("tutRuntime.y"));
+        ensure("Parameter \"false\" is false",
+               !parameters.GetParameterB("tutRuntime.false"));
+        ensure("Parameter \"1\" is true",
+               parameters.GetParameterB("tutRuntime.one"));
+
+        parameters.SetOverrideParameter("tutRuntime.length","2 cm");
+        ensure_distance("Length is converted to mm",
+                        parameters.GetParameterD("tutRuntime.length"),
+                        20.0, 1E-6);
+        CP::TRuntimeParameters::TParameter<double>
+            length("tutRuntime.length");
+        ensure_distance("Length handle is converted to mm",
+                        length.Get(), 20.0, 1E-6);
+        parameters.SetOverrideParameter("tutRuntime.length","3 mm");
+        ensure_distance("Changed length is converted",
+                        length.Get(), 3.0, 1E-6);
+        ensure_equals("Value without a unit is not converted",
+                      parameters.GetParameterS("tutRuntime.one"),
+                      std::string("1"));
+    }
+};